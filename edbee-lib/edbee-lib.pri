@@ -2,6 +2,9 @@
 
 INCLUDEPATH += $$PWD
 
+## Use CONFIG+=edbee_64bit_offsets for documents larger than 2^31 characters (see edbee/textoffset.h)
+edbee_64bit_offsets: DEFINES += EDBEE_64BIT_OFFSETS
+
 SOURCES += \
     $$PWD/edbee/commands/commentcommand.cpp \
     $$PWD/edbee/commands/copycommand.cpp \
@@ -25,7 +28,10 @@ SOURCES += \
     $$PWD/edbee/io/baseplistparser.cpp \
     $$PWD/edbee/io/jsonparser.cpp \
     $$PWD/edbee/io/keymapparser.cpp \
+    $$PWD/edbee/io/textdocumentcache.cpp \
+    $$PWD/edbee/io/textdocumentfollower.cpp \
     $$PWD/edbee/io/textdocumentserializer.cpp \
+    $$PWD/edbee/io/textdocumentserializerjob.cpp \
     $$PWD/edbee/io/tmlanguageparser.cpp \
     $$PWD/edbee/io/tmthemeparser.cpp \
     $$PWD/edbee/lexers/grammartextlexer.cpp \
@@ -40,6 +46,10 @@ SOURCES += \
     $$PWD/edbee/models/chardocument/chartextbuffer.cpp \
     $$PWD/edbee/models/chardocument/chartextdocument.cpp \
     $$PWD/edbee/models/dynamicvariables.cpp \
+    $$PWD/edbee/models/mappeddocument/mappedtextbuffer.cpp \
+    $$PWD/edbee/models/mappeddocument/mappedtextdocument.cpp \
+    $$PWD/edbee/models/ropedocument/ropetextbuffer.cpp \
+    $$PWD/edbee/models/ropedocument/ropetextdocument.cpp \
     $$PWD/edbee/models/textautocompleteprovider.cpp \
     $$PWD/edbee/models/textbuffer.cpp \
     $$PWD/edbee/models/textdocument.cpp \
@@ -50,9 +60,11 @@ SOURCES += \
     $$PWD/edbee/models/texteditorkeymap.cpp \
     $$PWD/edbee/models/textgrammar.cpp \
     $$PWD/edbee/models/textlexer.cpp \
+    $$PWD/edbee/models/textlexerscheduler.cpp \
     $$PWD/edbee/models/textlinedata.cpp \
     $$PWD/edbee/models/textrange.cpp \
     $$PWD/edbee/models/textsearcher.cpp \
+    $$PWD/edbee/models/textsnapshot.cpp \
     $$PWD/edbee/models/textundostack.cpp \
     $$PWD/edbee/texteditorcommand.cpp \
     $$PWD/edbee/texteditorcontroller.cpp \
@@ -60,16 +72,21 @@ SOURCES += \
     $$PWD/edbee/util/cascadingqvariantmap.cpp \
     $$PWD/edbee/util/gapvector.h \
     $$PWD/edbee/util/lineending.cpp \
+    $$PWD/edbee/util/lineoffsettree.cpp \
     $$PWD/edbee/util/lineoffsetvector.cpp \
     $$PWD/edbee/util/mem/debug_allocs.cpp \
     $$PWD/edbee/util/mem/debug_new.cpp \
+    $$PWD/edbee/util/newlinescanner.cpp \
+    $$PWD/edbee/util/paralleltextdecoder.cpp \
     $$PWD/edbee/util/rangelineiterator.cpp \
     $$PWD/edbee/util/rangesetlineiterator.cpp \
     $$PWD/edbee/util/regexp.cpp \
+    $$PWD/edbee/util/simdsupport.cpp \
     $$PWD/edbee/util/simpleprofiler.cpp \
     $$PWD/edbee/util/test.cpp \
     $$PWD/edbee/util/textcodec.cpp \
     $$PWD/edbee/util/textcodecdetector.cpp \
+    $$PWD/edbee/util/utf8validator.cpp \
     $$PWD/edbee/util/util.cpp \
     $$PWD/edbee/views/accessibletexteditorwidget.cpp \
     $$PWD/edbee/views/components/texteditorautocompletecomponent.cpp \
@@ -109,7 +126,10 @@ HEADERS += \
     $$PWD/edbee/io/baseplistparser.h \
     $$PWD/edbee/io/jsonparser.h \
     $$PWD/edbee/io/keymapparser.h \
+    $$PWD/edbee/io/textdocumentcache.h \
+    $$PWD/edbee/io/textdocumentfollower.h \
     $$PWD/edbee/io/textdocumentserializer.h \
+    $$PWD/edbee/io/textdocumentserializerjob.h \
     $$PWD/edbee/io/tmlanguageparser.h \
     $$PWD/edbee/io/tmthemeparser.h \
     $$PWD/edbee/lexers/grammartextlexer.h \
@@ -124,6 +144,10 @@ HEADERS += \
     $$PWD/edbee/models/chardocument/chartextbuffer.h \
     $$PWD/edbee/models/chardocument/chartextdocument.h \
     $$PWD/edbee/models/dynamicvariables.h \
+    $$PWD/edbee/models/mappeddocument/mappedtextbuffer.h \
+    $$PWD/edbee/models/mappeddocument/mappedtextdocument.h \
+    $$PWD/edbee/models/ropedocument/ropetextbuffer.h \
+    $$PWD/edbee/models/ropedocument/ropetextdocument.h \
     $$PWD/edbee/models/textautocompleteprovider.h \
     $$PWD/edbee/models/textbuffer.h \
     $$PWD/edbee/models/textdocument.h \
@@ -134,27 +158,37 @@ HEADERS += \
     $$PWD/edbee/models/texteditorkeymap.h \
     $$PWD/edbee/models/textgrammar.h \
     $$PWD/edbee/models/textlexer.h \
+    $$PWD/edbee/models/textlexerscheduler.h \
     $$PWD/edbee/models/textlinedata.h \
     $$PWD/edbee/models/textrange.h \
     $$PWD/edbee/models/textsearcher.h \
+    $$PWD/edbee/models/textsnapshot.h \
     $$PWD/edbee/models/textundostack.h \
     $$PWD/edbee/texteditorcommand.h \
     $$PWD/edbee/texteditorcontroller.h \
     $$PWD/edbee/texteditorwidget.h \
+    $$PWD/edbee/textoffset.h \
     $$PWD/edbee/util/cascadingqvariantmap.h \
     $$PWD/edbee/util/lineending.h \
+    $$PWD/edbee/util/lineoffsettree.h \
     $$PWD/edbee/util/lineoffsetvector.h \
     $$PWD/edbee/util/logging.h \
     $$PWD/edbee/util/mem/debug_allocs.h \
     $$PWD/edbee/util/mem/debug_new.h \
+    $$PWD/edbee/util/newlinescanner.h \
+    $$PWD/edbee/util/paralleltextdecoder.h \
     $$PWD/edbee/util/rangelineiterator.h \
     $$PWD/edbee/util/rangesetlineiterator.h \
     $$PWD/edbee/util/regexp.h \
+    $$PWD/edbee/util/simdsupport.h \
     $$PWD/edbee/util/simpleprofiler.h \
     $$PWD/edbee/util/test.h \
     $$PWD/edbee/util/textcodec.h \
     $$PWD/edbee/util/textcodecdetector.h \
+    $$PWD/edbee/util/treap.h \
+    $$PWD/edbee/util/utf8validator.h \
     $$PWD/edbee/util/util.h \
+    $$PWD/edbee/util/xorshiftrandom.h \
     $$PWD/edbee/views/accessibletexteditorwidget.h \
     $$PWD/edbee/views/components/texteditorautocompletecomponent.h \
     $$PWD/edbee/views/components/texteditorcomponent.h \
@@ -119,21 +119,25 @@ static bool areAllLinesCommented( TextDocument* doc, TextRange& range, const QLi
 
     // we directly check in the buffer for fast regexp without QString creation
     TextBuffer* buf = doc->buffer();
+    QString storage;    // only used when a line spans multiple buffer chunks
 
     // iterate over all lines
     RangeLineIterator itr( doc, range );
     while( itr.hasNext() ) {
 
         int line = itr.next();
-        int lineLength = doc->lineLengthWithoutNewline(line);
+        TextOffset lineLength = doc->lineLengthWithoutNewline(line);
 
         // when it's the last line and its blank, we must skip it
         if( !itr.hasNext() && lineLength == 0 ) {
             continue;
         }
 
-        // directly search in the raw data pointer buffer to prevent QString creation
-        int offset = doc->offsetFromLine(line);
+        // directly search in the buffer data to prevent QString creation (without moving the gap)
+        TextOffset offset = doc->offsetFromLine(line);
+        TextOffset searchLength = qMax<TextOffset>( 0, doc->lineLength(line)-1 );
+        TextOffset dataOffset = 0;
+        const QChar* data = buf->rangeData( offset, searchLength, storage, dataOffset );
 
         // iterate over all line definitions
         bool found = false;
@@ -145,7 +149,7 @@ static bool areAllLinesCommented( TextDocument* doc, TextRange& range, const QLi
             RegExp* commentStartRegExp = def->commentStartRegExp();
 
             /// toggle the found flag if a comment is found and break
-            if( commentStartRegExp->indexIn( buf->rawDataPointer(), offset, offset+doc->lineLength(line)-1 ) >= 0 ) {
+            if( commentStartRegExp->indexIn( data, static_cast<int>( offset - dataOffset ), static_cast<int>( offset - dataOffset + searchLength ) ) >= 0 ) {
                 found = true;
                 break;
             }
@@ -167,14 +171,18 @@ static void removeLineComment( TextDocument* doc, TextRange& range, const QList<
 {
 //    RegExp regExp( QStringLiteral("^[^\\S\n]*(%1[^\\S\n]?)").arg( RegExp::escape(commentStart.trimmed() ) ) );
     TextBuffer* buf = doc->buffer();
+    QString storage;    // only used when a line spans multiple buffer chunks
 
     // iterate over all lines and build all ranges
     RangeLineIterator itr( doc, range );
     while( itr.hasNext() ) {
 
-        // directly search in the raw data pointer buffer to prevent QString creation
+        // directly search in the buffer data to prevent QString creation (without moving the gap)
         int line = itr.next();
-        int offset = doc->offsetFromLine(line);
+        TextOffset offset = doc->offsetFromLine(line);
+        TextOffset searchLength = doc->lineLength(line);
+        TextOffset dataOffset = 0;
+        const QChar* data = buf->rangeData( offset, searchLength, storage, dataOffset );
 
         // iterate over alll definitions
         foreach( CommentDefinitionItem* def, definitions ) {
@@ -185,10 +193,10 @@ static void removeLineComment( TextDocument* doc, TextRange& range, const QList<
             RegExp* regExp = def->removeCommentStartRegeExp();
 
             // perform a regexp to extract the comment that needs to be removed
-            if( regExp->indexIn( buf->rawDataPointer(), offset, offset + doc->lineLength(line) ) >= 0 ) {
+            if( regExp->indexIn( data, static_cast<int>( offset - dataOffset ), static_cast<int>( offset - dataOffset + searchLength ) ) >= 0 ) {
 
-                // remove the found regexp and goto the next line
-                doc->replace( regExp->pos(1), regExp->len(1), "" );
+                // remove the found regexp and goto the next line (the data pointer is invalid after the change)
+                doc->replace( dataOffset + regExp->pos(1), regExp->len(1), "" );
                 break;
             }
         }
@@ -213,8 +221,8 @@ static void insertLineComments( TextDocument* doc, TextRange& range, const QStri
 
         // directly search in the raw data pointer buffer to prevent QString creation
         int line = itr.next();
-        int offset = doc->offsetFromLine(line);
-        int lineLength = doc->lineLengthWithoutNewline(line);
+        TextOffset offset = doc->offsetFromLine(line);
+        TextOffset lineLength = doc->lineLengthWithoutNewline(line);
 
         // when it's the last line and its blank, we must skip it
         if( !itr.hasNext() && lineLength == 0 ) {
@@ -222,7 +230,7 @@ static void insertLineComments( TextDocument* doc, TextRange& range, const QStri
         }
 
         // when there's no comment found at this line return false
-        int wordStart = buf->findCharPosWithinRangeOrClamp( offset, 1, doc->config()->whitespaces(), false, offset, offset + lineLength );
+        TextOffset wordStart = buf->findCharPosWithinRangeOrClamp( offset, 1, doc->config()->whitespaces(), false, offset, offset + lineLength );
         doc->replace(wordStart,0,str);
 
     }
@@ -244,7 +252,7 @@ static bool removeBlockComment( TextEditorController* controller, TextRange& ran
     TextScope* blockCommentScope = Edbee::instance()->scopeManager()->refTextScope("comment.block");
 
     // we only fetch multi-line scoped textranges
-    int middleRange= range.min()+(range.max()-range.min())/2;
+    TextOffset middleRange= range.min()+(range.max()-range.min())/2;
 
     // With this uberdirty for loop, we also check if there's a commentscope
     // 1 character to the left. (this is required to fix the uncommnt block issue when the caret is next to the comment :)
@@ -257,8 +265,8 @@ static bool removeBlockComment( TextEditorController* controller, TextRange& ran
 
             // did we found a block comment
             if( scope->startsWith( blockCommentScope ) ){
-                int min = scopedRange->min();
-                int max = scopedRange->max();
+                TextOffset min = scopedRange->min();
+                TextOffset max = scopedRange->max();
 
                 // check all 'block' comments
                 foreach( CommentDefinitionItem* def, definitions)  {
@@ -303,13 +311,13 @@ static bool removeBlockComment( TextEditorController* controller, TextRange& ran
 /// @param commentStart the start of the comment
 /// @param commentEnd the end of the comment
 /// @return the last affected range
-static int insertBlockComment( TextEditorController* controller, TextRange& range, const QString& commentStart, const QString& commentEnd )
+static TextOffset insertBlockComment( TextEditorController* controller, TextRange& range, const QString& commentStart, const QString& commentEnd )
 {
     TextDocument* doc = controller->textDocument();
 
     // for safety I don't use the range anymore. It's adjusted automatically, but could in theory vanish
-    int min = range.min();
-    int max = range.max();
+    TextOffset min = range.min();
+    TextOffset max = range.max();
 
     // when the range is 'blank' expand it to a full line
     if( range.isEmpty() ) {
@@ -368,7 +376,7 @@ static bool getCommentDefinitions( TextEditorController* controller, TextRange&
 /// @param controller the controller that conatins the controller
 /// @param range the range to comment
 /// @return the last affected offset
-static int commentRange( TextEditorController* controller, TextRange& range, bool block )
+static TextOffset commentRange( TextEditorController* controller, TextRange& range, bool block )
 {
     CommentDefinition defs;
     // retrieve all comment definitions
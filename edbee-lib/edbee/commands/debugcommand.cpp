@@ -89,9 +89,9 @@ void DebugCommand::dumpCharacterCodes(TextEditorController *controller)
     QString line;
 
     // iterate over the characters
-    int start = qMax(range.caret() - count, 0);
-    int end = qMin(range.caret() + count, controller->textDocument()->length()-1 );
-    for( int i=start; i<=end; ++i ) {
+    TextOffset start = qMax<TextOffset>(range.caret() - count, 0);
+    TextOffset end = qMin<TextOffset>(range.caret() + count, controller->textDocument()->length()-1 );
+    for( TextOffset i=start; i<=end; ++i ) {
         QChar c = controller->textDocument()->charAt(i);
         if( i == range.caret() ) {
             line.append("| ");
@@ -31,8 +31,8 @@ static void calculateNewSelectionRanges( TextDocument* doc, TextRangeSet& newCar
 {
     for( int i=0,cnt=newCaretSelection.rangeCount(); i<cnt; ++i) {
         TextRange& range = newCaretSelection.range(i);
-        int& min = range.minVar();
-        int& max = range.maxVar();
+        TextOffset& min = range.minVar();
+        TextOffset& max = range.maxVar();
 
         if( direction < 0 ) {
             int line = doc->lineFromOffset(min);
@@ -56,10 +56,10 @@ void updateNewCaretSelectionForMove( TextDocument* doc, TextRangeSet& newCaretSe
     for( int i=0, cnt=newCaretSelection.rangeCount(); i<cnt; ++i ) {
         TextRange& newRange = newCaretSelection.range(i);
         if( movedRange.min() <= newRange.min() && newRange.max() <= movedRange.max() ) {
-            int min = movedRange.min();
-            int max = movedRange.max();
+            TextOffset min = movedRange.min();
+            TextOffset max = movedRange.max();
 
-            int delta=0;
+            TextOffset delta=0;
             if( direction < 0 ) {
                 int line = doc->lineFromOffset(min);
                 delta = - doc->lineLength(line-1);
@@ -88,10 +88,10 @@ void MoveLineCommand::execute(TextEditorController *controller)
 
     // because of the full-line expansion, we can assume that 0 means at the first line
     // moving up on the first line is impossible
-    int firstOffset = moveRangeSet.firstRange().minVar();
+    TextOffset firstOffset = moveRangeSet.firstRange().minVar();
     if( firstOffset + direction_ <= 0 ) return;
 
-    int lastOffset = moveRangeSet.lastRange().maxVar();
+    TextOffset lastOffset = moveRangeSet.lastRange().maxVar();
     if( lastOffset + direction_ > doc->length() ) return;
 
     // Calculate the new caret positions
@@ -36,13 +36,13 @@ QString NewlineCommand::calculateSmartIndent(TextEditorController* controller, T
     TextEditorConfig* config = doc->config();
 
     // find the line column position
-    int caretOffset = range.min();
+    TextOffset caretOffset = range.min();
     int line = doc->lineFromOffset( range.min() );
-    int startOffset = doc->offsetFromLine(line);
-    int endOffset = qMin( caretOffset ,doc->offsetFromLine(line+1)-1 );
+    TextOffset startOffset = doc->offsetFromLine(line);
+    TextOffset endOffset = qMin( caretOffset ,doc->offsetFromLine(line+1)-1 );
 
     // searches for the start of the current line
-    int charPos = buf->findCharPosWithinRangeOrClamp( startOffset, 1, config->whitespaceWithoutNewline(), false, startOffset, endOffset );
+    TextOffset charPos = buf->findCharPosWithinRangeOrClamp( startOffset, 1, config->whitespaceWithoutNewline(), false, startOffset, endOffset );
 
     // when the start is found
     if( charPos > startOffset ) {
@@ -128,13 +128,13 @@ void NewlineCommand::executeSpecialNewline(TextEditorController* controller, boo
         if( line > lastLine ) {
 
             // create a new range
-            int pos = doc->offsetFromLine(line+lineDelta)-1;
+            TextOffset pos = doc->offsetFromLine(line+lineDelta)-1;
             TextRange newRange( pos, pos );
 
             QString text = QStringLiteral("\n%1").arg( smart ? calculateSmartIndent( controller, newRange ) : "" );
 
             // replaces the text
-            doc->replace( qMax(0,newRange.caret()), 0, text );
+            doc->replace( qMax<TextOffset>(0,newRange.caret()), 0, text );
             newRange.setCaret( pos +text.length()  );
             newRange.reset();
 
@@ -42,18 +42,18 @@ int RemoveCommand::coalesceId() const
 /// @param caret the current caret position
 ///
 /// @return the new caret position
-int RemoveCommand::smartBackspace(TextDocument* doc, int caret )
+TextOffset RemoveCommand::smartBackspace(TextDocument* doc, TextOffset caret )
 {
     TextBuffer* buf = doc->buffer();
     TextEditorConfig* config = doc->config();
 
     // find the line column position
     int line = doc->lineFromOffset( caret );
-    int lineStartOffset = doc->offsetFromLine(line);
-    int lineEndOffset = qMin( caret,doc->offsetFromLine(line+1)-1 );
+    TextOffset lineStartOffset = doc->offsetFromLine(line);
+    TextOffset lineEndOffset = qMin( caret,doc->offsetFromLine(line+1)-1 );
 
     // searches for the start of the current line
-    int firstNoneWhitespaceCharPos = buf->findCharPosWithinRangeOrClamp( lineStartOffset, 1, config->whitespaceWithoutNewline(), false, lineStartOffset, lineEndOffset );
+    TextOffset firstNoneWhitespaceCharPos = buf->findCharPosWithinRangeOrClamp( lineStartOffset, 1, config->whitespaceWithoutNewline(), false, lineStartOffset, lineEndOffset );
 
     // only when the caret if before a characer
     if( caret <= firstNoneWhitespaceCharPos && lineStartOffset < firstNoneWhitespaceCharPos ) {
@@ -64,16 +64,16 @@ int RemoveCommand::smartBackspace(TextDocument* doc, int caret )
 
 
         // when we're exactly at a columnOffset, we need to get the previous
-        int lastColumnOffset = lineColumnOffsets.last() + lineStartOffset;
+        TextOffset lastColumnOffset = lineColumnOffsets.last() + lineStartOffset;
         if( lastColumnOffset == caret) {
             lastColumnOffset = lineStartOffset + ( lineColumnOffsets.size() > 1 ?  lineColumnOffsets.at( lineColumnOffsets.size()-2 ): 0 );
         }
 
         // we need to got the given number of characters
-        return qMax( 0, caret - ( caret - lastColumnOffset ) );
+        return qMax<TextOffset>( 0, caret - ( caret - lastColumnOffset ) );
 
     }
-    return qMax( 0, caret-1 );
+    return qMax<TextOffset>( 0, caret-1 );
 }
 
 
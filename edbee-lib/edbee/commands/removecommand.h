@@ -42,7 +42,7 @@ public:
     RemoveCommand( int removeMode, int direction );
 
     int coalesceId() const;
-    int smartBackspace( TextDocument* doc, int caret );
+    TextOffset smartBackspace( TextDocument* doc, TextOffset caret );
 
     void rangesForRemoveChar( TextEditorController* controller, TextRangeSet* ranges );
     void rangesForRemoveWord( TextEditorController* controller, TextRangeSet* ranges );
@@ -0,0 +1,533 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textdocumentcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+
+#include "edbee/io/textdocumentserializer.h"
+#include "edbee/models/textdocument.h"
+#include "edbee/models/textdocumentscopes.h"
+#include "edbee/models/textgrammar.h"
+#include "edbee/util/lineending.h"
+#include "edbee/util/regexp.h"
+#include "edbee/util/textcodec.h"
+#include "edbee/edbee.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// The magic number at the start of a cache entry ("EDBC")
+static const quint32 CacheMagic = 0x45444243;
+
+/// The version of the format of the cache entries. Increase it when the format changes
+static const quint32 CacheVersion = 1;
+
+/// The size of the blocks at the start and the end of a file that are used for the content hash
+static const qint64 HashEdgeSize = 64 * 1024;
+
+/// The number of blocks between the start and the end of a file that are used for the content hash
+static const int HashSampleCount = 16;
+
+/// The size of the blocks between the start and the end of a file that are used for the content hash
+static const qint64 HashSampleSize = 4 * 1024;
+
+
+/// The data of a cache entry (after the key)
+class TextDocumentCacheEntry {
+public:
+    TextDocumentCacheEntry() : lineEnding(0), textLength(0) {}
+
+    QString encoding;               ///< The name of the encoding
+    qint32 lineEnding;              ///< The type of the line ending
+    qint64 textLength;              ///< The length of the text
+    QByteArray lineOffsets;         ///< The line count and the differences between the line offsets (variable length numbers)
+    QString grammarName;            ///< The grammar of the document
+    QStringList grammarNames;       ///< The grammars of the rules of the multi-line ranges
+    QVector<qint32> ruleCounts;     ///< The number of rules of these grammars (a changed grammar can't be used)
+    QStringList scopeNames;         ///< The names of the scopes
+    QStringList endRegExps;         ///< The end regexps of the multi-line ranges
+    QByteArray scopes;              ///< The scoped ranges, with indices of the lists above (variable length numbers)
+};
+
+
+/// Reads the variable length numbers of the data of a cache entry.
+/// After reading an invalid number the reader is invalid and returns 0
+class TextDocumentCacheReader {
+public:
+    TextDocumentCacheReader( const QByteArray& data )
+        : pos_( reinterpret_cast<const uchar*>( data.constData() ) )
+        , end_( pos_ + data.size() )
+        , valid_( true )
+    {
+    }
+
+    /// Reads the next number, which must be smaller than the given limit
+    qint64 read( qint64 limit )
+    {
+        quint64 result = 0;
+        for( int shift=0; shift < 64 && pos_ < end_; shift += 7 ) {
+            uchar c = *pos_++;
+            result |= static_cast<quint64>( c & 0x7f ) << shift;
+            if( !(c & 0x80) ) {
+                if( result < static_cast<quint64>( limit ) ) { return static_cast<qint64>( result ); }
+                break;
+            }
+        }
+        valid_ = false;
+        return 0;
+    }
+
+    void invalidate() { valid_ = false; }
+    bool isValid() const { return valid_; }
+    bool atEnd() const { return pos_ == end_; }
+
+private:
+    const uchar* pos_;      ///< The current position
+    const uchar* end_;      ///< The end of the data
+    bool valid_;            ///< Are all read numbers valid?
+};
+
+
+/// Appends the given number as a variable length number (7 bits per byte)
+static void writeNumber( QByteArray& data, quint64 value )
+{
+    while( value >= 0x80 ) {
+        data.append( static_cast<char>( ( value & 0x7f ) | 0x80 ) );
+        value >>= 7;
+    }
+    data.append( static_cast<char>( value ) );
+}
+
+
+/// Returns the index of the given scope in the list with names, the scope is appended when it isn't in the list
+static int scopeIndex( TextScope* scope, QHash<TextScope*,int>& indices, QStringList& names )
+{
+    QHash<TextScope*,int>::const_iterator itr = indices.constFind( scope );
+    if( itr != indices.constEnd() ) { return itr.value(); }
+    indices.insert( scope, names.size() );
+    names.append( scope->name() );
+    return names.size() - 1;
+}
+
+
+/// Decodes the line offsets of a cache entry
+/// @param data the line count and the differences between the line offsets
+/// @param textLength the length of the text
+/// @param lineOffsets (out) the offsets of the characters after the newlines
+/// @return false if the data is invalid
+static bool decodeLineOffsets( const QByteArray& data, qint64 textLength, QVector<TextOffset>& lineOffsets )
+{
+    TextDocumentCacheReader reader( data );
+    int count = static_cast<int>( reader.read( qMin( textLength, static_cast<qint64>( data.size() ) ) + 1 ) );
+    lineOffsets.reserve( count );
+    qint64 offset = 0;
+    for( int i=0; i < count && reader.isValid(); ++i ) {
+        offset += reader.read( textLength - offset + 1 );
+        lineOffsets.append( static_cast<TextOffset>( offset ) );
+    }
+    return reader.isValid() && reader.atEnd();
+}
+
+
+/// Constructs the cache
+/// @param path the directory for the cache entries (it's created when an entry is stored)
+TextDocumentCache::TextDocumentCache(const QString& path)
+    : path_(path)
+    , restored_(false)
+{
+}
+
+
+/// Returns the directory with the cache entries
+QString TextDocumentCache::path() const
+{
+    return path_;
+}
+
+
+/// Returns the name of the cache entry of the given file
+/// @param fileName the file of the document
+QString TextDocumentCache::entryFileName(const QString& fileName) const
+{
+    QByteArray key = QCryptographicHash::hash( QFileInfo( fileName ).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1 );
+    return QDir( path_ ).filePath( QString::fromLatin1( key.toHex() ) + QStringLiteral(".edbeecache") );
+}
+
+
+/// Loads the given file in the (empty) document with a TextDocumentSerializer.
+/// When the cache has a valid entry for the file, the encoding and line offsets of the entry are used and the
+/// scopes are restored afterwards (with the grammar of the cached document). See isRestored.
+/// An invalid or outdated cache entry is ignored, the file is loaded without the cache then
+/// @param document the document to load the file in
+/// @param fileName the file to load
+/// @return false if the file couldn't be loaded (see errorString)
+bool TextDocumentCache::load(TextDocument* document, const QString& fileName)
+{
+    restored_ = false;
+    errorString_.clear();
+
+    TextDocumentCacheEntry entry;
+    QVector<TextOffset> lineOffsets;
+    bool valid = document->length() == 0 && readEntry( fileName, entry ) && decodeLineOffsets( entry.lineOffsets, entry.textLength, lineOffsets );
+
+    TextDocumentSerializer serializer( document );
+    if( valid ) {
+        serializer.setKnownEncoding( Edbee::instance()->codecManager()->codecForName( entry.encoding ) );
+        serializer.setKnownLineOffsets( lineOffsets, static_cast<TextOffset>( entry.textLength ) );
+    }
+    QFile file( fileName );
+    if( !serializer.load( &file ) ) {
+        errorString_ = serializer.errorString();
+        return false;
+    }
+
+    // the file can be changed after reading the entry (a changed text with the same length has other newlines)
+    if( valid && document->length() == entry.textLength && !serializer.knownLineOffsetsRejected() ) {
+        document->setLineEnding( LineEnding::get( entry.lineEnding ) );
+        restoreScopes( document, entry );
+        restored_ = true;
+    }
+    return true;
+}
+
+
+/// Stores the cache entry for the given document, which must be identical to the given file (for example
+/// directly after loading or saving it). An existing entry is replaced
+/// @param document the document with the text of the file
+/// @param fileName the file of the document
+/// @return false if the entry couldn't be stored (see errorString)
+bool TextDocumentCache::store(TextDocument* document, const QString& fileName)
+{
+    errorString_.clear();
+    QFileInfo info( fileName );
+    if( !info.exists() ) {
+        errorString_ = QObject::tr("The file doesn't exist");
+        return false;
+    }
+    if( !QDir().mkpath( path_ ) ) {
+        errorString_ = QObject::tr("The cache directory can't be created");
+        return false;
+    }
+
+    QSaveFile file( entryFileName( fileName ) );
+    if( !file.open( QIODevice::WriteOnly ) ) {
+        errorString_ = file.errorString();
+        return false;
+    }
+
+    // the line offsets are stored as the differences between the offsets, which are small numbers
+    QByteArray lineOffsets;
+    int lineCount = document->lineCount();
+    writeNumber( lineOffsets, lineCount - 1 );
+    TextOffset lastOffset = 0;
+    for( int line=1; line < lineCount; ++line ) {
+        TextOffset offset = document->offsetFromLine( line );
+        writeNumber( lineOffsets, offset - lastOffset );
+        lastOffset = offset;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream << CacheMagic << CacheVersion;
+    stream << info.absoluteFilePath() << static_cast<qint64>( info.size() ) << info.lastModified().toMSecsSinceEpoch() << contentHash( fileName );
+    stream << ( document->encoding() ? document->encoding()->name() : QString() );
+    stream << static_cast<qint32>( document->lineEnding() ? document->lineEnding()->type() : LineEnding::UnixType );
+    stream << static_cast<qint64>( document->length() ) << lineOffsets;
+    writeScopes( stream, document );
+
+    if( stream.status() != QDataStream::Ok || !file.commit() ) {
+        errorString_ = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+
+/// Removes the cache entry of the given file
+/// @param fileName the file of the document
+/// @return true if the entry is removed
+bool TextDocumentCache::remove(const QString& fileName)
+{
+    return QFile::remove( entryFileName( fileName ) );
+}
+
+
+/// Returns true if the last loaded document is restored from the cache
+bool TextDocumentCache::isRestored() const
+{
+    return restored_;
+}
+
+
+/// Returns the last error
+QString TextDocumentCache::errorString() const
+{
+    return errorString_;
+}
+
+
+/// Calculates the hash of the content of the given file. For large files only samples are used:
+/// the first and last 64 KB and 16 blocks of 4 KB spread over the file.
+/// @param fileName the file to calculate the hash for
+/// @return the SHA-1 hash (empty if the file can't be read)
+QByteArray TextDocumentCache::contentHash(const QString& fileName)
+{
+    QFile file( fileName );
+    if( !file.open( QIODevice::ReadOnly ) ) { return QByteArray(); }
+
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    qint64 size = file.size();
+    if( size <= 2 * HashEdgeSize + HashSampleCount * HashSampleSize ) {
+        hash.addData( file.readAll() );
+    } else {
+        hash.addData( file.read( HashEdgeSize ) );
+        for( int i=1; i <= HashSampleCount; ++i ) {
+            file.seek( size / ( HashSampleCount + 1 ) * i );
+            hash.addData( file.read( HashSampleSize ) );
+        }
+        file.seek( size - HashEdgeSize );
+        hash.addData( file.read( HashEdgeSize ) );
+    }
+    return hash.result();
+}
+
+
+/// Reads the cache entry of the given file. The entry is only read when it's valid for the current file
+/// @param fileName the file of the document
+/// @param entry (out) the data of the entry
+/// @return false if there's no valid entry
+bool TextDocumentCache::readEntry(const QString& fileName, TextDocumentCacheEntry& entry)
+{
+    QFile file( entryFileName( fileName ) );
+    if( !file.open( QIODevice::ReadOnly ) ) { return false; }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if( magic != CacheMagic || version != CacheVersion ) { return false; }
+
+    // the key, the entry must belong to the same unchanged file
+    QFileInfo info( fileName );
+    QString path;
+    qint64 size = 0, modified = 0;
+    QByteArray hash;
+    stream >> path >> size >> modified >> hash;
+    if( stream.status() != QDataStream::Ok || path != info.absoluteFilePath() || size != info.size()
+            || modified != info.lastModified().toMSecsSinceEpoch() || hash != contentHash( fileName ) ) {
+        return false;
+    }
+
+    stream >> entry.encoding >> entry.lineEnding >> entry.textLength >> entry.lineOffsets;
+    stream >> entry.grammarName >> entry.grammarNames >> entry.ruleCounts >> entry.scopeNames >> entry.endRegExps >> entry.scopes;
+    return stream.status() == QDataStream::Ok && 0 <= entry.lineEnding && entry.lineEnding < LineEnding::typeCount() && entry.textLength >= 0;
+}
+
+
+/// Writes the scopes of the given document.
+/// The multi-line ranges are stored with the index of their grammar rule (see TextGrammar::rules). The ranges
+/// of the lines refer to the multi-line ranges by index (0 is a single line range, 1 the default range of the
+/// document and 2 the first multi-line range).
+/// @param stream the stream to write to
+/// @param document the document with the scopes
+void TextDocumentCache::writeScopes(QDataStream& stream, TextDocument* document)
+{
+    TextDocumentCacheEntry entry;
+    TextGrammar* grammar = document->languageGrammar();
+    TextDocumentScopes* scopes = document->scopes();
+    if( grammar ) { entry.grammarName = grammar->name(); }
+
+    QHash<TextScope*,int> scopeIndices;
+    QHash<TextGrammar*,int> grammarIndices;
+    QHash<TextGrammarRule*,int> ruleIndices;
+    QHash<MultiLineScopedTextRange*,int> rangeIndices;
+    rangeIndices.insert( &scopes->defaultScopedRange(), 1 );
+
+    // the multi-line ranges
+    writeNumber( entry.scopes, scopes->lastScopedOffset() );
+    int rangeCount = scopes->multiLineScopedRangeCount();
+    writeNumber( entry.scopes, rangeCount );
+    for( int i=0; i < rangeCount; ++i ) {
+        MultiLineScopedTextRange& range = scopes->multiLineScopedRange(i);
+        TextGrammarRule* rule = range.grammarRule();
+        Q_ASSERT(rule);
+        TextGrammar* ruleGrammar = rule->grammar();
+        if( !grammarIndices.contains( ruleGrammar ) ) {
+            QList<TextGrammarRule*> rules = ruleGrammar->rules();
+            for( int ruleIdx=0; ruleIdx < rules.size(); ++ruleIdx ) {
+                ruleIndices.insert( rules.at(ruleIdx), ruleIdx );
+            }
+            grammarIndices.insert( ruleGrammar, entry.grammarNames.size() );
+            entry.grammarNames.append( ruleGrammar->name() );
+            entry.ruleCounts.append( rules.size() );
+        }
+        rangeIndices.insert( &range, i + 2 );
+
+        writeNumber( entry.scopes, range.anchor() );
+        writeNumber( entry.scopes, range.caret() );
+        writeNumber( entry.scopes, scopeIndex( range.scope(), scopeIndices, entry.scopeNames ) );
+        writeNumber( entry.scopes, grammarIndices.value( ruleGrammar ) );
+        writeNumber( entry.scopes, ruleIndices.value( rule ) );
+        if( range.endRegExp() ) {
+            entry.endRegExps.append( range.endRegExp()->pattern() );
+            writeNumber( entry.scopes, entry.endRegExps.size() );
+        } else {
+            writeNumber( entry.scopes, 0 );
+        }
+    }
+
+    // the ranges of the lexed lines (0 for a line without ranges, else the number of ranges + 1)
+    int lineCount = qMin( scopes->scopedLineCount(), document->lineCount() );
+    writeNumber( entry.scopes, lineCount );
+    for( int line=0; line < lineCount; ++line ) {
+        ScopedTextRangeList* list = scopes->scopedRangesAtLine( line );
+        if( !list ) {
+            writeNumber( entry.scopes, 0 );
+            continue;
+        }
+        writeNumber( entry.scopes, list->size() + 1 );
+        writeNumber( entry.scopes, list->isIndependent() ? 1 : 0 );
+        for( int idx=0, cnt=list->size(); idx < cnt; ++idx ) {
+            ScopedTextRange* range = list->at(idx);
+            int rangeIndex = rangeIndices.value( range->multiLineScopedTextRange(), 0 );
+            writeNumber( entry.scopes, rangeIndex );
+            writeNumber( entry.scopes, range->anchor() );
+            writeNumber( entry.scopes, range->caret() );
+            if( !rangeIndex ) {
+                writeNumber( entry.scopes, scopeIndex( range->scope(), scopeIndices, entry.scopeNames ) );
+            }
+        }
+    }
+
+    stream << entry.grammarName << entry.grammarNames << entry.ruleCounts << entry.scopeNames << entry.endRegExps << entry.scopes;
+}
+
+
+/// Restores the scopes of the cache entry in the document. The grammar of the document is set to the
+/// grammar of the cached document. Nothing is restored when a grammar is missing or changed.
+/// @param document the loaded document
+/// @param entry the cache entry
+/// @return true if the scopes are restored
+bool TextDocumentCache::restoreScopes(TextDocument* document, const TextDocumentCacheEntry& entry)
+{
+    // the rules are referred to by index, so the grammars must be unchanged
+    TextGrammarManager* grammarManager = Edbee::instance()->grammarManager();
+    TextGrammar* grammar = grammarManager->get( entry.grammarName );
+    if( !grammar || entry.grammarNames.size() != entry.ruleCounts.size() ) { return false; }
+    QVector< QList<TextGrammarRule*> > grammarRules;
+    for( int i=0; i < entry.grammarNames.size(); ++i ) {
+        TextGrammar* ruleGrammar = grammarManager->get( entry.grammarNames.at(i) );
+        if( !ruleGrammar ) { return false; }
+        grammarRules.append( ruleGrammar->rules() );
+        if( grammarRules.last().size() != entry.ruleCounts.at(i) ) { return false; }
+    }
+    QVector<TextScope*> scopeRefs;
+    foreach( const QString& name, entry.scopeNames ) {
+        scopeRefs.append( Edbee::instance()->scopeManager()->refTextScope( name ) );
+    }
+
+    if( document->languageGrammar() != grammar ) { document->setLanguageGrammar( grammar ); }
+    TextDocumentScopes* scopes = document->scopes();
+    TextOffset length = document->length();
+    qint64 countLimit = entry.scopes.size() + 1;
+
+    // the multi-line ranges
+    TextDocumentCacheReader reader( entry.scopes );
+    TextOffset lastScopedOffset = static_cast<TextOffset>( reader.read( length + 1 ) );
+    QVector<MultiLineScopedTextRange*> ranges;
+    int rangeCount = static_cast<int>( reader.read( countLimit ) );
+    for( int i=0; i < rangeCount && reader.isValid(); ++i ) {
+        TextOffset anchor = static_cast<TextOffset>( reader.read( length + 1 ) );
+        TextOffset caret = static_cast<TextOffset>( reader.read( length + 1 ) );
+        TextScope* scope = scopeRefs.value( static_cast<int>( reader.read( scopeRefs.size() ) ) );
+        QList<TextGrammarRule*> rules = grammarRules.value( static_cast<int>( reader.read( grammarRules.size() ) ) );
+        TextGrammarRule* rule = rules.value( static_cast<int>( reader.read( rules.size() ) ) );
+        int endRegExpIndex = static_cast<int>( reader.read( entry.endRegExps.size() + 1 ) );
+        if( !reader.isValid() || rule->scopeName() != scope->name() ) {
+            reader.invalidate();
+            break;
+        }
+
+        MultiLineScopedTextRange* range = new MultiLineScopedTextRange( anchor, caret, scope );
+        range->setGrammarRule( rule );
+        if( endRegExpIndex ) { range->giveEndRegExp( new RegExp( entry.endRegExps.at( endRegExpIndex - 1 ) ) ); }
+        ranges.append( range );
+    }
+
+    // the ranges of the lines
+    QVector<ScopedTextRangeList*> lines;
+    int lineCount = reader.isValid() ? static_cast<int>( reader.read( document->lineCount() + 1 ) ) : 0;
+    for( int line=0; line < lineCount && reader.isValid(); ++line ) {
+        int listSize = static_cast<int>( reader.read( countLimit ) );
+        if( !listSize ) {
+            lines.append( 0 );
+            continue;
+        }
+        ScopedTextRangeList* list = new ScopedTextRangeList();
+        lines.append( list );
+        list->setIndependent( reader.read( 2 ) != 0 );
+        for( int idx=1; idx < listSize && reader.isValid(); ++idx ) {
+            int rangeIndex = static_cast<int>( reader.read( ranges.size() + 2 ) );
+            TextOffset anchor = static_cast<TextOffset>( reader.read( length + 1 ) );
+            TextOffset caret = static_cast<TextOffset>( reader.read( length + 1 ) );
+            if( !rangeIndex ) {
+                TextScope* scope = scopeRefs.value( static_cast<int>( reader.read( scopeRefs.size() ) ) );
+                if( reader.isValid() ) { list->giveRange( new ScopedTextRange( anchor, caret, scope ) ); }
+            } else if( reader.isValid() ) {
+                MultiLineScopedTextRange* multiRange = rangeIndex == 1 ? &scopes->defaultScopedRange() : ranges.at( rangeIndex - 2 );
+                MultiLineScopedTextRangeReference* range = new MultiLineScopedTextRangeReference( *multiRange );
+                range->setAnchor( anchor );
+                range->setCaret( caret );
+                list->giveRange( range );
+            }
+        }
+        list->squeeze();
+    }
+
+    if( !reader.isValid() || !reader.atEnd() ) {
+        qDeleteAll( lines );
+        qDeleteAll( ranges );
+        return false;
+    }
+
+    // the lexer state at the end of a line (the active multi-line ranges) are the references at the start of the next line
+    QVector<MultiLineScopedTextRange*> previousState;
+    for( int line=0; line+1 < lines.size(); ++line ) {
+        ScopedTextRangeList* list = lines.at(line);
+        ScopedTextRangeList* nextList = lines.at(line+1);
+        if( !list || !nextList ) { continue; }
+        QVector<MultiLineScopedTextRange*> state;
+        for( int idx=0; idx < nextList->size() && nextList->at(idx)->multiLineScopedTextRange(); ++idx ) {
+            state.append( nextList->at(idx)->multiLineScopedTextRange() );
+        }
+        if( state == previousState ) { state = previousState; }    // share the state with the previous line
+        list->setEndState( state );
+        previousState = state;
+    }
+
+    // replace the scopes of the document, the lexer continues after the last scoped offset.
+    // (removing the scopes keeps the ranges of the first line, these are always replaced)
+    scopes->removeScopesAfterOffset( 0 );
+    foreach( MultiLineScopedTextRange* range, ranges ) {
+        scopes->giveMultiLineScopedTextRange( range );
+    }
+    for( int line=0, cnt=qMax( lines.size(), 1 ); line < cnt; ++line ) {
+        scopes->giveLineScopedRangeList( line, lines.value( line ) );
+    }
+    scopes->setLastScopedOffset( lastScopedOffset );
+    return true;
+}
+
+
+} // edbee
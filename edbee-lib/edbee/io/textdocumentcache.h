@@ -0,0 +1,63 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QByteArray>
+#include <QString>
+
+class QDataStream;
+
+namespace edbee {
+
+class TextDocument;
+class TextDocumentCacheEntry;
+
+
+/// A persistent (on-disk) cache for large documents that are opened again.
+///
+/// For every file the cache stores the encoding, the line ending, the line offsets and the lexed scopes:
+/// the multi-line scoped ranges (the state of the lexer, which makes it possible to continue lexing) and
+/// the scoped ranges of the lexed lines. When an unchanged file is loaded again, the encoding isn't detected,
+/// the text isn't searched for newlines and the scopes are restored. The lexer continues after the last
+/// lexed offset, so only the part that wasn't lexed before is lexed.
+///
+/// An entry is only used for the file with the same path, size, modification time and content hash.
+/// The content hash is calculated with samples of the file, so a large file isn't read to calculate it.
+/// The entries are stored in a versioned binary format, entries of another version are ignored.
+///
+/// @code
+/// TextDocumentCache cache( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) );
+/// cache.load( document, fileName );
+/// ...
+/// cache.store( document, fileName );  // for example when the (unmodified or saved) document is closed
+/// @endcode
+class EDBEE_EXPORT TextDocumentCache {
+public:
+    TextDocumentCache( const QString& path );
+
+    QString path() const;
+    QString entryFileName( const QString& fileName ) const;
+
+    bool load( TextDocument* document, const QString& fileName );
+    bool store( TextDocument* document, const QString& fileName );
+    bool remove( const QString& fileName );
+
+    bool isRestored() const;
+    QString errorString() const;
+
+    static QByteArray contentHash( const QString& fileName );
+
+private:
+    bool readEntry( const QString& fileName, TextDocumentCacheEntry& entry );
+    void writeScopes( QDataStream& stream, TextDocument* document );
+    bool restoreScopes( TextDocument* document, const TextDocumentCacheEntry& entry );
+
+    QString path_;                  ///< The directory with the cache entries
+    bool restored_;                 ///< Was the last loaded document restored from the cache?
+    QString errorString_;           ///< The last error
+};
+
+} // edbee
@@ -0,0 +1,264 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textdocumentfollower.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+
+#include "edbee/models/textdocument.h"
+#include "edbee/util/textcodec.h"
+#include "edbee/util/textcodecdetector.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// The number of bytes that's read at once
+static const int ReadBlockSize = 1024 * 1024;
+
+/// When the lines are removed, 1/TrimLineDivisor of the maximum line count is removed extra.
+/// Removing the first lines moves the complete text, so this shouldn't happen for every appended block
+static const int TrimLineDivisor = 16;
+
+
+/// Constructs the follower for the given document
+/// @param document the document to append the text to
+/// @param parent the parent of this object
+TextDocumentFollower::TextDocumentFollower(TextDocument* document, QObject* parent)
+    : QObject(parent)
+    , documentRef_(document)
+    , watcher_(nullptr)
+    , decoder_(nullptr)
+    , position_(0)
+    , pendingCarriageReturn_(false)
+    , maxLineCount_(0)
+{
+}
+
+
+/// The destructor stops following the file
+TextDocumentFollower::~TextDocumentFollower()
+{
+    stop();
+}
+
+
+/// Starts following the given file. The bytes after the given position are appended to the document
+/// (with the encoding of the document), now and every time the file grows.
+/// @param fileName the file to follow
+/// @param position the position of the first byte to append. -1 is the current end of the file
+/// @return false if the file doesn't exist (see errorString)
+bool TextDocumentFollower::follow(const QString& fileName, qint64 position)
+{
+    stop();
+    QFileInfo info( fileName );
+    if( !info.exists() ) {
+        errorString_ = tr("The file doesn't exist");
+        return false;
+    }
+
+    fileName_ = info.absoluteFilePath();
+    position_ = position < 0 ? info.size() : position;
+    errorString_.clear();
+
+    TextCodec* codec = documentRef_ ? documentRef_->encoding() : nullptr;
+    decoder_ = new TextDecoder( codec ? codec : TextCodecDetector::globalPreferedCodec() );
+    pendingCarriageReturn_ = false;
+
+    // the directory is watched to notice a replaced (rotated) file
+    watcher_ = new QFileSystemWatcher( this );
+    connect( watcher_, SIGNAL(fileChanged(QString)), SLOT(fileChanged(QString)) );
+    connect( watcher_, SIGNAL(directoryChanged(QString)), SLOT(directoryChanged(QString)) );
+    watcher_->addPath( fileName_ );
+    watcher_->addPath( info.absolutePath() );
+
+    readAppendedData();
+    return true;
+}
+
+
+/// Stops following the file. A \r that's kept for joining a \r\n line ending is appended to the document
+void TextDocumentFollower::stop()
+{
+    flushPendingCarriageReturn();
+    delete watcher_;
+    watcher_ = nullptr;
+    delete decoder_;
+    decoder_ = nullptr;
+}
+
+
+/// Returns true if a file is followed
+bool TextDocumentFollower::isFollowing() const
+{
+    return decoder_ != nullptr;
+}
+
+
+/// Returns the document the text is appended to
+TextDocument* TextDocumentFollower::document() const
+{
+    return documentRef_;
+}
+
+
+/// Returns the followed file (the absolute path)
+QString TextDocumentFollower::fileName() const
+{
+    return fileName_;
+}
+
+
+/// Returns the position in the file of the first byte that isn't appended yet
+qint64 TextDocumentFollower::position() const
+{
+    return position_;
+}
+
+
+/// Returns the last error
+QString TextDocumentFollower::errorString() const
+{
+    return errorString_;
+}
+
+
+/// Sets the maximum number of lines of the document. When the document has more lines the first lines are removed.
+/// To prevent removing lines for every appended block, some extra lines are removed (1/16 of the maximum).
+/// @param count the maximum number of lines (0 is unlimited)
+void TextDocumentFollower::setMaxLineCount(int count)
+{
+    maxLineCount_ = qMax( count, 0 );
+    if( documentRef_ ) { removeExcessLines(); }
+}
+
+
+/// Returns the maximum number of lines of the document (0 is unlimited)
+int TextDocumentFollower::maxLineCount() const
+{
+    return maxLineCount_;
+}
+
+
+/// Reads the bytes that are appended to the file and appends them to the document.
+/// When the file is smaller than the current position (truncated), the file is followed from the start.
+/// This method is called when the file changes, it can be called with a timer for file systems without notifications.
+void TextDocumentFollower::readAppendedData()
+{
+    if( !isFollowing() || !documentRef_ ) { return; }
+
+    QFile file( fileName_ );
+    if( !file.open( QIODevice::ReadOnly ) ) {
+        errorString_ = file.errorString();
+        return;
+    }
+    if( file.size() < position_ ) { restart(); }
+    if( file.size() == position_ ) { return; }
+    if( !file.seek( position_ ) ) {
+        errorString_ = file.errorString();
+        return;
+    }
+
+    // the excess lines are removed after every block, so the memory stays bounded when a large file is appended
+    QByteArray block( ReadBlockSize, Qt::Uninitialized );
+    qint64 bytesAppended = 0;
+    qint64 bytesRead = 0;
+    while( ( bytesRead = file.read( block.data(), block.size() ) ) > 0 ) {
+        appendData( block.constData(), static_cast<int>( bytesRead ) );
+        removeExcessLines();
+        position_ += bytesRead;
+        bytesAppended += bytesRead;
+    }
+    if( bytesRead < 0 ) { errorString_ = file.errorString(); }
+    if( bytesAppended > 0 ) { emit dataAppended( bytesAppended ); }
+}
+
+
+/// This slot is called when the file is changed or removed
+/// @param path the path of the file
+void TextDocumentFollower::fileChanged(const QString& path)
+{
+    if( !QFile::exists( path ) ) {
+        watcher_->removePath( path );  // the file is watched again when it's recreated (see directoryChanged)
+        return;
+    }
+    readAppendedData();
+}
+
+
+/// This slot is called when the directory of the file is changed. When a removed (rotated) file is created
+/// again, the new file is followed from the start
+/// @param path the path of the directory
+void TextDocumentFollower::directoryChanged(const QString& path)
+{
+    Q_UNUSED(path);
+    if( !documentRef_ ) { return; }
+    if( watcher_->files().contains( fileName_ ) || !QFile::exists( fileName_ ) ) { return; }
+    watcher_->addPath( fileName_ );
+    restart();
+    readAppendedData();
+}
+
+
+/// Follows the file from the start (after a truncated or replaced file).
+/// The decoder is replaced, because an incomplete sequence of the old file doesn't continue in the new file.
+/// A pending \r of the old file is appended, it doesn't join a \n of the new file
+void TextDocumentFollower::restart()
+{
+    flushPendingCarriageReturn();
+    TextCodec* codec = documentRef_->encoding();
+    delete decoder_;
+    decoder_ = new TextDecoder( codec ? codec : TextCodecDetector::globalPreferedCodec() );
+    position_ = 0;
+    emit fileReset();
+}
+
+
+/// Decodes the given bytes and appends the text to the document, without collecting undo data.
+/// An incomplete sequence (and a \r) at the end of the data is kept until the next data
+/// @param data the bytes to append
+/// @param length the number of bytes
+void TextDocumentFollower::appendData(const char* data, int length)
+{
+    QString text = decoder_->toUnicode( data, length );
+    if( pendingCarriageReturn_ ) { text.prepend( QLatin1Char('\r') ); }
+    pendingCarriageReturn_ = text.endsWith( QLatin1Char('\r') );
+    if( pendingCarriageReturn_ ) { text.chop(1); }
+    if( text.contains( QLatin1Char('\r') ) ) { text.replace( QStringLiteral("\r\n"), QStringLiteral("\n") ); }
+    if( text.isEmpty() ) { return; }
+
+    documentRef_->rawAppendBegin();
+    documentRef_->rawAppend( text.constData(), text.length() );
+    documentRef_->rawAppendEnd();
+}
+
+
+/// Appends the \r that's kept for joining a \r\n line ending, when no data follows anymore
+/// (the follower stops or the file is reset)
+void TextDocumentFollower::flushPendingCarriageReturn()
+{
+    if( !pendingCarriageReturn_ ) { return; }
+    pendingCarriageReturn_ = false;
+    if( !documentRef_ ) { return; }
+
+    documentRef_->rawAppendBegin();
+    documentRef_->rawAppend( QLatin1Char('\r') );
+    documentRef_->rawAppendEnd();
+    removeExcessLines();
+}
+
+
+/// Removes the first lines of the document when it has more than the maximum number of lines
+void TextDocumentFollower::removeExcessLines()
+{
+    if( maxLineCount_ <= 0 ) { return; }
+    int lineCount = documentRef_->lineCount();
+    if( lineCount <= maxLineCount_ ) { return; }
+    int removeCount = qMin( lineCount - maxLineCount_ + maxLineCount_ / TrimLineDivisor, lineCount - 1 );
+    documentRef_->rawRemoveText( 0, documentRef_->offsetFromLine( removeCount ) );
+}
+
+
+} // edbee
@@ -0,0 +1,94 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+class QFileSystemWatcher;
+
+namespace edbee {
+
+class TextDecoder;
+class TextDocument;
+
+
+/// Follows a growing file (like tail -f), the bytes that are appended to the file are appended to the document.
+///
+/// Only the appended bytes are read and decoded (with the encoding of the document). The text is appended
+/// with the raw append methods of the document, so no undo data is collected. The \r of \r\n line endings is removed.
+/// A \r at the end of the read data is kept until the next data, it's appended when the follower stops.
+///
+/// The file is watched with a QFileSystemWatcher. When the file is replaced (log rotation) or truncated the
+/// new file is followed from the start. On file systems without change notifications, readAppendedData can be
+/// called with a timer.
+///
+/// With a maximum line count the first lines are removed when the document grows beyond it, so the memory
+/// stays bounded. The follower must be used on the thread of the document (the GUI thread).
+///
+/// @code
+/// TextDocumentFollower* follower = new TextDocumentFollower( document, this );
+/// follower->setMaxLineCount( 100000 );
+/// follower->follow( fileName, document->length() > 0 ? -1 : 0 );
+/// @endcode
+class EDBEE_EXPORT TextDocumentFollower : public QObject
+{
+    Q_OBJECT
+
+public:
+    TextDocumentFollower( TextDocument* document, QObject* parent=0 );
+    virtual ~TextDocumentFollower();
+
+    bool follow( const QString& fileName, qint64 position=-1 );
+    void stop();
+    bool isFollowing() const;
+
+    TextDocument* document() const;
+    QString fileName() const;
+    qint64 position() const;
+    QString errorString() const;
+
+    void setMaxLineCount( int count );
+    int maxLineCount() const;
+
+public slots:
+
+    void readAppendedData();
+
+signals:
+
+    /// This signal is emitted after text is appended to the document
+    /// @param bytes the number of bytes that are read from the file
+    void dataAppended( qint64 bytes );
+
+    /// This signal is emitted when the file is truncated or replaced. The file is followed from the start
+    void fileReset();
+
+private slots:
+
+    void fileChanged( const QString& path );
+    void directoryChanged( const QString& path );
+
+private:
+    void restart();
+    void appendData( const char* data, int length );
+    void flushPendingCarriageReturn();
+    void removeExcessLines();
+
+    QPointer<TextDocument> documentRef_;     ///< The document to append the text to
+    QString fileName_;                       ///< The followed file
+    QFileSystemWatcher* watcher_;            ///< The watcher of the file (and its directory)
+    TextDecoder* decoder_;                   ///< The decoder of the appended bytes (keeps incomplete sequences)
+    qint64 position_;                        ///< The position in the file of the first byte that isn't read
+    bool pendingCarriageReturn_;             ///< Is the last read character a \r? (which is appended with the next data)
+    int maxLineCount_;                       ///< The maximum number of lines of the document (0 is unlimited)
+    QString errorString_;                    ///< The last error
+
+    Q_DISABLE_COPY(TextDocumentFollower)
+};
+
+} // edbee
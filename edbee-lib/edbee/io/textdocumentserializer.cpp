@@ -4,13 +4,21 @@
 #include "textdocumentserializer.h"
 
 #include <QBuffer>
+#include <QFileDevice>
 #include <QIODevice>
 #include <QTextCodec>
 
+#include <limits>
+
+#include "edbee/models/textbuffer.h"
 #include "edbee/models/textdocument.h"
+#include "edbee/models/textlinedata.h"
+#include "edbee/models/textsnapshot.h"
 #include "edbee/util/lineending.h"
+#include "edbee/util/paralleltextdecoder.h"
 #include "edbee/util/textcodecdetector.h"
 #include "edbee/util/textcodec.h"
+#include "edbee/util/utf8validator.h"
 
 #include "edbee/debug.h"
 
@@ -19,7 +27,17 @@ namespace edbee {
 TextDocumentSerializer::TextDocumentSerializer( TextDocument* textDocument )
     : textDocumentRef_(textDocument)
     , blockSize_( 8192 )
+    , saveBufferSize_( 1024 * 1024 )
     , filterRef_(0)
+    , parallelLoadThreshold_( 256 * 1024 )
+    , validateWholeFile_(true)
+    , preserveLineEndings_(false)
+    , listenerRef_(0)
+    , detectedCodecRef_(0)
+    , knownCodecRef_(0)
+    , knownTextLength_(-1)
+    , knownLineOffsetsRejected_(false)
+    , detectedLineEndingRef_(0)
 {
 }
 
@@ -30,81 +48,292 @@ bool TextDocumentSerializer::loadWithoutOpening( QIODevice* ioDevice )
 {
     errorString_.clear();
 
-    // start raw appending
+    // start raw appending (the text is appended to the last line)
+    int firstLine = textDocumentRef_->lineCount() - 1;
     textDocumentRef_->rawAppendBegin();
+    loadBuffer( ioDevice, textDocumentRef_->buffer() );
+
+    // set the detected items
+    textDocumentRef_->setEncoding( detectedCodecRef_ );
+    textDocumentRef_->setLineEnding( detectedLineEndingRef_ );
+    textDocumentRef_->rawAppendEnd();
+    textDocumentRef_->setLineEndingStatistics( lineEndingStatistics_ );
+    if( preserveLineEndings_ ) { giveLineEndingData( textDocumentRef_, firstLine ); }
+    return errorString_.isEmpty();
+}
 
-    // read the file in blocks of 4096 bytes
-    TextCodec* detectedCodec = 0;
-    const LineEnding* detectedLineEnding = 0;
 
-    QTextDecoder* textDecoder=0;
+/// Loads the file data for the given (opened) ioDevice in the given buffer, instead of the document.
+/// This makes it possible to load the data in a detached buffer on another thread.
+/// The detected encoding and line ending are available via detectedEncoding and detectedLineEnding.
+/// @param ioDevice the device to read
+/// @param buffer the buffer to append the text to
+/// @return true on success
+bool TextDocumentSerializer::loadBufferWithoutOpening(QIODevice* ioDevice, TextBuffer* buffer)
+{
+    errorString_.clear();
+    buffer->rawAppendBegin();
+    loadBuffer( ioDevice, buffer );
+    buffer->rawAppendEnd();
+    return errorString_.isEmpty();
+}
+
+
+/// Requests to stop loading or saving. This method can be called from another thread.
+/// Loading/saving stops with the error "Cancelled". The request stays active, a stopped serializer can't be reused
+void TextDocumentSerializer::requestStop()
+{
+    stopRequested_.storeRelease(1);
+}
+
+
+/// Returns true if stopping is requested
+bool TextDocumentSerializer::isStopRequested() const
+{
+    return stopRequested_.loadAcquire() != 0;
+}
+
+
+/// Sets the line offsets of the text of the file when these are already known (for example from a TextDocumentCache).
+/// When a file with the given text length is loaded in an empty buffer, the buffer uses these offsets instead of
+/// searching the text for newlines. The offsets aren't used when the loaded text has another length, or when
+/// a character before an offset isn't a newline (see knownLineOffsetsRejected)
+/// @param lineOffsets the offsets of the characters after the newlines
+/// @param textLength the length of the text (-1 to clear the known line offsets)
+void TextDocumentSerializer::setKnownLineOffsets(const QVector<TextOffset>& lineOffsets, TextOffset textLength)
+{
+    knownLineOffsets_ = lineOffsets;
+    knownTextLength_ = textLength;
+}
+
+
+/// Detects the encoding of the data.
+/// Without validateWholeFile only the given data (normally the first block) is used.
+/// When the whole file must be validated and the data isn't the whole file, the rest of the device is read and
+/// validated block by block. The position of the device is restored afterwards. This isn't possible for
+/// sequential devices, these are always detected with the given data.
+/// @param ioDevice the device that's loaded (positioned after the given data)
+/// @param data the data at the start of the file
+/// @param length the number of bytes of data
+/// @param wholeFile is the data the complete file?
+/// @return the detected codec
+TextCodec* TextDocumentSerializer::detectCodec(QIODevice* ioDevice, const char* data, qint64 length, bool wholeFile)
+{
+    if( knownCodecRef_ ) { return knownCodecRef_; }
+
+    TextCodecDetector codecDetector( data, length );
+    codecDetector.setWholeFile( wholeFile && validateWholeFile_ );
+    if( wholeFile || !validateWholeFile_ || ioDevice->isSequential() || TextCodecDetector::hasByteOrderMark( data, length ) ) {
+        return codecDetector.detectCodec();
+    }
+
+    Utf8Validator validator;
+    validator.append( data, length );
+    qint64 pos = ioDevice->pos();
+    QByteArray bytes( blockSize_, 0 );
+    while( !validator.isInvalid() && !isStopRequested() ) {
+        qint64 bytesRead = ioDevice->read( bytes.data(), bytes.size() );
+        if( bytesRead <= 0 ) { break; }
+        validator.append( bytes.constData(), bytesRead );
+    }
+    ioDevice->seek( pos );
+    return codecDetector.codecForValidationResult( validator.result() );
+}
+
+
+/// Appends the text of the given device to the buffer, which should be in raw append mode.
+/// This method sets the detected encoding and line ending. The line endings of the complete file are counted,
+/// the detected line ending is the most common line ending
+/// @param ioDevice the device to read
+/// @param buffer the buffer to append the text to
+void TextDocumentSerializer::loadBuffer(QIODevice* ioDevice, TextBuffer* buffer)
+{
+    detectedCodecRef_ = 0;
+    detectedLineEndingRef_ = 0;
+    lineEndingStatistics_.clear();
+    lineEndingStatistics_.setWindowsLinesRecorded( preserveLineEndings_ );
+    knownLineOffsetsRejected_ = false;
+    TextOffset startLength = buffer->length();
+
+    // large UTF-8 and Latin-1 files are decoded with multiple threads (which finds the line offsets while decoding)
+    if( !stopIfRequested() && !loadParallel( ioDevice, buffer ) ) {
+        loadSerial( ioDevice, buffer );
+
+        // the known line offsets are only valid for the complete text
+        if( startLength == 0 && knownTextLength_ >= 0 && buffer->length() == knownTextLength_ ) {
+            if( matchesKnownLineOffsets( buffer ) ) {
+                buffer->setRawAppendLineOffsets( knownLineOffsets_ );
+            } else {
+                knownLineOffsetsRejected_ = true;
+            }
+        }
+    }
+
+    // When no line ending could be detected, take the unix line ending
+    detectedLineEndingRef_ = lineEndingStatistics_.mostCommon( LineEnding::unixType() );
+    if( !detectedCodecRef_ ) {  detectedCodecRef_ = TextCodecDetector::globalPreferedCodec();  }
+}
+
+
+/// Checks if the known line offsets match the loaded text. A file with the same length can have another content,
+/// so every offset must be ascending and must follow a newline. (Newlines that aren't in the known line offsets
+/// aren't detected, this would require searching the complete text)
+/// @param buffer the buffer with the loaded text
+/// @return true if the known line offsets can be used
+bool TextDocumentSerializer::matchesKnownLineOffsets(TextBuffer* buffer) const
+{
+    TextOffset lastOffset = 0;
+    for( int i=0, count=knownLineOffsets_.size(); i < count; ++i ) {
+        TextOffset offset = knownLineOffsets_.at(i);
+        if( offset <= lastOffset || offset > buffer->length() || buffer->charAt( offset - 1 ) != QChar('\n') ) { return false; }
+        lastOffset = offset;
+    }
+    return true;
+}
+
+
+/// Decodes the device block by block with a TextDecoder.
+/// UTF-8 and Latin-1 are decoded directly in the buffer (when the buffer supports it), other encodings are
+/// decoded with the QTextCodec
+/// @param ioDevice the device to read
+/// @param buffer the buffer to append the text to
+void TextDocumentSerializer::loadSerial(QIODevice* ioDevice, TextBuffer* buffer)
+{
+    TextDecoder* textDecoder=0;
 
     // read the buffer
     QByteArray bytes(blockSize_ + 1, 0);
-    QString remainingBuffer;
+    QString decodeBuffer;
+    bool pendingCarriageReturn = false;
+    qint64 total = ioDevice->isSequential() ? 0 : ioDevice->size() - ioDevice->pos();
+    qint64 processed = 0;
 
     /// TODO: atEnd doesn't seem to work !?!
-/// TODO: implement isStopRequested to stop loading if required
-    while( /*ioDeviceRef_->atEnd() &&*/ true /*!isStopRequested()*/ ) {
+    while( /*ioDeviceRef_->atEnd() &&*/ !stopIfRequested() ) {
 
         int bytesRead = ioDevice->read( bytes.data(), blockSize_ - 1);
         if( bytesRead > 0 ) {
             bytes[bytesRead + 1] = 0; // 0 terminate the read bytes
 
             // In the first block we're need to detect the correct encoding
-            if( !detectedCodec ) {
-                TextCodecDetector codecDetector(bytes.constData(), bytesRead);
-                detectedCodec = codecDetector.detectCodec();
-                Q_ASSERT(detectedCodec);
-                textDecoder = detectedCodec->makeDecoder();
+            if( !detectedCodecRef_ ) {
+                detectedCodecRef_ = detectCodec( ioDevice, bytes.constData(), bytesRead, false );
+                Q_ASSERT(detectedCodecRef_);
+                textDecoder = new TextDecoder( detectedCodecRef_ );
             }
 
-            // convert the bytes to a string
-            QString newBuffer = textDecoder->toUnicode( bytes.constData(), bytesRead );
-
-            // next detect the line ending. When no line ending is detected 0 is returned!
-            if( !detectedLineEnding ) {
-                detectedLineEnding = LineEnding::detect( newBuffer );
-            }
-
-            // when we detected a line ending
-            if( detectedLineEnding ) {
-                remainingBuffer.append( newBuffer );
-                remainingBuffer = appendBufferToDocument( remainingBuffer );
-            // else we need to append it to the rest
+            if( textDecoder->isBuiltin() ) {
+                appendDecodedToBuffer( buffer, textDecoder, bytes.constData(), bytesRead, decodeBuffer, pendingCarriageReturn );
             } else {
-                remainingBuffer.append( newBuffer );
+                QString text = textDecoder->toUnicode( bytes.constData(), bytesRead );
+                appendNormalizedToBuffer( buffer, text, false, pendingCarriageReturn );
             }
+
+            processed += bytesRead;
+            reportProgress( processed, total );
         }
 
         // we're done
         if( bytesRead <= 0 ) break;
     }
 
-    // When no line ending could be detected, take the unix line ending
-    if( !detectedLineEnding ) detectedLineEnding = LineEnding::get(LineEnding::UnixType); // fallback to unix
-    if( !detectedCodec ) {  detectedCodec = TextCodecDetector::globalPreferedCodec();  }
-
-    // set the detected items
+    // append the remaing line ending
+    if( textDecoder && textDecoder->isBuiltin() ) {
+        appendDecodedToBuffer( buffer, textDecoder, nullptr, 0, decodeBuffer, pendingCarriageReturn );
+    } else {
+        QString text;
+        appendNormalizedToBuffer( buffer, text, true, pendingCarriageReturn );
+    }
     delete textDecoder;
-    textDocumentRef_->setEncoding( detectedCodec );
-    textDocumentRef_->setLineEnding( detectedLineEnding );
+}
 
-    // append the remaing line ending
-    remainingBuffer = appendBufferToDocument( remainingBuffer );
-    //fileDocument_->appendLine( remainingBuffer, FsFileDocument::Line::StateUnkown ) ;  // append the last line
 
-    // next detect the file type
-//    FileType *fileType = app()->fileTypeManager()->detectFileType( virtualFile()->fileName() );
-//    fileDocument_->setFileType( fileType );
+/// Loads the given (opened) ioDevice with the ParallelTextDecoder.
+/// This only happens for random-access devices of at least parallelLoadThreshold bytes with an UTF-8 or Latin-1 encoding.
+/// Files are memory mapped and buffers are used directly, so the data isn't copied before decoding.
+/// The decoded text is written directly in the textbuffer (when the buffer supports it).
+/// @param ioDevice the device to read
+/// @param buffer the buffer to append the text to
+/// @return false if the device can't be loaded this way (nothing has been read). true if it's loaded (or failed, see errorString)
+bool TextDocumentSerializer::loadParallel(QIODevice* ioDevice, TextBuffer* buffer)
+{
+    if( ioDevice->isSequential() ) { return false; }
+    qint64 size = ioDevice->size() - ioDevice->pos();
+    if( size <= 0 || size < parallelLoadThreshold_ ) { return false; }
+
+    // the first block decides if the encoding can be decoded in parallel (byte order marks are found here)
+    QByteArray firstBlock = ioDevice->peek( blockSize_ - 1 );
+    TextCodecDetector codecDetector( firstBlock.constData(), firstBlock.size() );
+    TextCodec* detectedCodec = knownCodecRef_ ? knownCodecRef_ : codecDetector.detectCodec();
+    ParallelTextDecoder::Encoding encoding;
+    bool skipByteOrderMark = false;
+    if( !detectedCodec || !ParallelTextDecoder::encodingForCodec( detectedCodec, encoding, skipByteOrderMark ) ) { return false; }
+
+    // retrieve the data without copying it (when possible)
+    qint64 startPos = ioDevice->pos();
+    QFileDevice* fileDevice = qobject_cast<QFileDevice*>(ioDevice);
+    QBuffer* bufferDevice = qobject_cast<QBuffer*>(ioDevice);
+    uchar* mappedData = fileDevice ? fileDevice->map( startPos, size ) : nullptr;
+    QByteArray readData;
+    const char* data = reinterpret_cast<const char*>( mappedData );
+    if( !data && bufferDevice ) {
+        data = bufferDevice->data().constData() + startPos;
+    }
+    if( !data ) {
+        readData = ioDevice->read( size );
+        if( readData.size() != size ) {
+            errorString_ = ioDevice->errorString();
+            return true;
+        }
+        data = readData.constData();
+    }
+
+    // all data is available, so the encoding can be detected with the complete file
+    if( validateWholeFile_ && !knownCodecRef_ ) {
+        detectedCodec = detectCodec( ioDevice, data, size, true );
+        if( !ParallelTextDecoder::encodingForCodec( detectedCodec, encoding, skipByteOrderMark ) ) {
+            if( mappedData ) { fileDevice->unmap( mappedData ); }
+            ioDevice->seek( startPos );
+            return false;
+        }
+    }
+    detectedCodecRef_ = detectedCodec;
 
-    // start raw appending
-    textDocumentRef_->rawAppendEnd();
+    ParallelTextDecoder decoder( encoding, data, size );
+    decoder.setSkipByteOrderMark( skipByteOrderMark );
+    qint64 decodedLength = decoder.decodedLength();
+    if( decodedLength > std::numeric_limits<TextOffset>::max() - buffer->length() ) {
+        errorString_ = QObject::tr("The file is too large to load");
+    }
+
+    // the passes of the decoder can't be interrupted, so stopping is checked between the passes
+    reportProgress( size / 2, size );
+    if( !errorString_.isEmpty() || stopIfRequested() ) {
+        if( mappedData ) { fileDevice->unmap( mappedData ); }
+        return true;
+    }
+
+    // decode directly in the buffer, the line endings are counted while decoding
+    TextOffset length = static_cast<TextOffset>( decodedLength );
+    QVector<TextOffset> lineOffsets;
+    QChar* target = buffer->rawAppendDirect( length );
+    if( target ) {
+        decoder.decode( target, buffer->length() - length, lineOffsets, &lineEndingStatistics_ );
+        buffer->setRawAppendLineOffsets( lineOffsets );
+    } else {
+        QString text( length, Qt::Uninitialized );
+        decoder.decode( text.data(), buffer->length(), lineOffsets, &lineEndingStatistics_ );
+        buffer->rawAppend( text.constData(), text.length() );
+    }
+    reportProgress( size, size );
+
+    // move the device to the end (when the data isn't read)
+    if( mappedData ) { fileDevice->unmap( mappedData ); }
+    if( readData.isNull() ) { ioDevice->seek( ioDevice->pos() + size ); }
     return true;
 }
 
 
-
 /// executes the file loading for the given (unopened) ioDevice
 /// @return true on success,
 bool TextDocumentSerializer::load( QIODevice* ioDevice )
@@ -127,49 +356,213 @@ bool TextDocumentSerializer::load( QIODevice* ioDevice )
 /// loads the file data for the given (opened) ioDevice
 /// @return true on success
 bool TextDocumentSerializer::saveWithoutOpening(QIODevice *ioDevice)
+{
+    return saveText( ioDevice, 0, textDocumentRef_->encoding(), textDocumentRef_->lineEnding() );
+}
+
+
+/// Saves the given snapshot of the document to the (opened) ioDevice.
+/// The snapshot is immutable, so this method can be called on another thread while the document is changed
+/// @param ioDevice the device to write to
+/// @param snapshot the snapshot to save
+/// @param codec the encoding to use
+/// @param lineEnding the line ending to use
+/// @return true on success
+bool TextDocumentSerializer::saveSnapshotWithoutOpening(QIODevice* ioDevice, const TextSnapshot& snapshot, TextCodec* codec, const LineEnding* lineEnding)
+{
+    return saveText( ioDevice, &snapshot, codec, lineEnding );
+}
+
+
+/// Saves the text of the document or the given snapshot
+/// @param ioDevice the device to write to
+/// @param snapshot the snapshot to save (0 to save the document)
+/// @param codec the encoding to use
+/// @param lineEnding the line ending to use
+/// @return true on success
+bool TextDocumentSerializer::saveText(QIODevice* ioDevice, const TextSnapshot* snapshot, TextCodec* codec, const LineEnding* lineEnding)
 {
     errorString_.clear();
 
-    // get the codec en encoder
-    TextCodec* codec = textDocumentRef_->encoding();
-    QTextEncoder* encoder = codec->makeEncoder();
-    QString lineEnding( textDocumentRef_->lineEnding()->chars() );
+    // get the codec en encoder. The text always uses \n, the encoder replaces it with the line ending.
+    // The preserved line endings are stored in the line data of the document (snapshots don't have line data),
+    // these are appended per line
+    bool preserve = preserveLineEndings_ && !snapshot;
+    TextEncoder encoder( codec );
+    encoder.setLineEnding( preserve ? QStringLiteral("\n") : QString::fromLatin1( lineEnding->chars() ) );
 
-    // work via a buffer
+    // work via a buffer, which is reused for every write
     QByteArray buffer;
-    for( int lineIdx=0,cnt=textDocumentRef_->lineCount(); lineIdx<cnt; ++lineIdx ) {
-        QString line = textDocumentRef_->lineWithoutNewline(lineIdx);
+    buffer.reserve( saveBufferSize_ );
+    if( filter() || preserve ) {
+        saveLines( &encoder, snapshot, preserve ? lineEnding : 0, ioDevice, buffer );
+    } else {
+        saveChunks( &encoder, snapshot, ioDevice, buffer );
+    }
+
+    // flush the last part of the buffer
+    if( errorString_.isEmpty() && buffer.size() ) {
+        writeBuffer( ioDevice, buffer );
+    }
+    return errorString_.isEmpty();
+}
+
+
+/// Saves the document line by line. This is required when using a filter or when preserving the line endings.
+/// The text of every line is copied in the same string, so the string is only allocated once
+/// @param encoder the encoder to use
+/// @param snapshot the snapshot to save (0 to save the document)
+/// @param lineEnding the line ending for lines without a preserved line ending (0 when the encoder replaces the newlines)
+/// @param ioDevice the device to write to
+/// @param buffer the output buffer
+void TextDocumentSerializer::saveLines(TextEncoder* encoder, const TextSnapshot* snapshot, const LineEnding* lineEnding, QIODevice* ioDevice, QByteArray& buffer)
+{
+    QString line;
+    for( int lineIdx=0,cnt=snapshot ? snapshot->lineCount() : textDocumentRef_->lineCount(); lineIdx<cnt && !stopIfRequested(); ++lineIdx ) {
+        copyLineWithoutNewline( snapshot, lineIdx, line );
         if( filter() ) {
             // if this line is not selected move to the next
             if( !filter()->saveLineSelector( this, lineIdx, line ) ) { continue; }
         }
-        buffer.append( encoder->fromUnicode( line) );
 
         // no newline after the last line
         if( lineIdx+1<cnt ) {
-            buffer.append( encoder->fromUnicode( lineEnding ) );
+            if( lineEnding ) {
+                LineEndingLineData* lineEndingData = dynamic_cast<LineEndingLineData*>( textDocumentRef_->getLineData( lineIdx, LineEndingField ) );
+                line.append( QLatin1String( lineEndingData ? LineEnding::get( lineEndingData->value() )->chars() : lineEnding->chars() ) );
+            } else {
+                line.append( QLatin1Char('\n') );
+            }
         }
+        encoder->encode( line, buffer );
 
         // flush the bufer
-        if( buffer.size() >= blockSize_ ) {
-            if( ioDevice->write(buffer) < 0 ) {
-                errorString_ = ioDevice->errorString();
-                buffer.clear();
-                break;
+        if( buffer.size() >= saveBufferSize_ / 2 ) {
+            if( !writeBuffer( ioDevice, buffer ) ) { return; }
+            reportProgress( lineIdx + 1, cnt );
+        }
+    }
+}
+
+
+/// Saves the document by directly encoding the chunks of the textbuffer (for the CharTextBuffer the two
+/// parts around the gap). The encoder writes directly in the output buffer and replaces the newlines in the
+/// same pass. This prevents the creation of a QString for every line and never changes the layout of the textbuffer
+/// @param encoder the encoder to use
+/// @param snapshot the snapshot to save (0 to save the textbuffer of the document)
+/// @param ioDevice the device to write to
+/// @param buffer the output buffer
+void TextDocumentSerializer::saveChunks(TextEncoder* encoder, const TextSnapshot* snapshot, QIODevice* ioDevice, QByteArray& buffer)
+{
+    // a chunk can be huge, so it's encoded in slices. The buffer is written when it's half full, the slices are
+    // small enough to fit in the other half (UTF-8 requires at most 3 bytes per character)
+    TextOffset sliceSize = qMax( saveBufferSize_ / 8, 1 );
+
+    TextBuffer* textBuffer = snapshot ? 0 : textDocumentRef_->buffer();
+    TextOffset length = snapshot ? snapshot->length() : textBuffer->length();
+    TextOffset chunkStart = 0, chunkLength = 0;
+    for( TextOffset offset = 0; offset < length && !stopIfRequested(); offset = chunkStart + chunkLength ) {
+        const QChar* chunk = snapshot ? snapshot->chunkAt( offset, chunkStart, chunkLength ) : textBuffer->chunkAt( offset, chunkStart, chunkLength );
+        for( TextOffset sliceOffset=0; sliceOffset < chunkLength && !stopIfRequested(); sliceOffset += sliceSize ) {
+            int sliceLength = static_cast<int>( qMin<TextOffset>( sliceSize, chunkLength - sliceOffset ) );
+            encoder->encode( chunk + sliceOffset, sliceLength, buffer );
+
+            // flush the bufer
+            if( buffer.size() >= saveBufferSize_ / 2 ) {
+                if( !writeBuffer( ioDevice, buffer ) ) { return; }
+                reportProgress( chunkStart + sliceOffset + sliceLength, length );
             }
-            buffer.clear();
         }
     }
+}
 
-    // flush the last part of the buffer
-    if( buffer.size() ) {
-        if( ioDevice->write(buffer) < 0 ) {
-            errorString_ = ioDevice->errorString();
+
+/// Gives the line ending of the last load to the lines that end with another line ending than the line ending of
+/// the document (LineEndingField line data), so saving with preserved line endings restores them.
+/// This only works when the last load preserved the line endings (the \r\n lines are recorded then).
+/// @param document the document with the loaded text
+/// @param firstLine the line of the document where the loaded text starts
+void TextDocumentSerializer::giveLineEndingData(TextDocument* document, int firstLine)
+{
+    if( !lineEndingStatistics_.isWindowsLinesRecorded() ) { return; }
+    LineEnding::Type documentType = document->lineEnding()->type();
+    bool hasUnixLines = lineEndingStatistics_.count( LineEnding::UnixType ) > 0;
+    bool hasWindowsLines = lineEndingStatistics_.count( LineEnding::WindowsType ) > 0;
+    if( ( !hasUnixLines || documentType == LineEnding::UnixType ) && ( !hasWindowsLines || documentType == LineEnding::WindowsType ) ) { return; }
+
+    // the line data is given without undo, it belongs to the loaded text
+    TextLineDataManager* manager = document->lineDataManager();
+    const QVector<int>& windowsLines = lineEndingStatistics_.windowsLines();
+    int windowsIdx = 0;
+    for( int line=0, cnt=lineEndingStatistics_.newlineCount(); line < cnt; ++line ) {
+        LineEnding::Type type = LineEnding::UnixType;
+        if( windowsIdx < windowsLines.size() && windowsLines.at(windowsIdx) == line ) {
+            type = LineEnding::WindowsType;
+            ++windowsIdx;
+        }
+        if( type != documentType ) {
+            manager->give( firstLine + line, LineEndingField, new LineEndingLineData( type ) );
         }
-        buffer.clear();
     }
-    delete encoder;
-    return errorString_.isEmpty();
+}
+
+
+/// Copies the text of the given line (without the newline) to the given string.
+/// The string is reused, so the memory is only allocated when the string is too small
+/// @param snapshot the snapshot to copy the line from (0 to use the textbuffer of the document)
+/// @param line the line to copy
+/// @param text (out) the text of the line
+void TextDocumentSerializer::copyLineWithoutNewline(const TextSnapshot* snapshot, int line, QString& text)
+{
+    TextBuffer* textBuffer = snapshot ? 0 : textDocumentRef_->buffer();
+    TextOffset offset = snapshot ? snapshot->offsetFromLine( line ) : textBuffer->offsetFromLine( line );
+    TextOffset end = offset + ( snapshot ? snapshot->lineLength( line ) : textBuffer->lineLength( line ) );
+    if( end > offset && ( snapshot ? snapshot->charAt( end - 1 ) : textBuffer->charAt( end - 1 ) ) == '\n' ) { --end; }
+
+    text.resize( 0 );
+    TextOffset chunkStart = 0, chunkLength = 0;
+    for( ; offset < end; offset = chunkStart + chunkLength ) {
+        const QChar* chunk = snapshot ? snapshot->chunkAt( offset, chunkStart, chunkLength ) : textBuffer->chunkAt( offset, chunkStart, chunkLength );
+        text.append( chunk + ( offset - chunkStart ), static_cast<int>( qMin( end, chunkStart + chunkLength ) - offset ) );
+    }
+}
+
+
+/// Sets the error to "Cancelled" when stopping is requested
+/// @return true if loading/saving should stop
+bool TextDocumentSerializer::stopIfRequested()
+{
+    if( !isStopRequested() ) { return false; }
+    if( errorString_.isEmpty() ) {
+        errorString_ = QObject::tr("Cancelled");
+    }
+    return true;
+}
+
+
+/// Informs the listener about the progress
+/// @param processed the number of processed bytes or characters
+/// @param total the total number of bytes or characters (0 if unknown)
+void TextDocumentSerializer::reportProgress(qint64 processed, qint64 total)
+{
+    if( listenerRef_ ) {
+        listenerRef_->serializerProgress( this, processed, total );
+    }
+}
+
+
+/// Writes the given buffer to the io device and clears the buffer. The capacity of the buffer is kept
+/// @param ioDevice the device to write to
+/// @param buffer the buffer to write
+/// @return true on success. On failure the errorString is set
+bool TextDocumentSerializer::writeBuffer(QIODevice* ioDevice, QByteArray& buffer)
+{
+    bool result = ioDevice->write(buffer) >= 0;
+    if( !result ) {
+        errorString_ = ioDevice->errorString();
+    }
+    buffer.resize(0);
+    return result;
 }
 
 
@@ -192,44 +585,74 @@ bool TextDocumentSerializer::save(QIODevice* ioDevice)
 }
 
 
-/// This method appends the given lines to the document
-/// @param strIn the string to append
-/// @retirn the remaining last line
-QString TextDocumentSerializer::appendBufferToDocument(const QString& strIn)
+/// Decodes the given data with the built-in converter of the decoder and appends it to the buffer.
+/// The text is decoded directly in the buffer when the buffer supports it, else the decode buffer is used.
+/// The line endings are counted and the \r of a \r\n line ending is removed in the same pass.
+/// A \r at the end of the data is kept until the next call, because it can be followed by a \n.
+/// @param buffer the buffer to append the text to (in raw append mode)
+/// @param decoder the decoder with a built-in converter
+/// @param data the data to decode (nullptr to finish decoding)
+/// @param length the number of bytes
+/// @param decodeBuffer the buffer to decode in when the buffer can't be written directly
+/// @param pendingCarriageReturn is there a \r at the end of the previous data?
+void TextDocumentSerializer::appendDecodedToBuffer(TextBuffer* buffer, TextDecoder* decoder, const char* data, int length, QString& decodeBuffer, bool& pendingCarriageReturn)
 {
-    // The code blow is to translate all newlines to the correct format
-    int lastPos = 0;
-    for( int pos=0, len=strIn.length(); pos<len; ++pos ) {
+    bool finish = !data;
+    TextOffset maxLength = 1 + static_cast<TextOffset>( finish ? TextDecoder::MaxFinishLength : decoder->maxDecodedLength( length ) );
+    QChar* target = buffer->rawAppendDirect( maxLength );
+    bool direct = target != nullptr;
+    if( !direct ) {
+        if( decodeBuffer.length() < maxLength ) { decodeBuffer.resize( maxLength ); }
+        target = decodeBuffer.data();
+    }
 
-        // we found an 'wrong' endline
-        QChar c = strIn.at(pos);
-        if( c  == '\r' ) {
-            // append the buffer
-            if( pos-lastPos-1 >= 0 ) {
-                textDocumentRef_->rawAppend( strIn.data() + lastPos, pos-lastPos);
-                lastPos = pos;
-            }
+    QChar* end = target;
+    if( pendingCarriageReturn ) { *end++ = QLatin1Char('\r'); }
+    end += finish ? decoder->finish( end ) : decoder->decode( data, length, end );
 
-            // lookahead to check if it's a '\n'
-            if( pos+1 < strIn.length() ) {
-                pos += 1;
-                QChar c2 = strIn.at(pos);
-                if( c2 != '\n' ) {
-                    pos -= 1;
-                }
-                lastPos = pos;
-                //textDocumentRef_->rawAppend('\n');
-            // we need to process the last line-end (later)
-            } else {
-                return "\r";
-            }
-        }
+    // count the line endings and remove the \r of the \r\n line endings (in place)
+    pendingCarriageReturn = !finish && end > target && end[-1] == '\r';
+    if( pendingCarriageReturn ) { --end; }
+    QChar* out = lineEndingStatistics_.normalize( target, end );
+
+    TextOffset appendedLength = static_cast<TextOffset>( out - target );
+    if( direct ) {
+        buffer->rawAppendDirectShrink( maxLength - appendedLength );
+    } else {
+        buffer->rawAppend( target, appendedLength );
     }
+}
 
-    if( strIn.length()-lastPos > 0 ) {
-        textDocumentRef_->rawAppend( strIn.data() + lastPos, strIn.length()-lastPos);
+
+/// Counts the line endings of the given (decoded) text, removes the \r of the \r\n line endings in place and
+/// appends the text to the buffer. A \r at the end of the text is kept until the next call (unless finishing),
+/// because it can be followed by a \n.
+/// @param buffer the buffer to append the text to (in raw append mode)
+/// @param text the text to append, which is changed
+/// @param finish is this the end of the text?
+/// @param pendingCarriageReturn is there a \r at the end of the previous text?
+void TextDocumentSerializer::appendNormalizedToBuffer(TextBuffer* buffer, QString& text, bool finish, bool& pendingCarriageReturn)
+{
+    QChar* begin = text.data();
+    QChar* end = begin + text.length();
+
+    // the \r of the previous text is the start of a \r\n or a line ending of its own
+    if( pendingCarriageReturn ) {
+        if( begin < end && *begin == '\n' ) {
+            lineEndingStatistics_.addLineEnding( LineEnding::WindowsType );
+            buffer->rawAppend( *begin++ );
+        } else if( begin < end || finish ) {
+            lineEndingStatistics_.addLineEnding( LineEnding::MacClassicType );
+            buffer->rawAppend( QLatin1Char('\r') );
+        } else {
+            return;
+        }
     }
-    return "";
+    pendingCarriageReturn = !finish && begin < end && end[-1] == '\r';
+    if( pendingCarriageReturn ) { --end; }
+
+    end = lineEndingStatistics_.normalize( begin, end );
+    if( end > begin ) { buffer->rawAppend( begin, static_cast<TextOffset>( end - begin ) ); }
 }
 
 
@@ -5,14 +5,25 @@
 
 #include "edbee/exports.h"
 
+#include <QAtomicInt>
 #include <QString>
+#include <QVector>
+
+#include "edbee/textoffset.h"
+#include "edbee/util/lineending.h"
 
 class QIODevice;
 
 namespace edbee {
 
+class LineEnding;
+class TextBuffer;
+class TextCodec;
+class TextDecoder;
 class TextDocument;
 class TextDocumentSerializer;
+class TextEncoder;
+class TextSnapshot;
 
 class EDBEE_EXPORT TextDocumentSerializerFilter {
 public:
@@ -25,6 +36,20 @@ public:
 };
 
 
+/// A listener that's informed about the progress of loading and saving.
+/// The listener is called on the thread that's loading/saving
+class EDBEE_EXPORT TextDocumentSerializerListener {
+public:
+    virtual ~TextDocumentSerializerListener() {}
+
+    /// This method is called after every written or read block
+    /// @param serializer the text serializer
+    /// @param processed the number of processed bytes (loading) or the number of saved characters/lines (saving)
+    /// @param total the total number of bytes/characters/lines (0 if unknown)
+    virtual void serializerProgress( TextDocumentSerializer* serializer, qint64 processed, qint64 total ) = 0;
+};
+
+
 /// A class used to load/save a text-file from and to an IODevice
 class EDBEE_EXPORT TextDocumentSerializer {
 public:
@@ -32,23 +57,85 @@ public:
 
     bool loadWithoutOpening( QIODevice* ioDevice );
     bool load( QIODevice* ioDevice );
+    bool loadBufferWithoutOpening( QIODevice* ioDevice, TextBuffer* buffer );
 
     bool saveWithoutOpening( QIODevice* ioDevice );
     bool save( QIODevice* ioDevice );
+    bool saveSnapshotWithoutOpening( QIODevice* ioDevice, const TextSnapshot& snapshot, TextCodec* codec, const LineEnding* lineEnding );
 
+    void requestStop();
+    bool isStopRequested() const;
+
+    void setParallelLoadThreshold( qint64 threshold ) { parallelLoadThreshold_ = threshold; }
+    qint64 parallelLoadThreshold() const { return parallelLoadThreshold_; }
+
+    void setValidateWholeFile( bool enabled ) { validateWholeFile_ = enabled; }
+    bool validateWholeFile() const { return validateWholeFile_; }
+
+    void setSaveBufferSize( int size ) { saveBufferSize_ = size; }
+    int saveBufferSize() const { return saveBufferSize_; }
+
+    /// Restore the line endings of a file with mixed line endings when saving? When loading, the lines with another
+    /// line ending than the document get LineEndingField line data, which is used when saving the document
+    void setPreserveLineEndings( bool enabled ) { preserveLineEndings_ = enabled; }
+    bool preserveLineEndings() const { return preserveLineEndings_; }
+
+    /// Sets the encoding of the file when it's already known (for example from a TextDocumentCache).
+    /// The encoding isn't detected then, which saves the validation of the complete file (0 detects the encoding)
+    void setKnownEncoding( TextCodec* codec ) { knownCodecRef_ = codec; }
+    TextCodec* knownEncoding() const { return knownCodecRef_; }
+    void setKnownLineOffsets( const QVector<TextOffset>& lineOffsets, TextOffset textLength );
+    /// Returns true if the known line offsets didn't match the newlines of the text of the last load call
+    bool knownLineOffsetsRejected() const { return knownLineOffsetsRejected_; }
 
     QString errorString() { return errorString_; }
     void setFilter( TextDocumentSerializerFilter* filter ) { filterRef_ = filter; }
     TextDocumentSerializerFilter* filter() { return filterRef_; }
+    void setListener( TextDocumentSerializerListener* listener ) { listenerRef_ = listener; }
+    TextDocumentSerializerListener* listener() { return listenerRef_; }
+
+    /// Returns the encoding detected by the last load call
+    TextCodec* detectedEncoding() const { return detectedCodecRef_; }
+    /// Returns the line ending detected by the last load call
+    const LineEnding* detectedLineEnding() const { return detectedLineEndingRef_; }
+    /// Returns the line endings of the file of the last load call
+    const LineEndingStatistics& lineEndingStatistics() const { return lineEndingStatistics_; }
+    void giveLineEndingData( TextDocument* document, int firstLine=0 );
 
 private:
-    QString appendBufferToDocument(const QString& strIn);
+    TextCodec* detectCodec( QIODevice* ioDevice, const char* data, qint64 length, bool wholeFile );
+    void loadBuffer( QIODevice* ioDevice, TextBuffer* buffer );
+    void loadSerial( QIODevice* ioDevice, TextBuffer* buffer );
+    bool loadParallel( QIODevice* ioDevice, TextBuffer* buffer );
+    bool matchesKnownLineOffsets( TextBuffer* buffer ) const;
+    void appendNormalizedToBuffer( TextBuffer* buffer, QString& text, bool finish, bool& pendingCarriageReturn );
+    void appendDecodedToBuffer( TextBuffer* buffer, TextDecoder* decoder, const char* data, int length, QString& decodeBuffer, bool& pendingCarriageReturn );
+    bool saveText( QIODevice* ioDevice, const TextSnapshot* snapshot, TextCodec* codec, const LineEnding* lineEnding );
+    void saveLines( TextEncoder* encoder, const TextSnapshot* snapshot, const LineEnding* lineEnding, QIODevice* ioDevice, QByteArray& buffer );
+    void saveChunks( TextEncoder* encoder, const TextSnapshot* snapshot, QIODevice* ioDevice, QByteArray& buffer );
+    void copyLineWithoutNewline( const TextSnapshot* snapshot, int line, QString& text );
+    bool stopIfRequested();
+    void reportProgress( qint64 processed, qint64 total );
+    bool writeBuffer( QIODevice* ioDevice, QByteArray& buffer );
 
 private:
     TextDocument* textDocumentRef_;             ///< The reference to the textdocument
-    int blockSize_;                             ///< The block-size to read/write. you must NOT makes this to small.. The first block is used to detected the encoding!!
+    int blockSize_;                             ///< The block-size to read. you must NOT makes this to small.. The first block is used to detected the encoding!!
+    int saveBufferSize_;                        ///< The size of the output buffer (in bytes) for saving
     QString errorString_;                       ///< The last error (This is reset when calling load/save)
     TextDocumentSerializerFilter* filterRef_;   ///< The line filter
+    qint64 parallelLoadThreshold_;              ///< The minimal size (in bytes) of a device to load it with the ParallelTextDecoder
+    bool validateWholeFile_;                    ///< Validate the complete file to detect the encoding? (instead of the first block)
+    bool preserveLineEndings_;                  ///< Restore the line endings of the lines of a file with mixed line endings when saving?
+    TextDocumentSerializerListener* listenerRef_;   ///< The progress listener
+    QAtomicInt stopRequested_;                  ///< Is stopping requested? (1 when requested)
+    TextCodec* detectedCodecRef_;               ///< The encoding detected by the last load
+    TextCodec* knownCodecRef_;                  ///< The known encoding of the file (0 if it must be detected)
+    QVector<TextOffset> knownLineOffsets_;      ///< The known line offsets of the text (the offsets after the newlines)
+    TextOffset knownTextLength_;                ///< The length of the text of the known line offsets (-1 if unknown)
+    bool knownLineOffsetsRejected_;             ///< Didn't the known line offsets match the text of the last load?
+    const LineEnding* detectedLineEndingRef_;   ///< The line ending detected by the last load
+    LineEndingStatistics lineEndingStatistics_; ///< The line endings of the file of the last load
 };
 
 } // edbee
@@ -0,0 +1,346 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textdocumentserializerjob.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QThread>
+
+#include "edbee/io/textdocumentserializer.h"
+#include "edbee/models/chardocument/chartextbuffer.h"
+#include "edbee/models/textdocument.h"
+#include "edbee/models/textsnapshot.h"
+#include "edbee/models/textundostack.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// The thread that loads or saves the file. The members are set before the thread is started
+/// and are read by the job after the thread is finished
+class TextDocumentSerializerJob::Worker : public QThread, public TextDocumentSerializerListener
+{
+public:
+    Worker( TextDocumentSerializerJob* job, TextDocument* document )
+        : jobRef_(job)
+        , targetThreadRef_(job->thread())
+        , serializer_(document)
+        , codecRef_(0)
+        , lineEndingRef_(0)
+        , compactStorage_(false)
+        , lineOffsetTree_(false)
+        , buffer_(0)
+        , success_(false)
+        , lastProgress_(-1)
+    {
+        serializer_.setListener( this );
+    }
+
+    virtual ~Worker()
+    {
+        delete buffer_;
+    }
+
+    /// Forwards the progress to the job. The progress is only reported for every percent (or every MB when the total is unknown)
+    virtual void serializerProgress( TextDocumentSerializer* serializer, qint64 processed, qint64 total )
+    {
+        Q_UNUSED(serializer);
+        qint64 step = total > 0 ? total / 100 : 1024 * 1024;
+        if( lastProgress_ >= 0 && processed - lastProgress_ < step && processed != total ) { return; }
+        lastProgress_ = processed;
+        emit jobRef_->progress( processed, total );
+    }
+
+    TextDocumentSerializerJob* jobRef_;      ///< The job
+    QThread* targetThreadRef_;               ///< The thread of the job (the loaded buffer is moved to this thread)
+    TextDocumentSerializer serializer_;      ///< The serializer
+    QString fileName_;                       ///< The file to load or save
+    TextSnapshot snapshot_;                  ///< The snapshot to save
+    TextCodec* codecRef_;                    ///< The encoding to save with
+    const LineEnding* lineEndingRef_;        ///< The line ending to save with
+    bool compactStorage_;                    ///< Should the loaded buffer use compact storage? (like the document buffer)
+    bool lineOffsetTree_;                    ///< Should the loaded buffer use the line offset tree? (like the document buffer)
+    CharTextBuffer* buffer_;                 ///< The buffer with the loaded text (owned)
+    bool success_;                           ///< Is the file loaded/saved successfully?
+    QString errorString_;                    ///< The error when the file isn't loaded/saved
+    qint64 lastProgress_;                    ///< The last reported progress
+
+protected:
+
+    /// Loads the file in a detached buffer or saves the snapshot
+    virtual void run()
+    {
+        if( jobRef_->operation() == LoadOperation ) {
+            load();
+        } else {
+            save();
+        }
+    }
+
+private:
+
+    void load()
+    {
+        buffer_ = new CharTextBuffer();
+        buffer_->setCompactStorageEnabled( compactStorage_ );
+        buffer_->setLineOffsetTreeEnabled( lineOffsetTree_ );
+
+        QFile file( fileName_ );
+        if( file.open( QIODevice::ReadOnly ) ) {
+            success_ = serializer_.loadBufferWithoutOpening( &file, buffer_ );
+            errorString_ = serializer_.errorString();
+        } else {
+            errorString_ = file.errorString();
+        }
+
+        // the buffer is swapped in on the thread of the job
+        buffer_->moveToThread( targetThreadRef_ );
+    }
+
+    void save()
+    {
+        QSaveFile file( fileName_ );
+        if( !file.open( QIODevice::WriteOnly ) ) {
+            errorString_ = file.errorString();
+            return;
+        }
+        success_ = serializer_.saveSnapshotWithoutOpening( &file, snapshot_, codecRef_, lineEndingRef_ );
+        if( !success_ ) {
+            errorString_ = serializer_.errorString();
+            file.cancelWriting();
+            return;
+        }
+
+        // replace the file
+        success_ = file.commit();
+        if( !success_ ) {
+            errorString_ = file.errorString();
+        }
+    }
+};
+
+
+
+//=====================================================
+
+
+/// Constructs a job to load or save the given document. The job isn't started
+/// @param operation load or save the document
+/// @param document the document to load or save
+/// @param fileName the file to load or save
+/// @param parent the parent object
+TextDocumentSerializerJob::TextDocumentSerializerJob(Operation operation, TextDocument* document, const QString& fileName, QObject* parent)
+    : QObject(parent)
+    , operation_(operation)
+    , documentRef_(document)
+    , fileName_(fileName)
+    , worker_(0)
+    , started_(false)
+    , finished_(false)
+    , success_(false)
+{
+    Q_ASSERT(document);
+    worker_ = new Worker( this, document );
+    worker_->fileName_ = fileName;
+    connect( worker_, SIGNAL(finished()), this, SLOT(workerFinished()) );
+}
+
+
+/// The destructor cancels and waits for a running job. When loading, the document isn't changed
+TextDocumentSerializerJob::~TextDocumentSerializerJob()
+{
+    if( worker_->isRunning() ) {
+        cancel();
+        worker_->wait();
+    }
+    delete worker_;
+}
+
+
+/// Creates and starts a job that loads the given file in the document
+/// @param document the document to load the file in, the text of this document is replaced
+/// @param fileName the file to load
+/// @param parent the parent of the job
+/// @return the started job
+TextDocumentSerializerJob* TextDocumentSerializerJob::load(TextDocument* document, const QString& fileName, QObject* parent)
+{
+    TextDocumentSerializerJob* job = new TextDocumentSerializerJob( LoadOperation, document, fileName, parent );
+    job->start();
+    return job;
+}
+
+
+/// Creates and starts a job that saves the document to the given file
+/// @param document the document to save
+/// @param fileName the file to save to
+/// @param parent the parent of the job
+/// @return the started job
+TextDocumentSerializerJob* TextDocumentSerializerJob::save(TextDocument* document, const QString& fileName, QObject* parent)
+{
+    TextDocumentSerializerJob* job = new TextDocumentSerializerJob( SaveOperation, document, fileName, parent );
+    job->start();
+    return job;
+}
+
+
+/// Returns the operation of this job
+TextDocumentSerializerJob::Operation TextDocumentSerializerJob::operation() const
+{
+    return operation_;
+}
+
+
+/// Returns the document (0 when the document is deleted)
+TextDocument* TextDocumentSerializerJob::document() const
+{
+    return documentRef_.data();
+}
+
+
+/// Returns the file that's loaded or saved
+QString TextDocumentSerializerJob::fileName() const
+{
+    return fileName_;
+}
+
+
+/// Sets the minimal file size to load the file with the parallel decoder (see TextDocumentSerializer)
+/// This should be called before the job is started
+void TextDocumentSerializerJob::setParallelLoadThreshold(qint64 threshold)
+{
+    Q_ASSERT(!started_);
+    worker_->serializer_.setParallelLoadThreshold( threshold );
+}
+
+
+/// Gives the lines of a loaded file with mixed line endings their line ending as line data
+/// (see TextDocumentSerializer::setPreserveLineEndings). A save job doesn't restore these line endings,
+/// because the line data isn't part of the snapshot. This should be called before the job is started
+void TextDocumentSerializerJob::setPreserveLineEndings(bool enabled)
+{
+    Q_ASSERT(!started_);
+    worker_->serializer_.setPreserveLineEndings( enabled );
+}
+
+
+/// Starts loading or saving on the worker thread.
+/// When saving, a snapshot of the document is taken. Changes after this moment aren't saved
+void TextDocumentSerializerJob::start()
+{
+    Q_ASSERT(!started_);
+    Q_ASSERT(documentRef_);
+    started_ = true;
+
+    if( operation_ == LoadOperation ) {
+        CharTextBuffer* buffer = dynamic_cast<CharTextBuffer*>( documentRef_->buffer() );
+        if( buffer ) {
+            worker_->compactStorage_ = buffer->isCompactStorageEnabled();
+            worker_->lineOffsetTree_ = buffer->isLineOffsetTreeEnabled();
+        }
+    } else {
+        worker_->snapshot_ = documentRef_->snapshot();
+        worker_->codecRef_ = documentRef_->encoding();
+        worker_->lineEndingRef_ = documentRef_->lineEnding();
+    }
+    worker_->start();
+}
+
+
+/// Blocks until the job is finished. The document is loaded when this method returns
+/// @return true if the document is loaded/saved
+bool TextDocumentSerializerJob::waitForFinished()
+{
+    workerFinished();
+    return success_;
+}
+
+
+/// Returns true if the job is loading/saving
+bool TextDocumentSerializerJob::isRunning() const
+{
+    return started_ && !finished_;
+}
+
+
+/// Returns true if the job is finished (the finished signal has been emitted)
+bool TextDocumentSerializerJob::isFinished() const
+{
+    return finished_;
+}
+
+
+/// Returns true if the job is cancelled
+bool TextDocumentSerializerJob::isCancelled() const
+{
+    return worker_->serializer_.isStopRequested();
+}
+
+
+/// Returns true if the document is loaded/saved successfully
+bool TextDocumentSerializerJob::isSuccessful() const
+{
+    return success_;
+}
+
+
+/// Returns the error of a failed job
+QString TextDocumentSerializerJob::errorString() const
+{
+    return errorString_;
+}
+
+
+/// Cancels the job. When loading, the document isn't changed. When saving, the existing file isn't changed.
+/// The finished signal is still emitted (with success false), unless the job is already finished
+void TextDocumentSerializerJob::cancel()
+{
+    worker_->serializer_.requestStop();
+}
+
+
+/// This slot is called when the worker thread is finished (or by waitForFinished).
+/// The loaded text is swapped in the document
+void TextDocumentSerializerJob::workerFinished()
+{
+    if( finished_ || !started_ ) { return; }
+
+    // the finished signal is emitted just before the thread ends
+    worker_->wait();
+    finished_ = true;
+    success_ = worker_->success_;
+    errorString_ = worker_->errorString_;
+
+    // a load that's cancelled after the file was read, is still cancelled
+    if( operation_ == LoadOperation && isCancelled() ) {
+        success_ = false;
+        errorString_ = tr("Cancelled");
+    }
+    if( success_ && !documentRef_ ) {
+        success_ = false;
+        errorString_ = tr("The document is deleted");
+    }
+
+    if( success_ ) {
+        if( operation_ == LoadOperation ) {
+            documentRef_->rawReplaceText( worker_->buffer_ );
+            documentRef_->setEncoding( worker_->serializer_.detectedEncoding() );
+            documentRef_->setLineEnding( worker_->serializer_.detectedLineEnding() );
+            documentRef_->setLineEndingStatistics( worker_->serializer_.lineEndingStatistics() );
+            if( worker_->serializer_.preserveLineEndings() ) { worker_->serializer_.giveLineEndingData( documentRef_ ); }
+            documentRef_->textUndoStack()->setPersisted(true);
+        } else if( documentRef_->revision() == worker_->snapshot_.revision() ) {
+            documentRef_->textUndoStack()->setPersisted(true);
+        }
+    }
+
+    // the loaded buffer isn't required anymore
+    delete worker_->buffer_;
+    worker_->buffer_ = 0;
+
+    emit finished( success_ );
+}
+
+
+} // edbee
@@ -0,0 +1,99 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+namespace edbee {
+
+class TextDocument;
+
+
+/// Loads or saves a document on a background thread, so the event loop isn't blocked by large files.
+///
+/// Loading happens in a detached textbuffer. When loading is finished the text of the document is replaced
+/// with the loaded text at once (TextDocument::rawReplaceText), so the document is never partially loaded.
+/// Saving writes an immutable TextSnapshot to a temporary file, which replaces the file when saving
+/// is finished (QSaveFile). So the document can be changed while it's being saved, and a failed or cancelled
+/// save never leaves a partial file.
+///
+/// The job reports the progress with the progress signal and can be cancelled at any moment.
+/// The job must be created and started on the thread of the document (the GUI thread).
+///
+/// @code
+/// TextDocumentSerializerJob* job = TextDocumentSerializerJob::load( document, fileName, this );
+/// connect( job, SIGNAL(progress(qint64,qint64)), SLOT(showProgress(qint64,qint64)) );
+/// connect( job, SIGNAL(finished(bool)), SLOT(loadFinished(bool)) );
+/// @endcode
+class EDBEE_EXPORT TextDocumentSerializerJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Operation {
+        LoadOperation,
+        SaveOperation
+    };
+
+    TextDocumentSerializerJob( Operation operation, TextDocument* document, const QString& fileName, QObject* parent=0 );
+    virtual ~TextDocumentSerializerJob();
+
+    static TextDocumentSerializerJob* load( TextDocument* document, const QString& fileName, QObject* parent=0 );
+    static TextDocumentSerializerJob* save( TextDocument* document, const QString& fileName, QObject* parent=0 );
+
+    Operation operation() const;
+    TextDocument* document() const;
+    QString fileName() const;
+
+    void setParallelLoadThreshold( qint64 threshold );
+    void setPreserveLineEndings( bool enabled );
+
+    void start();
+    bool waitForFinished();
+
+    bool isRunning() const;
+    bool isFinished() const;
+    bool isCancelled() const;
+    bool isSuccessful() const;
+    QString errorString() const;
+
+public slots:
+
+    void cancel();
+
+signals:
+
+    /// This signal is emitted while loading/saving
+    /// @param processed the number of processed bytes (loading) or characters (saving)
+    /// @param total the total number of bytes or characters (0 if unknown)
+    void progress( qint64 processed, qint64 total );
+
+    /// This signal is emitted when the job is finished (also after a failure or cancellation)
+    /// @param success true when the document is loaded (or saved)
+    void finished( bool success );
+
+private slots:
+
+    void workerFinished();
+
+private:
+    class Worker;
+
+    Operation operation_;                    ///< The operation of this job
+    QPointer<TextDocument> documentRef_;     ///< The document to load or save
+    QString fileName_;                       ///< The file to load or save
+    Worker* worker_;                         ///< The worker thread
+    bool started_;                           ///< Is the job started?
+    bool finished_;                          ///< Is the job finished?
+    bool success_;                           ///< Is the document loaded/saved successfully?
+    QString errorString_;                    ///< The error of a failed job
+
+    Q_DISABLE_COPY(TextDocumentSerializerJob)
+};
+
+} // edbee
@@ -4,8 +4,8 @@
 #include "grammartextlexer.h"
 
 #include <limits>
-#include <QStack>
 
+#include "edbee/models/textbuffer.h"
 #include "edbee/models/textgrammar.h"
 #include "edbee/models/textdocument.h"
 #include "edbee/models/textdocumentscopes.h"
@@ -16,11 +16,22 @@
 
 namespace edbee {
 
+/// The minimal number of candidate rules to search them with a regexp set. The rule with the match is searched again
+/// (for the captures), so for a few rules a set doesn't save any searches
+static const int RegExpSetMinimumRuleCount = 4;
+
+
 /// Constructs the grammar textlexer
 /// @param scopes a reference to the scopes model
 GrammarTextLexer::GrammarTextLexer(TextDocumentScopes* scopes)
     : TextLexer( scopes )
     , lineRangeList_( 0 )
+    , maxRelexLineCount_( 100 )
+    , matchCacheLine_( 0 )
+    , matchCacheEnabled_( true )
+    , regExpSetEnabled_( true )
+    , ruleEvaluationCount_( 0 )
+    , regExpSearchCount_( 0 )
 {
     setGrammar( Edbee::instance()->grammarManager()->defaultGrammar() );
 }
@@ -54,7 +65,8 @@ RegExp* GrammarTextLexer::createEndRegExp( RegExp* startRegExp, const QString& e
         // append the 'match'
         int nr = matcher.cap(1).toInt();
         if( nr >= 0 ) {
-            endRegExpString.append( startRegExp->cap(nr) );
+            QStringView capture = startRegExp->capView(nr);
+            endRegExpString.append( capture.data(), int( capture.size() ) );
         }
         lastPos = pos + len + 1;
     }
@@ -63,76 +75,84 @@ RegExp* GrammarTextLexer::createEndRegExp( RegExp* startRegExp, const QString& e
 }
 
 
-/// Search the next grammar rule
+/// Searches the regexp of a rule in the line. A line is searched for many tokens, but most rules match after the
+/// found token. So the result of the previous search of the regexp in the same line is reused when it's still valid:
+/// a match at or after the offset, or no match at all. (The regexp still contains the captures of that match)
+/// @param regExp the regexp of the rule
+/// @param line the line to search
+/// @param offsetInLine the offset to start searching
+/// @return the found position (-1 if not found)
+int GrammarTextLexer::searchRuleRegExp( RegExp* regExp, const QString& line, int offsetInLine )
+{
+    ++ruleEvaluationCount_;
+    if( !matchCacheEnabled_ ) {
+        ++regExpSearchCount_;
+        return regExp->indexIn( QStringView( line ), offsetInLine );
+    }
+
+    QHash<RegExp*,RegExpMatch>::iterator itr = matchCache_.find( regExp );
+    if( itr == matchCache_.end() ) {
+        RegExpMatch match = { -1, 0, -1, !regExp->pattern().contains( QStringLiteral("\\G") ) };
+        itr = matchCache_.insert( regExp, match );
+    }
+    RegExpMatch& match = itr.value();
+    if( match.line == matchCacheLine_ && match.offset <= offsetInLine && ( match.pos >= offsetInLine || match.pos == -1 ) ) {
+        return match.pos;
+    }
+
+    ++regExpSearchCount_;
+    int pos = regExp->indexIn( QStringView( line ), offsetInLine );
+    if( match.cacheable ) {
+        match.line = matchCacheLine_;
+        match.offset = offsetInLine;
+        match.pos = pos;
+    }
+    return pos;
+}
+
+
+/// Search the next grammar rule. The candidate rules of the active rule are compiled by the grammar manager
+/// (with resolved includes), so this is a single loop without allocations. When there are enough candidates,
+/// all candidates are searched at once with the regexp set of the active rule
 /// @param (out) foundRegExp the found regexp
 /// @param (out) foundPosition the found position
 /// @return the grammarRule found
 void GrammarTextLexer::findNextGrammarRule( const QString& line, int offsetInLine, TextGrammarRule* activeRule, TextGrammarRule*& foundRule, RegExp*& foundRegExp, int& foundPosition )
 {
-
-    // next iterate over all rules and find the rule with the lowest offset
-    QStack<TextGrammarRule::Iterator*> ruleIterators;
-    ruleIterators.push( activeRule->createIterator() );
-    while( !ruleIterators.isEmpty() ) {
-
-        while( ruleIterators.top()->hasNext() ) {
-            TextGrammarRule* rule = ruleIterators.top()->next(); //activeRule->rule(i);
-
-            bool processNewRule = false;
-            do {
-                processNewRule = false;
-//qlog_info() << "     -   " << ":" << rule->toString(false);
-                switch( rule->instruction() ) {
-                    case TextGrammarRule::SingleLineRegExp:
-                    case TextGrammarRule::MultiLineRegExp:
-                    {
-                        // only use this match if the offset < foundPosition
-                        int pos = rule->matchRegExp()->indexIn( line, offsetInLine );
-                        if( pos >= 0 ) {
-                            if( pos < foundPosition ) {
-                                foundRule      = rule;
-                                foundRegExp    = rule->matchRegExp();
-                                foundPosition   = pos;
-                            }
-                        }
-                        break;
-                    }
-
-                    // and include rule
-                    case TextGrammarRule::IncludeCall:
-                    {
-                        TextGrammarRule* includedRule= findIncludeGrammarRule( rule);
-                        if( includedRule ) {
-                            // a rule list, append the iterator
-                            if( includedRule->isRuleList() || includedRule->isMainRule() ) {
-                                ruleIterators.push_back( includedRule->createIterator() );
-
-                            // a normal rule? We need to process this one again
-                            } else {
-                                rule = includedRule;
-                                processNewRule = true;
-                            }
-                        } else {
-                            qlog_warn() << "ERROR, include rule" << rule->includeName() << "not found!" ;
-                        }
-                        break;
-                    }
-                    case TextGrammarRule::MainRule:
-                        Q_ASSERT(false && "a mainrule as child is not allowed!");
-                        break;
-                    case TextGrammarRule::RuleList:
-                        Q_ASSERT(false && "a rule list is not directly allowed!");
-                        break;
-                    default:
-                        Q_ASSERT(false && "unkown rule");
+    TextGrammarManager* grammarManager = Edbee::instance()->grammarManager();
+    const QVector<TextGrammarRule*>& rules = grammarManager->compiledRules( grammar(), activeRule );
+
+    if( regExpSetEnabled_ && rules.size() >= RegExpSetMinimumRuleCount ) {
+        RegExpSet* regExpSet = grammarManager->compiledRegExpSet( grammar(), activeRule );
+        if( regExpSet->isValid() ) {
+            ++regExpSearchCount_;
+            int pos = regExpSet->indexIn( line, offsetInLine );
+            if( pos >= 0 && pos < foundPosition ) {
+                // search the regexp of the rule itself, which finds the same match, for the captures
+                TextGrammarRule* rule = rules.at( regExpSet->matchedIndex() );
+                pos = searchRuleRegExp( rule->matchRegExp(), line, offsetInLine );
+                if( pos >= 0 && pos < foundPosition ) {
+                    foundRule      = rule;
+                    foundRegExp    = rule->matchRegExp();
+                    foundPosition  = pos;
                 }
             }
-            while( processNewRule );
-        } // while hasNext
-
-        delete ruleIterators.pop();
+            return;
+        }
+    }
 
-    }// while ruleIterators
+    // next iterate over all rules and find the rule with the lowest offset
+    for( int i=0, cnt=rules.size(); i < cnt; ++i ) {
+        TextGrammarRule* rule = rules.at(i);
+
+        // only use this match if the offset < foundPosition
+        int pos = searchRuleRegExp( rule->matchRegExp(), line, offsetInLine );
+        if( pos >= 0 && pos < foundPosition ) {
+            foundRule      = rule;
+            foundRegExp    = rule->matchRegExp();
+            foundPosition  = pos;
+        }
+    }
 }
 
 
@@ -168,7 +188,7 @@ void GrammarTextLexer::processCaptures( RegExp* foundRegExp, const QMap<int, QSt
 /// @param currentDocOffset the current document offset
 /// @param line the line that's being matches
 /// @param offsetInLine (in/out) the current offset in the line
-TextGrammarRule* GrammarTextLexer::findAndApplyNextGrammarRule( int currentDocOffset, const QString& line, int& offsetInLine  )
+TextGrammarRule* GrammarTextLexer::findAndApplyNextGrammarRule( TextOffset currentDocOffset, const QString& line, int& offsetInLine  )
 {
     Q_ASSERT(lineRangeList_);
 
@@ -186,7 +206,8 @@ TextGrammarRule* GrammarTextLexer::findAndApplyNextGrammarRule( int currentDocOf
 
     // first try to close the active rule
     if( activeMultiRange->endRegExp() ) {
-        if( activeMultiRange->endRegExp()->indexIn( line, offsetInLine ) >= 0 ) {
+        ++regExpSearchCount_;
+        if( activeMultiRange->endRegExp()->indexIn( QStringView( line ), offsetInLine ) >= 0 ) {
             foundRule      = activeRule;
             foundRegExp    = activeMultiRange->endRegExp();
             foundPosition  = foundRegExp->pos();
@@ -310,53 +331,164 @@ void GrammarTextLexer::pushActiveRange(ScopedTextRange* range, MultiLineScopedTe
 }
 
 
-/// T his method finds the 'included' grammar rule
-TextGrammarRule* GrammarTextLexer::findIncludeGrammarRule(TextGrammarRule* base)
+/// This method is called to notify the lexer some data has been changed
+//void GrammarTextLexer::textReplaced( int offset, int length, int newLength )
+void GrammarTextLexer::textChanged( const TextBufferChange& change )
 {
-    Q_ASSERT( base->isIncludeCall() );
-    QString name = base->includeName();
-
-    // repos call
-    if( name.startsWith("#")) {
-        return base->grammar()->findFromRepos( name.mid(1) );
+    // lex the changed lines again, the scopes after the lines are kept when the lexer state converges
+    if( relexChangedLines( change ) ) { return; }
 
-    }
-    // another language call
-    // The difference between $base and $self is very subtle.. The exact difference is unkown to me..
-    if( name=="$base" || name == "$self" ) {
-        return grammar()->mainRule();
-    }
+    TextDocument* doc = textDocument();
+    TextDocumentScopes* docScopes = textScopes();
 
-    TextGrammar* grammar = Edbee::instance()->grammarManager()->get( name );
-    if( grammar ) { return grammar->mainRule(); }
-    return 0;
+    TextOffset offsetStart = doc->offsetFromLine(change.line());
+    docScopes->removeScopesAfterOffset(offsetStart);
 }
 
 
-
-/// This method is called to notify the lexer some data has been changed
-//void GrammarTextLexer::textReplaced( int offset, int length, int newLength )
-void GrammarTextLexer::textChanged( const TextBufferChange& change )
+/// Lexes the changed lines again, until the lexer state at the end of a line is the same as the state before the change.
+/// The scopes after that line don't change, so they are kept: the line ranges move with the lines and the multi-line
+/// ranges are moved with the change. When the state doesn't converge within maxRelexLineCount lines, the scopes after
+/// the lexed lines are removed (and lexed when required).
+///
+/// @param change the change (the text of the document is already changed)
+/// @return true if the lines are lexed again, false if the scopes after the changed lines weren't lexed before the change
+bool GrammarTextLexer::relexChangedLines( const TextBufferChange& change )
 {
     TextDocument* doc = textDocument();
     TextDocumentScopes* docScopes = textScopes();
+    int line = change.line();
+    int lastChangedLine = line + change.newLineCount();
+    TextOffset delta = change.newTextLength() - change.length();
+    TextOffset oldLastScopedOffset = docScopes->lastScopedOffset();
+
+    // only when the line after the change was lexed before the change there's something to keep
+    if( change.newLineCount() >= maxRelexLineCount_ || lastChangedLine + 1 >= doc->lineCount() ) { return false; }
+    if( doc->offsetFromLine( lastChangedLine + 1 ) - delta > oldLastScopedOffset ) { return false; }
+
+    matchCache_.clear();
+
+    // the changed lines get empty range lists, the list of the last changed line (with the old end state) moves to the new last line
+    TextOffset offsetStart = doc->offsetFromLine( line );
+    docScopes->replaceLineScopedRangeLists( line, change.lineCount(), change.newLineCount() );
+
+    // the multi-line ranges that start in the lexed lines are taken out (the next lines can still refer to them).
+    // The ranges that are active at the start are open until they're closed again, their old end is remembered.
+    QList<MultiLineScopedTextRange*> oldRanges = docScopes->takeMultiLineScopedRangesAfterOffset( offsetStart );
+    activeMultiLineRangesRefList_ = docScopes->multiLineScopedRangesBetweenOffsets( offsetStart, offsetStart );
+    QVector<MultiLineScopedTextRange*> startState = activeMultiLineRangesRefList_;
+    QVector<TextOffset> startStateEnds;
+    for( int i=1; i < startState.size(); ++i ) {
+        startStateEnds.append( startState.at(i)->max() );
+        startState.at(i)->maxVar() = doc->length();
+    }
+    docScopes->setLastScopedOffset( offsetStart );
+
+    // lex the lines until the state at the end of a line is the same as before the change
+    TextOffset currentDocOffset = offsetStart;
+    int nextLine = line;
+    int endLine = qMin( line + maxRelexLineCount_, doc->lineCount() );
+    while( nextLine < endLine ) {
+        QVector<MultiLineScopedTextRange*> oldState;
+        ScopedTextRangeList* oldList = docScopes->scopedRangesAtLine( nextLine );
+        if( oldList ) { oldState = oldList->endState(); }
+
+        lexLine( nextLine, currentDocOffset );
+        ++nextLine;
+
+        // the old state is only valid for lines that were completely lexed before the change
+        if( currentDocOffset - delta > oldLastScopedOffset ) { break; }
+        if( !isConvergedState( oldState, startState ) ) { continue; }
+
+        // the ranges that are still active continue after this line
+        for( int i=1; i < oldState.size(); ++i ) {
+            MultiLineScopedTextRange* oldRange = oldState.at(i);
+            MultiLineScopedTextRange* newRange = activeMultiLineRangesRefList_.at(i);
+
+            // a range that was active at the start gets its old end back
+            if( oldRange == newRange ) {
+                oldRange->maxVar() = startStateEnds.at( startState.indexOf( oldRange ) - 1 ) + delta;
+
+            // the old range (which the next lines refer to) replaces the new range
+            } else {
+                oldRange->set( newRange->min(), oldRange->max() + delta );
+                for( int lineIdx=line; lineIdx < nextLine; ++lineIdx ) {
+                    docScopes->scopedRangesAtLine( lineIdx )->replaceMultiLineScopedTextRange( newRange, oldRange );
+                }
+                docScopes->replaceMultiLineScopedTextRange( newRange, oldRange );
+                oldRanges.removeOne( oldRange );
+            }
+        }
 
-    int offsetStart = doc->offsetFromLine(change.line());
-    docScopes->removeScopesAfterOffset(offsetStart);
+        // the ranges after this line are moved, the other ranges have been lexed again
+        TextOffset oldOffset = currentDocOffset - delta;
+        foreach( MultiLineScopedTextRange* range, oldRanges ) {
+            if( range->min() >= oldOffset ) {
+                range->set( range->anchor() + delta, range->caret() + delta );
+                docScopes->giveMultiLineScopedTextRange( range );
+            } else {
+                delete range;
+            }
+        }
+        activeMultiLineRangesRefList_.clear();
+        docScopes->setLastScopedOffset( oldLastScopedOffset + delta );
+        return true;
+    }
 
-    /// TODO: rebuild an optimized scope-rebuilding algorithm
+    // the state didn't converge, the scopes after the lexed lines are removed (the removed lines referred to the old ranges)
+    docScopes->replaceLineScopedRangeLists( nextLine, docScopes->scopedLineCount(), 0 );
+    qDeleteAll( oldRanges );
+    docScopes->removeScopesAfterOffset( currentDocOffset );
+    docScopes->setLastScopedOffset( currentDocOffset );
+    activeMultiLineRangesRefList_.clear();
+    return true;
+}
+
+
+/// Checks if the lexer state (after lexing a line) is the same as the state of the line before the change.
+/// The same rules with the same end regexps must be active. A range that was active before the lexed lines can't
+/// be replaced by another range (the lines before would refer to the wrong range).
+/// @param oldState the end state of the line before the change
+/// @param startState the active ranges at the start of the lexed lines
+bool GrammarTextLexer::isConvergedState( const QVector<MultiLineScopedTextRange*>& oldState, const QVector<MultiLineScopedTextRange*>& startState ) const
+{
+    if( oldState.isEmpty() || oldState.size() != activeMultiLineRangesRefList_.size() ) { return false; }
+    for( int i=0; i < oldState.size(); ++i ) {
+        MultiLineScopedTextRange* oldRange = oldState.at(i);
+        MultiLineScopedTextRange* newRange = activeMultiLineRangesRefList_.at(i);
+        if( oldRange == newRange ) { continue; }
+        if( startState.contains( oldRange ) || startState.contains( newRange ) ) { return false; }
+        if( oldRange->grammarRule() != newRange->grammarRule() ) { return false; }
+
+        // the end regexp can contain captures of the begin regexp
+        RegExp* oldEndRegExp = oldRange->endRegExp();
+        RegExp* newEndRegExp = newRange->endRegExp();
+        if( !oldEndRegExp || !newEndRegExp ) {
+            if( oldEndRegExp != newEndRegExp ) { return false; }
+        } else if( oldEndRegExp->pattern() != newEndRegExp->pattern() ) {
+            return false;
+        }
+    }
+    return true;
 }
 
 
 /// This method lexes a single line
 /// @return the last indexed offset
 /// WARNING lexline CANNOT be called indepdently of lexLines (beacuse lex-lines set the activeScopes!
-bool GrammarTextLexer::lexLine( int lineIdx, int& currentDocOffset )
+bool GrammarTextLexer::lexLine( int lineIdx, TextOffset& currentDocOffset )
 {
     TextDocument* doc = textDocument();
     TextDocumentScopes* docScopes = textScopes();
 
-    QString line        = doc->line(lineIdx); //+ "\n";
+    // the line directly wraps the buffer data when possible (no copying, and the buffer layout isn't changed)
+    // the document is never changed while lexing a line, so the data stays valid
+    QString lineStorage;
+    TextOffset lineDataOffset  = 0;
+    TextOffset lineOffset      = doc->offsetFromLine(lineIdx);
+    TextOffset lineLength      = doc->lineLength(lineIdx);
+    const QChar* lineData = doc->buffer()->rangeData( lineOffset, lineLength, lineStorage, lineDataOffset );
+    QString line        = QString::fromRawData( lineData + lineOffset - lineDataOffset, static_cast<int>( lineLength ) );
 
     //    int lineStartOffset = doc->offsetFromLine(lineIdx);
 
@@ -365,6 +497,7 @@ bool GrammarTextLexer::lexLine( int lineIdx, int& currentDocOffset )
     Q_ASSERT( activeScopedRangesRefList_.isEmpty() );
 
     lineRangeList_ = new ScopedTextRangeList();
+    ++matchCacheLine_;  // the cached matches are of the previous line
 
     // append the active ranges
     for( int i=0,cnt=activeMultiLineRangesRefList_.size(); i<cnt; ++i ) {
@@ -432,6 +565,9 @@ bool GrammarTextLexer::lexLine( int lineIdx, int& currentDocOffset )
     lineRangeList_->squeeze();  // free unused memory
     bool result = lineRangeList_->isIndependent();
 
+    // remember the state at the end of the line, so relexing after a change can stop when the state is the same
+    lineRangeList_->setEndState( activeMultiLineRangesRefList_ );
+
     // give the line to the document scopes
     docScopes->giveLineScopedRangeList( lineIdx, lineRangeList_ );
     lineRangeList_ = 0;
@@ -470,11 +606,12 @@ void GrammarTextLexer::lexLines(int lineStart,int lineCount)
 
     TextDocument* doc = textDocument();
     TextDocumentScopes* docScopes = textScopes();
+    matchCache_.clear();    // the regexps of the cache could have been deleted (changed grammar)
 
 //qlog_info() << "===== lexText(" << offset << "," << length << ") ["<<lineStart <<","<<lineEnd<<"] ======";
 
     // next find all 'active' scoped ranges
-    int offsetStart = doc->offsetFromLine(lineStart);
+    TextOffset offsetStart = doc->offsetFromLine(lineStart);
     activeMultiLineRangesRefList_ = docScopes->multiLineScopedRangesBetweenOffsets( offsetStart, offsetStart);
 
 //    GrammarRule* activeRule = grammarRef_->mainRule();
@@ -482,7 +619,7 @@ void GrammarTextLexer::lexLines(int lineStart,int lineCount)
 //    Q_ASSERT( activeRule );
 
     // next find the rule
-    int currentDocOffset = offsetStart;
+    TextOffset currentDocOffset = offsetStart;
     bool independent = true;
     for( int idx=0; idx<lineCount; ++idx) {
         independent = lexLine( lineStart+idx, currentDocOffset  ) && independent;
@@ -509,7 +646,7 @@ void GrammarTextLexer::lexLines(int lineStart,int lineCount)
 ///
 /// @param beginOffset the first offset
 /// @param endOffset the last offset to
-void GrammarTextLexer::lexRange( int beginOffset, int endOffset )
+void GrammarTextLexer::lexRange( TextOffset beginOffset, TextOffset endOffset )
 {
     Q_UNUSED(beginOffset);
 
@@ -523,7 +660,7 @@ void GrammarTextLexer::lexRange( int beginOffset, int endOffset )
     }
 
     // first we need to find the correct location to start from
-    int offset = docScopes->lastScopedOffset(); //qMin( docScopes->scopedToOffset(), offset );
+    TextOffset offset = docScopes->lastScopedOffset(); //qMin( docScopes->scopedToOffset(), offset );
 
     int lineStart   = doc->lineFromOffset(offset);
     int lineEnd     = doc->lineFromOffset(endOffset) + 1;
@@ -532,4 +669,71 @@ void GrammarTextLexer::lexRange( int beginOffset, int endOffset )
 }
 
 
+/// Sets the maximum number of lines that are lexed again after a change. When the lexer state doesn't converge
+/// within these lines, the scopes after the lines are removed. (0 always removes the scopes after a change)
+/// @param count the number of lines
+void GrammarTextLexer::setMaxRelexLineCount( int count )
+{
+    maxRelexLineCount_ = qMax( count, 0 );
+}
+
+
+/// Returns the maximum number of lines that are lexed again after a change
+int GrammarTextLexer::maxRelexLineCount() const
+{
+    return maxRelexLineCount_;
+}
+
+
+/// Enables or disables reusing the matches of the rule regexps in a line (this is enabled by default)
+void GrammarTextLexer::setMatchCacheEnabled( bool enabled )
+{
+    matchCacheEnabled_ = enabled;
+}
+
+
+/// Returns true if the matches of the rule regexps are reused
+bool GrammarTextLexer::isMatchCacheEnabled() const
+{
+    return matchCacheEnabled_;
+}
+
+
+/// Enables or disables searching the candidate rules with a single regexp set search (this is enabled by default).
+/// Without a regexp set every candidate rule is searched on its own
+void GrammarTextLexer::setRegExpSetEnabled( bool enabled )
+{
+    regExpSetEnabled_ = enabled;
+}
+
+
+/// Returns true if the candidate rules are searched with a regexp set
+bool GrammarTextLexer::isRegExpSetEnabled() const
+{
+    return regExpSetEnabled_;
+}
+
+
+/// Returns the number of rule regexps that have been evaluated (searched or reused) since the last resetCounters
+qint64 GrammarTextLexer::ruleEvaluationCount() const
+{
+    return ruleEvaluationCount_;
+}
+
+
+/// Returns the number of regexp searches (rule and end regexps) since the last resetCounters
+qint64 GrammarTextLexer::regExpSearchCount() const
+{
+    return regExpSearchCount_;
+}
+
+
+/// Resets the evaluation and search counters
+void GrammarTextLexer::resetCounters()
+{
+    ruleEvaluationCount_ = 0;
+    regExpSearchCount_ = 0;
+}
+
+
 } // edbee
@@ -5,6 +5,7 @@
 
 #include "edbee/exports.h"
 
+#include <QHash>
 #include <QMap>
 #include <QList>
 #include <QVector>
@@ -31,20 +32,42 @@ public:
     virtual void textChanged( const TextBufferChange& change );
 
 private:
-    virtual bool lexLine(int line, int& currentDocOffset );
+    virtual bool lexLine(int line, TextOffset& currentDocOffset );
 
 public:
     virtual void lexLines( int line, int lineCount );
-    virtual void lexRange( int beginOffset, int endOffset );
+    virtual void lexRange( TextOffset beginOffset, TextOffset endOffset );
+
+    void setMaxRelexLineCount( int count );
+    int maxRelexLineCount() const;
+
+    void setMatchCacheEnabled( bool enabled );
+    bool isMatchCacheEnabled() const;
+    void setRegExpSetEnabled( bool enabled );
+    bool isRegExpSetEnabled() const;
+    qint64 ruleEvaluationCount() const;
+    qint64 regExpSearchCount() const;
+    void resetCounters();
 
 private:
+    /// The result of the last search of a rule regexp in the current line
+    struct RegExpMatch {
+        int line;               ///< The lexed line (serial) of the search (-1 if not searched)
+        int offset;             ///< The offset in the line the search started
+        int pos;                ///< The found position (-1 if not found)
+        bool cacheable;         ///< Can the result be reused? (not for \G patterns, which match at the search offset)
+    };
+
+    bool relexChangedLines( const TextBufferChange& change );
+    bool isConvergedState( const QVector<MultiLineScopedTextRange*>& oldState, const QVector<MultiLineScopedTextRange*>& startState ) const;
 
     RegExp* createEndRegExp( RegExp* startRegExp, const QString &endRegExpStringIn);
 
+    int searchRuleRegExp( RegExp* regExp, const QString& line, int offsetInLine );
     void findNextGrammarRule(const QString &line, int offsetInLine, TextGrammarRule *activeRule, TextGrammarRule *&foundRule, RegExp*& foundRegExp, int& foundPosition );
     void processCaptures( RegExp *foundRegExp, const QMap<int,QString>* foundCaptures );
 
-    TextGrammarRule* findAndApplyNextGrammarRule(int currentDocOffset, const QString& line, int& offsetInLine  );
+    TextGrammarRule* findAndApplyNextGrammarRule(TextOffset currentDocOffset, const QString& line, int& offsetInLine  );
 
     MultiLineScopedTextRange* activeMultiLineRange();
     ScopedTextRange* activeScopedTextRange();
@@ -52,7 +75,6 @@ private:
     void popActiveRange();
     void pushActiveRange( ScopedTextRange* range, MultiLineScopedTextRange* multiRange );
 
-    TextGrammarRule* findIncludeGrammarRule( TextGrammarRule* base );
 
 private:
 
@@ -65,6 +87,14 @@ private:
 //    QVector<MultiLineScopedTextRange*> currentLineRangesList_;      ///< The current scope ranges (only valid during parsing)
 
     ScopedTextRangeList* lineRangeList_;                            ///< The scopes at current line (only valid during parsing)
+    int maxRelexLineCount_;                                         ///< The maximum number of lines that are lexed again after a change
+
+    QHash<RegExp*,RegExpMatch> matchCache_;                         ///< The last match of every rule regexp in the current line
+    int matchCacheLine_;                                            ///< The serial of the line that's being lexed (for the match cache)
+    bool matchCacheEnabled_;                                        ///< Are the matches of the rule regexps reused?
+    bool regExpSetEnabled_;                                         ///< Are the candidate rules searched with a single regexp set search?
+    qint64 ruleEvaluationCount_;                                    ///< The number of evaluated rule regexps
+    qint64 regExpSearchCount_;                                      ///< The number of regexp searches
 
 };
 
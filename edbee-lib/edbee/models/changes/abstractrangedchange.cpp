@@ -15,7 +15,7 @@ AbstractRangedChange::~AbstractRangedChange()
 
 /// Adds the given amount to the offset
 /// @param amount the offset to add
-void AbstractRangedChange::addOffset(int amount)
+void AbstractRangedChange::addOffset(TextOffset amount)
 {
     setOffset( offset() + amount );
 }
@@ -23,9 +23,9 @@ void AbstractRangedChange::addOffset(int amount)
 
 /// Calculates the merged length
 /// @param change the change that't being merged
-int AbstractRangedChange::getMergedDocLength(AbstractRangedChange* change)
+TextOffset AbstractRangedChange::getMergedDocLength(AbstractRangedChange* change)
 {
-    int result = change->docLength();
+    TextOffset result = change->docLength();
 
     // add the prefix of the a length
     if( offset() < change->offset() ) {
@@ -33,8 +33,8 @@ int AbstractRangedChange::getMergedDocLength(AbstractRangedChange* change)
     }
 
     // add the postfix of the length
-    int aEnd = offset() + docLength();
-    int bEnd = change->offset() + change->storedLength();
+    TextOffset aEnd = offset() + docLength();
+    TextOffset bEnd = change->offset() + change->storedLength();
     if( bEnd < aEnd ) {
         result += aEnd - bEnd;
     }
@@ -45,9 +45,9 @@ int AbstractRangedChange::getMergedDocLength(AbstractRangedChange* change)
 /// Calculates the merge data size, that's required for merging the given change
 /// @param change the change to merge with this change
 /// @return the size of this change
-int AbstractRangedChange::getMergedStoredLength(AbstractRangedChange* change)
+TextOffset AbstractRangedChange::getMergedStoredLength(AbstractRangedChange* change)
 {
-    int result = 0;
+    TextOffset result = 0;
 
     // we first need to 'take' the leading part of the new change
     if( change->offset() < offset() ) {
@@ -58,8 +58,8 @@ int AbstractRangedChange::getMergedStoredLength(AbstractRangedChange* change)
     result += storedLength();
 
     // then we need to append the remainer
-    int delta = offset()-change->offset();
-    int remainerOffset = docLength() + delta;
+    TextOffset delta = offset()-change->offset();
+    TextOffset remainerOffset = docLength() + delta;
     if( 0 <= remainerOffset && remainerOffset < change->storedLength()  ) {
         result += change->storedLength() - remainerOffset;
     }
@@ -92,7 +92,7 @@ void AbstractRangedChange::mergeStoredDataViaMemcopy(void* targetData, void* dat
 
     // we first need to 'take' the leading part of the new change
     if( change->offset() < offset() ) {
-        int size = itemSize * (offset() - change->offset() );
+        size_t size = itemSize * (offset() - change->offset() );
         memcopy_or_zerofill( target, changeData, size );
         target += size;
     }
@@ -102,8 +102,8 @@ void AbstractRangedChange::mergeStoredDataViaMemcopy(void* targetData, void* dat
     target += itemSize * storedLength() ;
 
     // then we need to append the remainer
-    int delta = offset()-change->offset();
-    int remainerOffset = docLength() + delta;
+    TextOffset delta = offset()-change->offset();
+    TextOffset remainerOffset = docLength() + delta;
     if( 0 <= remainerOffset && remainerOffset < change->storedLength()  ) {
         memcopy_or_zerofill( target, changeData ? ((char*)changeData) + (remainerOffset*itemSize) : 0, (change->storedLength()-remainerOffset) * itemSize  );
     }
@@ -119,8 +119,8 @@ bool AbstractRangedChange::merge( AbstractRangedChange* change )
     if( isOverlappedBy(change) || isTouchedBy(change) ) {
 
         // build the new sizes and offsets
-        int newOffset = qMin( offset(), change->offset() );
-        int newLength = getMergedDocLength(change);
+        TextOffset newOffset = qMin( offset(), change->offset() );
+        TextOffset newLength = getMergedDocLength(change);
 
         // merge the data
         mergeStoredData( change );
@@ -6,6 +6,7 @@
 #include "edbee/exports.h"
 
 #include "edbee/models/change.h"
+#include "edbee/textoffset.h"
 
 namespace edbee {
 
@@ -18,20 +19,20 @@ public:
     virtual ~AbstractRangedChange();
 
     /// this method should return the offset of the change
-    virtual int offset() const = 0;
+    virtual TextOffset offset() const = 0;
 
     /// this method should set the offset
-    virtual void setOffset( int value ) = 0;
-    void addOffset( int amount );
+    virtual void setOffset( TextOffset value ) = 0;
+    void addOffset( TextOffset amount );
 
     /// this method should set the old length
-    virtual void setDocLength( int value ) = 0;
+    virtual void setDocLength( TextOffset value ) = 0;
 
     /// this method should return the length in the document
-    virtual int docLength() const = 0;
+    virtual TextOffset docLength() const = 0;
 
     /// this method should return the length of this item in memory
-    virtual int storedLength() const = 0;
+    virtual TextOffset storedLength() const = 0;
 
 
 protected:
@@ -45,8 +46,8 @@ protected:
     virtual void mergeStoredData( AbstractRangedChange* change ) = 0;
 
 
-    int getMergedDocLength(AbstractRangedChange* change);
-    int getMergedStoredLength(AbstractRangedChange* change);
+    TextOffset getMergedDocLength(AbstractRangedChange* change);
+    TextOffset getMergedStoredLength(AbstractRangedChange* change);
     void mergeStoredDataViaMemcopy(void* targetData, void* data, void* changeData, AbstractRangedChange* change, int itemSize );
     bool merge( AbstractRangedChange* change );
 
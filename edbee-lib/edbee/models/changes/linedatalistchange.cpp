@@ -91,7 +91,7 @@ void LineDataListChange::mergeStoredData(AbstractRangedChange* change)
     if( !lineTextChange ) return;
 
     // calculate the new size
-    int newOldListSize = getMergedStoredLength( change);// qlog_info() << "CALCULATED: " << newOldListSize ;
+    int newOldListSize = static_cast<int>( getMergedStoredLength( change) );// qlog_info() << "CALCULATED: " << newOldListSize ;
 
     // no old data, we don't need to store anthing
     if( this->oldListList_ == 0 && lineTextChange->oldListList_ == 0 ) {
@@ -177,21 +177,21 @@ QString LineDataListChange::toString()
 
 
 /// Returns the line
-int LineDataListChange::offset () const
+TextOffset LineDataListChange::offset () const
 {
     return offset_;
 }
 
 
 /// Sets the new offset
-void LineDataListChange::setOffset(int value)
+void LineDataListChange::setOffset(TextOffset value)
 {
-    offset_ = value;
+    offset_ = static_cast<int>(value);
 }
 
 
 /// Retursn the length in the document/data
-int LineDataListChange::docLength() const
+TextOffset LineDataListChange::docLength() const
 {
     return docLength_;
 }
@@ -199,15 +199,15 @@ int LineDataListChange::docLength() const
 
 /// This method sets the old length
 /// @param value the new old-length value
-void LineDataListChange::setDocLength(int value)
+void LineDataListChange::setDocLength(TextOffset value)
 {
-    docLength_ = value;
+    docLength_ = static_cast<int>(value);
 }
 
 
 
 /// The lengt of the content in this object
-int LineDataListChange::storedLength() const
+TextOffset LineDataListChange::storedLength() const
 {
     return contentLength_;
 }
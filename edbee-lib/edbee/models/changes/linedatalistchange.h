@@ -30,13 +30,13 @@ public:
 
     virtual QString toString();
 
-    int offset() const;
-    void setOffset( int value );
+    TextOffset offset() const;
+    void setOffset( TextOffset value );
 
-    virtual int docLength() const;
-    void setDocLength( int value );
+    virtual TextOffset docLength() const;
+    void setDocLength( TextOffset value );
 
-    virtual int storedLength() const;
+    virtual TextOffset storedLength() const;
 
     TextLineDataList** oldListList();
     int oldListListLength();
@@ -80,7 +80,7 @@ void MergableChangeGroup::revert( TextDocument* document )
 
 
 /// This method adds the given delta to the changes
-void MergableChangeGroup::addOffsetDeltaToChanges(QList<AbstractRangedChange*>& changes, int fromIndex, int delta)
+void MergableChangeGroup::addOffsetDeltaToChanges(QList<AbstractRangedChange*>& changes, int fromIndex, TextOffset delta)
 {
     for(int i = fromIndex; i<changes.size(); ++i ) {
         AbstractRangedChange* s2 = changes.at(i);
@@ -92,7 +92,7 @@ void MergableChangeGroup::addOffsetDeltaToChanges(QList<AbstractRangedChange*>&
 /// This method finds the insert index for the given offset
 /// @param offset the offset of the change
 /// @return the inertindex used for inserting the data
-int MergableChangeGroup::findInsertIndexForOffset(QList<AbstractRangedChange*>& changes, int offset)
+int MergableChangeGroup::findInsertIndexForOffset(QList<AbstractRangedChange*>& changes, TextOffset offset)
 {
     int insertIndex = 0;
     for( int i=0,cnt=changes.size(); i<cnt; ++i ){
@@ -109,14 +109,14 @@ int MergableChangeGroup::findInsertIndexForOffset(QList<AbstractRangedChange*>&
 /// @param newChange the new change to merge
 /// @param delta (out) the delta applied to this change
 /// @return the merged index or -1 if not merged!
-int MergableChangeGroup::mergeChange(QList<AbstractRangedChange*>& changes, TextDocument* doc, AbstractRangedChange* newChange, int& delta)
+int MergableChangeGroup::mergeChange(QList<AbstractRangedChange*>& changes, TextDocument* doc, AbstractRangedChange* newChange, TextOffset& delta)
 {
     for( int i=0,cnt=changes.size(); i<cnt; ++i ){
         AbstractRangedChange* change = changes.at(i);
 
         // we need the previous length and new-length to know how the delta is changed of the other items
-        int prevNewLength = change->docLength();
-        int prevContentLength = change->storedLength();
+        TextOffset prevNewLength = change->docLength();
+        TextOffset prevContentLength = change->storedLength();
 
         // try to merge it
         if( change->giveAndMerge( doc, newChange ) ) {
@@ -135,7 +135,7 @@ int MergableChangeGroup::mergeChange(QList<AbstractRangedChange*>& changes, Text
 /// @param orgStartOffset the offset of the orgingal merged textchange
 /// @param orgEndoOffset the end offset of the original merged textchange
 /// @param delta the current delta used for offset calculating
-void MergableChangeGroup::inverseMergeRemainingOverlappingChanges(QList<AbstractRangedChange*>& changes, TextDocument* doc, int mergedAtIndex, int orgStartOffset, int orgEndOffset, int delta)
+void MergableChangeGroup::inverseMergeRemainingOverlappingChanges(QList<AbstractRangedChange*>& changes, TextDocument* doc, int mergedAtIndex, TextOffset orgStartOffset, TextOffset orgEndOffset, TextOffset delta)
 {
     AbstractRangedChange* mergedChange = changes.at(mergedAtIndex);
     for( int i=mergedAtIndex+1; i<changes.size(); ++i ) {
@@ -145,7 +145,7 @@ void MergableChangeGroup::inverseMergeRemainingOverlappingChanges(QList<Abstract
         if( nextChange->offset() < orgEndOffset && orgStartOffset < (nextChange->offset() + nextChange->docLength())   ) {
 
             // take the delta of the previous change before the merge
-            int tmpDelta = mergedChange->storedLength() - mergedChange->docLength() + delta;
+            TextOffset tmpDelta = mergedChange->storedLength() - mergedChange->docLength() + delta;
 
             // alter the delta, so we find the correct merge index
             nextChange->addOffset(tmpDelta);
@@ -172,12 +172,12 @@ void MergableChangeGroup::giveChangeToList(QList<AbstractRangedChange*>& changes
 {
     //qlog_info() << "giveSingleTextChange" << newChange->toString();
     // remember the orginal ranges so we know which changes are affected by this new change
-    int orgStartOffset = newChange->offset();
-    int orgEndOffset = newChange->offset() + newChange->storedLength();
+    TextOffset orgStartOffset = newChange->offset();
+    TextOffset orgEndOffset = newChange->offset() + newChange->storedLength();
 
     // some variables to remebmer
     int addDeltaFromIndex = size();         // From which change index should we add delta?!
-    int delta = 0;
+    TextOffset delta = 0;
 
     // First try to merge this new change
     int mergedAtIndex = mergeChange( changes, doc, newChange, delta );
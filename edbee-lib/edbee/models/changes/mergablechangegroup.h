@@ -6,6 +6,7 @@
 #include "edbee/exports.h"
 
 #include "edbee/models/change.h"
+#include "edbee/textoffset.h"
 
 namespace edbee {
 
@@ -34,10 +35,10 @@ public:
     virtual void revert(TextDocument* document);
 
 private:
-    void addOffsetDeltaToChanges( QList<AbstractRangedChange*>& changes, int fromIndex, int delta );
-    int findInsertIndexForOffset( QList<AbstractRangedChange*>& changes, int offset );
-    int mergeChange( QList<AbstractRangedChange*>& changes, TextDocument* doc, AbstractRangedChange* newChange, int& delta );
-    void inverseMergeRemainingOverlappingChanges( QList<AbstractRangedChange*>& changes, TextDocument* doc, int mergedAtIndex, int orgStartOffset, int orgEndOffset , int delta);
+    void addOffsetDeltaToChanges( QList<AbstractRangedChange*>& changes, int fromIndex, TextOffset delta );
+    int findInsertIndexForOffset( QList<AbstractRangedChange*>& changes, TextOffset offset );
+    int mergeChange( QList<AbstractRangedChange*>& changes, TextDocument* doc, AbstractRangedChange* newChange, TextOffset& delta );
+    void inverseMergeRemainingOverlappingChanges( QList<AbstractRangedChange*>& changes, TextDocument* doc, int mergedAtIndex, TextOffset orgStartOffset, TextOffset orgEndOffset , TextOffset delta);
 
     void giveChangeToList(  QList<AbstractRangedChange*>& changes, TextDocument* doc, AbstractRangedChange* change );
     void giveAndMergeChangeToList(  QList<AbstractRangedChange*>& changes, TextDocument* doc, AbstractRangedChange* change );
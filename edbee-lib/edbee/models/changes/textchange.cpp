@@ -16,7 +16,7 @@ namespace edbee {
 /// @param length, the length of the change
 /// @param text , the new text
 /// @param executed, a boolean (mainly used for testing) to mark this change as exected
-TextChange::TextChange(int offset, int length, const QString& text)
+TextChange::TextChange(TextOffset offset, TextOffset length, const QString& text)
     : offset_(offset)
     , length_(length)
     , text_(text)
@@ -106,7 +106,7 @@ QString TextChange::toString()
 
 /// Return the offset
 /// @return the offset of the change
-int TextChange::offset() const
+TextOffset TextChange::offset() const
 {
     return offset_;
 }
@@ -114,21 +114,21 @@ int TextChange::offset() const
 
 /// set the new offset
 /// @param offset the new offset
-void TextChange::setOffset(int offset)
+void TextChange::setOffset(TextOffset offset)
 {
     offset_ = offset;
 }
 
 
 /// This is the length in the document
-int TextChange::docLength() const
+TextOffset TextChange::docLength() const
 {
     return length_;
 }
 
 
 /// The content length is the length that's currently stored in memory.
-int TextChange::storedLength() const
+TextOffset TextChange::storedLength() const
 {
     return text_.size();
 }
@@ -136,7 +136,7 @@ int TextChange::storedLength() const
 
 /// Set the length of the change
 /// @param len sets the length of the change
-void TextChange::setDocLength(int len)
+void TextChange::setDocLength(TextOffset len)
 {
     length_ = len;
 }
@@ -18,7 +18,7 @@ namespace edbee {
 class EDBEE_EXPORT TextChange : public AbstractRangedChange
 {
 public:
-    TextChange(int offset, int length, const QString& text );
+    TextChange(TextOffset offset, TextOffset length, const QString& text );
     virtual ~TextChange();
 
     virtual void execute(TextDocument* document);
@@ -32,12 +32,12 @@ public:
 
     virtual QString toString();
 
-    int offset() const;
-    void setOffset( int offset );
-    virtual int docLength() const;
-    virtual int storedLength() const;
+    TextOffset offset() const;
+    void setOffset( TextOffset offset );
+    virtual TextOffset docLength() const;
+    virtual TextOffset storedLength() const;
 
-    void setDocLength( int len );
+    void setDocLength( TextOffset len );
 
     QString storedText() const;
     void setStoredText( const QString& text );
@@ -50,8 +50,8 @@ protected:
     void replaceText( TextDocument* document );
 
 private:
-    int offset_;            ///< The offset of the text
-    int length_;            ///< the length of the change in the document
+    TextOffset offset_;     ///< The offset of the text
+    TextOffset length_;     ///< the length of the change in the document
     QString text_;          ///< The text data
 };
 
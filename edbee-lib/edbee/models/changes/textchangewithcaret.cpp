@@ -7,7 +7,7 @@
 
 namespace edbee {
 
-TextChangeWithCaret::TextChangeWithCaret(int offset, int length, const QString& text, int caret )
+TextChangeWithCaret::TextChangeWithCaret(TextOffset offset, TextOffset length, const QString& text, TextOffset caret )
     : TextChange( offset, length, text )
     , caret_( caret )
 {
@@ -15,7 +15,7 @@ TextChangeWithCaret::TextChangeWithCaret(int offset, int length, const QString&
 
 
 /// returns the caret position
-int TextChangeWithCaret::caret() const
+TextOffset TextChangeWithCaret::caret() const
 {
     return caret_;
 }
@@ -23,7 +23,7 @@ int TextChangeWithCaret::caret() const
 
 /// Sets the caret position
 /// @param caret the caret to set
-void TextChangeWithCaret::setCaret(int caret)
+void TextChangeWithCaret::setCaret(TextOffset caret)
 {
     caret_ = caret;
 }
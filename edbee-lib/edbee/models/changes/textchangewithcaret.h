@@ -15,13 +15,13 @@ namespace edbee {
 class EDBEE_EXPORT TextChangeWithCaret : public TextChange
 {
 public:
-    TextChangeWithCaret( int offset, int length, const QString& text, int caret );
+    TextChangeWithCaret( TextOffset offset, TextOffset length, const QString& text, TextOffset caret );
 
-    int caret() const ;
-    void setCaret( int caret );
+    TextOffset caret() const ;
+    void setCaret( TextOffset caret );
 
 private:
-    int caret_;         ///< The new cret
+    TextOffset caret_;  ///< The new cret
 };
 
 } // edbee
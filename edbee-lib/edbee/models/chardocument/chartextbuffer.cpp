@@ -6,37 +6,57 @@
 
 #include "chartextbuffer.h"
 
+#include "edbee/models/textrange.h"
+#include "edbee/util/lineoffsettree.h"
+
 #include "edbee/debug.h"
 
 namespace edbee {
 
+const int CharTextBuffer::CompactChunkSize;
+const int CharTextBuffer::CompactCachedChunkCount;
+
 
 /// The constructor of the textbuffer
 /// @param a reference to the parent
 CharTextBuffer::CharTextBuffer(QObject *parent)
     : TextBuffer( parent )
+    , compactStorageEnabled_(false)
+    , latin1_(false)
+    , lineOffsetTree_(nullptr)
     , rawAppendStart_(-1)
     , rawAppendLineStart_(-1)
+    , rawAppendLineOffsetsKnown_(false)
+{
+    // the memory is released after the change has been reported, the change can refer to the buffer data
+    buf_.setAutoReleaseEnabled( false );
+    latin1Buf_.setAutoReleaseEnabled( false );
+}
+
+
+/// The destructor
+CharTextBuffer::~CharTextBuffer()
 {
+    delete lineOffsetTree_;
 }
 
 
 /// Returns the length of the buffer
 /// @return the length of the given text
-int CharTextBuffer::length() const
+TextOffset CharTextBuffer::length() const
 {
-    return buf_.length();
+    return latin1_ ? latin1Buf_.length() : buf_.length();
 }
 
 
 /// Returns the character at the given character
 /// @param offset the offset of the given character
 /// @return the character at the given offset
-QChar CharTextBuffer::charAt(int offset) const
+QChar CharTextBuffer::charAt(TextOffset offset) const
 {
     Q_ASSERT(offset >= 0);
-    Q_ASSERT(offset < buf_.length() );
-    return buf_.at(offset);
+    Q_ASSERT(offset < length() );
+    return latin1_ ? latin1Buf_.charAt(offset) : buf_.at(offset);
 }
 
 
@@ -44,14 +64,14 @@ QChar CharTextBuffer::charAt(int offset) const
 /// @param pos the position of the given text
 /// @param length the length of the text to get
 /// @return returns a part of the text
-QString CharTextBuffer::textPart(int pos, int length) const
+QString CharTextBuffer::textPart(TextOffset pos, TextOffset length) const
 {
     // do NOT use data here. Data moves the gap!
     // QString str( buf_.data() + pos, length );
     // return str;
     ///buf_.data()
 
-    QString result = buf_.mid( pos, length );
+    QString result = latin1_ ? latin1Buf_.mid( pos, length ) : buf_.mid( pos, length );
     return result;
 }
 
@@ -61,14 +81,14 @@ QString CharTextBuffer::textPart(int pos, int length) const
 /// @param length the length of the text to replace
 /// @param buffer a pointer to a buffer with data
 /// @param bufferLenth the length of the buffer
-void CharTextBuffer::replaceText(int offset, int length, const QChar* buffer, int bufferLength )
+void CharTextBuffer::replaceText(TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength )
 {
     // make sure the length matches
     length = qMin( this->length()-offset, length );
 
     // make sure the position is correct
-    if( offset > buf_.length() ) {
-        offset = buf_.length();  // Qt doesn't append if the position > length
+    if( offset > this->length() ) {
+        offset = this->length();  // Qt doesn't append if the position > length
         length = 0;
     }
 
@@ -77,22 +97,56 @@ void CharTextBuffer::replaceText(int offset, int length, const QChar* buffer, in
     emit textAboutToBeChanged( change );
 
     // replace the text
-    QString oldText = buf_.mid(offset, length);
+    QString oldText = oldTextForChange(offset, length);
 
-    buf_.replace( offset, length, buffer, bufferLength );
+    if( ensureStorageFits( buffer, bufferLength ) ) {
+        latin1Buf_.replace( offset, length, buffer, bufferLength );
+    } else {
+        buf_.replace( offset, length, buffer, bufferLength );
+    }
+    invalidateDecodedChunks();
 
     // replace the line data and offsets
-    lineOffsetList_.applyChange( change );
+    applyLineChange( change );
 
     emit textChanged( change, oldText );
+
+    if( length > bufferLength ) {
+        buf_.releaseUnusedMemory();
+        latin1Buf_.releaseUnusedMemory();
+    }
+}
+
+
+/// Grows the gap once for a number of replacements (see TextBuffer::reserveGrowth).
+/// The gap is placed at the first replacement, after that it only moves forward from replacement to replacement
+/// @param offset the offset of the first replacement
+/// @param growth the total number of characters the replacements add
+void CharTextBuffer::reserveGrowth(TextOffset offset, TextOffset growth)
+{
+    if( growth <= 0 ) { return; }
+    if( latin1_ ) {
+        latin1Buf_.ensureGapSize( growth, qBound<TextOffset>( 0, offset, length() ) );
+    } else {
+        buf_.ensureGapSize( growth, qBound<TextOffset>( 0, offset, length() ) );
+    }
+}
+
+
+/// Returns the number of lines
+int CharTextBuffer::lineCount()
+{
+    return lineOffsetTree_ ? lineOffsetTree_->length() : lineOffsetList_.length();
 }
 
 
 /// Returns the line position at the given offset
 /// @param offset the offset to retreive the line from
 /// @return the line from the given offset
-int CharTextBuffer::lineFromOffset(int offset )
+int CharTextBuffer::lineFromOffset(TextOffset offset )
 {
+    if( lineOffsetTree_ ) { return lineOffsetTree_->findLineFromOffset(offset); }
+
 //    int result = lineFromOffsetSearch(offset);
     int result = lineOffsetList_.findLineFromOffset(offset);
     return result;
@@ -102,15 +156,15 @@ int CharTextBuffer::lineFromOffset(int offset )
 /// This method returns the offset of the given line
 /// @param lin the line to retrieve the offset from
 /// @return the offset of the given line
-int CharTextBuffer::offsetFromLine(int line)
+TextOffset CharTextBuffer::offsetFromLine(int line)
 {
     if( line < 0 ) return 0;    // at the start
 
-    if( line >= lineOffsetList_.length()) {
+    if( line >= lineCount() ) {
         return length();
     }
 
-    return lineOffsetList_.at(line);
+    return lineOffsetTree_ ? lineOffsetTree_->at(line) : lineOffsetList_.at(line);
 }
 
 
@@ -121,15 +175,21 @@ void CharTextBuffer::rawAppendBegin()
     Q_ASSERT(rawAppendLineStart_ == -1 );
     rawAppendStart_ = length();
     rawAppendLineStart_ = lineCount();
+    rawAppendLineOffsets_.clear();
+    rawAppendLineOffsetsKnown_ = false;
 }
 
 
 /// Appends a buffer of text to the document
 /// @param data the data to append
 /// @param dataLength the number of bytes availble by the data pointer
-void CharTextBuffer::rawAppend(const QChar* data, int dataLength)
+void CharTextBuffer::rawAppend(const QChar* data, TextOffset dataLength)
 {
-    buf_.append( data, dataLength );
+    if( ensureStorageFits( data, dataLength ) ) {
+        latin1Buf_.append( data, dataLength );
+    } else {
+        buf_.append( data, dataLength );
+    }
 }
 
 
@@ -137,7 +197,43 @@ void CharTextBuffer::rawAppend(const QChar* data, int dataLength)
 /// @param c the character to append
 void CharTextBuffer::rawAppend(QChar c)
 {
-    buf_.append( c );
+    if( ensureStorageFits( &c, 1 ) ) {
+        latin1Buf_.append( &c, 1 );
+    } else {
+        buf_.append( c );
+    }
+}
+
+
+/// Appends the given number of characters, which are directly written in the gapvector by the caller.
+/// With compact storage enabled this isn't supported, because the text could be stored as Latin-1.
+/// @param length the number of characters to append
+/// @return the pointer to the uninitialized characters (or 0 when not supported)
+QChar* CharTextBuffer::rawAppendDirect(TextOffset length)
+{
+    Q_ASSERT(rawAppendStart_ >= 0 );
+    if( compactStorageEnabled_ ) { return nullptr; }
+    return buf_.appendUninitialized( length );
+}
+
+
+/// Gives back the unused characters at the end of the last rawAppendDirect call
+/// @param unusedLength the number of unused characters
+void CharTextBuffer::rawAppendDirectShrink(TextOffset unusedLength)
+{
+    Q_ASSERT(rawAppendStart_ >= 0 );
+    Q_ASSERT(0 <= unusedLength && unusedLength <= buf_.length() - rawAppendStart_ );
+    buf_.truncate( buf_.length() - unusedLength );
+}
+
+
+/// Sets the line offsets of the raw appended text. These offsets are used by rawAppendEnd
+/// @param lineOffsets the offsets of the characters after the newlines
+void CharTextBuffer::setRawAppendLineOffsets(const QVector<TextOffset>& lineOffsets)
+{
+    Q_ASSERT(rawAppendStart_ >= 0 );
+    rawAppendLineOffsets_ = lineOffsets;
+    rawAppendLineOffsetsKnown_ = true;
 }
 
 
@@ -156,24 +252,343 @@ void CharTextBuffer::rawAppendEnd()
     int linesAdded = lineOffsetList_.length() - oldLength;
     */
 
-    //emit the about signal
-    TextBufferChange change( this, rawAppendStart_, 0, buf_.data() + rawAppendStart_, buf_.length() - rawAppendStart_ );
-
-    emit textAboutToBeChanged( change );
-    lineOffsetList_.applyChange( change );
-    emit textChanged( change, QString() );
+    invalidateDecodedChunks();
+
+    // the Latin-1 text is reported in decoded slices, to prevent decoding the complete text at once
+    if( latin1_ ) {
+        const TextOffset sliceSize = CompactChunkSize * 256;
+        TextOffset offset = rawAppendStart_;
+        do {
+            QString slice = latin1Buf_.mid( offset, qMin<TextOffset>( sliceSize, length() - offset ) );
+            TextBufferChange change( this, offset, 0, slice.constData(), slice.length() );
+
+            emit textAboutToBeChanged( change );
+            applyLineChange( change );
+            emit textChanged( change, QString() );
+            offset += slice.length();
+        } while( offset < length() );
+    } else {
+        // when the line offsets are known, the appended text doesn't need to be searched for newlines
+        const QChar* data = buf_.data() + rawAppendStart_;
+        TextOffset dataLength = buf_.length() - rawAppendStart_;
+        TextBufferChange change = rawAppendLineOffsetsKnown_
+            ? TextBufferChange( this, rawAppendStart_, 0, data, dataLength, rawAppendLineOffsets_ )
+            : TextBufferChange( this, rawAppendStart_, 0, data, dataLength );
+
+        //emit the about signal
+        emit textAboutToBeChanged( change );
+        applyLineChange( change );
+        emit textChanged( change, QString() );
+    }
 
     rawAppendLineStart_ = -1;
     rawAppendStart_     = -1;
+    rawAppendLineOffsets_.clear();
+    rawAppendLineOffsetsKnown_ = false;
+}
+
+
+/// Takes over the text and line offsets of the given buffer without copying them (when it's a CharTextBuffer).
+/// The source is converted to the storage settings of this buffer first. The source buffer is empty afterwards
+/// @param source the buffer with the new text
+void CharTextBuffer::takeText(TextBuffer* source)
+{
+    Q_ASSERT(rawAppendStart_ == -1 );
+    CharTextBuffer* charSource = dynamic_cast<CharTextBuffer*>(source);
+    if( !charSource ) {
+        TextBuffer::takeText( source );
+        return;
+    }
+    Q_ASSERT(charSource != this);
+    charSource->setCompactStorageEnabled( compactStorageEnabled_ );
+    charSource->setLineOffsetTreeEnabled( isLineOffsetTreeEnabled() );
+
+    // the change is created with the line offsets of the source, so the new text isn't searched for newlines
+    QVector<TextOffset> lineOffsets;
+    int lineCount = charSource->lineCount();
+    lineOffsets.reserve( lineCount - 1 );
+    for( int line=1; line < lineCount; ++line ) {
+        lineOffsets.append( charSource->offsetFromLine( line ) );
+    }
+    const QChar* text = charSource->rawDataPointer();
+    TextBufferChange change( this, 0, length(), text, charSource->length(), lineOffsets );
+
+    emit textAboutToBeChanged( change );
+    QString oldText = oldTextForChange( 0, length() );
+
+    // swap the storage (the decoded text of the rawDataPointer is swapped too, it's referenced by the change)
+    buf_.swap( charSource->buf_ );
+    latin1Buf_.swap( charSource->latin1Buf_ );
+    qSwap( latin1_, charSource->latin1_ );
+    qSwap( rawData_, charSource->rawData_ );
+    lineOffsetList_.swap( charSource->lineOffsetList_ );
+    qSwap( lineOffsetTree_, charSource->lineOffsetTree_ );
+    decodedChunks_.clear();
+
+    // the old text isn't required anymore
+    charSource->buf_.clear();
+    charSource->latin1Buf_.clear();
+    charSource->latin1_ = false;
+    charSource->invalidateDecodedChunks();
+    charSource->lineOffsetList_.clear();
+    delete charSource->lineOffsetTree_;
+    charSource->lineOffsetTree_ = nullptr;
+
+    emit textChanged( change, oldText );
 }
 
 
 /// This method returns the raw data pointer
 /// WARNING calling this method moves the gap of the gapvector to the end. Which could involve a lot of data moving
+/// When the text is stored as Latin-1 the complete text is decoded.
 QChar* CharTextBuffer::rawDataPointer()
 {
+    if( latin1_ ) {
+        rawData_ = latin1Buf_.mid( 0, latin1Buf_.length() );
+        return rawData_.data();
+    }
     return buf_.data();
 }
 
 
+/// Returns the chunk that contains the given offset. The gapvector has at most 2 chunks: the part before and after the gap
+/// This method never moves the gap
+///
+/// When the text is stored as Latin-1 a decoded chunk of CompactChunkSize characters is returned.
+/// The decoded chunk stays in memory until CompactCachedChunkCount other chunks are decoded,
+/// callers may only rely on the TextBuffer::chunkAt contract (valid until the next change or the next chunkAt call)
+const QChar* CharTextBuffer::chunkAt(TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength) const
+{
+    if( length() == 0 ) {
+        chunkStart = 0;
+        chunkLength = 0;
+        return nullptr;
+    }
+    if( !latin1_ ) {
+        return buf_.spanAt( offset, chunkStart, chunkLength );
+    }
+
+    // find or decode the chunk
+    if( offset >= length() ) { offset = length() - 1; }
+    chunkStart = offset - offset % CompactChunkSize;
+    for( int i=0, cnt=decodedChunks_.size(); i < cnt; ++i ) {
+        if( decodedChunks_.at(i).offset == chunkStart ) {
+            if( i > 0 ) { decodedChunks_.move( i, 0 ); }
+            chunkLength = decodedChunks_.first().text.length();
+            return decodedChunks_.first().text.constData();
+        }
+    }
+
+    DecodedChunk chunk;
+    chunk.offset = chunkStart;
+    chunk.text = latin1Buf_.mid( chunkStart, qMin<TextOffset>( CompactChunkSize, length() - chunkStart ) );
+    decodedChunks_.prepend( chunk );
+    while( decodedChunks_.size() > CompactCachedChunkCount ) { decodedChunks_.removeLast(); }
+
+    chunkLength = chunk.text.length();
+    return decodedChunks_.first().text.constData();
+}
+
+
+/// Enables or disables the compact (Latin-1) storage of the text.
+/// Enabling converts the current text to Latin-1 when all characters fit. Disabling converts the text to UTF-16
+/// @param enabled should the compact storage be used?
+void CharTextBuffer::setCompactStorageEnabled(bool enabled)
+{
+    compactStorageEnabled_ = enabled;
+    if( !enabled ) {
+        if( latin1_ ) { promoteToUtf16(); }
+        return;
+    }
+    if( latin1_ ) { return; }
+
+    // only convert when all characters fit
+    TextOffset chunkStart = 0, chunkLength = 0;
+    for( TextOffset offset = 0, len = buf_.length(); offset < len; offset = chunkStart + chunkLength ) {
+        const QChar* chunk = buf_.spanAt( offset, chunkStart, chunkLength );
+        if( !Latin1GapVector::fits( chunk, chunkLength ) ) { return; }
+    }
+
+    latin1Buf_.clear();
+    latin1Buf_.resize( buf_.length() + latin1Buf_.growSize() );
+    for( TextOffset offset = 0, len = buf_.length(); offset < len; offset = chunkStart + chunkLength ) {
+        const QChar* chunk = buf_.spanAt( offset, chunkStart, chunkLength );
+        latin1Buf_.append( chunk, chunkLength );
+    }
+    buf_.clear();
+    latin1_ = true;
+    invalidateDecodedChunks();
+}
+
+
+/// Returns true if the compact (Latin-1) storage is enabled
+bool CharTextBuffer::isCompactStorageEnabled() const
+{
+    return compactStorageEnabled_;
+}
+
+
+/// Returns true if the text is currently stored as Latin-1
+bool CharTextBuffer::isLatin1Storage() const
+{
+    return latin1_;
+}
+
+
+/// Selects the structure that stores the line offsets. The current offsets are converted
+/// @param enabled when true the LineOffsetTree is used, else the LineOffsetVector
+void CharTextBuffer::setLineOffsetTreeEnabled(bool enabled)
+{
+    if( enabled == isLineOffsetTreeEnabled() ) { return; }
+
+    if( enabled ) {
+        lineOffsetTree_ = new LineOffsetTree();
+        for( int i=1, cnt=lineOffsetList_.length(); i < cnt; ++i ) {
+            lineOffsetTree_->appendOffset( lineOffsetList_.at(i) );
+        }
+        lineOffsetList_.clear();
+    } else {
+        for( int i=1, cnt=lineOffsetTree_->length(); i < cnt; ++i ) {
+            lineOffsetList_.appendOffset( lineOffsetTree_->at(i) );
+        }
+        delete lineOffsetTree_;
+        lineOffsetTree_ = nullptr;
+    }
+}
+
+
+/// Returns true if the line offsets are stored in a LineOffsetTree
+bool CharTextBuffer::isLineOffsetTreeEnabled() const
+{
+    return lineOffsetTree_ != nullptr;
+}
+
+
+/// Returns the number of characters that fit in the buffer without growing it
+TextOffset CharTextBuffer::capacity() const
+{
+    return latin1_ ? latin1Buf_.capacity() : buf_.capacity();
+}
+
+
+/// Returns the number of characters that can be inserted at the gap position without growing the buffer
+TextOffset CharTextBuffer::gapSize() const
+{
+    return latin1_ ? latin1Buf_.gapSize() : buf_.gapSize();
+}
+
+
+/// Returns the number of bytes allocated for the text and the line offsets
+/// (the line offset tree isn't included)
+qint64 CharTextBuffer::memoryUsage() const
+{
+    return buf_.memoryUsage() + latin1Buf_.memoryUsage() + lineOffsetList_.memoryUsage();
+}
+
+
+/// Releases all unused memory of the text and the line offsets.
+/// After loading and truncating a large file this returns the memory of the gap. The next insert grows the buffer again
+void CharTextBuffer::squeeze()
+{
+    buf_.squeeze();
+    latin1Buf_.squeeze();
+    lineOffsetList_.squeeze();
+}
+
+
+/// Sets the growth divisor of the text storage (see GapVector::setGrowDivisor)
+/// @param divisor the growsize is doubled until it's at least capacity / divisor
+void CharTextBuffer::setGrowDivisor(int divisor)
+{
+    buf_.setGrowDivisor( divisor );
+    latin1Buf_.setGrowDivisor( divisor );
+}
+
+
+/// Returns the growth divisor of the text storage
+int CharTextBuffer::growDivisor() const
+{
+    return buf_.growDivisor();
+}
+
+
+/// Sets the maximum number of extra characters that are reserved when the buffer grows (0 means unlimited)
+/// @param size the maximum growsize
+void CharTextBuffer::setMaxGrowSize(TextOffset size)
+{
+    buf_.setMaxGrowSize( size );
+    latin1Buf_.setMaxGrowSize( size );
+}
+
+
+/// Returns the maximum number of extra characters that are reserved when the buffer grows (0 means unlimited)
+TextOffset CharTextBuffer::maxGrowSize() const
+{
+    return buf_.maxGrowSize();
+}
+
+
+/// Sets the capacity from which unused memory is released after a deletion (0 disables releasing memory)
+/// @param threshold the minimal capacity in characters
+void CharTextBuffer::setReleaseThreshold(TextOffset threshold)
+{
+    buf_.setReleaseThreshold( threshold );
+    latin1Buf_.setReleaseThreshold( threshold );
+}
+
+
+/// Returns the capacity from which unused memory is released after a deletion
+TextOffset CharTextBuffer::releaseThreshold() const
+{
+    return buf_.releaseThreshold();
+}
+
+
+/// Makes sure the given characters can be added to the current storage.
+/// The buffer is promoted to UTF-16 when the characters don't fit in Latin-1
+/// @return true if the characters should be added to the Latin-1 buffer
+bool CharTextBuffer::ensureStorageFits(const QChar* data, TextOffset length)
+{
+    // an empty buffer starts in Latin-1 mode
+    if( compactStorageEnabled_ && !latin1_ && buf_.length() == 0 ) {
+        latin1Buf_.clear();
+        latin1_ = true;
+    }
+    if( latin1_ && !Latin1GapVector::fits( data, length ) ) {
+        promoteToUtf16();
+    }
+    return latin1_;
+}
+
+
+/// Converts the Latin-1 buffer to the UTF-16 buffer
+void CharTextBuffer::promoteToUtf16()
+{
+    Q_ASSERT( latin1_ );
+    buf_.init( latin1Buf_, latin1Buf_.length() / 8 + buf_.growSize() );
+    latin1Buf_.clear();
+    latin1_ = false;
+    invalidateDecodedChunks();
+}
+
+
+/// Applies the given change to the line offsets
+void CharTextBuffer::applyLineChange(const TextBufferChange& change)
+{
+    if( lineOffsetTree_ ) {
+        lineOffsetTree_->applyChange( change );
+    } else {
+        lineOffsetList_.applyChange( change );
+    }
+}
+
+
+/// Removes all decoded Latin-1 chunks, this is required after every change
+void CharTextBuffer::invalidateDecodedChunks()
+{
+    decodedChunks_.clear();
+    rawData_.clear();
+}
+
+
 } // edbee
@@ -5,50 +5,115 @@
 
 #include "edbee/exports.h"
 
+#include <QList>
+
 #include "edbee/models/textbuffer.h"
 #include "edbee/util/gapvector.h"
 #include "edbee/util/lineoffsetvector.h"
 
 namespace edbee {
 
+class LineOffsetTree;
+
 
 /// This textbuffer implementation uses QChars for storing the data.
+///
+/// With compact storage enabled the text is stored with a single byte per character (Latin-1), as long as
+/// all characters fit in Latin-1. The buffer is promoted to UTF-16 storage on the first insert of a wider character.
+/// In compact mode chunkAt returns decoded chunks of CompactChunkSize characters.
+///
+/// The line offsets are stored in a LineOffsetVector by default. This vector is very fast for edits that are
+/// clustered around the same location. For many edits that are scattered over the document
+/// (multi-caret edits, search and replace) the LineOffsetTree can be enabled.
 class EDBEE_EXPORT CharTextBuffer : public TextBuffer
 {
 public:
     CharTextBuffer( QObject* parent=0);
+    virtual ~CharTextBuffer();
 
-    virtual int length() const;
-    virtual QChar charAt(  int offset ) const;
-    virtual QString textPart( int offset, int length ) const;
+    virtual TextOffset length() const;
+    virtual QChar charAt( TextOffset offset ) const;
+    virtual QString textPart( TextOffset offset, TextOffset length ) const;
 
-    virtual void replaceText( int offset, int length, const QChar* buffer, int bufferLength );
+    virtual void replaceText( TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength );
+    virtual void reserveGrowth( TextOffset offset, TextOffset growth );
 
-    virtual int lineCount() { return lineOffsetList_.length(); }
+    virtual int lineCount();
 
-    virtual int lineFromOffset( int offset );
-    virtual int offsetFromLine( int line );
+    virtual int lineFromOffset( TextOffset offset );
+    virtual TextOffset offsetFromLine( int line );
 
     virtual void rawAppendBegin();
     virtual void rawAppend( QChar c );
-    virtual void rawAppend( const QChar* data, int dataLength );
+    virtual void rawAppend( const QChar* data, TextOffset dataLength );
+    virtual QChar* rawAppendDirect( TextOffset length );
+    virtual void rawAppendDirectShrink( TextOffset unusedLength );
+    virtual void setRawAppendLineOffsets( const QVector<TextOffset>& lineOffsets );
     virtual void rawAppendEnd();
 
+    virtual void takeText( TextBuffer* source );
+
     virtual QChar* rawDataPointer();
+    virtual const QChar* chunkAt( TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength ) const;
+
+    void setCompactStorageEnabled( bool enabled );
+    bool isCompactStorageEnabled() const;
+    bool isLatin1Storage() const;
+
+    void setLineOffsetTreeEnabled( bool enabled );
+    bool isLineOffsetTreeEnabled() const;
+
+    TextOffset capacity() const;
+    TextOffset gapSize() const;
+    qint64 memoryUsage() const;
+    void squeeze();
 
-    /// TODO: Temporary debug method. REMOVE!!
+    void setGrowDivisor( int divisor );
+    int growDivisor() const;
+    void setMaxGrowSize( TextOffset size );
+    TextOffset maxGrowSize() const;
+    void setReleaseThreshold( TextOffset threshold );
+    TextOffset releaseThreshold() const;
+
+    /// The number of characters of a decoded chunk (when the text is stored as Latin-1)
+    static const int CompactChunkSize = 4096;
+
+    /// The number of decoded chunks that are kept in memory (when the text is stored as Latin-1)
+    static const int CompactCachedChunkCount = 4;
+
+    /// TODO: Temporary debug method. REMOVE!! (isn't updated when the line offset tree is enabled)
     LineOffsetVector& lineOffsetList() { return lineOffsetList_; }
 
 protected slots:
 
     void emitTextChanged( edbee::TextBufferChange* change, QString oldText = QString());
 
+private:
+    /// A decoded chunk of the Latin-1 buffer
+    struct DecodedChunk {
+        TextOffset offset;                   ///< The offset of the chunk
+        QString text;                        ///< The decoded text
+    };
+
+    bool ensureStorageFits( const QChar* data, TextOffset length );
+    void promoteToUtf16();
+    void invalidateDecodedChunks();
+    void applyLineChange( const TextBufferChange& change );
+
 private:
     QCharGapVector buf_;                     ///< The textbuffer
+    Latin1GapVector latin1Buf_;              ///< The textbuffer when the text is stored as Latin-1
+    bool compactStorageEnabled_;             ///< Should the text be stored as Latin-1 when possible?
+    bool latin1_;                            ///< Is the text stored in the Latin-1 buffer?
+    mutable QList<DecodedChunk> decodedChunks_;  ///< The decoded Latin-1 chunks, the most recently used chunk first
+    QString rawData_;                        ///< The decoded text returned by rawDataPointer (Latin-1 storage only)
     LineOffsetVector lineOffsetList_;        ///< The line offset vector
+    LineOffsetTree* lineOffsetTree_;         ///< The line offset tree, which replaces the line offset vector when set (owned)
 
-    int rawAppendStart_;                     ///< The start offset of raw appending. -1 means no appending is happening
+    TextOffset rawAppendStart_;              ///< The start offset of raw appending. -1 means no appending is happening
     int rawAppendLineStart_;                 ///< The line start
+    QVector<TextOffset> rawAppendLineOffsets_;   ///< The line offsets of the raw appended text (when known)
+    bool rawAppendLineOffsetsKnown_;         ///< Are the line offsets of the raw appended text given?
 
 };
 
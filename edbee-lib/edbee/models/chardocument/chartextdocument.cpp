@@ -31,9 +31,19 @@ CharTextDocument::CharTextDocument(QObject *object)
 }
 
 CharTextDocument::CharTextDocument(TextEditorConfig *config, QObject *object)
+    : edbee::CharTextDocument(new CharTextBuffer(), config, object)
+{
+}
+
+
+/// Constructs a document with the given textbuffer implementation
+/// @param buffer the textbuffer to use. The ownership of the buffer is transferred to the document
+/// @param config the text editor configuration (ownership is transferred)
+/// @param object the parent object
+CharTextDocument::CharTextDocument(TextBuffer* buffer, TextEditorConfig *config, QObject *object)
     : TextDocument(object)
     , config_(config)
-    , textBuffer_(0)
+    , textBuffer_(buffer)
     , textScopes_(0)
     , textLexer_(0)
     , textCodecRef_(0)
@@ -46,7 +56,7 @@ CharTextDocument::CharTextDocument(TextEditorConfig *config, QObject *object)
     // auto initialize edbee if this hasn't been done already
     Edbee::instance()->autoInit();
 
-    textBuffer_ = new CharTextBuffer();
+    Q_ASSERT(textBuffer_);
 
     textScopes_ = new TextDocumentScopes( this );
 
@@ -69,7 +79,7 @@ CharTextDocument::CharTextDocument(TextEditorConfig *config, QObject *object)
     // forward the persisted state changes
     connect( textUndoStack_, SIGNAL(persistedChanged(bool)), this,  SIGNAL(persistedChanged(bool)) );
 
-    connect( textScopes_, SIGNAL(lastScopedOffsetChanged(int,int)), this, SIGNAL(lastScopedOffsetChanged(int,int)) );
+    connect( textScopes_, SIGNAL(lastScopedOffsetChanged(edbee::TextOffset,edbee::TextOffset)), this, SIGNAL(lastScopedOffsetChanged(edbee::TextOffset,edbee::TextOffset)) );
 }
 
 
@@ -75,6 +75,9 @@ public:
     virtual Change* giveChangeWithoutFilter(Change* change, int coalesceId );
 
 
+protected:
+    CharTextDocument( TextBuffer* buffer, TextEditorConfig* config, QObject* object );
+
 protected slots:
 //    virtual void textReplaced( int offset, int length, const QChar* data, int dataLength );
 //    virtual void linesReplaced( int line, int lineCount, int newLineCount );
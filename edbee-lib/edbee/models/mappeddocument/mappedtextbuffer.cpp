@@ -0,0 +1,592 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "mappedtextbuffer.h"
+
+#include <QFile>
+
+#include "edbee/util/lineending.h"
+#include "edbee/util/newlinescanner.h"
+#include "edbee/util/textcodec.h"
+#include "edbee/util/textcodecdetector.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+const int MappedTextBuffer::BlockSize;
+const int MappedTextBuffer::CachedBlockCount;
+
+/// The number of bytes used to detect the encoding and line ending of the file
+static const int DetectionSize = 8192;
+
+
+/// A decoded block of text
+struct MappedTextBuffer::DecodedBlock {
+    int index;                  ///< The index of the block
+    QString text;               ///< The decoded text
+    QVector<TextOffset> newlines;   ///< The positions of all newlines in the text
+};
+
+
+/// Is the given byte a UTF-8 continuation byte (10xxxxxx)
+static inline bool isContinuationByte( uchar c )
+{
+    return (c & 0xC0) == 0x80;
+}
+
+
+/// The constructor of the mapped textbuffer
+/// @param parent the parent QObject
+MappedTextBuffer::MappedTextBuffer(QObject* parent)
+    : TextBuffer( parent )
+    , file_(nullptr)
+    , data_(nullptr)
+    , dataStart_(0)
+    , dataSize_(0)
+    , codecRef_(nullptr)
+    , lineEndingRef_(nullptr)
+    , latin1_(false)
+    , blockSize_(BlockSize)
+    , indexedBytes_(0)
+    , length_(0)
+    , newlineCount_(0)
+{
+}
+
+
+/// The destructor unmaps the file
+MappedTextBuffer::~MappedTextBuffer()
+{
+    clearCache();
+    delete file_;
+}
+
+
+/// Maps the given file and detects the encoding. This method doesn't index any block, call indexBlocks to fill the buffer.
+/// @param fileName the file to open
+/// @return true on success. On failure the reason is available via errorString()
+bool MappedTextBuffer::open(const QString& fileName)
+{
+    close();
+    errorString_.clear();
+
+    QFile* file = new QFile( fileName );
+    if( !file->open( QIODevice::ReadOnly ) ) {
+        errorString_ = file->errorString();
+        delete file;
+        return false;
+    }
+
+    qint64 size = file->size();
+    const uchar* data = nullptr;
+    if( size > 0 ) {
+        data = file->map( 0, size );
+        if( !data ) {
+            errorString_ = file->errorString();
+            delete file;
+            return false;
+        }
+    }
+
+    // detect the encoding with the first bytes of the file
+    TextCodec* codec = TextCodecDetector::globalPreferedCodec();
+    if( size > 0 ) {
+        TextCodecDetector detector( reinterpret_cast<const char*>( data ), static_cast<int>( qMin<qint64>( size, DetectionSize ) ) );
+        codec = detector.detectCodec();
+    }
+
+    // only encodings that can be decoded per block are supported
+    QString codecName = codec->name();
+    qint64 dataStart = 0;
+    bool latin1 = false;
+    if( codecName == QStringLiteral("UTF-8 with BOM") ) {
+        dataStart = 3;
+    } else if( codecName == QStringLiteral("ISO-8859-1") ) {
+        latin1 = true;
+    } else if( codecName != QStringLiteral("UTF-8") ) {
+        errorString_ = QStringLiteral("Encoding %1 is not supported for memory mapped files").arg( codecName );
+        delete file;
+        return false;
+    }
+
+    // the line ending characters are the same in all supported encodings
+    QString start = QString::fromLatin1( reinterpret_cast<const char*>( data ) + dataStart, static_cast<int>( qMin<qint64>( size - dataStart, DetectionSize ) ) );
+    lineEndingRef_ = LineEnding::detect( start, LineEnding::get( LineEnding::UnixType ) );
+
+    file_ = file;
+    data_ = data;
+    dataStart_ = dataStart;
+    dataSize_ = size;
+    codecRef_ = codec;
+    latin1_ = latin1;
+    indexedBytes_ = dataStart;
+    return true;
+}
+
+
+/// Closes the file. All indexed text is removed from the buffer
+void MappedTextBuffer::close()
+{
+    if( length_ > 0 ) {
+        TextBufferChange change( this, 0, length_, nullptr, 0 );
+        emit textAboutToBeChanged( change );
+        blocks_.clear();
+        length_ = 0;
+        newlineCount_ = 0;
+        clearCache();
+        emit textChanged( change, QString() );
+    }
+
+    clearCache();
+    blocks_.clear();
+    delete file_;
+    file_ = nullptr;
+    data_ = nullptr;
+    dataStart_ = 0;
+    dataSize_ = 0;
+    codecRef_ = nullptr;
+    lineEndingRef_ = nullptr;
+    indexedBytes_ = 0;
+    rawData_.clear();
+}
+
+
+/// Returns true if a file is opened
+bool MappedTextBuffer::isOpen() const
+{
+    return file_ != nullptr;
+}
+
+
+/// Returns the name of the opened file
+QString MappedTextBuffer::fileName() const
+{
+    return file_ ? file_->fileName() : QString();
+}
+
+
+/// Returns the error of the last open call
+QString MappedTextBuffer::errorString() const
+{
+    return errorString_;
+}
+
+
+/// Returns the detected codec of the opened file (0 when no file is opened)
+TextCodec* MappedTextBuffer::codec() const
+{
+    return codecRef_;
+}
+
+
+/// Returns the detected line ending of the opened file (0 when no file is opened)
+const LineEnding* MappedTextBuffer::lineEnding() const
+{
+    return lineEndingRef_;
+}
+
+
+/// Returns the size of the opened file in bytes
+qint64 MappedTextBuffer::fileSize() const
+{
+    return dataSize_;
+}
+
+
+/// Sets the preferred number of bytes in a block. Only blocks that are indexed after this call get this size
+/// @param size the block size in bytes
+void MappedTextBuffer::setBlockSize(int size)
+{
+    Q_ASSERT( size > 0 );
+    blockSize_ = size;
+}
+
+
+/// Returns the preferred number of bytes in a block
+int MappedTextBuffer::blockSize() const
+{
+    return blockSize_;
+}
+
+
+/// Indexes the next blocks of the file and appends their text to the buffer.
+/// Every block emits a textAboutToBeChanged and textChanged signal
+/// @param count the maximum number of blocks to index
+/// @return true if there are blocks left to index
+bool MappedTextBuffer::indexBlocks(int count)
+{
+    for( int i=0; i < count && indexedBytes_ < dataSize_; ++i ) {
+        qint64 byteEnd = blockEnd( indexedBytes_ );
+
+        DecodedBlock* decoded = decodeBlock( blocks_.size(), indexedBytes_, byteEnd - indexedBytes_ );
+        QString text = decoded->text;   // keeps the text alive when the block is removed from the cache while emitting
+
+        Block block;
+        block.byteOffset = indexedBytes_;
+        block.byteLength = byteEnd - indexedBytes_;
+        block.charOffset = length_;
+        block.charLength = text.length();
+        block.lineOffset = newlineCount_;
+        block.newlineCount = decoded->newlines.size();
+
+        TextBufferChange change( this, length_, 0, text.constData(), text.length() );
+        emit textAboutToBeChanged( change );
+
+        blocks_.append( block );
+        indexedBytes_ = byteEnd;
+        length_ += block.charLength;
+        newlineCount_ += block.newlineCount;
+        emit textChanged( change, QString() );
+    }
+    return !isFullyIndexed();
+}
+
+
+/// Indexes all remaining blocks of the file
+void MappedTextBuffer::indexAll()
+{
+    while( indexBlocks( 1 ) ) {}
+}
+
+
+/// Returns true if the complete file is indexed
+bool MappedTextBuffer::isFullyIndexed() const
+{
+    return indexedBytes_ >= dataSize_;
+}
+
+
+/// Returns the number of bytes of the file that are indexed (including the byte order mark)
+qint64 MappedTextBuffer::indexedByteCount() const
+{
+    return indexedBytes_;
+}
+
+
+/// Returns the number of indexed blocks
+int MappedTextBuffer::blockCount() const
+{
+    return blocks_.size();
+}
+
+
+/// Returns the length of the indexed text
+TextOffset MappedTextBuffer::length() const
+{
+    return length_;
+}
+
+
+/// Returns the character at the given offset
+/// @param offset the offset of the character
+QChar MappedTextBuffer::charAt(TextOffset offset) const
+{
+    Q_ASSERT(offset >= 0);
+    Q_ASSERT(offset < length());
+
+    int index = blockIndexForOffset( offset );
+    return decodedBlock( index )->text.at( static_cast<int>( offset - blocks_.at(index).charOffset ) );
+}
+
+
+/// Returns the given text part. Only the blocks that are touched are decoded
+/// @param offset the start offset
+/// @param length the number of characters
+QString MappedTextBuffer::textPart(TextOffset offset, TextOffset length) const
+{
+    Q_ASSERT(offset >= 0);
+    Q_ASSERT(length >= 0);
+    Q_ASSERT(offset + length <= this->length());
+
+    QString result;
+    result.reserve( static_cast<int>( length ) );
+    TextOffset end = offset + length;
+    while( offset < end ) {
+        int index = blockIndexForOffset( offset );
+        const Block& block = blocks_.at(index);
+        TextOffset blockEnd = qMin<TextOffset>( end, block.charOffset + block.charLength );
+        result.append( decodedBlock( index )->text.constData() + ( offset - block.charOffset ), static_cast<int>( blockEnd - offset ) );
+        offset = blockEnd;
+    }
+    return result;
+}
+
+
+/// The mapped textbuffer is read-only, changes are ignored
+void MappedTextBuffer::replaceText(TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength)
+{
+    Q_UNUSED(offset);
+    Q_UNUSED(length);
+    Q_UNUSED(buffer);
+    Q_UNUSED(bufferLength);
+    qlog_warn() << "MappedTextBuffer is read-only, replaceText is ignored";
+}
+
+
+/// Returns the number of lines of the indexed text
+int MappedTextBuffer::lineCount()
+{
+    return newlineCount_ + 1;
+}
+
+
+/// Returns the line number of the given offset
+/// @param offset the offset to retrieve the line for
+int MappedTextBuffer::lineFromOffset(TextOffset offset)
+{
+    Q_ASSERT(offset >= 0);
+    if( offset >= length_ ) { return newlineCount_; }
+
+    int index = blockIndexForOffset( offset );
+    const Block& block = blocks_.at(index);
+    if( block.newlineCount == 0 ) { return block.lineOffset; }
+
+    // count the newlines in the block before the offset
+    const QVector<TextOffset>& newlines = decodedBlock( index )->newlines;
+    TextOffset pos = offset - block.charOffset;
+    int begin = 0, end = newlines.size();
+    while( begin < end ) {
+        int middle = begin + (end - begin) / 2;
+        if( newlines.at(middle) < pos ) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return block.lineOffset + begin;
+}
+
+
+/// Returns the offset of the given line
+/// @param line the line to retrieve the offset for
+TextOffset MappedTextBuffer::offsetFromLine(int line)
+{
+    if( line <= 0 ) { return 0; }
+    if( line > newlineCount_ ) { return length_; }
+
+    int index = blockIndexForLine( line );
+    const Block& block = blocks_.at(index);
+    return block.charOffset + decodedBlock( index )->newlines.at( line - block.lineOffset - 1 ) + 1;
+}
+
+
+/// The mapped textbuffer is read-only, raw appending is ignored
+void MappedTextBuffer::rawAppendBegin()
+{
+    qlog_warn() << "MappedTextBuffer is read-only, rawAppend is ignored";
+}
+
+
+/// The mapped textbuffer is read-only, raw appending is ignored
+void MappedTextBuffer::rawAppend(QChar c)
+{
+    Q_UNUSED(c);
+}
+
+
+/// The mapped textbuffer is read-only, raw appending is ignored
+void MappedTextBuffer::rawAppend(const QChar* data, TextOffset dataLength)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(dataLength);
+}
+
+
+/// The mapped textbuffer is read-only, raw appending is ignored
+void MappedTextBuffer::rawAppendEnd()
+{
+}
+
+
+/// Returns the flattened text of the indexed blocks
+/// WARNING this decodes the complete indexed text, which defeats the purpose of this buffer. Prefer chunkAt or the TextBufferChunkIterator
+QChar* MappedTextBuffer::rawDataPointer()
+{
+    rawData_ = textPart( 0, length() );
+    return rawData_.data();
+}
+
+
+/// Returns the decoded text of the block that contains the given offset. An offset at the end of the buffer returns the last block.
+/// The decoded block stays in memory until CachedBlockCount other blocks are decoded,
+/// callers may only rely on the TextBuffer::chunkAt contract (valid until the next chunkAt call)
+const QChar* MappedTextBuffer::chunkAt(TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength) const
+{
+    Q_ASSERT( offset >= 0 );
+    chunkStart = 0;
+    chunkLength = 0;
+    if( length_ == 0 ) { return nullptr; }
+    if( offset >= length_ ) { offset = length_ - 1; }
+
+    int index = blockIndexForOffset( offset );
+    const Block& block = blocks_.at(index);
+    chunkStart = block.charOffset;
+    chunkLength = block.charLength;
+    return decodedBlock( index )->text.constData();
+}
+
+
+/// Returns the end of the block that starts at the given byte offset.
+/// A block never ends in the middle of an UTF-8 sequence or between a "\r\n" pair
+qint64 MappedTextBuffer::blockEnd(qint64 byteOffset) const
+{
+    qint64 end = byteOffset + blockSize_;
+    if( end >= dataSize_ ) { return dataSize_; }
+
+    // move the end to the start of the UTF-8 sequence
+    if( !latin1_ ) {
+        qint64 pos = end;
+        for( int i=0; i < 3 && pos > byteOffset && isContinuationByte( data_[pos] ); ++i ) { --pos; }
+        if( !isContinuationByte( data_[pos] ) ) {
+            if( pos > byteOffset ) {
+                end = pos;
+            } else {
+                // the block would be empty, include the complete sequence instead
+                for( int i=0; i < 3 && end < dataSize_ && isContinuationByte( data_[end] ); ++i ) { ++end; }
+            }
+        }
+    }
+
+    // keep a "\r\n" pair in a single block
+    if( end < dataSize_ && data_[end - 1] == '\r' && data_[end] == '\n' ) {
+        end += ( end - 1 > byteOffset ) ? -1 : 1;
+    }
+    return end;
+}
+
+
+/// Decodes the given bytes of the mapped file.
+/// Invalid UTF-8 sequences are replaced by U+FFFD. A "\r" that's followed by a "\n" is skipped.
+/// @param byteOffset the offset of the first byte
+/// @param byteLength the number of bytes to decode
+QString MappedTextBuffer::decode(qint64 byteOffset, qint64 byteLength) const
+{
+    // a byte never results in more than one character
+    QString result( static_cast<int>( byteLength ), Qt::Uninitialized );
+    QChar* target = result.data();
+
+    const uchar* c = data_ + byteOffset;
+    const uchar* end = c + byteLength;
+    while( c < end ) {
+        if( *c == '\r' && c + 1 < end && c[1] == '\n' ) {
+            ++c;
+        } else if( *c < 0x80 || latin1_ ) {
+            *target++ = QChar( static_cast<ushort>( *c ) );
+            ++c;
+        } else {
+            uint code = 0xFFFD;
+            int size = 1;
+            if( *c >= 0xC2 && *c <= 0xDF ) {
+                if( c + 1 < end && isContinuationByte( c[1] ) ) {
+                    code = ((c[0] & 0x1Fu) << 6) | (c[1] & 0x3Fu);
+                    size = 2;
+                }
+            } else if( *c >= 0xE0 && *c <= 0xEF ) {
+                if( c + 2 < end && isContinuationByte( c[1] ) && isContinuationByte( c[2] ) ) {
+                    uint value = ((c[0] & 0x0Fu) << 12) | ((c[1] & 0x3Fu) << 6) | (c[2] & 0x3Fu);
+                    if( value >= 0x800 && ( value < 0xD800 || value > 0xDFFF ) ) {
+                        code = value;
+                        size = 3;
+                    }
+                }
+            } else if( *c >= 0xF0 && *c <= 0xF4 ) {
+                if( c + 3 < end && isContinuationByte( c[1] ) && isContinuationByte( c[2] ) && isContinuationByte( c[3] ) ) {
+                    uint value = ((c[0] & 0x07u) << 18) | ((c[1] & 0x3Fu) << 12) | ((c[2] & 0x3Fu) << 6) | (c[3] & 0x3Fu);
+                    if( value >= 0x10000 && value <= 0x10FFFF ) {
+                        code = value;
+                        size = 4;
+                    }
+                }
+            }
+
+            if( code >= 0x10000 ) {
+                *target++ = QChar( QChar::highSurrogate( code ) );
+                *target++ = QChar( QChar::lowSurrogate( code ) );
+            } else {
+                *target++ = QChar( static_cast<ushort>( code ) );
+            }
+            c += size;
+        }
+    }
+    result.resize( static_cast<int>( target - result.constData() ) );
+    return result;
+}
+
+
+/// Returns the index of the block that contains the given offset (0 <= offset < length())
+int MappedTextBuffer::blockIndexForOffset(TextOffset offset) const
+{
+    int begin = 0, end = blocks_.size() - 1;
+    while( begin < end ) {
+        int middle = begin + (end - begin + 1) / 2;
+        if( blocks_.at(middle).charOffset <= offset ) {
+            begin = middle;
+        } else {
+            end = middle - 1;
+        }
+    }
+    return begin;
+}
+
+
+/// Returns the index of the block that contains the newline that ends the line before the given line (1 <= line <= newline count)
+int MappedTextBuffer::blockIndexForLine(int line) const
+{
+    int begin = 0, end = blocks_.size() - 1;
+    while( begin < end ) {
+        int middle = begin + (end - begin) / 2;
+        const Block& block = blocks_.at(middle);
+        if( block.lineOffset + block.newlineCount < line ) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+
+/// Returns the decoded block with the given index. The block is decoded when it isn't in the cache.
+const MappedTextBuffer::DecodedBlock* MappedTextBuffer::decodedBlock(int index) const
+{
+    for( int i=0, cnt=cache_.size(); i < cnt; ++i ) {
+        DecodedBlock* decoded = cache_.at(i);
+        if( decoded->index == index ) {
+            if( i > 0 ) { cache_.move( i, 0 ); }
+            return decoded;
+        }
+    }
+
+    const Block& block = blocks_.at(index);
+    return decodeBlock( index, block.byteOffset, block.byteLength );
+}
+
+
+/// Decodes the given bytes as a block and adds it to the cache.
+/// The least recently used block is removed from the cache when it is full
+/// @param index the index of the block
+/// @param byteOffset the offset of the first byte of the block
+/// @param byteLength the number of bytes of the block
+MappedTextBuffer::DecodedBlock* MappedTextBuffer::decodeBlock(int index, qint64 byteOffset, qint64 byteLength) const
+{
+    DecodedBlock* decoded = new DecodedBlock();
+    decoded->index = index;
+    decoded->text = decode( byteOffset, byteLength );
+    NewlineScanner::appendOffsets( decoded->text.constData(), decoded->text.length(), 0, decoded->newlines );
+
+    cache_.prepend( decoded );
+    while( cache_.size() > CachedBlockCount ) { delete cache_.takeLast(); }
+    return decoded;
+}
+
+
+/// Removes all decoded blocks
+void MappedTextBuffer::clearCache() const
+{
+    qDeleteAll( cache_ );
+    cache_.clear();
+}
+
+
+} // edbee
@@ -0,0 +1,125 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "edbee/models/textbuffer.h"
+
+class QFile;
+
+namespace edbee {
+
+class LineEnding;
+class TextCodec;
+
+
+/// A read-only textbuffer that is backed by a memory mapped file.
+///
+/// The file is split in blocks of (about) BlockSize bytes. For every block only the byte offset, character offset
+/// and line offset are stored. The text of a block is decoded on demand and kept in a small cache of recently used blocks.
+/// Which means the resident memory stays near the size of the visible part of the document, independent of the file size.
+///
+/// The blocks are indexed lazily. Only the indexed part of the file is part of the buffer (length() and lineCount()).
+/// Every call to indexBlocks appends the next blocks to the buffer, which emits the normal textAboutToBeChanged / textChanged signals.
+///
+/// Only UTF-8 and Latin-1 (ISO-8859-1) encoded files are supported, because these can be decoded per block.
+/// Like the TextDocumentSerializer a "\r\n" sequence is read as a single "\n".
+///
+/// All methods that change the buffer are ignored. (MappedTextDocument::isReadonly makes the document ignore
+/// the changes before a change object or undo entry is created.)
+/// There's no copy-on-write, to edit the text it must be loaded in another document.
+class EDBEE_EXPORT MappedTextBuffer : public TextBuffer
+{
+public:
+    MappedTextBuffer( QObject* parent=0 );
+    virtual ~MappedTextBuffer();
+
+    bool open( const QString& fileName );
+    void close();
+    bool isOpen() const;
+    QString fileName() const;
+    QString errorString() const;
+    TextCodec* codec() const;
+    const LineEnding* lineEnding() const;
+    qint64 fileSize() const;
+
+    void setBlockSize( int size );
+    int blockSize() const;
+
+    bool indexBlocks( int count );
+    void indexAll();
+    bool isFullyIndexed() const;
+    qint64 indexedByteCount() const;
+    int blockCount() const;
+
+    virtual TextOffset length() const;
+    virtual QChar charAt( TextOffset offset ) const;
+    virtual QString textPart( TextOffset offset, TextOffset length ) const;
+
+    virtual void replaceText( TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength );
+
+    virtual int lineCount();
+    virtual int lineFromOffset( TextOffset offset );
+    virtual TextOffset offsetFromLine( int line );
+
+    virtual void rawAppendBegin();
+    virtual void rawAppend( QChar c );
+    virtual void rawAppend( const QChar* data, TextOffset dataLength );
+    virtual void rawAppendEnd();
+
+    virtual QChar* rawDataPointer();
+    virtual const QChar* chunkAt( TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength ) const;
+
+    /// The preferred number of bytes in a single block
+    static const int BlockSize = 64 * 1024;
+
+    /// The number of decoded blocks that are kept in memory
+    static const int CachedBlockCount = 8;
+
+private:
+    /// The index information of a single block of the file
+    struct Block {
+        qint64 byteOffset;          ///< The offset of the first byte of this block in the file
+        qint64 byteLength;          ///< The number of bytes of this block
+        TextOffset charOffset;      ///< The offset of the first character of this block in the buffer
+        TextOffset charLength;      ///< The number of characters in this block
+        int lineOffset;             ///< The number of newlines before this block
+        int newlineCount;           ///< The number of newlines in this block
+    };
+    struct DecodedBlock;
+
+    qint64 blockEnd( qint64 byteOffset ) const;
+    QString decode( qint64 byteOffset, qint64 byteLength ) const;
+    int blockIndexForOffset( TextOffset offset ) const;
+    int blockIndexForLine( int line ) const;
+    const DecodedBlock* decodedBlock( int index ) const;
+    DecodedBlock* decodeBlock( int index, qint64 byteOffset, qint64 byteLength ) const;
+    void clearCache() const;
+
+private:
+    QFile* file_;                               ///< The mapped file (0 when no file is opened)
+    const uchar* data_;                         ///< The mapped data of the file
+    qint64 dataStart_;                          ///< The byte offset of the text (skips the byte order mark)
+    qint64 dataSize_;                           ///< The total number of mapped bytes
+    TextCodec* codecRef_;                       ///< The detected codec
+    const LineEnding* lineEndingRef_;           ///< The detected line ending
+    bool latin1_;                               ///< Is the file decoded as Latin-1? (else UTF-8)
+    QString errorString_;                       ///< The last error
+    int blockSize_;                             ///< The preferred number of bytes in a block
+
+    QVector<Block> blocks_;                     ///< All indexed blocks
+    qint64 indexedBytes_;                       ///< The byte offset of the first block that isn't indexed
+    TextOffset length_;                         ///< The number of characters in all indexed blocks
+    int newlineCount_;                          ///< The number of newlines in all indexed blocks
+
+    mutable QList<DecodedBlock*> cache_;        ///< The decoded blocks, the most recently used block first
+    QString rawData_;                           ///< The flattened text returned by rawDataPointer
+};
+
+} // edbee
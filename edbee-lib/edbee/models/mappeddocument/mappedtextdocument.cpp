@@ -0,0 +1,116 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "mappedtextdocument.h"
+
+#include <QTimer>
+
+#include "mappedtextbuffer.h"
+#include "edbee/models/texteditorconfig.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+const int MappedTextDocument::InitialBlockCount;
+const int MappedTextDocument::BlocksPerStep;
+
+
+/// Constructs the mapped text document
+/// @param object the parent object
+MappedTextDocument::MappedTextDocument(QObject* object)
+    : edbee::MappedTextDocument(new TextEditorConfig(), object)
+{
+}
+
+
+/// Constructs the mapped text document with the given config
+/// @param config the text editor configuration (ownership is transferred)
+/// @param object the parent object
+MappedTextDocument::MappedTextDocument(TextEditorConfig* config, QObject* object)
+    : CharTextDocument(new MappedTextBuffer(), config, object)
+    , indexTimer_(nullptr)
+{
+    indexTimer_ = new QTimer(this);
+    indexTimer_->setInterval(0);
+    connect( indexTimer_, SIGNAL(timeout()), this, SLOT(indexNextBlocks()) );
+}
+
+
+/// The destructor stops indexing
+MappedTextDocument::~MappedTextDocument()
+{
+    indexTimer_->stop();
+}
+
+
+/// Opens the given file. The first blocks are indexed directly, the remaining blocks are indexed in the background.
+/// @param fileName the file to open
+/// @return true on success. On failure the reason is available via errorString()
+bool MappedTextDocument::open(const QString& fileName)
+{
+    indexTimer_->stop();
+
+    // opening and indexing never results in undoable changes
+    setUndoCollectionEnabled(false);
+    bool result = mappedBuffer()->open(fileName);
+    if( result ) {
+        setEncoding( mappedBuffer()->codec() );
+        setLineEnding( mappedBuffer()->lineEnding() );
+        if( mappedBuffer()->indexBlocks( InitialBlockCount ) ) {
+            indexTimer_->start();
+        }
+    }
+    setUndoCollectionEnabled(true);
+    setPersisted(true);
+
+    if( result && !indexTimer_->isActive() ) {
+        emit indexingFinished();
+    }
+    return result;
+}
+
+
+/// Returns the error of the last open call
+QString MappedTextDocument::errorString() const
+{
+    return mappedBuffer()->errorString();
+}
+
+
+/// Returns the mapped textbuffer of this document
+MappedTextBuffer* MappedTextDocument::mappedBuffer() const
+{
+    return static_cast<MappedTextBuffer*>( buffer() );
+}
+
+
+/// A mapped document is always readonly
+bool MappedTextDocument::isReadonly() const
+{
+    return true;
+}
+
+
+/// Returns true if the file is still being indexed
+bool MappedTextDocument::isIndexing() const
+{
+    return indexTimer_->isActive();
+}
+
+
+/// Indexes the next blocks of the mapped file. Emits indexingFinished when all blocks are indexed
+void MappedTextDocument::indexNextBlocks()
+{
+    setUndoCollectionEnabled(false);
+    bool remaining = mappedBuffer()->indexBlocks( BlocksPerStep );
+    setUndoCollectionEnabled(true);
+
+    if( !remaining ) {
+        indexTimer_->stop();
+        emit indexingFinished();
+    }
+}
+
+
+} // edbee
@@ -0,0 +1,59 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include "edbee/models/chardocument/chartextdocument.h"
+
+class QTimer;
+
+namespace edbee {
+
+class MappedTextBuffer;
+class TextEditorConfig;
+
+/// A read-only textdocument for (very) large files, backed by a MappedTextBuffer.
+///
+/// Opening a file only indexes the first blocks, so the first screen is shown immediately.
+/// The remaining blocks are indexed in small steps on the event loop. The document grows while indexing,
+/// which is reported via the normal textChanged signals.
+/// The indexing runs on the GUI thread: every timeout of a zero-interval QTimer indexes the next BlocksPerStep blocks.
+/// There are no background (worker thread) chunks.
+///
+/// The document can't be changed, so an editor that shows this document is always readonly.
+/// The text changes are ignored by TextDocument (see isReadonly), there's no copy-on-write.
+class EDBEE_EXPORT MappedTextDocument : public CharTextDocument
+{
+Q_OBJECT
+
+public:
+    MappedTextDocument( QObject* object );
+    MappedTextDocument( TextEditorConfig* config = new TextEditorConfig(), QObject* object = nullptr );
+    virtual ~MappedTextDocument();
+
+    bool open( const QString& fileName );
+    QString errorString() const;
+
+    MappedTextBuffer* mappedBuffer() const;
+    virtual bool isReadonly() const;
+    bool isIndexing() const;
+
+    /// The number of blocks that are indexed synchronously when opening a file
+    static const int InitialBlockCount = 4;
+
+    /// The number of blocks that are indexed in a single step of the event loop
+    static const int BlocksPerStep = 16;
+
+signals:
+    void indexingFinished();
+
+protected slots:
+    void indexNextBlocks();
+
+private:
+    QTimer* indexTimer_;        ///< The timer that indexes the remaining blocks
+};
+
+} // edbee
@@ -0,0 +1,494 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "ropetextbuffer.h"
+
+#include "edbee/util/newlinescanner.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+const int RopeTextBuffer::ChunkSize;
+
+
+/// A single node of the rope. Every node contains a chunk of text
+/// and the aggregated information of the complete subtree
+struct RopeTextBuffer::Node {
+    QString text;           ///< The text chunk of this node
+    int newlineCount;       ///< The number of newlines in the text chunk
+    quint32 priority;       ///< The treap priority. A node always has a higher (or equal) priority than its children
+    Node* left;             ///< The left subtree (owned)
+    Node* right;            ///< The right subtree (owned)
+    TextOffset totalLength; ///< The total number of characters of this subtree
+    int totalNewlineCount;  ///< The total number of newlines in this subtree
+};
+
+
+/// Counts the number of newlines in the given string
+static int countNewlines( const QString& text )
+{
+    return NewlineScanner::count( text.constData(), text.length() );
+}
+
+
+/// Counts the number of newlines in the first length characters of the given string
+static int countNewlines( const QString& text, int length )
+{
+    return NewlineScanner::count( text.constData(), length );
+}
+
+
+/// The constructor of the rope textbuffer
+/// @param parent the parent QObject
+RopeTextBuffer::RopeTextBuffer(QObject* parent)
+    : TextBuffer( parent )
+    , root_(nullptr)
+    , priorities_(0x9E3779B9u)
+    , rawAppendStart_(-1)
+{
+}
+
+
+/// The destructor deletes all nodes
+RopeTextBuffer::~RopeTextBuffer()
+{
+    NodeTreap::deleteTree(root_);
+}
+
+
+/// Returns the length of the buffer
+TextOffset RopeTextBuffer::length() const
+{
+    return root_ ? root_->totalLength : 0;
+}
+
+
+/// Returns the character at the given offset
+/// @param offset the offset of the character
+QChar RopeTextBuffer::charAt(TextOffset offset) const
+{
+    Q_ASSERT(offset >= 0);
+    Q_ASSERT(offset < length());
+
+    const Node* node = root_;
+    while( node ) {
+        TextOffset leftLength = node->left ? node->left->totalLength : 0;
+        if( offset < leftLength ) {
+            node = node->left;
+        } else {
+            offset -= leftLength;
+            if( offset < node->text.length() ) { return node->text.at(offset); }
+            offset -= node->text.length();
+            node = node->right;
+        }
+    }
+    return QChar();
+}
+
+
+/// Returns the given part of the text
+/// @param offset the start of the text
+/// @param length the number of characters to return
+QString RopeTextBuffer::textPart(TextOffset offset, TextOffset length) const
+{
+    Q_ASSERT( offset >= 0 );
+    Q_ASSERT( length >= 0 );
+    QString result;
+    result.reserve(length);
+    appendRange( root_, offset, length, result );
+    return result;
+}
+
+
+/// Replaces the given text and fires the textAboutToBeChanged and textChanged signals
+/// @param offset the offset of the text to replace
+/// @param length the length of the text to replace
+/// @param buffer a pointer to the new text
+/// @param bufferLength the length of the new text
+void RopeTextBuffer::replaceText(TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength)
+{
+    // make sure the position is correct
+    if( offset > this->length() ) {
+        offset = this->length();
+        length = 0;
+    }
+
+    // make sure the length matches
+    length = qMin( this->length() - offset, length );
+
+    TextBufferChange change( this, offset, length, buffer, bufferLength );
+    emit textAboutToBeChanged( change );
+
+    QString oldText = oldTextForChange( offset, length );
+    replaceTextInTree( offset, length, buffer, bufferLength );
+
+    emit textChanged( change, oldText );
+}
+
+
+/// Returns the number of lines
+int RopeTextBuffer::lineCount()
+{
+    return ( root_ ? root_->totalNewlineCount : 0 ) + 1;
+}
+
+
+/// Returns the line at the given offset. This is the number of newlines before the given offset
+/// @param offset the offset to retrieve the line for
+int RopeTextBuffer::lineFromOffset(TextOffset offset)
+{
+    int line = 0;
+    const Node* node = root_;
+    while( node && offset > 0 ) {
+        TextOffset leftLength = node->left ? node->left->totalLength : 0;
+        if( offset <= leftLength ) {
+            node = node->left;
+        } else {
+            line   += node->left ? node->left->totalNewlineCount : 0;
+            offset -= leftLength;
+            if( offset <= node->text.length() ) {
+                return line + countNewlines( node->text, offset );
+            }
+            line   += node->newlineCount;
+            offset -= node->text.length();
+            node = node->right;
+        }
+    }
+    return line;
+}
+
+
+/// Returns the offset of the given line
+/// @param line the line to retrieve the offset for
+TextOffset RopeTextBuffer::offsetFromLine(int line)
+{
+    if( line <= 0 ) return 0;
+    if( line >= lineCount() ) return length();
+
+    TextOffset offset = 0;
+    const Node* node = root_;
+    while( node ) {
+        int leftNewlineCount = node->left ? node->left->totalNewlineCount : 0;
+        if( line <= leftNewlineCount ) {
+            node = node->left;
+        } else {
+            line   -= leftNewlineCount;
+            offset += node->left ? node->left->totalLength : 0;
+            if( line <= node->newlineCount ) {
+                // find the line-th newline in this chunk
+                const QChar* data = node->text.constData();
+                const QChar* end = data + node->text.length();
+                for( const QChar* c = NewlineScanner::find( data, end, '\n' ); c < end; c = NewlineScanner::find( c + 1, end, '\n' ) ) {
+                    if( --line == 0 ) { return offset + ( c - data ) + 1; }
+                }
+                Q_ASSERT(false && "newline count of chunk is invalid");
+            }
+            line   -= node->newlineCount;
+            offset += node->text.length();
+            node = node->right;
+        }
+    }
+    return length();
+}
+
+
+/// Starts raw data appending to the buffer
+void RopeTextBuffer::rawAppendBegin()
+{
+    Q_ASSERT(rawAppendStart_ == -1 );
+    rawAppendStart_ = length();
+    rawAppendBuffer_.clear();
+}
+
+
+/// Append a single character to the buffer in raw mode
+/// @param c the character to append
+void RopeTextBuffer::rawAppend(QChar c)
+{
+    rawAppendBuffer_.append(c);
+}
+
+
+/// Appends a buffer of text to the document
+/// @param data the data to append
+/// @param dataLength the number of characters available in the data pointer
+void RopeTextBuffer::rawAppend(const QChar* data, TextOffset dataLength)
+{
+    rawAppendBuffer_.append( data, dataLength );
+}
+
+
+/// Ends the 'raw' appending of data. The collected text is added to the tree in one go
+void RopeTextBuffer::rawAppendEnd()
+{
+    Q_ASSERT(rawAppendStart_ >= 0 );
+
+    TextBufferChange change( this, rawAppendStart_, 0, rawAppendBuffer_.constData(), rawAppendBuffer_.length() );
+    emit textAboutToBeChanged( change );
+    replaceTextInTree( rawAppendStart_, 0, rawAppendBuffer_.constData(), rawAppendBuffer_.length() );
+    emit textChanged( change, QString() );
+
+    rawAppendBuffer_.clear();
+    rawAppendStart_ = -1;
+}
+
+
+/// Returns a pointer to a flattened copy of the complete text.
+/// WARNING this method copies the complete document, which is expensive for big documents.
+/// The pointer is valid until the next call to this method.
+QChar* RopeTextBuffer::rawDataPointer()
+{
+    rawData_ = textPart( 0, length() );
+    return rawData_.data();
+}
+
+
+/// Returns the chunk (tree node) that contains the given offset. An offset at the end of the buffer returns the last chunk
+const QChar* RopeTextBuffer::chunkAt(TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength) const
+{
+    Q_ASSERT( offset >= 0 );
+    chunkStart = 0;
+    chunkLength = 0;
+    if( !root_ ) { return nullptr; }
+    if( offset >= root_->totalLength ) { offset = root_->totalLength - 1; }
+
+    const Node* node = root_;
+    TextOffset nodeStart = 0;
+    while( node ) {
+        TextOffset leftLength = node->left ? node->left->totalLength : 0;
+        if( offset < leftLength ) {
+            node = node->left;
+        } else {
+            offset -= leftLength;
+            nodeStart += leftLength;
+            if( offset < node->text.length() ) {
+                chunkStart = nodeStart;
+                chunkLength = node->text.length();
+                return node->text.constData();
+            }
+            offset -= node->text.length();
+            nodeStart += node->text.length();
+            node = node->right;
+        }
+    }
+    return nullptr;
+}
+
+
+/// Returns the number of chunks (tree nodes) used for storing the text
+int RopeTextBuffer::chunkCount() const
+{
+    return NodeTreap::nodeCount(root_);
+}
+
+
+/// Creates a new tree node for the given chunk of text
+/// @param text the chunk of text
+/// @param priority the treap priority of the node
+RopeTextBuffer::Node* RopeTextBuffer::createNode(const QString& text, quint32 priority)
+{
+    Node* node = new Node();
+    node->text = text;
+    node->newlineCount = countNewlines(text);
+    node->priority = priority;
+    node->left = nullptr;
+    node->right = nullptr;
+    update(node);
+    return node;
+}
+
+
+/// Recalculates the aggregated subtree values of the given node
+void RopeTextBuffer::update(Node* node)
+{
+    node->totalLength       = node->text.length();
+    node->totalNewlineCount = node->newlineCount;
+    if( node->left ) {
+        node->totalLength       += node->left->totalLength;
+        node->totalNewlineCount += node->left->totalNewlineCount;
+    }
+    if( node->right ) {
+        node->totalLength       += node->right->totalLength;
+        node->totalNewlineCount += node->right->totalNewlineCount;
+    }
+}
+
+
+/// Appends the given range of the subtree to the result string
+/// @param node the subtree
+/// @param offset the offset relative to the start of the subtree
+/// @param length the number of characters to append
+/// @param result the string to append the characters to
+void RopeTextBuffer::appendRange(const Node* node, TextOffset offset, TextOffset length, QString& result)
+{
+    while( node && length > 0 ) {
+        TextOffset leftLength = node->left ? node->left->totalLength : 0;
+
+        // the range starts in the left subtree
+        if( offset < leftLength ) {
+            TextOffset len = qMin( leftLength - offset, length );
+            appendRange( node->left, offset, len, result );
+            length -= len;
+            offset = leftLength;
+        }
+        if( length <= 0 ) return;
+
+        // (a part of) the text of this node
+        offset -= leftLength;
+        if( offset < node->text.length() ) {
+            TextOffset len = qMin<TextOffset>( node->text.length() - offset, length );
+            result.append( node->text.constData() + offset, len );
+            length -= len;
+            offset = node->text.length();
+        }
+
+        // continue in the right subtree
+        offset -= node->text.length();
+        node = node->right;
+    }
+}
+
+
+/// Splits the tree at the given offset. When the offset is inside a chunk the chunk is split in 2 parts
+/// @param node the tree to split
+/// @param offset the offset to split the tree at
+/// @param left (out) the tree with all text before the offset
+/// @param right (out) the tree with all text starting at the offset
+void RopeTextBuffer::split(Node* node, TextOffset offset, Node*& left, Node*& right)
+{
+    if( !node ) {
+        left  = nullptr;
+        right = nullptr;
+        return;
+    }
+
+    TextOffset leftLength = node->left ? node->left->totalLength : 0;
+    int textLength = node->text.length();
+
+    if( offset <= leftLength ) {
+        split( node->left, offset, left, node->left );
+        update( node );
+        right = node;
+
+    } else if( offset >= leftLength + textLength ) {
+        split( node->right, offset - leftLength - textLength, node->right, right );
+        update( node );
+        left = node;
+
+    // the offset is inside the chunk of this node
+    } else {
+        int pos = static_cast<int>( offset - leftLength );
+        // the tail gets the same priority, so it can take the place of this node as root of the right subtree
+        Node* tail = createNode( node->text.mid(pos), node->priority );
+        tail->right = node->right;
+        update( tail );
+
+        node->text.truncate(pos);
+        node->newlineCount = countNewlines(node->text);
+        node->right = nullptr;
+        update( node );
+
+        left  = node;
+        right = tail;
+    }
+}
+
+
+/// Removes the last chunk from the given tree
+/// @param tree (in/out) the tree to remove the last chunk from
+/// @return the node with the last chunk or 0 if the tree is empty
+RopeTextBuffer::Node* RopeTextBuffer::takeLastChunk(Node*& tree)
+{
+    if( !tree ) return nullptr;
+    const Node* last = NodeTreap::lastNode( tree );
+
+    Node* result = nullptr;
+    split( tree, tree->totalLength - last->text.length(), tree, result );
+    Q_ASSERT( result && !result->left && !result->right );
+    return result;
+}
+
+
+/// Removes the first chunk from the given tree
+/// @param tree (in/out) the tree to remove the first chunk from
+/// @return the node with the first chunk or 0 if the tree is empty
+RopeTextBuffer::Node* RopeTextBuffer::takeFirstChunk(Node*& tree)
+{
+    if( !tree ) return nullptr;
+    const Node* first = NodeTreap::firstNode( tree );
+
+    Node* result = nullptr;
+    split( tree, first->text.length(), result, tree );
+    Q_ASSERT( result && !result->left && !result->right );
+    return result;
+}
+
+
+/// Builds a tree with evenly sized chunks for the concatenation of prefix, data and suffix
+/// @param prefix the text to place before the data
+/// @param data the data
+/// @param dataLength the number of characters in data
+/// @param suffix the text to place after the data
+/// @return the new tree (or 0 if there's no text)
+RopeTextBuffer::Node* RopeTextBuffer::buildChunks(const QString& prefix, const QChar* data, TextOffset dataLength, const QString& suffix)
+{
+    TextOffset totalLength = prefix.length() + dataLength + suffix.length();
+    if( totalLength == 0 ) return nullptr;
+
+    TextOffset chunkCount = ( totalLength + ChunkSize - 1 ) / ChunkSize;
+    TextOffset chunkLength = totalLength / chunkCount;
+    TextOffset remainder = totalLength % chunkCount;
+
+    // the source parts are 'walked' as one continuous text
+    const QChar* parts[3]     = { prefix.constData(), data, suffix.constData() };
+    TextOffset partLengths[3] = { static_cast<TextOffset>(prefix.length()), dataLength, static_cast<TextOffset>(suffix.length()) };
+    int partIdx = 0;
+    TextOffset partOffset = 0;
+
+    Node* result = nullptr;
+    for( TextOffset i=0; i < chunkCount; ++i ) {
+        TextOffset length = chunkLength + ( i < remainder ? 1 : 0 );
+        QString chunk;
+        chunk.reserve(length);
+        while( length > 0 ) {
+            TextOffset available = partLengths[partIdx] - partOffset;
+            if( available <= 0 ) {
+                ++partIdx;
+                partOffset = 0;
+                continue;
+            }
+            TextOffset len = qMin( available, length );
+            chunk.append( parts[partIdx] + partOffset, len );
+            partOffset += len;
+            length -= len;
+        }
+        result = NodeTreap::merge( result, createNode( chunk, priorities_.next() ) );
+    }
+    return result;
+}
+
+
+/// Replaces the text in the tree, without emitting signals
+/// The chunks directly around the change are rebuilt together with the new text, this prevents the
+/// tree from fragmenting into lots of tiny chunks while typing.
+void RopeTextBuffer::replaceTextInTree(TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength)
+{
+    Node* left   = nullptr;
+    Node* middle = nullptr;
+    Node* right  = nullptr;
+    split( root_, offset, left, right );
+    split( right, length, middle, right );
+    NodeTreap::deleteTree( middle );
+
+    Node* prev = takeLastChunk( left );
+    Node* next = takeFirstChunk( right );
+    middle = buildChunks( prev ? prev->text : QString(), buffer, bufferLength, next ? next->text : QString() );
+    delete prev;
+    delete next;
+
+    root_ = NodeTreap::merge( NodeTreap::merge( left, middle ), right );
+}
+
+
+} // edbee
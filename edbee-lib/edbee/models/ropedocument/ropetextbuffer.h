@@ -0,0 +1,83 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QString>
+
+#include "edbee/models/textbuffer.h"
+#include "edbee/util/treap.h"
+#include "edbee/util/xorshiftrandom.h"
+
+namespace edbee {
+
+
+/// This textbuffer implementation stores the text in a balanced tree of small text chunks (a rope).
+///
+/// Every tree node contains a chunk of text and the aggregated length and newline count of its subtree.
+/// This makes replaceText, charAt, textPart, lineFromOffset and offsetFromLine O(log n) operations, independent
+/// of the location of the previous edit. Which is a lot better for huge documents and scattered (multi-caret) edits
+/// than the gap-vector of the CharTextBuffer.
+///
+/// The tree is a treap (a randomized binary search tree) which is kept balanced with split and merge operations.
+///
+/// The text isn't stored in a single block of memory. So rawDataPointer copies the entire text (on every call),
+/// use chunkAt, rangeData or the TextBufferChunkIterator to read the text without copying it.
+class EDBEE_EXPORT RopeTextBuffer : public TextBuffer
+{
+public:
+    RopeTextBuffer( QObject* parent=0 );
+    virtual ~RopeTextBuffer();
+
+    virtual TextOffset length() const;
+    virtual QChar charAt( TextOffset offset ) const;
+    virtual QString textPart( TextOffset offset, TextOffset length ) const;
+
+    virtual void replaceText( TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength );
+
+    virtual int lineCount();
+    virtual int lineFromOffset( TextOffset offset );
+    virtual TextOffset offsetFromLine( int line );
+
+    virtual void rawAppendBegin();
+    virtual void rawAppend( QChar c );
+    virtual void rawAppend( const QChar* data, TextOffset dataLength );
+    virtual void rawAppendEnd();
+
+    virtual QChar* rawDataPointer();
+    virtual const QChar* chunkAt( TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength ) const;
+
+    int chunkCount() const;
+
+    /// The preferred maximum number of characters in a single chunk
+    static const int ChunkSize = 1024;
+
+private:
+    struct Node;
+
+    Node* createNode( const QString& text, quint32 priority );
+
+    static void update( Node* node );
+    typedef Treap<Node, &RopeTextBuffer::update> NodeTreap;
+
+    static void appendRange( const Node* node, TextOffset offset, TextOffset length, QString& result );
+
+    void split( Node* node, TextOffset offset, Node*& left, Node*& right );
+    Node* takeLastChunk( Node*& tree );
+    Node* takeFirstChunk( Node*& tree );
+    Node* buildChunks( const QString& prefix, const QChar* data, TextOffset dataLength, const QString& suffix );
+
+    void replaceTextInTree( TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength );
+
+private:
+    Node* root_;                    ///< The root node of the tree (0 when the buffer is empty)
+    XorShiftRandom priorities_;     ///< The pseudo random number generator of the node priorities
+
+    QString rawAppendBuffer_;       ///< The text collected between rawAppendBegin and rawAppendEnd
+    TextOffset rawAppendStart_;     ///< The start offset of raw appending. -1 means no appending is happening
+    QString rawData_;               ///< The flattened text returned by rawDataPointer
+};
+
+} // edbee
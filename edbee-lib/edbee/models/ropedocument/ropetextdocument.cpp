@@ -0,0 +1,31 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "ropetextdocument.h"
+
+#include "ropetextbuffer.h"
+#include "edbee/models/texteditorconfig.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Constructs the rope text document
+/// @param object the parent object
+RopeTextDocument::RopeTextDocument(QObject* object)
+    : edbee::RopeTextDocument(new TextEditorConfig(), object)
+{
+}
+
+
+/// Constructs the rope text document with the given config
+/// @param config the text editor configuration (ownership is transferred)
+/// @param object the parent object
+RopeTextDocument::RopeTextDocument(TextEditorConfig* config, QObject* object)
+    : CharTextDocument(new RopeTextBuffer(), config, object)
+{
+}
+
+
+} // edbee
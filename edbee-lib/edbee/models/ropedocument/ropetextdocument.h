@@ -0,0 +1,26 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include "edbee/models/chardocument/chartextdocument.h"
+
+namespace edbee {
+
+class TextEditorConfig;
+
+/// A textdocument that stores its text in a RopeTextBuffer.
+/// This document is preferred for very large documents and documents with a lot of scattered edits
+/// All other document behaviour (undo, scopes, lexing, line-data) is the same as the CharTextDocument
+class EDBEE_EXPORT RopeTextDocument : public CharTextDocument
+{
+Q_OBJECT
+
+public:
+    RopeTextDocument( QObject* object );
+    RopeTextDocument( TextEditorConfig* config = new TextEditorConfig(), QObject* object = nullptr );
+};
+
+} // edbee
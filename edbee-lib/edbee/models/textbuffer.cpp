@@ -3,22 +3,42 @@
 
 #include "textbuffer.h"
 
+#include <QMetaMethod>
+
 #include "edbee/models/textrange.h"
 #include "edbee/util/lineoffsetvector.h"
+#include "edbee/util/newlinescanner.h"
 
 #include "edbee/debug.h"
 
 namespace edbee {
 
 
+/// Constructs an empty change
+TextBufferChange::TextBufferChange()
+    : offset_(0)
+    , length_(0)
+    , newText_(nullptr)
+    , newTextLength_(0)
+    , line_(0)
+    , lineCount_(0)
+    , newLineCount_(0)
+{
+}
+
+
 /// Initializes the textbuffer change
-/// @param buffer when buffer is 0 NO line calculation is done
-TextBufferChangeData::TextBufferChangeData(TextBuffer* buffer, int off, int len, const QChar *text, int textlen)
+/// @param buffer the buffer, which is used to calculate the line information (before the change is applied)
+/// @param off the offset of the change
+/// @param len the number of characters that are replaced
+/// @param text the new text
+/// @param textlen the length of the new text
+TextBufferChange::TextBufferChange(TextBuffer* buffer, TextOffset off, TextOffset len, const QChar* text, TextOffset textlen)
     : offset_( off )
     , length_(len)
     , newText_(text)
     , newTextLength_(textlen)
-    , newLineOffsets_()
+    , newLineCount_(0)
 {
     Q_ASSERT(buffer);
 
@@ -28,22 +48,22 @@ TextBufferChangeData::TextBufferChangeData(TextBuffer* buffer, int off, int len,
     lineCount_    = endLine - line_;
     Q_ASSERT(lineCount_>=0);
 
-    // find the newlines in the text
-    for( int i=0; i< newTextLength_; ++i ) {
-        if( newText_[i] == '\n' ) {
-            newLineOffsets_.append( offset_ + i + 1 );    // +1 because it points to the start of the next line
-        }
-    }
+    findNewLines();
 }
 
+
 /// Initializes the textbuffer change
-/// @param buffer when buffer is 0 NO line calculation is done
-TextBufferChangeData::TextBufferChangeData(LineOffsetVector* lineOffsets, int off, int len, const QChar *text, int textlen)
+/// @param lineOffsets the line offsets, which are used to calculate the line information (before the change is applied)
+/// @param off the offset of the change
+/// @param len the number of characters that are replaced
+/// @param text the new text
+/// @param textlen the length of the new text
+TextBufferChange::TextBufferChange(LineOffsetVector* lineOffsets, TextOffset off, TextOffset len, const QChar *text, TextOffset textlen)
     : offset_( off )
     , length_(len)
     , newText_(text)
     , newTextLength_(textlen)
-    , newLineOffsets_()
+    , newLineCount_(0)
 {
     Q_ASSERT(lineOffsets );
 
@@ -53,32 +73,70 @@ TextBufferChangeData::TextBufferChangeData(LineOffsetVector* lineOffsets, int of
     lineCount_    = endLine - line_;
     Q_ASSERT(lineCount_>=0);
 
-    // find the newlines in the text
-    for( int i=0; i< newTextLength_; ++i ) {
-        if( newText_[i] == '\n' ) {
-            newLineOffsets_.append( offset_ + i + 1 );    // +1 because it points to the start of the next line
-        }
-    }
+    findNewLines();
 }
 
 
-TextBufferChange::TextBufferChange()
+/// Initializes the textbuffer change with the line offsets of the new text, which are already known.
+/// This prevents searching the new text for newlines
+/// @param buffer the buffer, which is used to calculate the line information (before the change is applied)
+/// @param off the offset of the change
+/// @param len the number of characters that are replaced
+/// @param text the new text
+/// @param textlen the length of the new text
+/// @param newLineOffsets the offsets of the characters after the newlines in the new text (offsets in the buffer)
+TextBufferChange::TextBufferChange(TextBuffer* buffer, TextOffset off, TextOffset len, const QChar* text, TextOffset textlen, const QVector<TextOffset>& newLineOffsets)
+    : offset_( off )
+    , length_(len)
+    , newText_(text)
+    , newTextLength_(textlen)
+    , newLineCount_( newLineOffsets.size() )
 {
-    d_ = new TextBufferChangeData( (TextBuffer*)0, 0, 0, 0, 0 );
-}
+    Q_ASSERT(buffer);
 
-TextBufferChange::TextBufferChange(TextBuffer* buffer, int off, int len, const QChar* text, int textlen)
-{
-    d_ = new TextBufferChangeData( buffer, off, len, text, textlen );
+    // decide which lines
+    line_         = buffer->lineFromOffset( offset_ );
+    int endLine   = buffer->lineFromOffset( offset_ + length_ );
+    lineCount_    = endLine - line_;
+    Q_ASSERT(lineCount_>=0);
+
+    if( newLineCount_ > InlineLineOffsetCount ) {
+        newLineOffsetList_ = newLineOffsets;
+    } else {
+        for( int i=0; i < newLineCount_; ++i ) { inlineLineOffsets_[i] = newLineOffsets.at(i); }
+    }
 }
 
-TextBufferChange::TextBufferChange(LineOffsetVector* lineOffsets, int off, int len, const QChar *text, int textlen)
+
+/// Returns a copy of the new line offsets.
+/// This method allocates memory, for fast access use newLineOffsetData and newLineCount
+QVector<TextOffset> TextBufferChange::newLineOffsets() const
 {
-    d_ = new TextBufferChangeData( lineOffsets, off, len, text, textlen );
+    QVector<TextOffset> result;
+    result.reserve( newLineCount_ );
+    const TextOffset* offsets = newLineOffsetData();
+    for( int i=0; i < newLineCount_; ++i ) { result.append( offsets[i] ); }
+    return result;
 }
 
-TextBufferChange::TextBufferChange(const TextBufferChange& other) : d_(other.d_)
+
+/// Finds the newlines in the new text. An offset points to the start of the next line (the character after the newline).
+/// The first InlineLineOffsetCount offsets are stored inline, when there are more all offsets are moved to the list
+void TextBufferChange::findNewLines()
 {
+    if( !newText_ ) { return; }
+    const QChar* end = newText_ + newTextLength_;
+    for( const QChar* c = NewlineScanner::find( newText_, end, '\n' ); c < end; c = NewlineScanner::find( c + 1, end, '\n' ) ) {
+        TextOffset idx = c - newText_;
+        if( newLineCount_ == InlineLineOffsetCount ) {
+            newLineOffsetList_.reserve( InlineLineOffsetCount + NewlineScanner::count( c, end - c ) );
+            for( int i=0; i < InlineLineOffsetCount; ++i ) { newLineOffsetList_.append( inlineLineOffsets_[i] ); }
+            NewlineScanner::appendOffsets( c, end - c, offset_ + idx + 1, newLineOffsetList_ );
+            newLineCount_ = newLineOffsetList_.size();
+            return;
+        }
+        inlineLineOffsets_[newLineCount_++] = offset_ + idx + 1;
+    }
 }
 
 
@@ -89,7 +147,56 @@ TextBufferChange::TextBufferChange(const TextBufferChange& other) : d_(other.d_)
 /// The textbuffer constructor
 TextBuffer::TextBuffer(QObject *parent)
     : QObject(parent)
+    , oldTextRequired_(true)
+    , textChangedReceiverCount_(0)
+    , revision_(0)
+{
+    // this connection is made before all other connections, so the revision is already increased when other receivers are notified
+    connect( this, SIGNAL(textChanged(edbee::TextBufferChange,QString)), SLOT(increaseRevision()), Qt::DirectConnection );
+    textChangedReceiverCount_ = 0;  // the revision slot doesn't use the old text
+}
+
+
+/// Appends the given number of characters in raw append mode, the caller writes the characters directly in the
+/// storage of the buffer. This prevents copying large texts (while loading a file).
+/// The characters must be written before rawAppendEnd is called.
+/// @param length the number of characters to append
+/// @return the pointer to the (uninitialized) characters or 0 when the buffer doesn't support direct appending (the default)
+QChar* TextBuffer::rawAppendDirect(TextOffset length)
 {
+    Q_UNUSED(length);
+    return nullptr;
+}
+
+
+/// Gives back the last characters of the last rawAppendDirect call, when less characters are written than requested.
+/// (for example when the decoded length is only known after decoding)
+/// @param unusedLength the number of unused characters at the end of the last rawAppendDirect call
+void TextBuffer::rawAppendDirectShrink(TextOffset unusedLength)
+{
+    Q_UNUSED(unusedLength);
+    Q_ASSERT(false && "rawAppendDirectShrink without rawAppendDirect");
+}
+
+
+/// Sets the line start offsets of all text that's appended since rawAppendBegin, so rawAppendEnd doesn't need
+/// to search the appended text for newlines. The default implementation ignores the offsets
+/// @param lineOffsets the offsets of the characters after the newlines (offsets in the buffer)
+void TextBuffer::setRawAppendLineOffsets(const QVector<TextOffset>& lineOffsets)
+{
+    Q_UNUSED(lineOffsets);
+}
+
+
+/// Replaces the complete text of this buffer with the text of the given buffer, with a single change.
+/// This is used to swap in a text that's loaded in a detached buffer (on another thread).
+/// The default implementation copies the text. Implementations can take over the storage of the source without copying.
+/// @param source the buffer with the new text. The content of the source buffer is undefined afterwards
+void TextBuffer::takeText(TextBuffer* source)
+{
+    Q_ASSERT(source && source != this);
+    QString text = source->textPart( 0, source->length() );
+    replaceText( 0, length(), text.constData(), text.length() );
 }
 
 
@@ -97,7 +204,7 @@ TextBuffer::TextBuffer(QObject *parent)
 /// @param offset the offset to replace
 /// @param length the of the text to replace
 /// @param text the new text to insert
-void TextBuffer::replaceText(int offset, int length, const QString& text)
+void TextBuffer::replaceText(TextOffset offset, TextOffset length, const QString& text)
 {
     replaceText( offset, length, text.data(), text.length() );
 }
@@ -120,12 +227,12 @@ void TextBuffer::setText(const QString& text)
 /// this method translates the given position to a column number.
 /// @param offset the character offset
 /// @param line the line index this position is on. (Use this argument for optimization if you already know this)
-int TextBuffer::columnFromOffsetAndLine( int offset, int line  )
+TextOffset TextBuffer::columnFromOffsetAndLine( TextOffset offset, int line  )
 {
     if( line < 0 ) line = lineFromOffset( offset );
     // const QList<int>& lofs = lineOffsets();
     if( line < lineCount() ) {
-        int col = offset - offsetFromLine(line);
+        TextOffset col = offset - offsetFromLine(line);
         if( col < 0 ) return 0;
         return qMin( lineLength(line), col );
     } else {
@@ -144,11 +251,11 @@ void TextBuffer::appendText(const QString& text)
 
 /// This method returns the offset from the give line and column
 /// If the column exceed the number of column the caret is placed just before the newline
-int TextBuffer::offsetFromLineAndColumn(int line, int col)
+TextOffset TextBuffer::offsetFromLineAndColumn(int line, TextOffset col)
 {
-    int offsetLine = offsetFromLine(line);
-    int offsetNextLine = offsetFromLine(line+1);
-    int offset = offsetLine + col;
+    TextOffset offsetLine = offsetFromLine(line);
+    TextOffset offsetNextLine = offsetFromLine(line+1);
+    TextOffset offset = offsetLine + col;
     if( offset >= offsetNextLine && offset < length() ) { --offset; }
     return offset;
 }
@@ -158,8 +265,8 @@ int TextBuffer::offsetFromLineAndColumn(int line, int col)
 /// @param line the line to return
 QString TextBuffer::line(int line)
 {
-    int off = offsetFromLine(line);
-    int endOff = offsetFromLine(line+1);
+    TextOffset off = offsetFromLine(line);
+    TextOffset endOff = offsetFromLine(line+1);
     return textPart( off, endOff - off  ); // skip the return
 }
 
@@ -167,7 +274,7 @@ QString TextBuffer::line(int line)
 /// Returns the line without the newline character
 QString TextBuffer::lineWithoutNewline(int line)
 {
-    int off = offsetFromLine(line);
+    TextOffset off = offsetFromLine(line);
     int removeNewlineCount = 1;
     if( line == lineCount()-1 ) { removeNewlineCount = 0; }
     return textPart( off , offsetFromLine(line+1) - off - removeNewlineCount  ); // skip the return
@@ -177,7 +284,7 @@ QString TextBuffer::lineWithoutNewline(int line)
 /// Returns the length of the given line. Also counting the trailing newline character if present
 /// @param line the line to retrieve the length for
 /// @return the length of the given line
-int TextBuffer::lineLength(int line)
+TextOffset TextBuffer::lineLength(int line)
 {
     return offsetFromLine(line+1) - offsetFromLine(line);
 }
@@ -186,11 +293,11 @@ int TextBuffer::lineLength(int line)
 /// Returns the length of the given line. Without counting a trailing newline character
 /// @param line the line to retrieve the length for
 /// @return the length of the given line
-int TextBuffer::lineLengthWithoutNewline(int line)
+TextOffset TextBuffer::lineLengthWithoutNewline(int line)
 {
     int removeNewlineCount = 1;
     if( line == lineCount()-1 ) { removeNewlineCount = 0; }
-    int lastOffset = offsetFromLine(line+1) - removeNewlineCount;
+    TextOffset lastOffset = offsetFromLine(line+1) - removeNewlineCount;
     return  lastOffset - offsetFromLine(line);
 }
 
@@ -204,12 +311,85 @@ void TextBuffer::replaceText( const TextRange& range, const QString& text )
 }
 
 
+/// Prepares the buffer for a number of replacements that grow the text, starting at the given offset.
+/// This is only a hint, a buffer can reserve the room for all replacements at once (instead of growing per replacement).
+/// The default implementation does nothing
+/// @param offset the offset of the first replacement
+/// @param growth the total number of characters the replacements add
+void TextBuffer::reserveGrowth(TextOffset offset, TextOffset growth)
+{
+    Q_UNUSED(offset);
+    Q_UNUSED(growth);
+}
+
+
+/// Replaces multiple ranges in a single forward pass over the buffer.
+/// The ranges are replaced from the first to the last one, every range is reported with its own
+/// textAboutToBeChanged / textChanged signal pair. So the line data, the old text and the lexer only see the
+/// change of that range. The room for the complete replacement is reserved once (see reserveGrowth).
+/// The offsets of the given ranges are the offsets before the replacement.
+/// @param ranges the ranges to replace, sorted and not overlapping (like the ranges of a TextRangeSet)
+/// @param texts the new texts. Range i is replaced by text i % texts.size(), so a single text can be used for all ranges
+void TextBuffer::replaceRanges(const QVector<TextRange>& ranges, const QStringList& texts)
+{
+    if( ranges.isEmpty() ) { return; }
+    Q_ASSERT( !texts.isEmpty() );
+
+    TextOffset growth = 0;
+    for( int i=0, cnt=ranges.size(); i < cnt; ++i ) {
+        growth += texts.at( i % texts.size() ).length() - ranges.at(i).length();
+    }
+    reserveGrowth( ranges.first().min(), growth );
+
+    TextOffset delta = 0;
+    for( int i=0, cnt=ranges.size(); i < cnt; ++i ) {
+        const TextRange& range = ranges.at(i);
+        const QString& text = texts.at( i % texts.size() );
+        Q_ASSERT( i == 0 || ranges.at(i-1).max() <= range.min() );
+        replaceText( range.min() + delta, range.length(), text.constData(), text.length() );
+        delta += text.length() - range.length();
+    }
+}
+
+
+/// Returns a read-only pointer to contiguous character data that contains the given range.
+/// When the range is located in a single chunk, the chunk data is returned directly (no copying at all).
+/// When the range spans multiple chunks the range is copied to the given storage string.
+/// The returned pointer is only valid until the buffer or the storage string is changed,
+/// or until the next call to chunkAt or rangeData on this buffer (see chunkAt)
+///
+/// The character at document offset 'x' can be found at: result[x - dataOffset]
+///
+/// @param offset the start offset of the range
+/// @param length the length of the range
+/// @param storage the string that is used when the data needs to be copied
+/// @param dataOffset (out) the document offset of the first character of the returned data
+/// @return the pointer to the data
+const QChar* TextBuffer::rangeData(TextOffset offset, TextOffset length, QString& storage, TextOffset& dataOffset) const
+{
+    Q_ASSERT( offset >= 0 );
+    Q_ASSERT( length >= 0 );
+    Q_ASSERT( offset + length <= this->length() );
+
+    TextOffset chunkStart = 0, chunkLength = 0;
+    const QChar* chunk = chunkAt( offset, chunkStart, chunkLength );
+    if( chunk && offset + length <= chunkStart + chunkLength ) {
+        dataOffset = chunkStart;
+        return chunk;
+    }
+
+    storage = textPart( offset, length );
+    dataOffset = offset;
+    return storage.constData();
+}
+
+
 /// See documentation at findCharPosWithinRange
 /// @param offset the offset to start searching
 /// @parm direction the direction (left < 0, or right > 0 )
 /// @param chars the chars to search
 /// @param equals when setting to true if will search for the first given char. When false it will stop when another char is found
-int TextBuffer::findCharPos(int offset, int direction, const QString& chars, bool equals)
+TextOffset TextBuffer::findCharPos(TextOffset offset, int direction, const QString& chars, bool equals)
 {
     return findCharPosWithinRange(offset, direction, chars, equals, 0, length() );
 
@@ -225,7 +405,7 @@ int TextBuffer::findCharPos(int offset, int direction, const QString& chars, boo
 /// @param beginRange the start of the range to search in
 /// @param endRange the end of the range to search in (exclusive)
 /// @return the offset of the first character
-int TextBuffer::findCharPosWithinRange(int offset, int direction, const QString& chars, bool equals, int beginRange, int endRange)
+TextOffset TextBuffer::findCharPosWithinRange(TextOffset offset, int direction, const QString& chars, bool equals, TextOffset beginRange, TextOffset endRange)
 {
     int charStep      = direction < 0 ? -1 : 1;
     int charNumber    = qAbs(direction);
@@ -242,7 +422,7 @@ int TextBuffer::findCharPosWithinRange(int offset, int direction, const QString&
 
 /// See documentation at findCharPosWithinRange.
 /// This method searches a char position within the given rang (from the given ofset)
-int TextBuffer::findCharPosOrClamp(int offset, int direction, const QString& chars, bool equals)
+TextOffset TextBuffer::findCharPosOrClamp(TextOffset offset, int direction, const QString& chars, bool equals)
 {
     return findCharPosWithinRangeOrClamp( offset, direction, chars, equals, 0, length() );
 }
@@ -250,9 +430,9 @@ int TextBuffer::findCharPosOrClamp(int offset, int direction, const QString& cha
 
 /// See documentation at findCharPosWithinRange.
 /// This method searches a char position within the given rang (from the given ofset)
-int TextBuffer::findCharPosWithinRangeOrClamp(int offset, int direction, const QString& chars, bool equals, int beginRange, int endRange)
+TextOffset TextBuffer::findCharPosWithinRangeOrClamp(TextOffset offset, int direction, const QString& chars, bool equals, TextOffset beginRange, TextOffset endRange)
 {
-    int pos = findCharPosWithinRange(offset, direction, chars, equals, beginRange, endRange);
+    TextOffset pos = findCharPosWithinRange(offset, direction, chars, equals, beginRange, endRange);
     if( pos < 0 ) {
         if( direction < 0 ) return beginRange;
         if( direction > 0 ) return endRange;
@@ -267,7 +447,7 @@ QString TextBuffer::lineOffsetsAsString()
 {
     QString str;
     for( int idx=0,cnt=lineCount(); idx<cnt; ++idx  ) {
-        int offset = offsetFromLine(idx);
+        TextOffset offset = offsetFromLine(idx);
         if( !str.isEmpty() ) str.append(',');
         str.append( QStringLiteral("%1").arg(offset) );
     }
@@ -275,4 +455,123 @@ QString TextBuffer::lineOffsetsAsString()
 }
 
 
+/// Sets if the replaced text should be passed to the textChanged signal (enabled by default).
+/// The replaced text is only copied when the textChanged signal has receivers, so a buffer without listeners
+/// (like the typing path of a detached buffer) never copies it.
+/// Internal operations whose listeners don't need the replaced text can disable it temporarily (see TextDocument::rawRemoveText)
+/// @param required should the old text be passed to the textChanged signal
+void TextBuffer::setOldTextRequired(bool required)
+{
+    oldTextRequired_ = required;
+}
+
+
+/// Returns true if the replaced text is passed to the textChanged signal (when it has receivers)
+bool TextBuffer::isOldTextRequired() const
+{
+    return oldTextRequired_;
+}
+
+
+/// Returns the text that's going to be replaced by a change, for the textChanged signal.
+/// A null string is returned when nothing is replaced, when the old text isn't required or when nobody receives
+/// the textChanged signal, without allocating memory
+/// @param offset the offset of the change
+/// @param length the number of characters that are replaced
+QString TextBuffer::oldTextForChange(TextOffset offset, TextOffset length) const
+{
+    if( length == 0 || !oldTextRequired_ || textChangedReceiverCount_ <= 0 ) { return QString(); }
+    return textPart( offset, length );
+}
+
+
+/// Counts the receivers of the textChanged signal
+void TextBuffer::connectNotify(const QMetaMethod& signal)
+{
+    if( signal == QMetaMethod::fromSignal( &TextBuffer::textChanged ) ) { ++textChangedReceiverCount_; }
+}
+
+
+/// Counts the receivers of the textChanged signal (also called when a receiver is destroyed)
+void TextBuffer::disconnectNotify(const QMetaMethod& signal)
+{
+    if( signal == QMetaMethod::fromSignal( &TextBuffer::textChanged ) ) { --textChangedReceiverCount_; }
+}
+
+
+/// Returns the revision of the buffer. The revision is increased on every change of the text.
+/// It can be used to check if a result that's calculated in the background (for a TextSnapshot) is outdated
+quint64 TextBuffer::revision() const
+{
+    return revision_;
+}
+
+
+/// Increases the revision, this slot is connected to the textChanged signal
+void TextBuffer::increaseRevision()
+{
+    ++revision_;
+}
+
+
+//--------------------------------------------------------------
+
+
+/// Constructs the chunk iterator
+/// @param buffer the buffer to iterate
+/// @param offset the start offset of the range to iterate
+/// @param length the length of the range to iterate
+TextBufferChunkIterator::TextBufferChunkIterator(const TextBuffer* buffer, TextOffset offset, TextOffset length)
+    : bufferRef_(buffer)
+    , curOffset_(offset)
+    , endOffset_(offset + length)
+    , chunkOffset_(offset)
+    , chunkLength_(0)
+{
+    Q_ASSERT(bufferRef_);
+    Q_ASSERT(offset >= 0);
+    Q_ASSERT(endOffset_ <= bufferRef_->length());
+}
+
+
+/// Returns true if there's another chunk available
+bool TextBufferChunkIterator::hasNext() const
+{
+    return curOffset_ < endOffset_;
+}
+
+
+/// Moves to the next chunk and returns the pointer to the first character of this chunk.
+/// The chunk is clipped to the iterated range. Use offset() and length() to retrieve the location of the chunk
+const QChar* TextBufferChunkIterator::next()
+{
+    TextOffset chunkStart = 0, chunkLength = 0;
+    const QChar* chunk = bufferRef_->chunkAt( curOffset_, chunkStart, chunkLength );
+
+    chunkOffset_ = curOffset_;
+    chunkLength_ = qMin( chunkStart + chunkLength, endOffset_ ) - curOffset_;
+    if( !chunk || chunkLength_ <= 0 ) {    // should never happen, but prevents an endless loop
+        chunkLength_ = 0;
+        curOffset_ = endOffset_;
+        return nullptr;
+    }
+    curOffset_ += chunkLength_;
+    return chunk + ( chunkOffset_ - chunkStart );
+}
+
+
+/// Returns the document offset of the chunk returned by next
+TextOffset TextBufferChunkIterator::offset() const
+{
+    return chunkOffset_;
+}
+
+
+/// Returns the length of the chunk returned by next
+TextOffset TextBufferChunkIterator::length() const
+{
+    return chunkLength_;
+}
+
+
 } // edbee
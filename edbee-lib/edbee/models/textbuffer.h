@@ -6,61 +6,62 @@
 #include "edbee/exports.h"
 
 #include <QObject>
+#include <QStringList>
 #include <QVector>
-#include <QSharedData>
-#include <QExplicitlySharedDataPointer>
+
+#include "edbee/textoffset.h"
 
 namespace edbee {
 
 class TextBuffer;
 class TextBufferChange;
+class TextBufferChunkIterator;
 class TextRange;
 class TextLineData;
 class LineOffsetVector;
 
 
-class EDBEE_EXPORT TextBufferChangeData : public QSharedData
-{
-public:
-    TextBufferChangeData( TextBuffer* buffer, int off, int len, const QChar* text, int textlen );
-    TextBufferChangeData( LineOffsetVector* lineOffsets, int off, int len, const QChar* text, int textlen );
-
-    // text information
-    int offset_;             ///< The offset in the buffer
-    int length_;             ///< The number of chars to replaced
-    const QChar* newText_;   ///< The reference to a new text
-    int newTextLength_;      ///< The length of this text
-
-    // line informationm
-    int line_;                    ///< The line number were the change occured
-    int lineCount_;               ///< the number of lines that are involved.
-    QVector<int> newLineOffsets_; ///< A list of new line offset
-
-};
-
-
 /// This clas represents a text buffer change and is used to pass around between events
-/// This is a shareddata object so the data can be thrown between different threads (delayed emit-support)_
+/// This is a small value object, which can be copied to other threads (delayed emit-support).
+/// The offsets of the first InlineLineOffsetCount newlines are stored in the object itself, so a change of a
+/// typical edit (a typed character, a single line) doesn't allocate any memory.
 /// TODO: Still problematic maybe the QChar* text pointer. It is possible that this pointer is being freed.
 class EDBEE_EXPORT TextBufferChange {
 public:
     TextBufferChange();
-    TextBufferChange( TextBuffer* buffer, int off, int len, const QChar* text, int textlen );
-    TextBufferChange( LineOffsetVector* lineOffsets, int off, int len, const QChar* text, int textlen );
-    TextBufferChange( const TextBufferChange& other );
+    TextBufferChange( TextBuffer* buffer, TextOffset off, TextOffset len, const QChar* text, TextOffset textlen );
+    TextBufferChange( LineOffsetVector* lineOffsets, TextOffset off, TextOffset len, const QChar* text, TextOffset textlen );
+    TextBufferChange( TextBuffer* buffer, TextOffset off, TextOffset len, const QChar* text, TextOffset textlen, const QVector<TextOffset>& newLineOffsets );
+
+    TextOffset offset() const { return offset_; }
+    TextOffset length() const { return length_; }
+    const QChar* newText() const  { return newText_; }
+    TextOffset newTextLength() const { return newTextLength_; }
+    int line() const { return line_; }
+    int lineCount() const { return lineCount_; }
+    inline int newLineCount() const { return newLineCount_; }
+    inline const TextOffset* newLineOffsetData() const { return newLineCount_ > InlineLineOffsetCount ? newLineOffsetList_.constData() : inlineLineOffsets_; }
+    inline TextOffset newLineOffset( int idx ) const { return newLineOffsetData()[idx]; }
+    QVector<TextOffset> newLineOffsets() const;
+
+    /// The number of newline offsets that are stored without allocating memory
+    static const int InlineLineOffsetCount = 4;
 
-    int offset() const { return d_->offset_; }
-    int length() const { return d_->length_; }
-    const QChar* newText() const  { return d_->newText_; }
-    int newTextLength() const { return d_->newTextLength_; }
-    int line() const { return d_->line_; }
-    int lineCount() const { return d_->lineCount_; }
-    inline int newLineCount() const { return d_->newLineOffsets_.size(); }
-    const QVector<int>& newLineOffsets() const { return d_->newLineOffsets_; }
+private:
+    void findNewLines();
 
+    // text information
+    TextOffset offset_;          ///< The offset in the buffer
+    TextOffset length_;          ///< The number of chars to replaced
+    const QChar* newText_;       ///< The reference to a new text
+    TextOffset newTextLength_;   ///< The length of this text
 
-private:
-    QExplicitlySharedDataPointer<TextBufferChangeData> d_;
+    // line informationm
+    int line_;                                              ///< The line number were the change occured
+    int lineCount_;                                         ///< the number of lines that are involved.
+    int newLineCount_;                                      ///< The number of new lines
+    TextOffset inlineLineOffsets_[InlineLineOffsetCount];   ///< The new line offsets (when there are at most InlineLineOffsetCount)
+    QVector<TextOffset> newLineOffsetList_;                 ///< The new line offsets (when there are more than InlineLineOffsetCount)
 };
 
 /// This class represents the textbuffer of the editor
@@ -74,23 +75,23 @@ public:
 // Minimal abstract interface to implement
 
     /// should return the number of 'characters'.
-    virtual int length() const = 0;
+    virtual TextOffset length() const = 0;
 
     /// A method for returning a single char
-    virtual QChar charAt( int offset ) const = 0;
+    virtual QChar charAt( TextOffset offset ) const = 0;
 
     /// return the given text.
-    virtual QString textPart( int offset, int length ) const = 0;
+    virtual QString textPart( TextOffset offset, TextOffset length ) const = 0;
 
     /// this method should replace the given text
     /// And fire a 'text-replaced' signal
-    virtual void replaceText( int offset, int length, const QChar* buffer, int bufferLength ) = 0;
+    virtual void replaceText( TextOffset offset, TextOffset length, const QChar* buffer, TextOffset bufferLength ) = 0;
 
     /// this method should return an array with all line offsets. A line offset pointsto the START of a line
     /// So it does NOT point to a newline character, but it points to the first character AFTER the newline character
     virtual int lineCount() = 0; // { return lineOffsets().length(); }
-    virtual int lineFromOffset(int offset ) = 0;
-    virtual int offsetFromLine( int line ) = 0;
+    virtual int lineFromOffset( TextOffset offset ) = 0;
+    virtual TextOffset offsetFromLine( int line ) = 0;
 
 // raw loading methods
 
@@ -101,7 +102,13 @@ public:
     virtual void rawAppend( QChar c ) = 0;
 
     /// This method should raw append the given character string
-    virtual void rawAppend( const QChar* data, int dataLength ) = 0;
+    virtual void rawAppend( const QChar* data, TextOffset dataLength ) = 0;
+
+    virtual QChar* rawAppendDirect( TextOffset length );
+    virtual void rawAppendDirectShrink( TextOffset unusedLength );
+    virtual void setRawAppendLineOffsets( const QVector<TextOffset>& lineOffsets );
+
+    virtual void takeText( TextBuffer* source );
 
     /// the end raw append method should bring the document in a consistent state and
     /// emit the correct "replaceText" signals
@@ -112,39 +119,99 @@ public:
 
     /// This method returns the raw data buffer.
     /// WARNING this method CAN be slow because when using a gapvector the gap is moved to the end to make a full buffer
+    /// (a RopeTextBuffer even copies the entire text to a flat buffer on every call)
     /// Modifying the content of the data will mess up the line-offset-vector and other dependent classes. For reading it's ok :-)
+    /// For read-only access prefer chunkAt, rangeData or the TextBufferChunkIterator
     virtual QChar* rawDataPointer() = 0;
 
+    /// This method should return a pointer to the contiguous chunk of characters that contains the given offset.
+    /// This method may NEVER change the layout of the buffer, which makes it safe and fast for read-only access.
+    /// The pointer is only valid until the next change of the buffer or the next call to chunkAt or rangeData on this buffer.
+    /// (Buffers that decode their text on demand keep the decoded chunks in a small cache, which is reused by the next call)
+    /// Because of this cache, a single buffer may not be read from multiple threads. Use a TextSnapshot for that.
+    /// @param offset the offset to retrieve the chunk for (0 <= offset <= length()). When offset == length() the last chunk is returned
+    /// @param chunkStart (out) the offset of the first character of the chunk
+    /// @param chunkLength (out) the number of characters in the chunk
+    /// @return the pointer to the first character of the chunk (0 when the buffer is empty)
+    virtual const QChar* chunkAt( TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength ) const = 0;
+
 
 // easy functions
 
     /// Replace the given text.
-    virtual void replaceText( int offset, int length, const QString& text );
+    virtual void replaceText( TextOffset offset, TextOffset length, const QString& text );
 
     QString text();
     void setText( const QString& text );
-    virtual int columnFromOffsetAndLine( int offset, int line=-1 );
+    virtual TextOffset columnFromOffsetAndLine( TextOffset offset, int line=-1 );
     virtual void appendText( const QString& text );
-    virtual int offsetFromLineAndColumn( int line, int col );
+    virtual TextOffset offsetFromLineAndColumn( int line, TextOffset col );
     virtual QString line( int line);
     virtual QString lineWithoutNewline( int line );
 
-    virtual int lineLength(int line);
-    virtual int lineLengthWithoutNewline(int line);
+    virtual TextOffset lineLength(int line);
+    virtual TextOffset lineLengthWithoutNewline(int line);
     virtual void replaceText( const TextRange& range, const QString& text  );
+    virtual void reserveGrowth( TextOffset offset, TextOffset growth );
+    virtual void replaceRanges( const QVector<TextRange>& ranges, const QStringList& texts );
 
-    virtual int findCharPos( int offset, int direction, const QString& chars, bool equals );
-    virtual int findCharPosWithinRange( int offset, int direction, const QString& chars, bool equals, int beginRange, int endRange );
-    virtual int findCharPosOrClamp( int offset, int direction, const QString& chars, bool equals );
-    virtual int findCharPosWithinRangeOrClamp( int offset, int direction, const QString& chars, bool equals, int beginRange, int endRange );
+    const QChar* rangeData( TextOffset offset, TextOffset length, QString& storage, TextOffset& dataOffset ) const;
+
+    virtual TextOffset findCharPos( TextOffset offset, int direction, const QString& chars, bool equals );
+    virtual TextOffset findCharPosWithinRange( TextOffset offset, int direction, const QString& chars, bool equals, TextOffset beginRange, TextOffset endRange );
+    virtual TextOffset findCharPosOrClamp( TextOffset offset, int direction, const QString& chars, bool equals );
+    virtual TextOffset findCharPosWithinRangeOrClamp( TextOffset offset, int direction, const QString& chars, bool equals, TextOffset beginRange, TextOffset endRange );
 
     virtual QString lineOffsetsAsString();
 
+    void setOldTextRequired( bool required );
+    bool isOldTextRequired() const;
+
+    quint64 revision() const;
+
+protected:
+    QString oldTextForChange( TextOffset offset, TextOffset length ) const;
+    virtual void connectNotify( const QMetaMethod& signal );
+    virtual void disconnectNotify( const QMetaMethod& signal );
+
  signals:
 
     void textAboutToBeChanged( edbee::TextBufferChange change );
     void textChanged( edbee::TextBufferChange change, QString oldText = QString() );
 
+private slots:
+
+    void increaseRevision();
+
+private:
+    bool oldTextRequired_;      ///< Should the replaced text be passed to the textChanged signal? (true by default)
+    int textChangedReceiverCount_;  ///< The number of receivers of the textChanged signal (the revision slot excluded)
+    quint64 revision_;          ///< The revision, which is increased on every change
+
+};
+
+
+/// A read-only iterator that walks over the contiguous chunks of a textbuffer.
+/// The iterator never changes the layout of the buffer (it never moves the gap of a gapvector)
+/// The buffer may NOT be changed while iterating.
+/// The chunk returned by next() is only valid until the next call to next() (see TextBuffer::chunkAt)
+class EDBEE_EXPORT TextBufferChunkIterator
+{
+public:
+    TextBufferChunkIterator( const TextBuffer* buffer, TextOffset offset, TextOffset length );
+
+    bool hasNext() const;
+    const QChar* next();
+
+    TextOffset offset() const;
+    TextOffset length() const;
+
+private:
+    const TextBuffer* bufferRef_;            ///< The buffer to iterate
+    TextOffset curOffset_;                   ///< The offset of the next chunk
+    TextOffset endOffset_;                   ///< The end offset of the iterated range
+    TextOffset chunkOffset_;                 ///< The offset of the chunk returned by next
+    TextOffset chunkLength_;                 ///< The length of the chunk returned by next
 };
 
 } // edbee
@@ -27,6 +27,7 @@ TextDocument::TextDocument( QObject* obj )
     , documentFilter_(nullptr)
     , documentFilterRef_(nullptr)
     , textLineDataManager_(nullptr)
+    , snapshotBuilder_(nullptr)
 {
     textLineDataManager_ = new TextLineDataManager();
 }
@@ -35,6 +36,7 @@ TextDocument::TextDocument( QObject* obj )
 /// Destroys the textdocument
 TextDocument::~TextDocument()
 {
+    delete snapshotBuilder_;
     delete textLineDataManager_;
     delete documentFilter_;
 }
@@ -52,6 +54,23 @@ void TextDocument::setLineDataFieldsPerLine( int count )
     textUndoStack()->clear();
 }
 
+/// Returns the line endings of the file that's loaded in this document (see TextDocumentSerializer).
+/// The statistics aren't updated when the document is changed
+const LineEndingStatistics& TextDocument::lineEndingStatistics() const
+{
+    return lineEndingStatistics_;
+}
+
+
+/// Sets the line ending statistics of the loaded file. Only the counts are stored (not the recorded lines)
+/// @param statistics the statistics of the loaded file
+void TextDocument::setLineEndingStatistics(const LineEndingStatistics& statistics)
+{
+    lineEndingStatistics_ = statistics;
+    lineEndingStatistics_.clearWindowsLines();
+}
+
+
 void TextDocument::giveLineDataManager(TextLineDataManager *manager)
 {
     delete textLineDataManager_;
@@ -166,6 +185,15 @@ void TextDocument::setPersisted(bool enabled)
 }
 
 
+/// Returns true if the document can't be changed (for example a memory mapped document).
+/// The text changes of a read-only document (replace, append, setText and replaceRangeSet) are ignored.
+/// The default implementation returns false
+bool TextDocument::isReadonly() const
+{
+    return false;
+}
+
+
 /// Sets the document filter without tranfering the ownership
 void TextDocument::setDocumentFilter(TextDocumentFilter* filter)
 {
@@ -192,6 +220,26 @@ TextDocumentFilter* TextDocument::documentFilter()
 }
 
 
+/// Returns an immutable snapshot of the text and the lines of this document.
+/// The snapshot can be read from other threads, while this document is being changed.
+/// Only the parts of the text that are changed since the previous snapshot are copied.
+/// This method should be called from the GUI thread
+TextSnapshot TextDocument::snapshot()
+{
+    if( !snapshotBuilder_ ) {
+        snapshotBuilder_ = new TextSnapshotBuilder( buffer() );
+    }
+    return snapshotBuilder_->snapshot();
+}
+
+
+/// Returns the current revision of the document. A snapshot is outdated when its revision differs from this revision
+quint64 TextDocument::revision() const
+{
+    return buffer()->revision();
+}
+
+
 /// Start the changes
 void TextDocument::beginChanges(TextEditorController* controller)
 {
@@ -209,14 +257,27 @@ void TextDocument::replaceRangeSet(TextRangeSet& rangeSet, const QString& textIn
 /// replaces the given rangeset
 void TextDocument::replaceRangeSet(TextRangeSet& rangeSet, const QStringList& textsIn, bool stickySelection)
 {
+    if( isReadonly() ) {
+        qlog_warn() << "The document is read-only, replaceRangeSet is ignored";
+        return;
+    }
 
     QStringList texts = textsIn;
     if( documentFilter() ) {
         documentFilter()->filterReplaceRangeSet( this, rangeSet, texts );
     }
 
+    // the buffer reserves the room for all ranges at once
+    if( rangeSet.rangeCount() > 1 ) {
+        TextOffset growth = 0;
+        for( int i=0, cnt=rangeSet.rangeCount(); i < cnt; ++i ) {
+            growth += texts.at( i % texts.size() ).length() - rangeSet.constRange(i).length();
+        }
+        buffer()->reserveGrowth( rangeSet.constRange(0).min(), growth );
+    }
+
     rangeSet.beginChanges();
-    int delta = 0;
+    TextOffset delta = 0;
     int idx = 0, oldRangeCount = 0;
     while( idx < (oldRangeCount = rangeSet.rangeCount())  ) {
         TextRange& range = rangeSet.range(idx);
@@ -235,7 +296,7 @@ void TextDocument::replaceRangeSet(TextRangeSet& rangeSet, const QStringList& te
 
         // when a new caret position is supplied (can only happen via a TextDocumentFilter)
         // access it and change the caret to the given position
-        int caret = 0;
+        TextOffset caret = 0;
         if( effectiveChangeWithCaret && effectiveChangeWithCaret->caret() >= 0 ) {
           caret = effectiveChangeWithCaret->caret();
         // Default caret location is change-independent: old location + length new text
@@ -322,10 +383,15 @@ void TextDocument::append(const QString& text, int coalesceId )
 
 
 /// Appends the given text
+/// A read-only document (see isReadonly) ignores the change, no change is executed or added to the undo stack
 /// @param text the text to append
 /// @param coalesceId (default 0) the coalesceId to use. Whe using the same number changes could be merged to one change. CoalesceId of 0 means no merging
-void TextDocument::replace( int offset, int length, const QString& text, int coalesceId )
+void TextDocument::replace( TextOffset offset, TextOffset length, const QString& text, int coalesceId )
 {
+    if( isReadonly() ) {
+        qlog_warn() << "The document is read-only, replace is ignored";
+        return;
+    }
     executeAndGiveChange( new TextChange( offset, length, text ), coalesceId);
 }
 
@@ -364,15 +430,46 @@ void TextDocument::rawAppend(QChar c)
 
 
 /// Appends an array of characters
-void TextDocument::rawAppend(const QChar* chars, int length)
+void TextDocument::rawAppend(const QChar* chars, TextOffset length)
 {
     buffer()->rawAppend(chars,length);
 }
 
 
+/// Replaces the complete text with the text of the given (detached) buffer, see TextBuffer::takeText.
+/// Just like raw appending no undo data is collected. The undo stack is cleared, because the history doesn't apply to the new text
+/// @param source the buffer with the new text, the content of this buffer is undefined afterwards
+void TextDocument::rawReplaceText(TextBuffer* source)
+{
+    setUndoCollectionEnabled(false); // no undo's
+    buffer()->takeText(source);
+    setUndoCollectionEnabled(true);
+    textUndoStack()->clear();
+}
+
+
+/// Removes the given text without collecting undo data and without copying the removed text for the
+/// textChanged signal (the oldText is empty). This is used to remove the first lines of a followed file.
+/// The undo stack is cleared, because the offsets of the history don't apply to the remaining text
+/// @param offset the offset of the text to remove
+/// @param length the number of characters to remove
+void TextDocument::rawRemoveText(TextOffset offset, TextOffset length)
+{
+    if( length <= 0 ) { return; }
+    TextBuffer* textBuffer = buffer();
+    bool oldTextRequired = textBuffer->isOldTextRequired();
+    setUndoCollectionEnabled(false); // no undo's
+    textBuffer->setOldTextRequired(false);
+    textBuffer->replaceText( offset, length, nullptr, 0 );
+    textBuffer->setOldTextRequired(oldTextRequired);
+    setUndoCollectionEnabled(true);
+    textUndoStack()->clear();
+}
+
+
 /// Returns the length of the document in characters
 /// default implementation is to forward this call to the textbuffer
-int TextDocument::length()
+TextOffset TextDocument::length()
 {
     return buffer()->length();
 }
@@ -386,7 +483,7 @@ int TextDocument::lineCount()
 
 
 /// Returns the character at the given position
-QChar TextDocument::charAt(int idx)
+QChar TextDocument::charAt(TextOffset idx)
 {
     return buffer()->charAt(idx);
 }
@@ -397,7 +494,7 @@ QChar TextDocument::charAt(int idx)
 ///
 /// @param idx the index to retrieve
 /// @return the character at the given index or the null-character
-QChar TextDocument::charAtOrNull(int idx)
+QChar TextDocument::charAtOrNull(TextOffset idx)
 {
     if( 0 <= idx && idx < length() ) {
         return charAt(idx);
@@ -409,7 +506,7 @@ QChar TextDocument::charAtOrNull(int idx)
 /// Retrieves the character-offset of the given line
 /// @param line the line number (0-based) to retrieve the offset for
 /// @return the character offset
-int TextDocument::offsetFromLine(int line)
+TextOffset TextDocument::offsetFromLine(int line)
 {
     return buffer()->offsetFromLine(line);
 }
@@ -418,7 +515,7 @@ int TextDocument::offsetFromLine(int line)
 /// returns the line number which contains the given offset
 /// @param offset the character offset
 /// @return the line number (0 is the first line )
-int TextDocument::lineFromOffset(int offset)
+int TextDocument::lineFromOffset(TextOffset offset)
 {
     return buffer()->lineFromOffset(offset);
 }
@@ -428,7 +525,7 @@ int TextDocument::lineFromOffset(int offset)
 /// @param offset the offset position
 /// @param line the line number which contains this offset. (When -1 the line number is calculated)
 /// @return the column position of the given offset
-int TextDocument::columnFromOffsetAndLine(int offset, int line)
+TextOffset TextDocument::columnFromOffsetAndLine(TextOffset offset, int line)
 {
     return buffer()->columnFromOffsetAndLine(offset,line);
 }
@@ -438,7 +535,7 @@ int TextDocument::columnFromOffsetAndLine(int offset, int line)
 /// @param line the line number
 /// @param column the column position
 /// @return the character offset in the document
-int TextDocument::offsetFromLineAndColumn(int line, int column)
+TextOffset TextDocument::offsetFromLineAndColumn(int line, TextOffset column)
 {
     return buffer()->offsetFromLineAndColumn(line,column);
 }
@@ -447,7 +544,7 @@ int TextDocument::offsetFromLineAndColumn(int line, int column)
 /// Returns the length of the given line
 /// @param line the line number
 /// @return the line length
-int TextDocument::lineLength(int line)
+TextOffset TextDocument::lineLength(int line)
 {
     return buffer()->lineLength(line);
 }
@@ -456,7 +553,7 @@ int TextDocument::lineLength(int line)
 /// returns the length of the given lilne without the newline
 /// @param line the line number
 /// @return the length of the line excluding the newline character
-int TextDocument::lineLengthWithoutNewline(int line)
+TextOffset TextDocument::lineLengthWithoutNewline(int line)
 {
     return buffer()->lineLengthWithoutNewline(line);
 }
@@ -474,7 +571,7 @@ QString TextDocument::text()
 /// @param offset the character offset in the document
 /// @param length the length of the part in characters
 /// @return the text at the given positions
-QString TextDocument::textPart(int offset, int length)
+QString TextDocument::textPart(TextOffset offset, TextOffset length)
 {
     return buffer()->textPart( offset, length );
 }
@@ -9,6 +9,8 @@
 #include <QList>
 
 #include "edbee/models/textbuffer.h"
+#include "edbee/models/textsnapshot.h"
+#include "edbee/util/lineending.h"
 
 namespace edbee {
 
@@ -33,7 +35,7 @@ class TextUndoStack;
 /// A TextDocument is the model part of the editor.
 ///
 /// It's the main owner of the following objects:
-/// - A textbuffer, which holds the character data. Currently there's only a CharTextBuffer, a gap-vectored buffer.
+/// - A textbuffer, which holds the character data. A CharTextBuffer (a gap-vectored buffer) or a RopeTextBuffer (a balanced tree of chunks)
 /// - An undostack, a stack which holds the undo-operations of the editor
 /// - the textdocument scopes, these are the language-dependent scopes found in the current document
 /// - A textlexer, which is used for (re-)building the textdocument scopes.
@@ -76,6 +78,9 @@ public:
     virtual const LineEnding* lineEnding() = 0 ;
     virtual void setLineEnding( const LineEnding* lineENding ) = 0;
 
+    const LineEndingStatistics& lineEndingStatistics() const;
+    void setLineEndingStatistics( const LineEndingStatistics& statistics );
+
     ///  Should return the current document lexer
     virtual TextLexer* textLexer() = 0;
 
@@ -102,6 +107,7 @@ public:
     virtual bool isUndoOrRedoRunning();
     virtual bool isPersisted();
     virtual void setPersisted(bool enabled=true);
+    virtual bool isReadonly() const;
 
     /// this method should return the config
     virtual TextEditorConfig* config() const = 0;
@@ -110,6 +116,9 @@ public:
     virtual void giveDocumentFilter( TextDocumentFilter* filter );
     virtual TextDocumentFilter* documentFilter();
 
+    TextSnapshot snapshot();
+    quint64 revision() const;
+
     void beginChanges( TextEditorController* controller );
     void replaceRangeSet(TextRangeSet& rangeSet, const QString& text, bool stickySelection = false);
     void replaceRangeSet(TextRangeSet& rangeSet, const QStringList& texts, bool stickySelection = false);
@@ -124,31 +133,33 @@ public:
 //    void giveChange( TextChange* change, bool merge  );
     virtual Change* giveChangeWithoutFilter( Change* change, int coalesceId) = 0;
     void append(const QString& text, int coalesceId=0 );
-    void replace( int offset, int length, const QString& text, int coalesceId=0);
+    void replace( TextOffset offset, TextOffset length, const QString& text, int coalesceId=0);
     void setText( const QString& text );
 
     // raw access for filling the document
     void rawAppendBegin();
     void rawAppendEnd();
     void rawAppend( QChar c );
-    void rawAppend(const QChar *chars, int length );
+    void rawAppend(const QChar *chars, TextOffset length );
+    void rawReplaceText( TextBuffer* source );
+    void rawRemoveText( TextOffset offset, TextOffset length );
 
 public:
 
  // Methods directly forwarded to the  textbuffer
 
-    int length();
+    TextOffset length();
     int lineCount();
-    QChar charAt(int idx);
-    QChar charAtOrNull(int idx);
-    int offsetFromLine( int line );
-    int lineFromOffset( int offset );
-    int columnFromOffsetAndLine( int offset, int line=-1 );
-    int offsetFromLineAndColumn( int line, int column );
-    int lineLength( int line );
-    int lineLengthWithoutNewline( int line );
+    QChar charAt( TextOffset idx );
+    QChar charAtOrNull( TextOffset idx );
+    TextOffset offsetFromLine( int line );
+    int lineFromOffset( TextOffset offset );
+    TextOffset columnFromOffsetAndLine( TextOffset offset, int line=-1 );
+    TextOffset offsetFromLineAndColumn( int line, TextOffset column );
+    TextOffset lineLength( int line );
+    TextOffset lineLengthWithoutNewline( int line );
     QString text();
-    QString textPart( int offset, int length );
+    QString textPart( TextOffset offset, TextOffset length );
     QString lineWithoutNewline( int line );
     QString line( int line );
 
@@ -164,14 +175,18 @@ signals:
     void languageGrammarChanged();
 
     /// this signal is emitted if the scoped range has been changed
-    void lastScopedOffsetChanged( int previousOffset, int lastScopedOffset );
+    void lastScopedOffsetChanged( edbee::TextOffset previousOffset, edbee::TextOffset lastScopedOffset );
 
 
+private:
+
 private:
     TextDocumentFilter* documentFilter_;             ///< The document filter if the filter is owned
     TextDocumentFilter* documentFilterRef_;          ///< The reference to the document filter.
 
     TextLineDataManager* textLineDataManager_;               ///< A class for managing text line data items
+    TextSnapshotBuilder* snapshotBuilder_;                   ///< The builder of the snapshots (created on the first snapshot call)
+    LineEndingStatistics lineEndingStatistics_;              ///< The line endings of the loaded file
 
 };
 
@@ -18,7 +18,7 @@ namespace edbee {
 /// @param anchor the start of the range
 /// @param caret the caret position of the range
 /// @param scope the text scope
-ScopedTextRange::ScopedTextRange(int anchor, int caret, TextScope* scope)
+ScopedTextRange::ScopedTextRange(TextOffset anchor, TextOffset caret, TextScope* scope)
     : TextRange(anchor,caret)
     , scopeRef_(scope)
 {
@@ -79,6 +79,14 @@ MultiLineScopedTextRange* MultiLineScopedTextRangeReference::multiLineScopedText
 }
 
 
+/// Changes the referenced multi-line scoped textrange
+/// @param range the new range (with the same scope)
+void MultiLineScopedTextRangeReference::setMultiLineScopedTextRange(MultiLineScopedTextRange* range)
+{
+    multiScopeRef_ = range;
+}
+
+
 //===========================================
 
 
@@ -150,6 +158,38 @@ bool ScopedTextRangeList::isIndependent() const
 }
 
 
+/// Sets the state of the lexer at the end of the line: the stack of active multi-line ranges.
+/// The lexer compares this state after changing a line, when the state is the same the next lines don't change.
+/// @param state the active multi-line ranges (the first item is the default range)
+void ScopedTextRangeList::setEndState(const QVector<MultiLineScopedTextRange*>& state)
+{
+    endStateRefs_ = state;
+}
+
+
+/// Returns the active multi-line ranges at the end of the line (empty if unknown)
+const QVector<MultiLineScopedTextRange*>& ScopedTextRangeList::endState() const
+{
+    return endStateRefs_;
+}
+
+
+/// Replaces all references to the given multi-line range (in the ranges and the end state)
+/// @param range the range to replace
+/// @param newRange the new range
+void ScopedTextRangeList::replaceMultiLineScopedTextRange(MultiLineScopedTextRange* range, MultiLineScopedTextRange* newRange)
+{
+    foreach( ScopedTextRange* scopedRange, ranges_ ) {
+        // only references return a multi-line range
+        if( scopedRange->multiLineScopedTextRange() == range ) {
+            static_cast<MultiLineScopedTextRangeReference*>( scopedRange )->setMultiLineScopedTextRange( newRange );
+        }
+    }
+    int idx = endStateRefs_.indexOf( range );
+    if( idx >= 0 ) { endStateRefs_.replace( idx, newRange ); }
+}
+
+
 /// Converts the scoped textrange list to a strubg
 QString ScopedTextRangeList::toString()
 {
@@ -168,7 +208,7 @@ QString ScopedTextRangeList::toString()
 
 /// The multiline scoped textrange
 /// @param anchor
-MultiLineScopedTextRange::MultiLineScopedTextRange(int anchor, int caret, TextScope* scope )
+MultiLineScopedTextRange::MultiLineScopedTextRange(TextOffset anchor, TextOffset caret, TextScope* scope )
     : ScopedTextRange(anchor,caret,scope)
     , ruleRef_(0)
     , endRegExp_(0)
@@ -214,7 +254,7 @@ RegExp*MultiLineScopedTextRange::endRegExp()
 /// This method compares selection ranges
 bool MultiLineScopedTextRange::lessThan(MultiLineScopedTextRange* r1, MultiLineScopedTextRange* r2)
 {
-    int diff = r1->min() - r2->min();
+    TextOffset diff = r1->min() - r2->min();
     if( diff == 0 ) {
         diff = r2->length() - r1->length();     // larger areas need to be placed before smaller areas
     }
@@ -646,7 +686,7 @@ const TextRange& MultiLineScopedTextRangeSet::constRange(int idx) const
 
 
 /// This method adds a range with the default scope
-void MultiLineScopedTextRangeSet::addRange(int anchor, int caret)
+void MultiLineScopedTextRangeSet::addRange(TextOffset anchor, TextOffset caret)
 {
     scopedRangeList_.append( new MultiLineScopedTextRange(anchor, caret,Edbee::instance()->scopeManager()->refEmptyScope() ) );
 }
@@ -698,7 +738,7 @@ MultiLineScopedTextRange& MultiLineScopedTextRangeSet::scopedRange(int idx)
 
 
 /// Adds a textrange with the given name
-MultiLineScopedTextRange& MultiLineScopedTextRangeSet::addRange(int anchor, int caret, const QString& name, TextGrammarRule* rule )
+MultiLineScopedTextRange& MultiLineScopedTextRangeSet::addRange(TextOffset anchor, TextOffset caret, const QString& name, TextGrammarRule* rule )
 {
     MultiLineScopedTextRange* tr = new MultiLineScopedTextRange(anchor, caret, Edbee::instance()->scopeManager()->refTextScope(name) );
     tr->setGrammarRule( rule );
@@ -710,9 +750,9 @@ MultiLineScopedTextRange& MultiLineScopedTextRangeSet::addRange(int anchor, int
 /// This method removes all ranges after a given offset. This means it will remove all
 /// complete ranges after the given offset. Ranges that start before the offset and
 /// end after the offset are 'invalidated' which means the end offset is placed to the end of the document
-void MultiLineScopedTextRangeSet::removeAndInvalidateRangesAfterOffset(int offset)
+void MultiLineScopedTextRangeSet::removeAndInvalidateRangesAfterOffset(TextOffset offset)
 {
-    int len = textDocument()->length();
+    TextOffset len = textDocument()->length();
     beginChanges();
     for( int idx=rangeCount()-1; idx >= 0; idx-- ) {
         TextRange& range = this->range(idx);
@@ -727,6 +767,37 @@ void MultiLineScopedTextRangeSet::removeAndInvalidateRangesAfterOffset(int offse
 }
 
 
+/// Takes all ranges that start at or after the given offset out of this set (without deleting them)
+/// @param offset the offset
+/// @return the removed ranges (in order). The caller is responsible for giving or deleting these ranges
+QList<MultiLineScopedTextRange*> MultiLineScopedTextRangeSet::takeRangesAfterOffset(TextOffset offset)
+{
+    // the ranges are sorted, so all ranges after the offset are at the end
+    int idx = scopedRangeList_.size();
+    while( idx > 0 && scopedRangeList_.at(idx-1)->min() >= offset ) { --idx; }
+    QList<MultiLineScopedTextRange*> result = scopedRangeList_.mid( idx );
+    scopedRangeList_.erase( scopedRangeList_.begin() + idx, scopedRangeList_.end() );
+    return result;
+}
+
+
+/// Replaces the given range by another range and deletes it. The new range is placed at the position of the old range
+/// @param range the range to replace (this range is deleted)
+/// @param newRange the new range (with the same start offset, so the set stays sorted)
+void MultiLineScopedTextRangeSet::replaceScopedTextRange(MultiLineScopedTextRange* range, MultiLineScopedTextRange* newRange)
+{
+    // usually a recently added range is replaced
+    for( int idx=scopedRangeList_.size()-1; idx >= 0; --idx ) {
+        if( scopedRangeList_.at(idx) == range ) {
+            scopedRangeList_[idx] = newRange;
+            delete range;
+            return;
+        }
+    }
+    Q_ASSERT( false && "range not found" );
+}
+
+
 /// This method gives the scoped text range to this object
 void MultiLineScopedTextRangeSet::giveScopedTextRange(MultiLineScopedTextRange* textScope)
 {
@@ -786,7 +857,7 @@ TextDocumentScopes::~TextDocumentScopes()
 
 
 /// returns the last scoped offset
-int TextDocumentScopes::lastScopedOffset()
+TextOffset TextDocumentScopes::lastScopedOffset()
 {
     return lastScopedOffset_;
 }
@@ -794,9 +865,9 @@ int TextDocumentScopes::lastScopedOffset()
 
 /// Sets the last scoped offset
 /// @param offset the last scoped offset
-void TextDocumentScopes::setLastScopedOffset(int offset)
+void TextDocumentScopes::setLastScopedOffset(TextOffset offset)
 {
-    int previousOffset = lastScopedOffset_ ;
+    TextOffset previousOffset = lastScopedOffset_ ;
     if( previousOffset != offset ) {
         lastScopedOffset_ = offset;
         emit lastScopedOffsetChanged( previousOffset, lastScopedOffset_);
@@ -846,6 +917,23 @@ int TextDocumentScopes::scopedLineCount()
 }
 
 
+/// Replaces the line scoped range lists of the given lines with empty (0) lists. The lists of the lines after
+/// these lines move with the lines, so they stay valid when lines are inserted or removed.
+/// @param line the first line to replace
+/// @param lineCount the number of lines to replace (the lists of these lines are deleted)
+/// @param newLineCount the number of new lines
+void TextDocumentScopes::replaceLineScopedRangeLists(int line, int lineCount, int newLineCount)
+{
+    int len = lineRangeList_.length();
+    if( line >= len ) { return; }
+    lineCount = qMin( lineCount, len - line );
+    for( int i=line; i < line + lineCount; ++i ) {
+        delete lineRangeList_.at(i);
+    }
+    lineRangeList_.fill( line, lineCount, 0, newLineCount );
+}
+
+
 /// gives the multi-lined textrange to the scopedranges
 void TextDocumentScopes::giveMultiLineScopedTextRange(MultiLineScopedTextRange *range)
 {
@@ -853,9 +941,24 @@ void TextDocumentScopes::giveMultiLineScopedTextRange(MultiLineScopedTextRange *
 }
 
 
+/// Returns the number of (document wide) multi-line scoped ranges
+int TextDocumentScopes::multiLineScopedRangeCount() const
+{
+    return scopedRanges_.rangeCount();
+}
+
+
+/// Returns the multi-line scoped range at the given index
+/// @param idx the index of the range (0 <= idx < multiLineScopedRangeCount)
+MultiLineScopedTextRange& TextDocumentScopes::multiLineScopedRange(int idx)
+{
+    return scopedRanges_.scopedRange(idx);
+}
+
+
 /// This method invalidates all scopes after the given offset
 /// @param offset the offset from which to remove the offset
-void TextDocumentScopes::removeScopesAfterOffset(int offset)
+void TextDocumentScopes::removeScopesAfterOffset(TextOffset offset)
 {
     if( offset == 0 ) {
         scopedRanges_.clear();
@@ -879,6 +982,26 @@ void TextDocumentScopes::removeScopesAfterOffset(int offset)
 }
 
 
+/// Takes the multi-line ranges that start at or after the given offset out of the scopes (without deleting them).
+/// The line ranges still refer to these ranges
+/// @param offset the offset
+/// @return the ranges (in order), the caller is responsible for giving them back or deleting them
+QList<MultiLineScopedTextRange*> TextDocumentScopes::takeMultiLineScopedRangesAfterOffset(TextOffset offset)
+{
+    return scopedRanges_.takeRangesAfterOffset( offset );
+}
+
+
+/// Replaces a multi-line range by another range (with the same start offset) and deletes it.
+/// The references of the line ranges aren't changed
+/// @param range the range to replace and delete
+/// @param newRange the new range
+void TextDocumentScopes::replaceMultiLineScopedTextRange(MultiLineScopedTextRange* range, MultiLineScopedTextRange* newRange)
+{
+    scopedRanges_.replaceScopedTextRange( range, newRange );
+}
+
+
 /// This method retursn the default scoped textrange
 /// Currently this is done very dirty, by retrieving the defaultscoped range the begin and end is set tot he complete document
 /// a better solution would be a subclass that always returns 0 for an anchor and the documentlength for the caret
@@ -890,15 +1013,15 @@ MultiLineScopedTextRange& TextDocumentScopes::defaultScopedRange()
 
 
 /// This method returns all scope-ranges at the given offset-ranges
-QVector<MultiLineScopedTextRange*> TextDocumentScopes::multiLineScopedRangesBetweenOffsets(int offsetBegin, int offsetEnd)
+QVector<MultiLineScopedTextRange*> TextDocumentScopes::multiLineScopedRangesBetweenOffsets(TextOffset offsetBegin, TextOffset offsetEnd)
 {
     QVector<MultiLineScopedTextRange*> result;
     result.append( &defaultScopedRange_ );
-    int minOffset=0;
+    TextOffset minOffset=0;
     for( int i=0, cnt=scopedRanges_.rangeCount(); i<cnt && minOffset <= /** CHANGED 2013-01-22, was < */ offsetEnd; ++i ) {
         MultiLineScopedTextRange& range = scopedRanges_.scopedRange(i);
         minOffset = range.min();
-        int maxOffset = range.max();
+        TextOffset maxOffset = range.max();
         if( (offsetBegin <= minOffset && minOffset < offsetEnd) || (minOffset <= offsetBegin && offsetBegin < maxOffset) ) {
             result.append(&range);
         }
@@ -908,7 +1031,7 @@ QVector<MultiLineScopedTextRange*> TextDocumentScopes::multiLineScopedRangesBetw
 
 
 /// returns all scopes between the given offsets
-TextScopeList TextDocumentScopes::scopesAtOffset( int offset, bool includeEnd  )
+TextScopeList TextDocumentScopes::scopesAtOffset( TextOffset offset, bool includeEnd  )
 {
     TextScopeList result;
 
@@ -916,7 +1039,7 @@ TextScopeList TextDocumentScopes::scopesAtOffset( int offset, bool includeEnd  )
 //    qlog_info() <<  "------------[ scopesAtOffset("<<offset<<") ] --------";
     //QVector<MultiLineScopedTextRange*> ranges = scopedRangesBetweenOffsets(offsetBegin, offsetEnd);
     int line = textDocument()->lineFromOffset(offset);
-    int offsetInLine = offset-textDocument()->offsetFromLine(line);
+    TextOffset offsetInLine = offset-textDocument()->offsetFromLine(line);
     ScopedTextRangeList* list = scopedRangesAtLine(line);
     if( list ) {
         //scopes.reserve( ranges.size() );
@@ -945,14 +1068,14 @@ TextScopeList TextDocumentScopes::scopesAtOffset( int offset, bool includeEnd  )
 ///
 /// @param offset he offset to retrieve the scoped ranges
 /// @return the vector with text scopes. These scopes are document wide
-QVector<ScopedTextRange*> TextDocumentScopes::createScopedRangesAtOffsetList(int offset)
+QVector<ScopedTextRange*> TextDocumentScopes::createScopedRangesAtOffsetList(TextOffset offset)
 {
     QVector<ScopedTextRange*> result;
 
     // retrieve the line
     int line = textDocument()->lineFromOffset(offset);
-    int lineOffset = textDocument()->offsetFromLine(line);
-    int offsetInLine = offset-lineOffset;
+    TextOffset lineOffset = textDocument()->offsetFromLine(line);
+    TextOffset offsetInLine = offset-lineOffset;
 
     ScopedTextRangeList* list = scopedRangesAtLine(line);
     if( list ) {
@@ -175,7 +175,7 @@ private:
 class EDBEE_EXPORT ScopedTextRange : public TextRange
 {
 public:
-    ScopedTextRange( int anchor, int caret, TextScope* scope );
+    ScopedTextRange( TextOffset anchor, TextOffset caret, TextScope* scope );
 //    ScopedTextRange( const MultiLineScopedTextRange& range );
     virtual ~ScopedTextRange();
 
@@ -205,6 +205,7 @@ public:
 
     /// returns the multi-line scoped text range
     virtual MultiLineScopedTextRange* multiLineScopedTextRange();
+    void setMultiLineScopedTextRange( MultiLineScopedTextRange* range );
 
 private:
     MultiLineScopedTextRange* multiScopeRef_;       ///< the reference to the multi-scoped textrange that defined this scope
@@ -233,6 +234,10 @@ public:
     void setIndependent(bool enable=true);
     bool isIndependent() const;
 
+    void setEndState( const QVector<MultiLineScopedTextRange*>& state );
+    const QVector<MultiLineScopedTextRange*>& endState() const;
+    void replaceMultiLineScopedTextRange( MultiLineScopedTextRange* range, MultiLineScopedTextRange* newRange );
+
     QString toString();
 
 
@@ -240,6 +245,7 @@ private:
 
     QVector<ScopedTextRange*> ranges_;  ///< the textranges
     bool independent_;                  ///< this boolean tells if the line contains a multi-lined scope start or end
+    QVector<MultiLineScopedTextRange*> endStateRefs_;   ///< The active multi-line ranges at the end of the line (the lexer state, shared between lines)
 
 //    int size_;                      /// The number of ranges
 //    ScopedTextRange* ranges_;       /// The list of ranges
@@ -253,7 +259,7 @@ private:
 class EDBEE_EXPORT MultiLineScopedTextRange : public ScopedTextRange
 {
 public:
-    MultiLineScopedTextRange(int anchor, int caret, TextScope* scope);
+    MultiLineScopedTextRange(TextOffset anchor, TextOffset caret, TextScope* scope);
     virtual ~MultiLineScopedTextRange();
 
     void setGrammarRule( TextGrammarRule* rule );
@@ -286,7 +292,7 @@ public:
     virtual int rangeCount() const;
     virtual TextRange& range(int idx);
     virtual const TextRange& constRange(int idx) const;
-    virtual void addRange( int anchor, int caret );
+    virtual void addRange( TextOffset anchor, TextOffset caret );
     virtual void addRange(const TextRange& range);
 
     virtual void removeRange( int idx );
@@ -294,9 +300,11 @@ public:
     virtual void toSingleRange();
     virtual void sortRanges();
     virtual MultiLineScopedTextRange& scopedRange(int idx);
-    virtual MultiLineScopedTextRange& addRange(int anchor, int caret, const QString& name , TextGrammarRule *rule);
+    virtual MultiLineScopedTextRange& addRange(TextOffset anchor, TextOffset caret, const QString& name , TextGrammarRule *rule);
 
-    void removeAndInvalidateRangesAfterOffset( int offset );
+    void removeAndInvalidateRangesAfterOffset( TextOffset offset );
+    QList<MultiLineScopedTextRange*> takeRangesAfterOffset( TextOffset offset );
+    void replaceScopedTextRange( MultiLineScopedTextRange* range, MultiLineScopedTextRange* newRange );
 
   // adds a text scope
     void giveScopedTextRange( MultiLineScopedTextRange* textScope );
@@ -326,8 +334,8 @@ public:
     TextDocumentScopes( TextDocument* textDocument);
     virtual ~TextDocumentScopes();
 
-    int lastScopedOffset();
-    void setLastScopedOffset( int offset );
+    TextOffset lastScopedOffset();
+    void setLastScopedOffset( TextOffset offset );
 
 
   // scope management
@@ -336,14 +344,19 @@ public:
     void giveLineScopedRangeList( int line, ScopedTextRangeList* list);
     ScopedTextRangeList* scopedRangesAtLine( int line );
     int scopedLineCount();
+    void replaceLineScopedRangeLists( int line, int lineCount, int newLineCount );
 
     void giveMultiLineScopedTextRange( MultiLineScopedTextRange* range );
-    void removeScopesAfterOffset( int offset );
+    int multiLineScopedRangeCount() const;
+    MultiLineScopedTextRange& multiLineScopedRange( int idx );
+    void removeScopesAfterOffset( TextOffset offset );
+    QList<MultiLineScopedTextRange*> takeMultiLineScopedRangesAfterOffset( TextOffset offset );
+    void replaceMultiLineScopedTextRange( MultiLineScopedTextRange* range, MultiLineScopedTextRange* newRange );
     MultiLineScopedTextRange& defaultScopedRange();
 
-    QVector<MultiLineScopedTextRange*> multiLineScopedRangesBetweenOffsets( int offsetBegin, int offsetEnd );
-    TextScopeList scopesAtOffset(int offset , bool includeEnd=false );
-    QVector<ScopedTextRange*> createScopedRangesAtOffsetList( int offset );
+    QVector<MultiLineScopedTextRange*> multiLineScopedRangesBetweenOffsets( TextOffset offsetBegin, TextOffset offsetEnd );
+    TextScopeList scopesAtOffset(TextOffset offset , bool includeEnd=false );
+    QVector<ScopedTextRange*> createScopedRangesAtOffsetList( TextOffset offset );
 
     QString toString();
     QStringList scopesAsStringList();
@@ -358,7 +371,7 @@ protected slots:
     void grammarChanged();
 
 signals:
-    void lastScopedOffsetChanged(int previousOffset, int lastScopedOffset );
+    void lastScopedOffsetChanged( edbee::TextOffset previousOffset, edbee::TextOffset lastScopedOffset );
 
 private:
 
@@ -378,7 +391,7 @@ private:
     /// For all 'open' multi-line scopes with an end-offset of (documentLength).
     ///
     /// The scopedToOffset_ should only mark the multi-line scopes. Single lines scopes do NOT affect other regions of the document
-    int lastScopedOffset_;            ///< How far has the text been fully scoped?
+    TextOffset lastScopedOffset_;     ///< How far has the text been fully scoped?
 
 };
 
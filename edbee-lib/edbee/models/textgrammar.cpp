@@ -193,6 +193,7 @@ TextGrammar::TextGrammar(const QString& name, const QString& displayName)
 /// The textgrammar destructor
 TextGrammar::~TextGrammar()
 {
+    clearCompiledRules();
     qDeleteAll( repository_ );
     repository_.clear();
     delete mainRule_;
@@ -261,6 +262,39 @@ void TextGrammar::addFileExtension(const QString& ext)
 }
 
 
+/// Removes the compiled rules and regexp sets (of the TextGrammarManager)
+void TextGrammar::clearCompiledRules()
+{
+    compiledRules_.clear();
+    qDeleteAll( compiledRegExpSets_ );
+    compiledRegExpSets_.clear();
+}
+
+
+/// Appends the given rule and all its sub-rules (depth first) to the list
+static void appendRuleTree( TextGrammarRule* rule, QList<TextGrammarRule*>& rules )
+{
+    rules.append( rule );
+    for( int i=0, cnt=rule->ruleCount(); i<cnt; ++i ) {
+        appendRuleTree( rule->rule(i), rules );
+    }
+}
+
+
+/// Returns all rules of this grammar: the main rule with its sub-rules (depth first), followed by the rules
+/// of the repository (sorted by name). The index of a rule in this list is the same for every instance of
+/// the same grammar definition, which makes it possible to store references to rules (TextDocumentCache)
+QList<TextGrammarRule*> TextGrammar::rules() const
+{
+    QList<TextGrammarRule*> result;
+    if( mainRule_ ) { appendRuleTree( mainRule_, result ); }
+    foreach( TextGrammarRule* rule, repository_ ) {
+        appendRuleTree( rule, result );
+    }
+    return result;
+}
+
+
 //==========================
 
 
@@ -348,6 +382,82 @@ void TextGrammarManager::giveGrammar(TextGrammar* grammar)
         delete oldGrammar;
     }
     grammarMap_.insert(name,grammar);
+
+    // the compiled rules can include rules of the replaced grammar, or can miss the rules of the new grammar
+    foreach( TextGrammar* existingGrammar, grammarMap_ ) {
+        existingGrammar->clearCompiledRules();
+    }
+}
+
+
+/// Finds the rule included by the given include rule
+/// @param baseGrammar the grammar of the document, which is included by $base and $self
+/// @param includeRule the include rule
+/// @return the included rule (0 if not found)
+TextGrammarRule* TextGrammarManager::findIncludeRule( TextGrammar* baseGrammar, TextGrammarRule* includeRule )
+{
+    Q_ASSERT( includeRule->isIncludeCall() );
+    QString name = includeRule->includeName();
+
+    // repos call
+    if( name.startsWith("#")) {
+        return includeRule->grammar()->findFromRepos( name.mid(1) );
+
+    }
+    // another language call
+    // The difference between $base and $self is very subtle.. The exact difference is unkown to me..
+    if( name=="$base" || name == "$self" ) {
+        return baseGrammar->mainRule();
+    }
+
+    TextGrammar* grammar = get( name );
+    if( grammar ) { return grammar->mainRule(); }
+    return 0;
+}
+
+
+/// Returns the compiled rules of the given rule: the single- and multi-line regexp rules that can match in the
+/// context of the rule, in the order they need to be tried. The includes are resolved and the included rule lists
+/// are flattened, so the lexer can try all candidates with a single loop.
+///
+/// The result is compiled once and cached in the base grammar, until a grammar is added or replaced.
+/// @param baseGrammar the grammar of the document (the $base and $self includes refer to this grammar)
+/// @param rule the rule with the sub-rules (the main rule, a rule list or a multi-line regexp rule)
+/// @return the candidate rules
+const QVector<TextGrammarRule*>& TextGrammarManager::compiledRules( TextGrammar* baseGrammar, TextGrammarRule* rule )
+{
+    QHash<TextGrammarRule*, QVector<TextGrammarRule*> >::iterator itr = baseGrammar->compiledRules_.find( rule );
+    if( itr == baseGrammar->compiledRules_.end() ) {
+        QVector<TextGrammarRule*> rules;
+        QSet<TextGrammarRule*> visitedRules;
+        compileRules( baseGrammar, rule, rules, visitedRules );
+        rules.squeeze();
+        itr = baseGrammar->compiledRules_.insert( rule, rules );
+    }
+    return itr.value();
+}
+
+
+/// Returns a regexp set with the patterns of the compiled rules of the given rule (in the same order), which
+/// finds the leftmost match of all candidate rules with a single search.
+/// The set is compiled once and cached in the base grammar, like the compiled rules.
+/// @param baseGrammar the grammar of the document
+/// @param rule the rule with the sub-rules
+/// @return the regexp set (which is invalid when one of the patterns is invalid)
+RegExpSet* TextGrammarManager::compiledRegExpSet( TextGrammar* baseGrammar, TextGrammarRule* rule )
+{
+    RegExpSet* regExpSet = baseGrammar->compiledRegExpSets_.value( rule, 0 );
+    if( !regExpSet ) {
+        const QVector<TextGrammarRule*>& rules = compiledRules( baseGrammar, rule );
+        QStringList patterns;
+        patterns.reserve( rules.size() );
+        foreach( TextGrammarRule* compiledRule, rules ) {
+            patterns.append( compiledRule->matchRegExp()->pattern() );
+        }
+        regExpSet = new RegExpSet( patterns );
+        baseGrammar->compiledRegExpSets_.insert( rule, regExpSet );
+    }
+    return regExpSet;
 }
 
 
@@ -407,4 +517,44 @@ QString TextGrammarManager::lastErrorMessage() const
 }
 
 
+/// Appends the candidate rules of the sub-rules of the given rule (depth first)
+/// A rule that's already visited isn't added again: it can never match before the first occurrence.
+/// This also prevents endless recursion of include cycles.
+/// @param baseGrammar the grammar of the document
+/// @param rule the rule with the sub-rules
+/// @param rules (in/out) the candidate rules
+/// @param visitedRules (in/out) the visited rules
+void TextGrammarManager::compileRules( TextGrammar* baseGrammar, TextGrammarRule* rule, QVector<TextGrammarRule*>& rules, QSet<TextGrammarRule*>& visitedRules )
+{
+    for( int i=0, cnt=rule->ruleCount(); i < cnt; ++i ) {
+        TextGrammarRule* childRule = rule->rule(i);
+
+        // an include can refer to another include
+        while( childRule && childRule->isIncludeCall() && !visitedRules.contains( childRule ) ) {
+            visitedRules.insert( childRule );
+            TextGrammarRule* includedRule = findIncludeRule( baseGrammar, childRule );
+            if( !includedRule ) {
+                qlog_warn() << "ERROR, include rule" << childRule->includeName() << "not found!" ;
+            }
+            childRule = includedRule;
+        }
+        if( !childRule || visitedRules.contains( childRule ) ) { continue; }
+        visitedRules.insert( childRule );
+
+        switch( childRule->instruction() ) {
+            case TextGrammarRule::SingleLineRegExp:
+            case TextGrammarRule::MultiLineRegExp:
+                rules.append( childRule );
+                break;
+            case TextGrammarRule::MainRule:
+            case TextGrammarRule::RuleList:
+                compileRules( baseGrammar, childRule, rules, visitedRules );
+                break;
+            default:
+                Q_ASSERT(false && "unkown rule");
+        }
+    }
+}
+
+
 } // edbee
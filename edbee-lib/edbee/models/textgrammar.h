@@ -8,14 +8,17 @@
 #include <QHash>
 #include <QList>
 #include <QMap>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 class QFile;
 
 namespace edbee {
 
 class RegExp;
+class RegExpSet;
 class TextGrammar;
 class Edbee;
 
@@ -138,12 +141,20 @@ public:
     TextGrammarRule* findFromRepos( const QString& name, TextGrammarRule* defValue = 0  );
     void addFileExtension( const QString& ext );
 
+    QList<TextGrammarRule*> rules() const;
+
 private:
     QString name_;                               ///< the display name of this
     QString displayName_;                        ///< the name to display
     TextGrammarRule *mainRule_;                      ///< the 'main' rule of this grammar
     QMap<QString, TextGrammarRule*> repository_;     ///< A map with all named grammar rules
     QStringList fileExtensions_;                  ///< A list with all file-extensions
+    QHash<TextGrammarRule*, QVector<TextGrammarRule*> > compiledRules_;  ///< The compiled (flattened) candidate rules of the rules, with this grammar as base grammar
+    QHash<TextGrammarRule*, RegExpSet*> compiledRegExpSets_;             ///< The regexp sets with the patterns of the compiled rules (owned)
+
+    void clearCompiledRules();
+
+    friend class TextGrammarManager;
 };
 
 
@@ -173,7 +184,12 @@ public:
 
     QString lastErrorMessage() const;
 
+    TextGrammarRule* findIncludeRule( TextGrammar* baseGrammar, TextGrammarRule* includeRule );
+    const QVector<TextGrammarRule*>& compiledRules( TextGrammar* baseGrammar, TextGrammarRule* rule );
+    RegExpSet* compiledRegExpSet( TextGrammar* baseGrammar, TextGrammarRule* rule );
+
 private:
+    void compileRules( TextGrammar* baseGrammar, TextGrammarRule* rule, QVector<TextGrammarRule*>& rules, QSet<TextGrammarRule*>& visitedRules );
 
     TextGrammar* defaultGrammarRef_;                   ///< A reference to the default grammar
     QMap<QString,TextGrammar*> grammarMap_;            ///< A map with all grammar definitions
@@ -34,7 +34,7 @@ public:
     ///
     /// @param beginOffset the first offset
     /// @param endOffset the last offset to
-    virtual void lexRange( int beginOffset, int endOffset ) = 0;
+    virtual void lexRange( TextOffset beginOffset, TextOffset endOffset ) = 0;
 
 
     TextDocumentScopes* textScopes() { return textDocumentScopesRef_; }
@@ -0,0 +1,166 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textlexerscheduler.h"
+
+#include <QElapsedTimer>
+
+#include "edbee/models/textdocument.h"
+#include "edbee/models/textdocumentscopes.h"
+#include "edbee/models/textlexer.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Constructs the lexer scheduler
+/// @param parent the parent of this object
+TextLexerScheduler::TextLexerScheduler(QObject* parent)
+    : QObject(parent)
+    , requestedOffset_(0)
+    , timeSlice_(10)
+    , batchLineCount_(64)
+{
+    timer_.setSingleShot( true );
+    timer_.setInterval( 0 );
+    connect( &timer_, SIGNAL(timeout()), this, SLOT(lexPendingRange()) );
+}
+
+
+/// Sets the document to lex. A pending request for another document is cancelled
+/// @param document the document to lex
+void TextLexerScheduler::setDocument(TextDocument* document)
+{
+    if( documentRef_ == document ) { return; }
+    cancel();
+    documentRef_ = document;
+}
+
+
+/// Returns the document that's lexed
+TextDocument* TextLexerScheduler::document() const
+{
+    return documentRef_;
+}
+
+
+/// Sets the maximum time to lex at once. At least one batch of lines is lexed per time slice
+/// @param msecs the time in milliseconds
+void TextLexerScheduler::setTimeSlice(int msecs)
+{
+    timeSlice_ = qMax( msecs, 0 );
+}
+
+
+/// Returns the maximum time to lex at once (in milliseconds)
+int TextLexerScheduler::timeSlice() const
+{
+    return timeSlice_;
+}
+
+
+/// Sets the number of lines that are lexed between checking the time
+/// @param count the number of lines
+void TextLexerScheduler::setBatchLineCount(int count)
+{
+    batchLineCount_ = qMax( count, 1 );
+}
+
+
+/// Returns the number of lines that are lexed between checking the time
+int TextLexerScheduler::batchLineCount() const
+{
+    return batchLineCount_;
+}
+
+
+/// Lexes the given range. When this can't be done in a single time slice, the rest is lexed on the event loop
+/// (see requestLexing)
+/// @param beginOffset the first offset (the lexer always starts at the last scoped offset)
+/// @param endOffset the end offset of the range
+/// @return true if the range is lexed, false if the lexing continues on the event loop
+bool TextLexerScheduler::lexRange(TextOffset beginOffset, TextOffset endOffset)
+{
+    Q_UNUSED(beginOffset);
+    requestedOffset_ = endOffset;
+    if( lexTimeSlice() ) {
+        timer_.stop();
+        return true;
+    }
+    timer_.start();
+    return false;
+}
+
+
+/// Requests to lex the document to the given offset on the event loop. This replaces a pending request
+/// @param offset the offset to lex to
+void TextLexerScheduler::requestLexing(TextOffset offset)
+{
+    requestedOffset_ = offset;
+    timer_.start();
+}
+
+
+/// Cancels the pending request
+void TextLexerScheduler::cancel()
+{
+    timer_.stop();
+}
+
+
+/// Returns true if lexing is pending (and continues on the event loop)
+bool TextLexerScheduler::isPending() const
+{
+    return timer_.isActive();
+}
+
+
+/// Returns the last requested offset
+TextOffset TextLexerScheduler::requestedOffset() const
+{
+    return requestedOffset_;
+}
+
+
+/// Lexes the next time slice of the pending request (called by the timer)
+void TextLexerScheduler::lexPendingRange()
+{
+    if( !documentRef_ || !documentRef_->textLexer() ) { return; }
+    TextOffset previousOffset = documentRef_->scopes()->lastScopedOffset();
+    bool finished = lexTimeSlice();
+    emit batchLexed( previousOffset, documentRef_->scopes()->lastScopedOffset() );
+    if( !finished ) { timer_.start(); }
+}
+
+
+/// Lexes batches of lines (from the last scoped offset) until the requested offset is lexed or the time slice is used
+/// @return true if the requested offset is lexed
+bool TextLexerScheduler::lexTimeSlice()
+{
+    if( !documentRef_ || !documentRef_->textLexer() ) { return true; }
+    TextDocument* doc = documentRef_;
+    TextDocumentScopes* scopes = doc->scopes();
+    TextLexer* lexer = doc->textLexer();
+
+    QElapsedTimer timer;
+    timer.start();
+    while( true ) {
+        // the document can be changed after requesting
+        TextOffset endOffset = qMin( requestedOffset_, doc->length() );
+        TextOffset lastScopedOffset = scopes->lastScopedOffset();
+        if( endOffset <= lastScopedOffset ) { return true; }
+
+        // lex the next batch of lines
+        int batchEndLine = doc->lineFromOffset( lastScopedOffset ) + batchLineCount_;
+        TextOffset batchEndOffset = batchEndLine < doc->lineCount() ? doc->offsetFromLine( batchEndLine ) : doc->length();
+        lexer->lexRange( lastScopedOffset, qMin( endOffset, batchEndOffset ) );
+
+        // prevent an endless loop when the lexer doesn't make progress
+        if( scopes->lastScopedOffset() <= lastScopedOffset ) { return true; }
+        if( timer.elapsed() >= timeSlice_ ) { return scopes->lastScopedOffset() >= endOffset; }
+    }
+}
+
+
+} // edbee
@@ -0,0 +1,73 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include "edbee/textoffset.h"
+
+namespace edbee {
+
+class TextDocument;
+
+
+/// Lexes a document in time-sliced batches, so lexing a large part of a document never blocks the user interface.
+///
+/// The lexer always lexes from the last scoped offset forward. When a range far after the last scoped offset
+/// is requested (like jumping to the end of a large file), lexRange only lexes for a single time slice and
+/// schedules the rest. The remaining batches are lexed on the event loop (with a zero timer), so paint and
+/// input events are handled in between. The lines that aren't lexed yet are painted without styling, every
+/// lexed batch is reported with batchLexed so the visible lines can be repainted.
+///
+/// The last requested range has priority: a new request replaces the pending request.
+///
+/// The lexing happens on the thread of the document, the grammar lexer can't be moved to another thread:
+/// it changes the document scopes and the regular expressions of the (shared) grammar rules store their match.
+class EDBEE_EXPORT TextLexerScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    TextLexerScheduler( QObject* parent=0 );
+
+    void setDocument( TextDocument* document );
+    TextDocument* document() const;
+
+    void setTimeSlice( int msecs );
+    int timeSlice() const;
+    void setBatchLineCount( int count );
+    int batchLineCount() const;
+
+    bool lexRange( TextOffset beginOffset, TextOffset endOffset );
+    void requestLexing( TextOffset offset );
+    void cancel();
+    bool isPending() const;
+    TextOffset requestedOffset() const;
+
+signals:
+
+    /// This signal is emitted after lexing a time slice on the event loop
+    /// @param previousOffset the last scoped offset before lexing
+    /// @param lastScopedOffset the last scoped offset after lexing
+    void batchLexed( edbee::TextOffset previousOffset, edbee::TextOffset lastScopedOffset );
+
+private slots:
+
+    void lexPendingRange();
+
+private:
+    bool lexTimeSlice();
+
+    QPointer<TextDocument> documentRef_;    ///< The document to lex
+    QTimer timer_;                          ///< The zero timer that lexes the next time slice
+    TextOffset requestedOffset_;            ///< The offset that needs to be lexed
+    int timeSlice_;                         ///< The maximum time to lex at once (in milliseconds)
+    int batchLineCount_;                    ///< The number of lines that are lexed between time checks
+};
+
+} // edbee
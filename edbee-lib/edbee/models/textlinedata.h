@@ -17,7 +17,8 @@ enum TextLineDataPredefinedFields {
     LineTextScopesField=0,
     //    LineDataMarkers,      /// Bookmarks etc
     LineAppendTextLayoutFormatListField=1,
-    PredefinedFieldCount=2
+    LineEndingField=2,
+    PredefinedFieldCount=3
 };
 
 
@@ -50,6 +51,7 @@ private:
 
 typedef BasicTextLineData<QString> QStringTextLineData;
 typedef BasicTextLineData<QList<QTextLayout::FormatRange>> LineAppendTextLayoutFormatListData;
+typedef BasicTextLineData<int> LineEndingLineData;    ///< The LineEnding::Type of a line with another line ending than the document
 
 //-------
 
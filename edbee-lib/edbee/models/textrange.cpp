@@ -38,26 +38,26 @@ void TextRange::fixCaretForUnicode(TextDocument *doc, int direction)
 /// Sets the anchor to the given location, and forces the anchor to say between the document bounds
 /// @param doc document to set the anchor for
 /// @param anchor the anchor location to set
-void TextRange::setAnchorBounded(TextDocument* doc, int anchor)
+void TextRange::setAnchorBounded(TextDocument* doc, TextOffset anchor)
 {
-    setAnchor( qBound( 0,  anchor, doc->length() ) );
+    setAnchor( qBound<TextOffset>( 0,  anchor, doc->length() ) );
 }
 
 
 /// Sets the caret to the given location, and forces the caret to say between the document bounds
 /// @param doc the document (used for checking the document bounds)
 /// @param caret the caret position to set
-void TextRange::setCaretBounded(TextDocument* doc, int caret)
+void TextRange::setCaretBounded(TextDocument* doc, TextOffset caret)
 {
-    setCaret( qBound( 0,  caret, doc->length() ) );
+    setCaret( qBound<TextOffset>( 0,  caret, doc->length() ) );
 }
 
 
 /// Changes the length by modifying the max-variable
-void TextRange::setLength(int newLength)
+void TextRange::setLength(TextOffset newLength)
 {
-    int& vMin = minVar();
-    int& vMax = maxVar();
+    TextOffset& vMin = minVar();
+    TextOffset& vMax = maxVar();
     vMax = vMin + newLength;
 }
 
@@ -106,9 +106,9 @@ void TextRange::moveCaretOrDeselect(TextDocument* doc, int amount)
 /// @param doc the text document
 /// @param var the initial position
 /// @param amount the amount to move
-int TextRange::moveWhileChar(TextDocument* doc, int pos, int amount, const QString& chars)
+TextOffset TextRange::moveWhileChar(TextDocument* doc, TextOffset pos, int amount, const QString& chars)
 {
-    int docLength = doc->length();
+    TextOffset docLength = doc->length();
     if( amount < 0 ) {
         --pos;   // first move left
         while( pos >= 0 && chars.indexOf( doc->charAt(pos) )>=0 ) { --pos; }
@@ -122,9 +122,9 @@ int TextRange::moveWhileChar(TextDocument* doc, int pos, int amount, const QStri
 
 /// This method charactes until the given chargroup is found
 /// When moving to the LEFT the cursor is placed AFTER the found character
-int TextRange::moveUntilChar(TextDocument* doc, int pos, int amount, const QString& chars)
+TextOffset TextRange::moveUntilChar(TextDocument* doc, TextOffset pos, int amount, const QString& chars)
 {
-    int docLength = doc->length();
+    TextOffset docLength = doc->length();
     if( amount < 0 ) {
         --pos;
         while( pos >= 0 && chars.indexOf( doc->charAt(pos) )<0 ) { --pos; }
@@ -169,7 +169,7 @@ void TextRange::moveCaretByCharGroup(TextDocument *doc, int amount, const QStrin
     for( int i=0; i<count; ++i ) {
 
         // first 'skip' the whitespaces
-        int oldCaret = caret_;
+        TextOffset oldCaret = caret_;
         moveCaretWhileChar( doc, amount, whitespace );
 
         // find the character group
@@ -219,14 +219,14 @@ void TextRange::moveCaretByCharGroup(TextDocument *doc, int amount, const QStrin
 void TextRange::moveCaretToLineBoundary(TextDocument* doc, int amount, const QString& whitespace )
 {
     TextBuffer* buf     = doc->buffer();
-    int caret           = caret_;
-    int line            = doc->lineFromOffset( caret );
-    int offsetNextLine  = doc->offsetFromLine( line + 1 );
+    TextOffset caret          = caret_;
+    int line                  = doc->lineFromOffset( caret );
+    TextOffset offsetNextLine = doc->offsetFromLine( line + 1 );
     if( amount < 0 ) {
-        int lineStart = doc->offsetFromLine( line );
+        TextOffset lineStart = doc->offsetFromLine( line );
 
         // find the first word
-        int wordStart = buf->findCharPosWithinRangeOrClamp( lineStart, 1, whitespace, false, lineStart, offsetNextLine );
+        TextOffset wordStart = buf->findCharPosWithinRangeOrClamp( lineStart, 1, whitespace, false, lineStart, offsetNextLine );
         if( caret > wordStart || lineStart ==  caret ) {
             caret = wordStart;
         } else {
@@ -244,7 +244,7 @@ void TextRange::moveCaretToLineBoundary(TextDocument* doc, int amount, const QSt
 }
 
 /// Moves the caret to a word boundary  (used for word dragging selections)
-void TextRange::moveCaretToWordBoundaryAtOffset(TextDocument *doc, int newOffset)
+void TextRange::moveCaretToWordBoundaryAtOffset(TextDocument *doc, TextOffset newOffset)
 {
     TextEditorConfig* config = doc->config();
 
@@ -261,7 +261,7 @@ void TextRange::moveCaretToWordBoundaryAtOffset(TextDocument *doc, int newOffset
 }
 
 /// Moves the caret to a word boundary  (used for word dragging selections)
-void TextRange::moveCaretToLineBoundaryAtOffset(TextDocument *doc, int newOffset)
+void TextRange::moveCaretToLineBoundaryAtOffset(TextDocument *doc, TextOffset newOffset)
 {
     int firstLine = doc->lineFromOffset(min());
     int lastLine = doc->lineFromOffset(max());
@@ -289,8 +289,8 @@ void TextRange::moveCaretToLineBoundaryAtOffset(TextDocument *doc, int newOffset
 /// 0 is a special case, it moves the caret to the start of the current line and expands to the end of the line. It does not add lines
 void TextRange::expandToFullLine(TextDocument* doc, int amount)
 {
-    int minOffset = min();
-    int maxOffset = max();
+    TextOffset minOffset = min();
+    TextOffset maxOffset = max();
 
     // select the current line (everse caret
     if( amount == 0 ) {
@@ -309,7 +309,7 @@ void TextRange::expandToFullLine(TextDocument* doc, int amount)
     } else {
 
         int minLine = doc->lineFromOffset( minOffset );
-        int minLineStartOffset = doc->offsetFromLine( minLine );
+        TextOffset minLineStartOffset = doc->offsetFromLine( minLine );
 
         // only select line above if the full line isn't selected yet
         if( minOffset == minLineStartOffset ) {
@@ -320,7 +320,7 @@ void TextRange::expandToFullLine(TextDocument* doc, int amount)
 
         // select to eol if required
         int maxLine = doc->lineFromOffset( maxOffset );
-        int maxLineStartOffset = doc->offsetFromLine( maxLine );
+        TextOffset maxLineStartOffset = doc->offsetFromLine( maxLine );
         if( maxLineStartOffset != maxOffset ) {
             maxOffset = doc->offsetFromLine( doc->lineFromOffset(maxOffset)+1 );
         }
@@ -361,8 +361,8 @@ static QString findCharGroup( QChar c, const QString& whitespace, const QStringL
 /// Expands the selection to a words
 void TextRange::expandToWord(TextDocument *doc, const QString& whitespace, const QStringList& characterGroups )
 {
-    int& min = minVar();
-    int& max = maxVar();
+    TextOffset& min = minVar();
+    TextOffset& max = maxVar();
 
     // first check which character is under the caret to find the character grouop
     if( min > 0 ) {
@@ -388,8 +388,8 @@ void TextRange::expandToWord(TextDocument *doc, const QString& whitespace, const
 
 void TextRange::expandToIncludeRange(TextRange& range)
 {
-    int& min = minVar();
-    int& max = maxVar();
+    TextOffset& min = minVar();
+    TextOffset& max = maxVar();
     min = qMin( min, range.min() );
     max = qMax( max, range.max() );
 }
@@ -413,15 +413,15 @@ bool TextRange::equals( const TextRange& range)
 ///  (A)(B) or (B)(A)
 bool TextRange::touches(TextRange& range)
 {
-    int min1 = min();
-    int max1 = max();
-    int min2 = range.min();
-    int max2 = range.max();
+    TextOffset min1 = min();
+    TextOffset max1 = max();
+    TextOffset min2 = range.min();
+    TextOffset max2 = range.max();
     return( max1 == min2 || max2 == min1 );
 }
 
 /// checks if the given position is in this textrange
-bool TextRange::contains(int pos)
+bool TextRange::contains(TextOffset pos)
 {
     return min() <= pos && pos < max();
 }
@@ -453,13 +453,13 @@ TextRange &TextRangeSetBase::firstRange()
 /// This method returns the range index at the given offset
 /// @param offset the offset to check
 /// @return the offset index or -1 if not found
-int TextRangeSetBase::rangeIndexAtOffset(int offset)
+int TextRangeSetBase::rangeIndexAtOffset(TextOffset offset)
 {
     // find the range of this offset
     for( int i=0, cnt = rangeCount(); i<cnt; ++i ) {
         TextRange& found = this->range(i);
-        int minOffset = found.min();
-        int maxOffset = found.max();
+        TextOffset minOffset = found.min();
+        TextOffset maxOffset = found.max();
         if( minOffset <= offset && offset <= maxOffset ) {
             return i;
         }
@@ -474,15 +474,15 @@ int TextRangeSetBase::rangeIndexAtOffset(int offset)
 /// @param firstIndex(out) The first index found (-1 if not found)
 /// @param lastIndex(out) The last index found (-1 if not found)
 /// @return true if the range is found
-bool TextRangeSetBase::rangesBetweenOffsets( int offsetBegin, int offsetEnd, int& firstIndex, int& lastIndex )
+bool TextRangeSetBase::rangesBetweenOffsets( TextOffset offsetBegin, TextOffset offsetEnd, int& firstIndex, int& lastIndex )
 {
     firstIndex = -1;
     lastIndex  = -1;
     /// Todo optimize with a binairy search
     for( int i=0, cnt = rangeCount(); i<cnt; ++i ) {
         TextRange& range = this->range(i);
-        int minOffset = range.min();
-        int maxOffset = range.max();
+        TextOffset minOffset = range.min();
+        TextOffset maxOffset = range.max();
 
         if( (offsetBegin <= minOffset && minOffset <= offsetEnd) || (minOffset <= offsetBegin && offsetBegin <= maxOffset) ) {
             if( firstIndex < 0 ) firstIndex = i;
@@ -498,15 +498,15 @@ bool TextRangeSetBase::rangesBetweenOffsets( int offsetBegin, int offsetEnd, int
 /// @param firstIndex(out) The first index found (-1 if not found)
 /// @param lastIndex(out) The last index found (-1 if not found)
 /// @return true if the range is found
-bool TextRangeSetBase::rangesBetweenOffsetsExlusiveEnd(int offsetBegin, int offsetEnd, int &firstIndex, int &lastIndex)
+bool TextRangeSetBase::rangesBetweenOffsetsExlusiveEnd(TextOffset offsetBegin, TextOffset offsetEnd, int &firstIndex, int &lastIndex)
 {
     firstIndex = -1;
     lastIndex  = -1;
     /// Todo optimize with a binairy search
     for( int i=0, cnt = rangeCount(); i<cnt; ++i ) {
         TextRange& range = this->range(i);
-        int minOffset = range.min();
-        int maxOffset = range.max();
+        TextOffset minOffset = range.min();
+        TextOffset maxOffset = range.max();
 
         if( (offsetBegin <= minOffset && minOffset < offsetEnd) || (minOffset <= offsetBegin && offsetBegin < maxOffset) ) {
             if( firstIndex < 0 ) firstIndex = i;
@@ -521,8 +521,8 @@ bool TextRangeSetBase::rangesBetweenOffsetsExlusiveEnd(int offsetBegin, int offs
 bool TextRangeSetBase::rangesAtLine(int line, int& firstIndex, int& lastIndex)
 {
     TextDocument* doc = textDocument();
-    int offsetBegin = doc->offsetFromLine(line);
-    int offsetEnd   = doc->offsetFromLine(line+1)-1;
+    TextOffset offsetBegin = doc->offsetFromLine(line);
+    TextOffset offsetEnd   = doc->offsetFromLine(line+1)-1;
     return rangesBetweenOffsets( offsetBegin, offsetEnd, firstIndex, lastIndex );
 }
 
@@ -530,8 +530,8 @@ bool TextRangeSetBase::rangesAtLine(int line, int& firstIndex, int& lastIndex)
 bool TextRangeSetBase::rangesAtLineExclusiveEnd(int line, int &firstIndex, int &lastIndex)
 {
     TextDocument* doc = textDocument();
-    int offsetBegin = doc->offsetFromLine(line);
-    int offsetEnd   = doc->offsetFromLine(line+1)-1;
+    TextOffset offsetBegin = doc->offsetFromLine(line);
+    TextOffset offsetEnd   = doc->offsetFromLine(line+1)-1;
     return rangesBetweenOffsetsExlusiveEnd( offsetBegin, offsetEnd, firstIndex, lastIndex );
 }
 
@@ -598,8 +598,8 @@ QString TextRangeSetBase::getSelectedTextExpandedToFullLines()
     int lastLine = -1;
     for( int i=0, cnt=rangeCount(); i<cnt; ++i ) {
         TextRange& range = this->range(i);
-        int min = range.min();
-        int max = range.max();
+        TextOffset min = range.min();
+        TextOffset max = range.max();
         int line = doc->lineFromOffset(min);
         int maxLine = doc->lineFromOffset(max);
 
@@ -710,13 +710,13 @@ void TextRangeSetBase::substractTextRanges(const TextRangeSetBase& sel)
 
 
 /// This method substracts a single range from the ranges list
-void TextRangeSetBase::substractRange(int minB, int maxB)
+void TextRangeSetBase::substractRange(TextOffset minB, TextOffset maxB)
 {
     beginChanges();
     for( int i=rangeCount()-1; i >=0; --i ) {
         TextRange& rangeItem = range(i);
-        int& minA = rangeItem.minVar();
-        int& maxA = rangeItem.maxVar();
+        TextOffset& minA = rangeItem.minVar();
+        TextOffset& maxA = rangeItem.maxVar();
 
         // A: [             ]
         // B:     [XXXXX]
@@ -777,7 +777,7 @@ void TextRangeSetBase::expandToWords(const QString& whitespace, const QStringLis
 
 /// Selects the word at the given offset
 /// @param offset the offset of the word to select
-void TextRangeSetBase::selectWordAt(int offset, const QString& whitespace, const QStringList& characterGroups )
+void TextRangeSetBase::selectWordAt(TextOffset offset, const QString& whitespace, const QStringList& characterGroups )
 {
     TextRange newRange(offset,offset);
     newRange.expandToWord( textDocument(), whitespace, characterGroups );
@@ -789,7 +789,7 @@ void TextRangeSetBase::selectWordAt(int offset, const QString& whitespace, const
 /// Toggles a word selection at the given location
 /// The idea is the following, double-click an empty place to select the word at the given location
 /// Double click an existing selection to remove the selection (and caret)
-void TextRangeSetBase::toggleWordSelectionAt(int offset, const QString& whitespace, const QStringList& characterGroups)
+void TextRangeSetBase::toggleWordSelectionAt(TextOffset offset, const QString& whitespace, const QStringList& characterGroups)
 {
     int idx = rangeIndexAtOffset( offset );
 
@@ -867,14 +867,14 @@ void TextRangeSetBase::mergeOverlappingRanges( bool joinBorders )
     beginChanges();
     for( int i=rangeCount()-1; i>=0; --i ) {
         TextRange& range1 = range(i);
-        int min1 = range1.min();
-        int max1 = range1.max();
+        TextOffset min1 = range1.min();
+        TextOffset max1 = range1.max();
 
         // check overlap with all other ranges
         for( int j=i-1; j>=0; --j ) {
             TextRange& range2 = range(j);
-            int min2 = range2.min();
-            int max2 = range2.max();
+            TextOffset min2 = range2.min();
+            TextOffset max2 = range2.max();
 
             // Overlappping possibilities:
             // 1: [        ]
@@ -938,7 +938,7 @@ void TextRangeSetBase::mergeOverlappingRanges( bool joinBorders )
 /// @param anchor the anchor of the selection
 /// @param caret the caret position
 /// @param index the default range index (default 0)
-void TextRangeSetBase::setRange(int anchor, int caret, int index)
+void TextRangeSetBase::setRange(TextOffset anchor, TextOffset caret, int index)
 {
     range(index).set( anchor, caret );
 }
@@ -984,21 +984,21 @@ TextDocument*TextRangeSetBase::textDocument() const
 /// @param length the length of the text that's changed
 /// @param newLength the new length of the text
 /// @param sticky, when sticky the caret/anchor is sticky and isn't moved if the change happens at the same location
-void TextRangeSetBase::changeSpatial(int pos, int length, int newLength, bool sticky , bool performDelete)
+void TextRangeSetBase::changeSpatial(TextOffset pos, TextOffset length, TextOffset newLength, bool sticky , bool performDelete)
 {
     int stickyDelta = sticky ? 0 : -1;
 
     // change the ranges
-    int endPos = pos + length;
-    int delta = newLength - length;
-    int newEndPos = endPos + delta;
+    TextOffset endPos = pos + length;
+    TextOffset delta = newLength - length;
+    TextOffset newEndPos = endPos + delta;
     beginChanges();
     for( int i=rangeCount()-1; i>=0; --i ) {
 
         TextRange& range = this->range(i);
 
-        int& min = range.minVar();
-        int& max = range.maxVar();
+        TextOffset& min = range.minVar();
+        TextOffset& max = range.maxVar();
 
         // cut 'off' the endpos
         if( pos <= min && min < endPos ) {
@@ -1098,7 +1098,7 @@ const TextRange &TextRangeSet::constRange(int idx) const
 
 
 /// Adds a text range
-void TextRangeSet::addRange(int anchor, int caret)
+void TextRangeSet::addRange(TextOffset anchor, TextOffset caret)
 {
     selectionRanges_.append( TextRange( anchor, caret ) );
     processChangesIfRequired();
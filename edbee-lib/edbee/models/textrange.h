@@ -28,32 +28,32 @@ class TextDocument;
 ///
 class EDBEE_EXPORT TextRange {
 public:
-    TextRange( int anchor=0, int caret=0 ) : anchor_(anchor), caret_(caret) {}
+    TextRange( TextOffset anchor=0, TextOffset caret=0 ) : anchor_(anchor), caret_(caret) {}
 
-    inline int anchor() const { return anchor_; }
-    inline int caret() const { return caret_; }
+    inline TextOffset anchor() const { return anchor_; }
+    inline TextOffset caret() const { return caret_; }
 
     /// returns the minimal value
-    inline int min() const { return qMin( caret_, anchor_ ); }
-    inline int max() const { return qMax( caret_, anchor_ ); }
+    inline TextOffset min() const { return qMin( caret_, anchor_ ); }
+    inline TextOffset max() const { return qMax( caret_, anchor_ ); }
 
     /// returns the minimal variable reference
-    inline int& minVar() { return caret_ < anchor_ ? caret_ : anchor_; }
-    inline int& maxVar() { return caret_ < anchor_ ? anchor_: caret_; }
+    inline TextOffset& minVar() { return caret_ < anchor_ ? caret_ : anchor_; }
+    inline TextOffset& maxVar() { return caret_ < anchor_ ? anchor_: caret_; }
 
-    inline int length() const { return qAbs(caret_ - anchor_ ); }
+    inline TextOffset length() const { return qAbs(caret_ - anchor_ ); }
 
     void fixCaretForUnicode(TextDocument* doc, int direction );
 
 
-    void setAnchor( int anchor ) { anchor_ = anchor; }
-    void setAnchorBounded( TextDocument* doc, int anchor );
-    void setCaret( int caret ) { caret_ = caret; }
-    void setCaretBounded( TextDocument* doc, int caret );
-    void setLength( int newLength );
+    void setAnchor( TextOffset anchor ) { anchor_ = anchor; }
+    void setAnchorBounded( TextDocument* doc, TextOffset anchor );
+    void setCaret( TextOffset caret ) { caret_ = caret; }
+    void setCaretBounded( TextDocument* doc, TextOffset caret );
+    void setLength( TextOffset newLength );
 
 
-    void set( int anchor, int caret ) { anchor_ = anchor; caret_ = caret; }
+    void set( TextOffset anchor, TextOffset caret ) { anchor_ = anchor; caret_ = caret; }
 
     void reset() { anchor_ = caret_; }
     bool hasSelection() const  { return anchor_ != caret_; }
@@ -64,16 +64,16 @@ public:
 
     void moveCaret( TextDocument* doc, int amount );
     void moveCaretOrDeselect( TextDocument* doc, int amount );
-    int moveWhileChar( TextDocument* doc, int pos, int amount, const QString& chars );
-    int moveUntilChar( TextDocument* doc, int pos, int amount, const QString& chars );
+    TextOffset moveWhileChar( TextDocument* doc, TextOffset pos, int amount, const QString& chars );
+    TextOffset moveUntilChar( TextDocument* doc, TextOffset pos, int amount, const QString& chars );
     void moveCaretWhileChar( TextDocument* doc, int amount, const QString& chars );
     void moveCaretUntilChar( TextDocument* doc, int amount, const QString& chars );
     void moveAnchortWhileChar( TextDocument* doc, int amount, const QString& chars );
     void moveAnchorUntilChar( TextDocument* doc, int amount, const QString& chars );
     void moveCaretByCharGroup( TextDocument* doc, int amount, const QString& whitespace, const QStringList& characterGroups );
     void moveCaretToLineBoundary( TextDocument* doc, int amount, const QString& whitespace );
-    void moveCaretToWordBoundaryAtOffset( TextDocument* doc, int offset );
-    void moveCaretToLineBoundaryAtOffset( TextDocument* doc, int offset );
+    void moveCaretToWordBoundaryAtOffset( TextDocument* doc, TextOffset offset );
+    void moveCaretToLineBoundaryAtOffset( TextDocument* doc, TextOffset offset );
 
 
     void expandToFullLine( TextDocument* doc, int amount );
@@ -85,13 +85,13 @@ public:
 
     bool equals(const TextRange &range );
     bool touches( TextRange& range );
-    bool contains( int pos );
+    bool contains( TextOffset pos );
 
     static bool lessThan( TextRange& r1, TextRange& r2 );
 
 private:
-    int anchor_;        ///< The position of the anchor
-    int caret_;         ///< The position of the caret
+    TextOffset anchor_;         ///< The position of the anchor
+    TextOffset caret_;          ///< The position of the caret
 };
 
 
@@ -118,7 +118,7 @@ public:
     virtual int rangeCount() const  = 0;
     virtual TextRange& range(int idx) = 0;
     virtual const TextRange& constRange(int idx) const = 0;
-    virtual void addRange( int anchor, int caret ) = 0;
+    virtual void addRange( TextOffset anchor, TextOffset caret ) = 0;
     virtual void addRange( const TextRange& range ) = 0;
     virtual void removeRange( int idx ) = 0;
     virtual void clear() = 0;
@@ -128,9 +128,9 @@ public:
     TextRange& lastRange();
     TextRange& firstRange();
 
-    int rangeIndexAtOffset( int offset );
-    bool rangesBetweenOffsets( int offsetBegin, int offsetEnd, int& firstIndex, int& lastIndex );
-    bool rangesBetweenOffsetsExlusiveEnd( int offsetBegin, int offsetEnd, int& firstIndex, int& lastIndex );
+    int rangeIndexAtOffset( TextOffset offset );
+    bool rangesBetweenOffsets( TextOffset offsetBegin, TextOffset offsetEnd, int& firstIndex, int& lastIndex );
+    bool rangesBetweenOffsetsExlusiveEnd( TextOffset offsetBegin, TextOffset offsetEnd, int& firstIndex, int& lastIndex );
     bool rangesAtLine( int line, int& firstIndex, int& lastIndex );
     bool rangesAtLineExclusiveEnd( int line, int& firstIndex, int& lastIndex );
     bool hasSelection();
@@ -154,14 +154,14 @@ public:
 
     void addTextRanges( const TextRangeSetBase& sel);
     void substractTextRanges( const TextRangeSetBase& sel );
-    void substractRange( int min, int max );
+    void substractRange( TextOffset min, TextOffset max );
 
 
   // selection
     void expandToFullLines(int amount);
     void expandToWords( const QString& whitespace, const QStringList& characterGroups);
-    void selectWordAt(int offset , const QString& whitespace, const QStringList& characterGroups);
-    void toggleWordSelectionAt( int offset, const QString& whitespace, const QStringList& characterGroups);
+    void selectWordAt( TextOffset offset, const QString& whitespace, const QStringList& characterGroups);
+    void toggleWordSelectionAt( TextOffset offset, const QString& whitespace, const QStringList& characterGroups);
 
   // movement
     void moveCarets( int amount );
@@ -173,9 +173,9 @@ public:
 
   // changing
     //    void growSelectionAtBegin( int amount );
-    void changeSpatial(int pos, int length, int newLength, bool sticky=false, bool performDelete=false);
+    void changeSpatial( TextOffset pos, TextOffset length, TextOffset newLength, bool sticky=false, bool performDelete=false);
 
-    void setRange( int anchor, int caret, int index = 0 );
+    void setRange( TextOffset anchor, TextOffset caret, int index = 0 );
     void setRange( const TextRange& range , int index = 0 );
 
     virtual void processChangesIfRequired(bool joinBorders=false);
@@ -212,7 +212,7 @@ public:
     virtual int rangeCount() const { return selectionRanges_.size(); }
     virtual TextRange& range(int idx);
     virtual const TextRange& constRange(int idx ) const;
-    virtual void addRange(int anchor, int caret);
+    virtual void addRange( TextOffset anchor, TextOffset caret );
     virtual void addRange( const TextRange& range );
     virtual void removeRange(int idx);
     virtual void clear();
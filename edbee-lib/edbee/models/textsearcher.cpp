@@ -107,6 +107,116 @@ void TextSearcher::setReverse(bool on)
 }
 
 
+/// Searches the regexp in the given range of the buffer.
+/// The range is searched in blocks. A block that's located in a single chunk of the buffer (including the context
+/// around it) is searched directly in the chunk. Only a bounded block around a chunk boundary is copied.
+/// So the buffer layout is never changed (the gap isn't moved) and the searched data is never larger than an int.
+/// @param buffer the buffer to search in
+/// @param offset the offset to start searching. (In reverse mode the lower bound of the match)
+/// @param rangeEnd the end of the searched data
+/// @return the document offset of the match, or < 0 when nothing is found
+TextOffset TextSearcher::searchRange(TextBuffer* buffer, TextOffset offset, TextOffset rangeEnd)
+{
+    TextOffset context = matchContextSize();
+    TextOffset boundaryBlockSize = qMax( SearchBoundaryBlockSize, context );
+    TextOffset chunkStart = 0, chunkLength = 0;
+    if( isReverse() ) {
+        TextOffset blockEnd = rangeEnd;
+        while( blockEnd > offset ) {
+            buffer->chunkAt( blockEnd - 1, chunkStart, chunkLength );
+            TextOffset blockStart = chunkStart > 0 ? chunkStart + SearchContextSize : 0;
+            if( qMin( blockEnd + context, rangeEnd ) > chunkStart + chunkLength || blockStart >= blockEnd ) {
+                blockStart = blockEnd - boundaryBlockSize;
+            }
+            blockStart = qMax( qMax( blockStart, blockEnd - SearchMaxBlockSize ), offset );
+
+            TextOffset idx = searchBlock( buffer, blockStart, blockEnd, rangeEnd, context );
+            if( idx != -1 ) { return idx; }
+            blockEnd = blockStart;
+        }
+    } else {
+        TextOffset blockStart = offset;
+        while( blockStart < rangeEnd ) {
+            buffer->chunkAt( blockStart, chunkStart, chunkLength );
+            TextOffset chunkEnd = chunkStart + chunkLength;
+            TextOffset blockEnd = chunkEnd >= rangeEnd ? rangeEnd : chunkEnd - context;
+            if( ( chunkStart > 0 && blockStart - SearchContextSize < chunkStart ) || blockEnd <= blockStart ) {
+                blockEnd = blockStart + boundaryBlockSize;
+            }
+            blockEnd = qMin( qMin( blockEnd, blockStart + SearchMaxBlockSize ), rangeEnd );
+
+            TextOffset idx = searchBlock( buffer, blockStart, blockEnd, rangeEnd, context );
+            if( idx != -1 ) { return idx; }
+            blockStart = blockEnd;
+        }
+    }
+    return -1;
+}
+
+
+/// Searches a match that starts in the given block. The characters around the block (SearchContextSize before it
+/// and the given context after it) are visible to the regular expression, so matches aren't cut off at the block boundaries.
+/// A match that reaches the end of the visible data (before the end of the range) is searched again with
+/// a twice as large context, until it ends before the visible data or the range end is reached.
+/// @param buffer the buffer to search in
+/// @param blockStart the first offset a match may start at
+/// @param blockEnd the end of the block (a match starts before this offset)
+/// @param rangeEnd the end of the searched data
+/// @param context the number of characters after the block that are visible to the regular expression
+/// @return the document offset of the first match (the last match in reverse mode), -1 if not found
+TextOffset TextSearcher::searchBlock(TextBuffer* buffer, TextOffset blockStart, TextOffset blockEnd, TextOffset rangeEnd, TextOffset context)
+{
+    while( true ) {
+        TextOffset dataStart = qMax<TextOffset>( 0, blockStart - SearchContextSize );
+        TextOffset dataEnd = qMin( blockEnd + context, rangeEnd );
+        QString storage;
+        TextOffset dataOffset = 0;
+        const QChar* data = buffer->rangeData( dataStart, dataEnd - dataStart, storage, dataOffset );
+        data += dataStart - dataOffset;
+        int start = static_cast<int>( blockStart - dataStart );
+        int end = static_cast<int>( blockEnd - dataStart );
+        int length = static_cast<int>( dataEnd - dataStart );
+
+        int idx = 0;
+        if( isReverse() ) {
+            idx = regExp_->lastIndexIn( data, start, length );
+
+            // the last match starts in the context after the block, find the last match in the block
+            if( idx >= end ) {
+                int last = -1;
+                for( idx = regExp_->indexIn( data, start, length ); 0 <= idx && idx < end; idx = regExp_->indexIn( data, idx + 1, length ) ) {
+                    last = idx;
+                }
+                idx = last >= 0 ? regExp_->indexIn( data, last, length ) : -1;
+            }
+        } else {
+            idx = regExp_->indexIn( data, start, length );
+            if( idx >= end && dataEnd < rangeEnd ) { idx = -1; }
+        }
+
+        // the match is cut off by the end of the visible data, search it again with a larger context
+        if( idx >= 0 && dataEnd < rangeEnd && idx + regExp_->len(0) >= length && context < SearchMaxBlockSize ) {
+            blockStart = idx + dataStart;
+            blockEnd = blockStart + 1;
+            context = qMin( 2 * context, SearchMaxBlockSize );
+            continue;
+        }
+        return idx >= 0 ? idx + dataStart : idx;
+    }
+}
+
+
+/// Returns the number of characters after a searched block that are visible to the regular expression.
+/// A plain string match is never longer than the search term. A regular expression match can span many lines
+TextOffset TextSearcher::matchContextSize() const
+{
+    if( syntax_ == SyntaxPlainString ) {
+        return qMax<TextOffset>( SearchContextSize, searchTerm_.length() );
+    }
+    return SearchMatchSize;
+}
+
+
 /// Finds the next matching textrange
 /// This method does not alter the textrange selection. It only returns the range of the next match
 /// @param selection the text-selection to use
@@ -114,11 +224,11 @@ void TextSearcher::setReverse(bool on)
 TextRange TextSearcher::findNextRange(TextRangeSet* selection)
 {
     TextDocument* document = selection->textDocument();
-    QChar* buffer = document->buffer()->rawDataPointer();
+    TextBuffer* buffer = document->buffer();
 
     if( !regExp_ ) { regExp_ = createRegExp(); }
 
-    int caretPos= 0;
+    TextOffset caretPos= 0;
     if( selection->rangeCount() > 0 ) {
         if( isReverse() ) {
             caretPos = selection->firstRange().min();
@@ -127,20 +237,16 @@ TextRange TextSearcher::findNextRange(TextRangeSet* selection)
         }
     }
 
-    int idx = 0;
+    TextOffset idx = 0;
     if( isReverse() ) {
-        idx = regExp_->lastIndexIn(buffer,0,caretPos);
+        idx = searchRange( buffer, 0, caretPos );
     } else {
-        idx = regExp_->indexIn(buffer,caretPos,document->length());
+        idx = searchRange( buffer, caretPos, document->length() );
     }
 
     // wrapped around? Let's try it from the beginning
     if( idx < 0 && isWrapAroundEnabled() ) {
-        if( isReverse() ) {
-            idx = regExp_->lastIndexIn(buffer,0,document->length());
-        } else {
-            idx = regExp_->indexIn(buffer,0,document->length());
-        }
+        idx = searchRange( buffer, 0, document->length() );
     }
     if( idx >= 0 ) {
         int len = regExp_->len(0);
@@ -13,6 +13,7 @@ namespace edbee {
 
 
 class RegExp;
+class TextBuffer;
 class TextDocument;
 class TextEditorWidget;
 
@@ -74,6 +75,24 @@ protected:
 
     void setDirty();
     RegExp* createRegExp();
+    TextOffset searchRange( TextBuffer* buffer, TextOffset offset, TextOffset rangeEnd );
+    TextOffset searchBlock( TextBuffer* buffer, TextOffset blockStart, TextOffset blockEnd, TextOffset rangeEnd, TextOffset context );
+    TextOffset matchContextSize() const;
+
+    /// The number of characters before a searched block that are visible to the regular expression.
+    /// (And the number of characters after it for a plain string search)
+    static const TextOffset SearchContextSize = 4096;
+
+    /// The number of characters after a searched block that are visible to a regular expression.
+    /// Every regular expression match up to this length is found. A longer match that reaches the end of
+    /// the visible data is searched again with a larger context
+    static const TextOffset SearchMatchSize = 0x100000;
+
+    /// The minimal number of match positions of a block that crosses a chunk boundary (the data of this block is copied)
+    static const TextOffset SearchBoundaryBlockSize = 16 * SearchContextSize;
+
+    /// The maximum number of match positions of a block (the regular expression engines use int offsets)
+    static const TextOffset SearchMaxBlockSize = 0x10000000;
 
 private:
 
@@ -0,0 +1,335 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textsnapshot.h"
+
+#include <algorithm>
+
+#include "edbee/models/textbuffer.h"
+#include "edbee/util/newlinescanner.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Constructs a null snapshot. A null snapshot behaves like an empty text
+TextSnapshot::TextSnapshot()
+{
+}
+
+
+/// Constructs a snapshot with the given data
+/// @param data the data of the snapshot (ownership is transferred)
+TextSnapshot::TextSnapshot(Data* data)
+    : d_(data)
+{
+}
+
+
+/// Returns true if this snapshot isn't created by a TextSnapshotBuilder
+bool TextSnapshot::isNull() const
+{
+    return d_.isNull();
+}
+
+
+/// Returns the revision of the textbuffer at the moment this snapshot was taken
+quint64 TextSnapshot::revision() const
+{
+    return d_ ? d_->revision : 0;
+}
+
+
+/// Returns the number of characters
+TextOffset TextSnapshot::length() const
+{
+    return d_ ? d_->length : 0;
+}
+
+
+/// Returns the character at the given offset
+QChar TextSnapshot::charAt(TextOffset offset) const
+{
+    Q_ASSERT( 0 <= offset && offset < length() );
+    int idx = chunkIndex( offset );
+    return d_->chunks.at(idx).text.at( offset - d_->chunkOffsets.at(idx) );
+}
+
+
+/// Returns the given part of the text
+QString TextSnapshot::textPart(TextOffset offset, TextOffset length) const
+{
+    Q_ASSERT( 0 <= offset && 0 <= length && offset + length <= this->length() );
+    QString result;
+    if( length == 0 ) { return result; }
+    result.reserve( length );
+
+    TextOffset end = offset + length;
+    for( int idx = chunkIndex( offset ); offset < end; ++idx ) {
+        const QString& text = d_->chunks.at(idx).text;
+        TextOffset chunkOffset = d_->chunkOffsets.at(idx);
+        TextOffset chunkEnd = chunkOffset + text.length();
+        TextOffset partLength = qMin( end, chunkEnd ) - offset;
+        result.append( text.constData() + offset - chunkOffset, partLength );
+        offset += partLength;
+    }
+    return result;
+}
+
+
+/// Returns the complete text of the snapshot
+QString TextSnapshot::text() const
+{
+    return textPart( 0, length() );
+}
+
+
+/// Returns the number of lines
+int TextSnapshot::lineCount() const
+{
+    if( !d_ || d_->chunks.isEmpty() ) { return 1; }
+    return d_->chunkLines.last() + d_->chunks.last().lineStarts.size() + 1;
+}
+
+
+/// Returns the line at the given offset
+int TextSnapshot::lineFromOffset(TextOffset offset) const
+{
+    Q_ASSERT( 0 <= offset && offset <= length() );
+    if( !d_ || d_->chunks.isEmpty() ) { return 0; }
+    int idx = chunkIndex( offset );
+    const QVector<TextOffset>& lineStarts = d_->chunks.at(idx).lineStarts;
+    int count = std::upper_bound( lineStarts.constBegin(), lineStarts.constEnd(), offset - d_->chunkOffsets.at(idx) ) - lineStarts.constBegin();
+    return d_->chunkLines.at(idx) + count;
+}
+
+
+/// Returns the offset of the first character of the given line
+TextOffset TextSnapshot::offsetFromLine(int line) const
+{
+    Q_ASSERT( 0 <= line && line < lineCount() );
+    if( line == 0 ) { return 0; }
+
+    // the line start of line n is the (n-1)th newline
+    int lineStart = line - 1;
+    int idx = std::upper_bound( d_->chunkLines.constBegin(), d_->chunkLines.constEnd(), lineStart ) - d_->chunkLines.constBegin() - 1;
+    return d_->chunkOffsets.at(idx) + d_->chunks.at(idx).lineStarts.at( lineStart - d_->chunkLines.at(idx) );
+}
+
+
+/// Returns the length of the given line (including the newline)
+TextOffset TextSnapshot::lineLength(int line) const
+{
+    TextOffset end = line + 1 < lineCount() ? offsetFromLine( line + 1 ) : length();
+    return end - offsetFromLine( line );
+}
+
+
+/// Returns the given line (including the newline)
+QString TextSnapshot::line(int line) const
+{
+    return textPart( offsetFromLine( line ), lineLength( line ) );
+}
+
+
+/// Returns the given line without the newline
+QString TextSnapshot::lineWithoutNewline(int line) const
+{
+    TextOffset len = lineLength( line );
+    if( line + 1 < lineCount() ) { --len; }
+    return textPart( offsetFromLine( line ), len );
+}
+
+
+/// Returns the number of chunks
+int TextSnapshot::chunkCount() const
+{
+    return d_ ? d_->chunks.size() : 0;
+}
+
+
+/// Returns the chunk that contains the given offset (see TextBuffer::chunkAt)
+/// The returned pointer is valid as long as this snapshot (or a copy of it) exists
+/// @param offset the offset to retrieve the chunk for (0 <= offset <= length())
+/// @param chunkStart (out) the offset of the first character of the chunk
+/// @param chunkLength (out) the number of characters in the chunk
+/// @return the pointer to the first character of the chunk (0 when the snapshot is empty)
+const QChar* TextSnapshot::chunkAt(TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength) const
+{
+    Q_ASSERT( 0 <= offset && offset <= length() );
+    if( !d_ || d_->chunks.isEmpty() ) {
+        chunkStart = 0;
+        chunkLength = 0;
+        return nullptr;
+    }
+    int idx = chunkIndex( offset );
+    const QString& text = d_->chunks.at(idx).text;
+    chunkStart = d_->chunkOffsets.at(idx);
+    chunkLength = text.length();
+    return text.constData();
+}
+
+
+/// Returns the index of the chunk that contains the given offset. (The last chunk for offset == length())
+int TextSnapshot::chunkIndex(TextOffset offset) const
+{
+    int idx = std::upper_bound( d_->chunkOffsets.constBegin(), d_->chunkOffsets.constEnd(), offset ) - d_->chunkOffsets.constBegin() - 1;
+    return qMax( idx, 0 );
+}
+
+
+
+//=====================================================
+
+
+/// Constructs the snapshot builder
+/// @param buffer the buffer to create snapshots of
+/// @param parent the parent object
+TextSnapshotBuilder::TextSnapshotBuilder(TextBuffer* buffer, QObject* parent)
+    : QObject(parent)
+    , bufferRef_(buffer)
+    , fullRebuild_(true)
+    , dirtyFirst_(-1)
+    , dirtyLast_(-1)
+    , dirtyDelta_(0)
+    , rebuiltChunkCount_(0)
+{
+    Q_ASSERT(bufferRef_);
+    connect( bufferRef_, SIGNAL(textChanged(edbee::TextBufferChange,QString)), SLOT(textChanged(edbee::TextBufferChange)), Qt::DirectConnection );
+}
+
+
+/// The destructor
+TextSnapshotBuilder::~TextSnapshotBuilder()
+{
+}
+
+
+/// Returns a snapshot of the current state of the textbuffer.
+/// When the buffer isn't changed since the previous call, the same snapshot is returned.
+TextSnapshot TextSnapshotBuilder::snapshot()
+{
+    rebuiltChunkCount_ = 0;
+    if( fullRebuild_ || dirtyFirst_ >= 0 ) {
+        rebuild();
+    }
+    return snapshot_;
+}
+
+
+/// Returns the textbuffer
+TextBuffer* TextSnapshotBuilder::buffer() const
+{
+    return bufferRef_;
+}
+
+
+/// Returns the number of chunks that were rebuilt by the last call to snapshot()
+int TextSnapshotBuilder::rebuiltChunkCount() const
+{
+    return rebuiltChunkCount_;
+}
+
+
+/// This method is called when the text of the buffer is changed. It extends the changed region.
+void TextSnapshotBuilder::textChanged(TextBufferChange change)
+{
+    if( fullRebuild_ ) { return; }
+    if( snapshot_.chunkCount() == 0 ) {
+        fullRebuild_ = true;
+        return;
+    }
+
+    int first = chunkIndexAfterChanges( change.offset() );
+    int last = chunkIndexAfterChanges( change.offset() + change.length() );
+    if( dirtyFirst_ >= 0 ) {
+        first = qMin( first, dirtyFirst_ );
+        last = qMax( last, dirtyLast_ );
+    }
+    dirtyFirst_ = first;
+    dirtyLast_ = last;
+    dirtyDelta_ += change.newTextLength() - change.length();
+}
+
+
+/// Returns the chunk of the last snapshot that contains the given offset of the current buffer.
+/// Offsets in the changed region return the first chunk of this region.
+int TextSnapshotBuilder::chunkIndexAfterChanges(TextOffset offset) const
+{
+    if( dirtyFirst_ >= 0 ) {
+        const TextSnapshot::Data* data = snapshot_.d_.data();
+        TextOffset dirtyBegin = data->chunkOffsets.at(dirtyFirst_);
+        TextOffset dirtyEnd = data->chunkOffsets.at(dirtyLast_) + data->chunks.at(dirtyLast_).text.length() + dirtyDelta_;
+        if( dirtyBegin <= offset && offset <= dirtyEnd ) { return dirtyFirst_; }
+        if( offset > dirtyEnd ) { offset -= dirtyDelta_; }
+    }
+    return snapshot_.chunkIndex( offset );
+}
+
+
+/// Appends the text of the given range of the buffer as chunks.
+/// The range is divided in chunks of equal size between ChunkSize and 2*ChunkSize characters (when the range is large enough).
+/// So inserting a few characters in a chunk doesn't split it.
+void TextSnapshotBuilder::appendChunks(TextOffset offset, TextOffset length, QVector<TextSnapshot::Chunk>& chunks)
+{
+    if( length == 0 ) { return; }
+    TextOffset count = qMax( length / ChunkSize, TextOffset(1) );
+    TextOffset begin = offset;
+    for( TextOffset i = 1; i <= count; ++i ) {
+        TextOffset chunkEnd = begin + TextOffset( qint64(length) * i / count );
+        TextSnapshot::Chunk chunk;
+        chunk.text = bufferRef_->textPart( offset, chunkEnd - offset );
+        NewlineScanner::appendOffsets( chunk.text.constData(), chunk.text.length(), 1, chunk.lineStarts );
+        chunks.append( chunk );
+        offset = chunkEnd;
+        ++rebuiltChunkCount_;
+    }
+}
+
+
+/// Rebuilds the changed chunks and creates a new snapshot.
+/// Unchanged chunks are shared with the previous snapshot
+void TextSnapshotBuilder::rebuild()
+{
+    TextSnapshot::Data* data = new TextSnapshot::Data();
+    data->revision = bufferRef_->revision();
+    data->length = bufferRef_->length();
+
+    if( fullRebuild_ ) {
+        appendChunks( 0, data->length, data->chunks );
+    } else {
+        const TextSnapshot::Data* prev = snapshot_.d_.data();
+        TextOffset begin = prev->chunkOffsets.at(dirtyFirst_);
+        TextOffset end = prev->chunkOffsets.at(dirtyLast_) + prev->chunks.at(dirtyLast_).text.length() + dirtyDelta_;
+
+        data->chunks.reserve( prev->chunks.size() - ( dirtyLast_ - dirtyFirst_ + 1 ) + ( end - begin ) / ChunkSize + 1 );
+        for( int i=0; i < dirtyFirst_; ++i ) { data->chunks.append( prev->chunks.at(i) ); }
+        appendChunks( begin, end - begin, data->chunks );
+        for( int i=dirtyLast_+1; i < prev->chunks.size(); ++i ) { data->chunks.append( prev->chunks.at(i) ); }
+    }
+
+    // calculate the offsets and line starts of all chunks
+    int chunkCount = data->chunks.size();
+    data->chunkOffsets.resize( chunkCount );
+    data->chunkLines.resize( chunkCount );
+    TextOffset offset = 0;
+    int lines = 0;
+    for( int i=0; i < chunkCount; ++i ) {
+        const TextSnapshot::Chunk& chunk = data->chunks.at(i);
+        data->chunkOffsets[i] = offset;
+        data->chunkLines[i] = lines;
+        offset += chunk.text.length();
+        lines += chunk.lineStarts.size();
+    }
+    Q_ASSERT( offset == data->length );
+
+    snapshot_ = TextSnapshot( data );
+    fullRebuild_ = false;
+    dirtyFirst_ = -1;
+    dirtyLast_ = -1;
+    dirtyDelta_ = 0;
+}
+
+
+} // edbee
@@ -0,0 +1,123 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "edbee/textoffset.h"
+
+namespace edbee {
+
+class TextBuffer;
+class TextBufferChange;
+
+
+/// An immutable, versioned view of the text and the line offsets of a textbuffer.
+///
+/// The text of a snapshot is stored in chunks of about TextSnapshotBuilder::ChunkSize characters.
+/// Chunks are implicitly shared QStrings, so the chunks that aren't touched by a change are shared
+/// by all snapshots that are created after each other.
+///
+/// A snapshot is a small value object. It's never changed after creation, which makes it safe to read it
+/// from other threads (for searching, lexing, saving) while the document is being edited on the GUI thread.
+/// The revision is the revision of the textbuffer at the moment the snapshot is taken, it can be used to
+/// detect (and discard) results that are calculated for an outdated snapshot.
+class EDBEE_EXPORT TextSnapshot
+{
+public:
+    TextSnapshot();
+
+    bool isNull() const;
+    quint64 revision() const;
+
+    TextOffset length() const;
+    QChar charAt( TextOffset offset ) const;
+    QString textPart( TextOffset offset, TextOffset length ) const;
+    QString text() const;
+
+    int lineCount() const;
+    int lineFromOffset( TextOffset offset ) const;
+    TextOffset offsetFromLine( int line ) const;
+    TextOffset lineLength( int line ) const;
+    QString line( int line ) const;
+    QString lineWithoutNewline( int line ) const;
+
+    int chunkCount() const;
+    const QChar* chunkAt( TextOffset offset, TextOffset& chunkStart, TextOffset& chunkLength ) const;
+
+private:
+    friend class TextSnapshotBuilder;
+
+    /// A chunk of text with the line starts of the newlines in this chunk
+    struct Chunk {
+        QString text;                        ///< The text of the chunk (never empty)
+        QVector<TextOffset> lineStarts;      ///< The offsets (relative to the chunk) of the characters after the newlines
+    };
+
+    struct Data {
+        quint64 revision;                    ///< The revision of the textbuffer
+        TextOffset length;                   ///< The total number of characters
+        QVector<Chunk> chunks;               ///< The chunks with the text
+        QVector<TextOffset> chunkOffsets;    ///< The offset of every chunk
+        QVector<int> chunkLines;             ///< The number of line starts before every chunk
+    };
+
+    explicit TextSnapshot( Data* data );
+
+    int chunkIndex( TextOffset offset ) const;
+
+    QSharedPointer<const Data> d_;           ///< The shared (immutable) data of the snapshot
+};
+
+
+/// Builds snapshots of a textbuffer.
+///
+/// The builder keeps track of the region of the last snapshot that's changed. When a new snapshot is requested
+/// only the chunks in this region are rebuilt, all other chunks are shared with the previous snapshot.
+/// Creating a snapshot after a typical edit only copies a single chunk.
+///
+/// The builder should only be used on the thread of the textbuffer (the GUI thread).
+class EDBEE_EXPORT TextSnapshotBuilder : public QObject
+{
+Q_OBJECT
+
+public:
+    explicit TextSnapshotBuilder( TextBuffer* buffer, QObject* parent=0 );
+    virtual ~TextSnapshotBuilder();
+
+    TextSnapshot snapshot();
+    TextBuffer* buffer() const;
+
+    int rebuiltChunkCount() const;
+
+    /// The preferred number of characters in a single chunk (a chunk is always smaller than 2*ChunkSize)
+    static const int ChunkSize = 4096;
+
+protected slots:
+
+    void textChanged( edbee::TextBufferChange change );
+
+private:
+    int chunkIndexAfterChanges( TextOffset offset ) const;
+    void appendChunks( TextOffset offset, TextOffset length, QVector<TextSnapshot::Chunk>& chunks );
+    void rebuild();
+
+private:
+    TextBuffer* bufferRef_;                  ///< The textbuffer to create snapshots of
+    TextSnapshot snapshot_;                  ///< The last created snapshot
+    bool fullRebuild_;                       ///< Should all chunks be rebuilt?
+    int dirtyFirst_;                         ///< The first changed chunk of the last snapshot (-1 if nothing is changed)
+    int dirtyLast_;                          ///< The last changed chunk of the last snapshot
+    TextOffset dirtyDelta_;                  ///< The total length difference of the changed chunks
+    int rebuiltChunkCount_;                  ///< The number of chunks that were rebuilt by the last snapshot call
+
+    Q_DISABLE_COPY(TextSnapshotBuilder)
+};
+
+} // edbee
@@ -566,9 +566,10 @@ void TextEditorController::executeCommand(const QString& name)
 }
 
 /// Return the readonly state.
+/// A document that can't be changed (like a memory mapped document) is always readonly
 bool TextEditorController::readonly() const
 {
-    return widget()->readonly();
+    return widget()->readonly() || ( textDocumentRef_ && textDocumentRef_->isReadonly() );
 }
 
 /// Sets the readonly state
@@ -655,14 +656,14 @@ void TextEditorController::moveCaretTo(int line, int col, bool keepAnchors, int
         line = textDocument()->lineCount() + line;
         if( line < 0 ) { line = 0; }
     }
-    int offset = textDocument()->offsetFromLine(line);
-    int lineLength = textDocument()->lineLength(line);
+    TextOffset offset = textDocument()->offsetFromLine(line);
+    TextOffset lineLength = textDocument()->lineLength(line);
     if( col < 0 ){
         col = lineLength + col;
     }
 
     int minusNewLineChar = textDocument()->lineCount()-1 == line ? 0 : 1;
-    offset += qBound(0, col, qMax(lineLength-minusNewLineChar, 0));
+    offset += qBound<TextOffset>(0, col, qMax<TextOffset>(lineLength-minusNewLineChar, 0));
 
 //textDocument()->offsetFromLineAndColumn(line,col)
 
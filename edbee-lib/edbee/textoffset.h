@@ -0,0 +1,24 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <QtCore/qglobal.h>
+
+namespace edbee {
+
+/// The type used for character offsets and lengths in the document model
+/// (TextBuffer, GapVector, LineOffsetVector, TextRange and the change classes).
+///
+/// By default this is an int, which limits a document to 2^31 characters.
+/// Define EDBEE_64BIT_OFFSETS (cmake option EDBEE_64BIT_OFFSETS, qmake CONFIG+=edbee_64bit_offsets)
+/// to use 64 bit offsets, for documents that are larger.
+///
+/// Line numbers and indices in lists (like the range index in a TextRangeSet) are still plain ints.
+#ifdef EDBEE_64BIT_OFFSETS
+typedef qint64 TextOffset;
+#else
+typedef int TextOffset;
+#endif
+
+} // edbee
@@ -8,6 +8,8 @@
 #include <QChar>
 #include <QString>
 
+#include "edbee/textoffset.h"
+
 //#define GAP_VECTOR_CLEAR_GAP
 
 namespace edbee {
@@ -15,15 +17,27 @@ namespace edbee {
 
 /// This class is used to define a gap vector. A Gapvector is split in 2 parts. where the gap
 /// is moved to the insertation/changing point. So reducing the movement of fields
+///
+/// When the gap is too small the vector grows with at least growSize items. The growSize doubles until it's at least
+/// capacity / growDivisor (and at most maxGrowSize), so the number of reallocations stays small for large vectors.
+/// After a large deletion the unused memory is released when the capacity is at least the releaseThreshold
+/// and less than a quarter of the capacity is used.
 template <typename T>
 class EDBEE_EXPORT GapVector {
 public:
-    GapVector( int capacity=16 ) : items_(nullptr), capacity_(0), gapBegin_(0), gapEnd_(0)  {
+    GapVector( TextOffset capacity=16 ) : items_(nullptr), capacity_(0), gapBegin_(0), gapEnd_(0)  {
         items_    = new T[capacity];
         capacity_ = capacity;
         gapBegin_ = 0;
         gapEnd_   = capacity;
         growSize_ = 16;
+        baseGrowSize_ = 16;
+        growDivisor_ = 6;
+        maxGrowSize_ = 0;
+        releaseThreshold_ = DefaultReleaseThreshold;
+        autoRelease_ = true;
+        highWaterMark_ = capacity;
+        reallocationCount_ = 0;
     }
 
     ~GapVector() {
@@ -31,11 +45,23 @@ public:
     }
 
     /// returns the used length of the data
-    inline int length() const { return capacity_ - gapEnd_ + gapBegin_; }
-    inline int gapSize() const { return gapEnd_ - gapBegin_; }
-    inline int gapBegin() const { return gapBegin_; }
-    inline int gapEnd() const { return gapEnd_; }
-    inline int capacity() const { return capacity_; }
+    inline TextOffset length() const { return capacity_ - gapEnd_ + gapBegin_; }
+    inline TextOffset gapSize() const { return gapEnd_ - gapBegin_; }
+    inline TextOffset gapBegin() const { return gapBegin_; }
+    inline TextOffset gapEnd() const { return gapEnd_; }
+    inline TextOffset capacity() const { return capacity_; }
+
+    /// returns the largest capacity this vector has had
+    inline TextOffset highWaterMark() const { return highWaterMark_; }
+
+    /// returns the number of times the items have been reallocated
+    inline int reallocationCount() const { return reallocationCount_; }
+
+    /// returns the number of bytes allocated for the items
+    inline qint64 memoryUsage() const { return static_cast<qint64>( capacity_ ) * static_cast<qint64>( sizeof(T) ); }
+
+    /// The default capacity from which unused memory is released after a deletion
+    static const TextOffset DefaultReleaseThreshold = 1024 * 1024;
 
 
     /// clears the data
@@ -57,14 +83,14 @@ protected:
     /// @param offset the target to move the data to
     /// @param length the number of items to replace
     /// @param data the data pointer with the source data
-    void replace( int offset, int length, const T* data ) {
+    void replace( TextOffset offset, TextOffset length, const T* data ) {
         Q_ASSERT( 0 <= offset && offset <= this->length() );
         Q_ASSERT( length >= 0 );
         Q_ASSERT( offset + length <= capacity_ );
 
         // copy the first part
         if( offset < gapBegin() ) {
-            int len = qMin( gapBegin_-offset, length ); // issue 141, added -offset
+            TextOffset len = qMin( gapBegin_-offset, length ); // issue 141, added -offset
             memcpy( items_ + offset, data, sizeof(T)*static_cast<size_t>(len) );
             data      += len;   // increase the pointer
             offset    += len;
@@ -82,22 +108,22 @@ protected:
     /// @param offset the target to move the data to
     /// @param length the number of items to replace
     /// @param data the data pointer with the source data
-    void fill( int offset, int length, const T& data ) {
+    void fill( TextOffset offset, TextOffset length, const T& data ) {
         Q_ASSERT( 0 <= offset && offset <= this->length() );
         Q_ASSERT( length >= 0 );
         Q_ASSERT( offset + length <= capacity_ );
 
         // copy the first part
         if( offset < gapBegin() ) {
-            int len = qMin( gapBegin_-offset, length );
-            for( int i=0; i<len; ++i ) { items_ [offset + i] = data; }
+            TextOffset len = qMin( gapBegin_-offset, length );
+            for( TextOffset i=0; i<len; ++i ) { items_ [offset + i] = data; }
             offset    += len;
             length    -= len;
         }
 
         if( 0 < length ) {
             offset += gapSize();
-            for( int i=0; i<length; ++i ) { items_ [offset + i] = data; }
+            for( TextOffset i=0; i<length; ++i ) { items_ [offset + i] = data; }
         }
     }
 
@@ -109,15 +135,15 @@ public:
     /// @param length the number of items to replace
     /// @param data an array with new items
     /// @param newLength the number of items in the new array
-    void replace( int offset, int length, const T* data, int newLength ) {
-        int currentLength=this->length();
+    void replace( TextOffset offset, TextOffset length, const T* data, TextOffset newLength ) {
+        TextOffset currentLength=this->length();
         Q_ASSERT( 0 <= length );
         Q_ASSERT( 0 <= newLength );
         Q_ASSERT( 0 <= offset && ((offset+length) <= currentLength) );
         Q_ASSERT( offset + length <= capacity_ );
         Q_UNUSED( currentLength );
 
-        int gapSize = this->gapSize();
+        TextOffset gapSize = this->gapSize();
 
         // Is it a 'delete' or 'insert' or 'replace' operation
 
@@ -127,8 +153,8 @@ public:
 
         // insert operation
         } else if( length < newLength ) {
-            int gapSizeRequired = newLength - length;
-            ensureGapSize( gapSizeRequired );
+            TextOffset gapSizeRequired = newLength - length;
+            ensureGapSize( gapSizeRequired, offset + length );
             moveGapTo( offset + length );
             memcpy( items_ + offset, data, sizeof(T) * static_cast<size_t>(newLength) );
             gapBegin_ = offset + newLength;
@@ -139,6 +165,7 @@ public:
             memcpy( items_ + offset, data, sizeof(T) * static_cast<size_t>(newLength) );
             gapBegin_ = offset + newLength;
             gapEnd_   = offset + gapSize + length;
+            autoReleaseUnusedMemory();
         }
 
         Q_ASSERT( gapBegin_ <= gapEnd_ );
@@ -150,15 +177,15 @@ public:
     /// @param offset the offset of the items to replace
     /// @param lenth the number of items to replace
     /// @param newLength the number of times to repeat data
-    void fill( int offset, int length, const T& data, int newLength ) {
-        int currentLength=this->length();
+    void fill( TextOffset offset, TextOffset length, const T& data, TextOffset newLength ) {
+        TextOffset currentLength=this->length();
         Q_ASSERT( 0 <= length );
         Q_ASSERT( 0 <= newLength );
         Q_ASSERT( 0 <= offset && ((offset+length) <= currentLength) );
         Q_ASSERT( offset + length <= capacity_ );
         Q_UNUSED(currentLength);
 
-        int gapSize = this->gapSize();
+        TextOffset gapSize = this->gapSize();
 
         // Is it a 'delete' or 'insert' or 'replace' operation
 
@@ -168,18 +195,19 @@ public:
 
         // insert operation
         } else if( length < newLength ) {
-            int gapSizeRequired = newLength - length;
-            ensureGapSize( gapSizeRequired );
+            TextOffset gapSizeRequired = newLength - length;
+            ensureGapSize( gapSizeRequired, offset + length );
             moveGapTo( offset + length );
-            for( int i=0; i<newLength; ++i ) { items_[offset+i] = data; }
+            for( TextOffset i=0; i<newLength; ++i ) { items_[offset+i] = data; }
             gapBegin_ = offset + newLength;
 
         // delete operation
         } else {
             moveGapTo( offset );
-            for( int i=0; i<newLength; ++i ) { items_[offset+i] = data; }
+            for( TextOffset i=0; i<newLength; ++i ) { items_[offset+i] = data; }
             gapBegin_ = offset + newLength;
             gapEnd_   = offset + gapSize + length;
+            autoReleaseUnusedMemory();
         }
 
         Q_ASSERT( gapBegin_ <= gapEnd_ );
@@ -193,13 +221,35 @@ public:
     }
 
     /// another append method
-    void append( const T* t, int length ) {
+    void append( const T* t, TextOffset length ) {
         replace( this->length(), 0, t, length );
     }
 
+    /// Appends the given number of uninitialized items and returns a pointer to the first appended item.
+    /// The caller should fill the items. The pointer is only valid until the vector is changed
+    T* appendUninitialized( TextOffset length ) {
+        Q_ASSERT( 0 <= length );
+        ensureGapSize( length, this->length() );
+        moveGapTo( this->length() );
+        T* result = items_ + gapBegin_;
+        gapBegin_ += length;
+        Q_ASSERT( gapBegin_ <= gapEnd_ );
+        return result;
+    }
+
+
+    /// Removes all items after the given length. The memory isn't released, so this can be used to give back
+    /// the unused part of appendUninitialized
+    /// @param length the new length of the vector
+    void truncate( TextOffset length ) {
+        Q_ASSERT( 0 <= length && length <= this->length() );
+        moveGapTo( this->length() );
+        gapBegin_ = length;
+    }
+
 
     /// This method returns the item at the given index
-    T at( int offset ) const {
+    T at( TextOffset offset ) const {
         Q_ASSERT( 0 <= offset && offset < length() );
         if( offset < gapBegin_ ) {
             return items_[offset];
@@ -209,7 +259,7 @@ public:
     }
 
     /// This method sets an item at the given index
-    void set( int offset, const T& value ) {
+    void set( TextOffset offset, const T& value ) {
         Q_ASSERT( 0 <= offset && offset < length() );
         if( offset < gapBegin_ ) {
             items_[offset] = value;
@@ -220,7 +270,7 @@ public:
 
 
     /// This method return an index
-    T& operator[]( int offset ) {
+    T& operator[]( TextOffset offset ) {
         Q_ASSERT( 0 <= offset && offset < length() );
         if( offset < gapBegin_ ) {
             return items_[offset];
@@ -231,21 +281,21 @@ public:
 
     /// This method returns the 'raw' element at the given location
     /// This method does NOT take in account the gap
-    T& rawAt( int index ) {
+    T& rawAt( TextOffset index ) {
         Q_ASSERT(0 <= index && index < capacity_);
         return items_[index];
     }
 
 
     /// This method copies the given range to the data pointer
-    void copyRange( QChar* data, int offset, int length ) const {
+    void copyRange( QChar* data, TextOffset offset, TextOffset length ) const {
         if( length <= 0 ) { return; }
         Q_ASSERT( 0 <= offset && offset < this->length() );
         Q_ASSERT( (offset+length) <= this->length() );
 
         // copy the first part
         if( offset < gapBegin() ) {
-            int len = qMin( gapBegin_-offset, length );
+            TextOffset len = qMin( gapBegin_-offset, length );
             memcpy( data, items_ + offset, sizeof(T)*static_cast<size_t>(len) );
             data      += len;   // increase the pointer
             offset    += len;
@@ -258,11 +308,34 @@ public:
     }
 
 
+    /// Returns a pointer to the contiguous block of items that contains the given offset.
+    /// A gapvector consists of at most 2 blocks: the items before the gap and the items after the gap.
+    /// This method does NOT move the gap, so it can be used for read-only access without changing the layout
+    /// @param offset the offset to retrieve the block for (0 <= offset <= length)
+    /// @param spanStart (out) the offset of the first item of the returned block
+    /// @param spanLength (out) the number of items in the returned block
+    /// @return the pointer to the first item of the block
+    const T* spanAt( TextOffset offset, TextOffset& spanStart, TextOffset& spanLength ) const {
+        Q_ASSERT( 0 <= offset && offset <= length() );
+
+        // the gap is at the end, all items are before the gap
+        if( offset < gapBegin_ || gapEnd_ == capacity_ ) {
+            spanStart  = 0;
+            spanLength = gapBegin_;
+            return items_;
+        }
+        spanStart  = gapBegin_;
+        spanLength = length() - gapBegin_;
+        return items_ + gapEnd_;
+    }
+
+
     /// This method returns a direct pointer to the 0-terminated buffer
     /// This pointer is only valid as long as the buffer doesn't change
     /// WARNING, this method MOVES the gap! Which means this method should NOT be used for a lot of operations
+    /// For read-only access use spanAt, which never moves the gap
     T* data() {
-        ensureGapSize(1);
+        ensureGapSize( 1, length() );
         moveGapTo( length() );
         items_[length()] = QChar(); // a \0 character
         return items_;
@@ -271,11 +344,11 @@ public:
 
     //// moves the gap to the given position
     //// Warning when the gap is moved after the length the gap shrinks
-    void moveGapTo( int offset ) {
+    void moveGapTo( TextOffset offset ) {
         Q_ASSERT( 0 <= offset && offset <= capacity_);
         Q_ASSERT( offset <= length() );
         if( offset != gapBegin_ ) {
-            int gapSize = this->gapSize();
+            TextOffset gapSize = this->gapSize();
 
             // move the the data right after the gap
             if (offset < gapBegin_ ) {
@@ -296,61 +369,101 @@ public:
     }
 
     /// this method makes sure there's enough room for the insertation
-    void ensureGapSize( int requiredSize ) {
+    /// @param requiredSize the minimal size of the gap
+    /// @param gapOffset the offset to place the gap at when the vector grows (-1 places the gap at the end)
+    void ensureGapSize( TextOffset requiredSize, TextOffset gapOffset=-1 ) {
         Q_ASSERT(0 <= requiredSize );
         if( gapSize() < requiredSize ) {
-            while( growSize_ < capacity_ / 6) { growSize_ *= 2; }
-            resize(capacity_ + requiredSize + growSize_ - gapSize() );
+            while( growSize_ < capacity_ / growDivisor_ && ( maxGrowSize_ <= 0 || growSize_ < maxGrowSize_ ) ) { growSize_ *= 2; }
+            TextOffset growSize = maxGrowSize_ > 0 ? qMin( growSize_, maxGrowSize_ ) : growSize_;
+            reallocate( capacity_ + requiredSize + growSize - gapSize(), gapOffset < 0 ? length() : gapOffset );
         }
     }
 
 
-    /// resizes the array of data
-    void resize(int newSize)
+    /// resizes the array of data. The vector never shrinks with this method, and the gap is placed at the end
+    void resize(TextOffset newSize)
     {
         if( capacity_ >= newSize) return;
         Q_ASSERT( 0 <= newSize );
+        reallocate( newSize, length() );
+    }
 
-        int lengte = length();
-        Q_ASSERT( lengte <= capacity_);
-/// TODO: optimize, so data is moved only once
-/// in other words, gap movement is not required over here!!
-/// this can be done with 2 memcopies
-//qlog_info() << "BEGIN resize: capacity =" << capacity_<< " => " << newSize;
 
-        moveGapTo( lengte );
-        T *newChars = new T[ newSize ];
+    /// Releases all unused memory, so the capacity equals the length (and the gap is empty)
+    void squeeze()
+    {
+        if( capacity_ == length() ) return;
+        reallocate( length(), gapBegin_ );
+        growSize_ = baseGrowSize_;
+    }
 
-        if( capacity_ > 0 ) {
-            memmove( newChars, items_, sizeof(T)*lengte );
-            delete[] items_;
-        }
-        items_ = newChars;
-        capacity_ = newSize;
-        gapEnd_   = newSize;
 
-        // DEBUG gapsize
-#ifdef GAP_VECTOR_CLEAR_GAP
-        memset( items_+gapBegin_, 0, sizeof(T)*(gapEnd_-gapBegin_));
-#endif
+    /// Swaps the items of this vector with the items of the given vector, without copying the items.
+    /// The growth/release settings of both vectors aren't swapped
+    void swap( GapVector<T>& other )
+    {
+        qSwap( items_, other.items_ );
+        qSwap( capacity_, other.capacity_ );
+        qSwap( gapBegin_, other.gapBegin_ );
+        qSwap( gapEnd_, other.gapEnd_ );
+        qSwap( growSize_, other.growSize_ );
+        qSwap( highWaterMark_, other.highWaterMark_ );
+        qSwap( reallocationCount_, other.reallocationCount_ );
     }
 
 
     /// sets the growsize. The growsize if the amount to reserve extra
-    void setGrowSize( int size ) { growSize_=size; }
+    void setGrowSize( TextOffset size ) { growSize_=size; baseGrowSize_=size; }
 
     /// returns the growsize
-    int growSize() { return growSize_; }
+    TextOffset growSize() { return growSize_; }
+
+    /// Sets the growth divisor. When the vector grows, the growsize is doubled until it's at least capacity / divisor
+    void setGrowDivisor( int divisor ) { Q_ASSERT( divisor > 0 ); growDivisor_ = divisor; }
+
+    /// returns the growth divisor
+    int growDivisor() const { return growDivisor_; }
+
+    /// Sets the maximum number of extra items that are reserved when the vector grows (0 means unlimited)
+    void setMaxGrowSize( TextOffset size ) { maxGrowSize_ = size; }
+
+    /// returns the maximum growsize (0 means unlimited)
+    TextOffset maxGrowSize() const { return maxGrowSize_; }
+
+    /// Sets the capacity from which unused memory is released after a deletion (0 disables releasing memory)
+    void setReleaseThreshold( TextOffset threshold ) { releaseThreshold_ = threshold; }
+
+    /// returns the capacity from which unused memory is released after a deletion
+    TextOffset releaseThreshold() const { return releaseThreshold_; }
+
+    /// Enables releasing the unused memory directly after a deletion. When disabled the owner of the vector
+    /// calls releaseUnusedMemory itself, for example when nobody refers to the items anymore
+    void setAutoReleaseEnabled( bool enabled ) { autoRelease_ = enabled; }
+
+    /// returns true if unused memory is released directly after a deletion
+    bool isAutoReleaseEnabled() const { return autoRelease_; }
+
+
+    /// Releases the unused memory after a large deletion. This happens when the capacity is at least the
+    /// release threshold and less than a quarter of it is used. The gap keeps the size of the remaining items,
+    /// so the vector doesn't need to grow directly again
+    void releaseUnusedMemory()
+    {
+        if( releaseThreshold_ <= 0 || capacity_ < releaseThreshold_ || length() >= capacity_ / 4 ) { return; }
+        reallocate( qMax( length() * 2, baseGrowSize_ ), gapBegin_ );
+        growSize_ = baseGrowSize_;
+    }
 
 
     /// Converts the 'gap-buffer' to a unit-test debugging string
     QString getUnitTestString( QChar gapChar = '_' ) const {
         QString s;
-        int gapBegin = this->gapBegin();
-        int gapEnd   = this->gapEnd();
-        int capacity = this->capacity();
+        TextOffset gapBegin = this->gapBegin();
+        TextOffset gapEnd   = this->gapEnd();
+        TextOffset capacity = this->capacity();
 
-        for( int i=0; i<gapBegin; ++i ) {
+        for( TextOffset i=0; i<gapBegin; ++i ) {
             if( items_[i].isNull() ) {
                 s.append("@");
             } else {
@@ -358,11 +471,11 @@ public:
             }
         }
         s.append( "[" );
-        for( int i=gapBegin; i<gapEnd; ++i ) {
+        for( TextOffset i=gapBegin; i<gapEnd; ++i ) {
             s.append( gapChar );
         }
         s.append( ">" );
-        for( int i=gapEnd; i<capacity; ++i ) {
+        for( TextOffset i=gapEnd; i<capacity; ++i ) {
             if( items_[i].isNull() ) {
                 s.append("@");
             } else {
@@ -376,11 +489,11 @@ public:
     /// Converts the 'gap-buffer' to a unit-test debugging string
     QString getUnitTestString2( ) const {
         QString s;
-        int gapBegin = this->gapBegin();
-        int gapEnd   = this->gapEnd();
-        int capacity = this->capacity();
+        TextOffset gapBegin = this->gapBegin();
+        TextOffset gapEnd   = this->gapEnd();
+        TextOffset capacity = this->capacity();
 
-        for( int i=0; i<capacity;i++ ) {
+        for( TextOffset i=0; i<capacity;i++ ) {
             if( i ) { s.append(","); }
             if( gapEnd == i) s.append(">");
             s.append( QStringLiteral("%1").arg( "X" ));
@@ -395,11 +508,148 @@ public:
 
 protected:
 
-    T *items_;              ///< The item data
-    int capacity_;          ///< The number of reserved bytes
-    int gapBegin_;          ///< The start of the gap
-    int gapEnd_;            ///< The end of the gap
-    int growSize_;          ///< The size to grow extra
+    /// Moves the items to a new array with the given capacity. The items are moved only once, directly
+    /// to their new location, so the gap is placed at the given offset without moving it first.
+    /// @param newCapacity the new capacity (at least the length)
+    /// @param gapOffset the offset of the gap in the new array
+    void reallocate( TextOffset newCapacity, TextOffset gapOffset )
+    {
+        TextOffset length = this->length();
+        Q_ASSERT( length <= newCapacity );
+        Q_ASSERT( 0 <= gapOffset && gapOffset <= length );
+
+        T* newItems = new T[ newCapacity ];
+        TextOffset newGapEnd = newCapacity - ( length - gapOffset );
+        copyItems( newItems, 0, gapOffset );
+        copyItems( newItems + newGapEnd, gapOffset, length - gapOffset );
+        delete[] items_;
+
+        items_    = newItems;
+        capacity_ = newCapacity;
+        gapBegin_ = gapOffset;
+        gapEnd_   = newGapEnd;
+        highWaterMark_ = qMax( highWaterMark_, newCapacity );
+        ++reallocationCount_;
+
+#ifdef GAP_VECTOR_CLEAR_GAP
+        memset( items_+gapBegin_, 0, sizeof(T)*(gapEnd_-gapBegin_));
+#endif
+    }
+
+
+    /// Copies the given items to the target (the items before and after the gap are copied with a single memcpy each)
+    void copyItems( T* target, TextOffset offset, TextOffset length ) const
+    {
+        if( offset < gapBegin_ ) {
+            TextOffset len = qMin( gapBegin_ - offset, length );
+            memcpy( target, items_ + offset, sizeof(T) * static_cast<size_t>(len) );
+            target += len;
+            offset += len;
+            length -= len;
+        }
+        if( length > 0 ) {
+            memcpy( target, items_ + offset + gapSize(), sizeof(T) * static_cast<size_t>(length) );
+        }
+    }
+
+
+    /// Releases the unused memory after a deletion, when auto release is enabled
+    void autoReleaseUnusedMemory()
+    {
+        if( autoRelease_ ) { releaseUnusedMemory(); }
+    }
+
+
+    T *items_;                  ///< The item data
+    TextOffset capacity_;       ///< The number of reserved bytes
+    TextOffset gapBegin_;       ///< The start of the gap
+    TextOffset gapEnd_;         ///< The end of the gap
+    TextOffset growSize_;       ///< The size to grow extra
+    TextOffset baseGrowSize_;   ///< The configured growsize (the growsize is reset to this value when memory is released)
+    int growDivisor_;           ///< The growsize is doubled until it's at least capacity / growDivisor
+    TextOffset maxGrowSize_;    ///< The maximum growsize (0 is unlimited)
+    TextOffset releaseThreshold_;   ///< The minimal capacity for releasing unused memory after a deletion (0 is never)
+    bool autoRelease_;          ///< Release the unused memory directly after a deletion?
+    TextOffset highWaterMark_;  ///< The largest capacity
+    int reallocationCount_;     ///< The number of reallocations
+};
+
+
+/// A character vector that stores every character in a single byte (Latin-1).
+/// It can only contain characters below U+0100, use fits to check this before inserting characters.
+class Latin1GapVector : public GapVector<char>
+{
+public:
+
+    Latin1GapVector( TextOffset size=16 ) : GapVector<char>(size){}
+
+    /// Returns true if all given characters can be stored in a Latin-1 vector
+    static bool fits( const QChar* data, TextOffset length )
+    {
+        for( const QChar* c = data, *end = data + length; c < end; ++c ) {
+            if( c->unicode() > 0xFF ) { return false; }
+        }
+        return true;
+    }
+
+    /// Replaces the given characters with the given (Latin-1 compatible) characters
+    /// @param offset the offset of the characters to replace
+    /// @param length the number of characters to replace
+    /// @param data the new characters
+    /// @param newLength the number of new characters
+    void replace( TextOffset offset, TextOffset length, const QChar* data, TextOffset newLength ) {
+        Q_ASSERT( 0 <= offset && 0 <= length && (offset+length) <= this->length() );
+        Q_ASSERT( 0 <= newLength );
+        Q_ASSERT( fits( data, newLength ) );
+
+        // move the gap behind the replaced characters and add them to the gap
+        if( length < newLength ) { ensureGapSize( newLength - length, offset + length ); }
+        moveGapTo( offset + length );
+        gapBegin_ = offset;
+
+        // convert the new characters directly into the gap
+        char* target = items_ + offset;
+        for( TextOffset i=0; i < newLength; ++i ) { target[i] = static_cast<char>( data[i].unicode() ); }
+        gapBegin_ = offset + newLength;
+        if( newLength < length ) { autoReleaseUnusedMemory(); }
+    }
+
+    /// appends the given characters
+    void append( const QChar* data, TextOffset length ) {
+        replace( this->length(), 0, data, length );
+    }
+
+    /// Returns the character at the given offset
+    QChar charAt( TextOffset offset ) const {
+        return QChar( QLatin1Char( at( offset ) ) );
+    }
+
+    /// Copies the given range to the (UTF-16) data pointer
+    void copyRange( QChar* data, TextOffset offset, TextOffset length ) const {
+        if( length <= 0 ) { return; }
+        Q_ASSERT( 0 <= offset && offset < this->length() );
+        Q_ASSERT( (offset+length) <= this->length() );
+
+        while( length > 0 ) {
+            TextOffset spanStart = 0, spanLength = 0;
+            const char* span = spanAt( offset, spanStart, spanLength );
+            TextOffset len = qMin( spanStart + spanLength - offset, length );
+            const uchar* source = reinterpret_cast<const uchar*>( span + ( offset - spanStart ) );
+            for( TextOffset i=0; i < len; ++i ) { data[i] = QChar( static_cast<ushort>( source[i] ) ); }
+            data   += len;
+            offset += len;
+            length -= len;
+        }
+    }
+
+    /// a convenient method to retrieve a QString part
+    QString mid( TextOffset offset, TextOffset length ) const
+    {
+        Q_ASSERT( length >= 0 );
+        QString str( static_cast<int>( length ), Qt::Uninitialized );
+        copyRange( str.data(), offset, length );
+        return str;
+    }
 };
 
 
@@ -408,10 +658,10 @@ class EDBEE_EXPORT QCharGapVector : public GapVector<QChar>
 {
 public:
 
-    QCharGapVector( int size=16 ) : GapVector<QChar>(size){}
+    QCharGapVector( TextOffset size=16 ) : GapVector<QChar>(size){}
 
     /// initializes the vector with a given string
-    QCharGapVector( const QString& data, int gapSize ) : GapVector<QChar>( data.length() + gapSize )
+    QCharGapVector( const QString& data, TextOffset gapSize ) : GapVector<QChar>( data.length() + gapSize )
     {
         memcpy( items_, data.constData(), sizeof(QChar)*static_cast<size_t>(data.length()) );
         gapBegin_ = data.length();
@@ -420,19 +670,33 @@ public:
 
 
     /// Initializes the gapvector
-    void init( const QString& data, int gapSize )
+    void init( const QString& data, TextOffset gapSize )
     {
-        delete items_;
+        delete[] items_;
         capacity_ = data.length() + gapSize;
         items_ = new QChar[capacity_];
         memcpy( items_, data.constData(), sizeof(QChar)*static_cast<size_t>(data.length()) );
         gapBegin_ = data.length();
         gapEnd_ = capacity_;
         growSize_ = 16;
+        highWaterMark_ = qMax( highWaterMark_, capacity_ );
+    }
+
+    /// Initializes the gapvector with the content of a Latin-1 vector
+    void init( const Latin1GapVector& data, TextOffset gapSize )
+    {
+        delete[] items_;
+        capacity_ = data.length() + gapSize;
+        items_ = new QChar[capacity_];
+        data.copyRange( items_, 0, data.length() );
+        gapBegin_ = data.length();
+        gapEnd_ = capacity_;
+        growSize_ = 16;
+        highWaterMark_ = qMax( highWaterMark_, capacity_ );
     }
 
     /// a convenient string replace function
-    void replaceString( int offset, int length, const QString& data ) {
+    void replaceString( TextOffset offset, TextOffset length, const QString& data ) {
 
 //        qlog_info() << "replace(" << offset << length << data << ") : " << getUnitTestString().replace("\n","|");
 
@@ -442,17 +706,12 @@ public:
     }
 
     /// a convenient method to retrieve a QString part
-    QString mid( int offset, int length ) const
+    QString mid( TextOffset offset, TextOffset length ) const
     {
         Q_ASSERT( length >= 0 );
 
-//        QString str( length, QChar() );
-//        this->copyRange( str.data(), offset, length );
-
-        QChar* data = new QChar[length];
-        copyRange( data, offset, length );
-        QString str( data, length );
-        delete[] data;
+        QString str( length, Qt::Uninitialized );
+        copyRange( str.data(), offset, length );
 
 //qlog_info() << "mid(" << offset << "," << length << ") => " << str.replace("\n","|")  << "  // " << getUnitTestString().replace("\n","|");
         return str;
@@ -466,7 +725,7 @@ public:
 template <typename T>
 class EDBEE_EXPORT NoGapVector {
 public:
-    NoGapVector( int capacity=16 ) {
+    NoGapVector( TextOffset capacity=16 ) {
         Q_UNUSED(capacity);
     }
 
@@ -474,11 +733,11 @@ public:
     }
 
     /// returns the used length of the data
-    inline int length() const { return items_.size(); }
-    inline int gapSize() const { return 0; }
-    inline int gapBegin() const { return 0; }
-    inline int gapEnd() const { return 0; }
-    inline int capacity() const { return items_.capacity(); }
+    inline TextOffset length() const { return items_.size(); }
+    inline TextOffset gapSize() const { return 0; }
+    inline TextOffset gapBegin() const { return 0; }
+    inline TextOffset gapEnd() const { return 0; }
+    inline TextOffset capacity() const { return items_.capacity(); }
 
 
     /// clears the data
@@ -497,9 +756,9 @@ public:
     /// @param lenth the number of items to replace
     /// @param data an array with new items
     /// @param newLength the number of items in the new array
-    void replace( int offset, int length, const T* data, int newLength ) {
+    void replace( TextOffset offset, TextOffset length, const T* data, TextOffset newLength ) {
         items_.remove(offset,length);
-        for( int i=0; i < newLength; i++ ) {
+        for( TextOffset i=0; i < newLength; i++ ) {
             items_.insert(offset+i,data[i]);
         }
     }
@@ -508,9 +767,9 @@ public:
     /// @param offset the offset of the items to replace
     /// @param lenth the number of items to replace
     /// @param newLength the number of times to repeat data
-    void fill( int offset, int length, const T& data, int newLength ) {
+    void fill( TextOffset offset, TextOffset length, const T& data, TextOffset newLength ) {
         items_.remove(offset,length);
-        for( int i=0; i < newLength; i++ ) {
+        for( TextOffset i=0; i < newLength; i++ ) {
             items_.insert(offset+i,data);
         }
 
@@ -522,26 +781,26 @@ public:
     }
 
     /// another append method
-    void append( const T* t, int length ) {
-        for( int i=0; i < length; i++ ) {
+    void append( const T* t, TextOffset length ) {
+        for( TextOffset i=0; i < length; i++ ) {
             items_.append(t[i]);
         }
     }
 
 
     /// This method returns the item at the given index
-    T at( int offset ) const {
+    T at( TextOffset offset ) const {
         return items_.at(offset);
     }
 
     /// This method sets an item at the given index
-    void set( int offset, const T& value ) {
+    void set( TextOffset offset, const T& value ) {
         items_.replace(offset,value);
     }
 
 
     /// This method return an index
-    T& operator[]( int offset ) {
+    T& operator[]( TextOffset offset ) {
         return items_[offset];
     }
 
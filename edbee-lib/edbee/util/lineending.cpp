@@ -4,6 +4,10 @@
 #include <QString>
 #include "lineending.h"
 
+#include <string.h>
+
+#include "edbee/util/newlinescanner.h"
+
 #include "edbee/debug.h"
 
 namespace edbee {
@@ -84,24 +88,22 @@ LineEnding *LineEnding::detect(const QString& str, LineEnding *unkown )
     int unixCount = 0;
     int winCount = 0;
 
-    for( int i=0, cnt=str.length(); i<cnt; i++ ) {
-
-        // retrieve the characters
-        QChar c1 = str.at(i);
-        QChar c2 = (i+1<cnt) ? str.at(i+1) : QChar(0);
+    // jump from line break to line break
+    const QChar* end = str.constData() + str.length();
+    for( const QChar* c = NewlineScanner::findLineBreak( str.constData(), end ); c < end; c = NewlineScanner::findLineBreak( c + 1, end ) ) {
 
         // detect the line-ending
-        if( c1 == '\r' ) {
-           if( c2 == '\n' ) {
+        if( *c == '\r' ) {
+           if( c + 1 < end && c[1] == '\n' ) {
                ++winCount;
-               ++i;
+               ++c;
                if( winCount >= endLoopWhenCountReaches ) break;
            } else  {
                ++macClassicCount;
                if( macClassicCount >= endLoopWhenCountReaches ) break;
            }
         }
-        else if( c1 == '\n') {
+        else {
             ++unixCount;
             if( unixCount >= endLoopWhenCountReaches ) break;
         }
@@ -113,4 +115,129 @@ LineEnding *LineEnding::detect(const QString& str, LineEnding *unkown )
 }
 
 
+
+//=====================================================
+
+
+/// Constructs empty statistics
+LineEndingStatistics::LineEndingStatistics()
+    : windowsLinesRecorded_(false)
+{
+    clear();
+}
+
+
+/// Resets all counts (the recording setting is kept)
+void LineEndingStatistics::clear()
+{
+    for( int i=0; i < LineEnding::TypeCount; ++i ) { counts_[i] = 0; }
+    windowsLines_.clear();
+}
+
+
+/// Returns the total number of line endings
+qint64 LineEndingStatistics::totalCount() const
+{
+    qint64 result = 0;
+    for( int i=0; i < LineEnding::TypeCount; ++i ) { result += counts_[i]; }
+    return result;
+}
+
+
+/// Returns the number of line endings that end a line of the normalized text (\n and \r\n).
+/// A Mac classic \r isn't a newline in the normalized text
+int LineEndingStatistics::newlineCount() const
+{
+    return static_cast<int>( counts_[LineEnding::UnixType] + counts_[LineEnding::WindowsType] );
+}
+
+
+/// Returns true if the text contains more than one type of line ending
+bool LineEndingStatistics::isMixed() const
+{
+    int types = 0;
+    for( int i=0; i < LineEnding::TypeCount; ++i ) {
+        if( counts_[i] > 0 ) { ++types; }
+    }
+    return types > 1;
+}
+
+
+/// Returns the most common line ending. With equal counts the same choice is made as LineEnding::detect.
+/// @param unknownEnding the line ending to return when the text doesn't contain line endings
+LineEnding* LineEndingStatistics::mostCommon(LineEnding* unknownEnding) const
+{
+    qint64 unixCount = counts_[LineEnding::UnixType];
+    qint64 winCount = counts_[LineEnding::WindowsType];
+    qint64 macClassicCount = counts_[LineEnding::MacClassicType];
+    if( macClassicCount > unixCount && macClassicCount > winCount ) return LineEnding::get( LineEnding::MacClassicType );
+    if( winCount > unixCount ) return LineEnding::get( LineEnding::WindowsType );
+    if( unixCount > 0 ) return LineEnding::get( LineEnding::UnixType );
+    return unknownEnding;
+}
+
+
+/// Releases the recorded lines (the counts are kept)
+void LineEndingStatistics::clearWindowsLines()
+{
+    windowsLines_ = QVector<int>();
+}
+
+
+/// Counts a single line ending, which ends the current line
+/// @param type the type of the line ending
+void LineEndingStatistics::addLineEnding(LineEnding::Type type)
+{
+    if( type == LineEnding::WindowsType && windowsLinesRecorded_ ) {
+        windowsLines_.append( newlineCount() );
+    }
+    ++counts_[type];
+}
+
+
+/// Adds the statistics of the text that follows the counted text (for example of the next block)
+/// @param other the statistics to add
+void LineEndingStatistics::append(const LineEndingStatistics& other)
+{
+    if( windowsLinesRecorded_ ) {
+        int lineBase = newlineCount();
+        windowsLines_.reserve( windowsLines_.size() + other.windowsLines_.size() );
+        for( int i=0, cnt=other.windowsLines_.size(); i < cnt; ++i ) {
+            windowsLines_.append( lineBase + other.windowsLines_.at(i) );
+        }
+    }
+    for( int i=0; i < LineEnding::TypeCount; ++i ) { counts_[i] += other.counts_[i]; }
+}
+
+
+/// Counts the line endings of the given text and removes the \r of the \r\n line endings in place.
+/// The text jumps from line break to line break with the vectorized NewlineScanner, the text is only moved
+/// after the first \r\n. A \r at the end of the text is counted as Mac classic line ending, so the caller
+/// should keep it when the text continues.
+/// @param begin the text to normalize
+/// @param end the end of the text
+/// @return the end of the normalized text
+QChar* LineEndingStatistics::normalize(QChar* begin, QChar* end)
+{
+    QChar* out = begin;
+    const QChar* runStart = begin;
+    for( const QChar* c = NewlineScanner::findLineBreak( begin, end ); c < end; c = NewlineScanner::findLineBreak( c + 1, end ) ) {
+        if( *c == '\n' ) {
+            addLineEnding( LineEnding::UnixType );
+        } else if( c + 1 < end && c[1] == '\n' ) {
+            addLineEnding( LineEnding::WindowsType );
+
+            // move the text before the \r, the \n starts the next run
+            if( out != runStart ) { memmove( out, runStart, ( c - runStart ) * sizeof(QChar) ); }
+            out += c - runStart;
+            runStart = ++c;
+        } else {
+            addLineEnding( LineEnding::MacClassicType );
+        }
+    }
+    if( out != runStart ) { memmove( out, runStart, ( end - runStart ) * sizeof(QChar) ); }
+    return out + ( end - runStart );
+}
+
+
 } // edbee
@@ -5,6 +5,10 @@
 
 #include "edbee/exports.h"
 
+#include <QVector>
+
+class QChar;
+
 namespace edbee {
 
 
@@ -63,5 +67,41 @@ private:
 };
 
 
+/// Counts the line endings of a (complete) text, for example while loading a file.
+///
+/// The counting happens in the same pass that normalizes the text: the \r of the \r\n line endings is
+/// removed in place. A \r without a \n (Mac classic) is kept, just like when loading a file.
+/// Optionally the lines that end with \r\n are recorded, so mixed line endings can be restored when saving.
+class EDBEE_EXPORT LineEndingStatistics {
+public:
+    LineEndingStatistics();
+
+    void clear();
+
+    void setWindowsLinesRecorded( bool enabled ) { windowsLinesRecorded_ = enabled; }
+    bool isWindowsLinesRecorded() const { return windowsLinesRecorded_; }
+
+    /// Returns the number of line endings of the given type
+    qint64 count( LineEnding::Type type ) const { return counts_[type]; }
+    qint64 totalCount() const;
+    int newlineCount() const;
+    bool isMixed() const;
+    LineEnding* mostCommon( LineEnding* unknownEnding=0 ) const;
+
+    /// Returns the lines that end with \r\n (only when recorded). The line numbers are relative to the counted text
+    const QVector<int>& windowsLines() const { return windowsLines_; }
+    void clearWindowsLines();
+
+    void addLineEnding( LineEnding::Type type );
+    void append( const LineEndingStatistics& other );
+    QChar* normalize( QChar* begin, QChar* end );
+
+private:
+    qint64 counts_[LineEnding::TypeCount];  ///< The number of line endings per type
+    bool windowsLinesRecorded_;             ///< Should the lines that end with \r\n be recorded?
+    QVector<int> windowsLines_;             ///< The lines that end with \r\n (when recorded)
+};
+
+
 
 } // edbee
@@ -0,0 +1,391 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "lineoffsettree.h"
+
+#include "edbee/models/textbuffer.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+const int LineOffsetTree::ChunkSize;
+
+
+/// A single node of the tree. Every node contains a chunk of line lengths
+/// and the aggregated information of the complete subtree
+struct LineOffsetTree::Node {
+    QVector<TextOffset> lengths;    ///< The lengths of the lines in this chunk (including the newline)
+    TextOffset chunkLength;         ///< The sum of the lengths in this chunk
+    quint32 priority;               ///< The treap priority. A node always has a higher (or equal) priority than its children
+    Node* left;                     ///< The left subtree (owned)
+    Node* right;                    ///< The right subtree (owned)
+    int totalCount;                 ///< The total number of lines in this subtree
+    TextOffset totalLength;         ///< The total length of all lines in this subtree
+};
+
+
+/// Constructs an empty tree, which contains a single line starting at offset 0
+LineOffsetTree::LineOffsetTree()
+    : root_(nullptr)
+    , priorities_(0x2545F491u)
+{
+}
+
+
+/// The destructor deletes all nodes
+LineOffsetTree::~LineOffsetTree()
+{
+    NodeTreap::deleteTree(root_);
+}
+
+
+/// Applies the given textbuffer change. The change should have been created before the text was changed
+/// (so the line information of the change is based on the old offsets)
+void LineOffsetTree::applyChange(const TextBufferChange& change)
+{
+    int line = change.line();
+    int lineCount = change.lineCount();
+    int count = root_ ? root_->totalCount : 0;
+
+    // a change inside a single line (like typing a character) only changes the length of that line
+    if( lineCount == 0 && change.newLineCount() == 0 ) {
+        if( line < count ) { adjustLength( line, change.newTextLength() - change.length() ); }
+        return;
+    }
+
+    // the line that contains the end of the replaced range keeps its tail. When it isn't the last line its length changes
+    TextOffset lineStart = at( line );
+    bool endLineComplete = line + lineCount < count;
+    TextOffset endLineEnd = endLineComplete ? at( line + lineCount + 1 ) : 0;
+
+    // calculate the new lengths of the changed lines
+    const TextOffset* newLineOffsets = change.newLineOffsetData();
+    QVector<TextOffset> lengths;
+    lengths.reserve( change.newLineCount() + 1 );
+    TextOffset previous = lineStart;
+    for( int i=0, cnt=change.newLineCount(); i < cnt; ++i ) {
+        lengths.append( newLineOffsets[i] - previous );
+        previous = newLineOffsets[i];
+    }
+    if( endLineComplete ) {
+        lengths.append( endLineEnd + change.newTextLength() - change.length() - previous );
+    }
+
+    replaceLengths( line, lineCount + ( endLineComplete ? 1 : 0 ), lengths );
+}
+
+
+/// Returns the offset of the start of the given line
+TextOffset LineOffsetTree::at(int idx) const
+{
+    Q_ASSERT( 0 <= idx && idx < length() );
+
+    TextOffset result = 0;
+    const Node* node = root_;
+    while( node ) {
+        int leftCount = node->left ? node->left->totalCount : 0;
+        if( idx < leftCount ) {
+            node = node->left;
+            continue;
+        }
+
+        idx -= leftCount;
+        result += node->left ? node->left->totalLength : 0;
+
+        // the line starts in (or directly after) this chunk
+        if( idx <= node->lengths.size() ) {
+            const TextOffset* lengths = node->lengths.constData();
+            for( int i=0; i < idx; ++i ) { result += lengths[i]; }
+            return result;
+        }
+
+        idx -= node->lengths.size();
+        result += node->chunkLength;
+        node = node->right;
+    }
+    return result;
+}
+
+
+/// Returns the number of lines
+int LineOffsetTree::length() const
+{
+    return ( root_ ? root_->totalCount : 0 ) + 1;
+}
+
+
+/// Returns the line that contains the given offset
+int LineOffsetTree::findLineFromOffset(TextOffset offset) const
+{
+    int result = 0;
+    const Node* node = root_;
+    while( node ) {
+        TextOffset leftLength = node->left ? node->left->totalLength : 0;
+        if( offset < leftLength ) {
+            node = node->left;
+            continue;
+        }
+
+        offset -= leftLength;
+        result += node->left ? node->left->totalCount : 0;
+
+        // skip the complete chunk
+        if( offset >= node->chunkLength ) {
+            offset -= node->chunkLength;
+            result += node->lengths.size();
+            node = node->right;
+            continue;
+        }
+
+        // the offset is inside this chunk
+        const TextOffset* lengths = node->lengths.constData();
+        for( int i=0, cnt=node->lengths.size(); i < cnt && offset >= lengths[i]; ++i ) {
+            offset -= lengths[i];
+            ++result;
+        }
+        return result;
+    }
+    return result;
+}
+
+
+/// Appends a line that starts at the given offset. The offset must be after the start of the last line
+void LineOffsetTree::appendOffset(TextOffset offset)
+{
+    TextOffset length = offset - ( root_ ? root_->totalLength : 0 );
+    Q_ASSERT( length >= 0 );
+
+    // when the last chunk has room the length is added to it, all nodes on the right spine contain this chunk
+    Node* last = root_;
+    while( last && last->right ) { last = last->right; }
+    if( last && last->lengths.size() < ChunkSize ) {
+        last->lengths.append( length );
+        last->chunkLength += length;
+        for( Node* node = root_; node; node = node->right ) {
+            node->totalCount += 1;
+            node->totalLength += length;
+        }
+        return;
+    }
+
+    QVector<TextOffset> lengths;
+    lengths.append( length );
+    root_ = NodeTreap::merge( root_, createNode( lengths, priorities_.next() ) );
+}
+
+
+/// Removes all lines, only line 0 remains
+void LineOffsetTree::clear()
+{
+    NodeTreap::deleteTree( root_ );
+    root_ = nullptr;
+}
+
+
+/// Returns the number of chunks (tree nodes)
+int LineOffsetTree::chunkCount() const
+{
+    return NodeTreap::nodeCount(root_);
+}
+
+
+/// Converts the line offsets to a comma separated string (for unit testing)
+QString LineOffsetTree::toUnitTestString() const
+{
+    QString s;
+    for( int i=0, cnt=length(); i < cnt; ++i ) {
+        if( i ) { s.append(","); }
+        s.append( QStringLiteral("%1").arg( at(i) ) );
+    }
+    return s;
+}
+
+
+/// Adds the given delta to the length of the given line, without changing the structure of the tree
+/// @param idx the index of the line length
+/// @param delta the value to add to the length
+void LineOffsetTree::adjustLength(int idx, TextOffset delta)
+{
+    Node* node = root_;
+    while( node ) {
+        node->totalLength += delta;
+
+        int leftCount = node->left ? node->left->totalCount : 0;
+        if( idx < leftCount ) {
+            node = node->left;
+            continue;
+        }
+
+        idx -= leftCount;
+        if( idx < node->lengths.size() ) {
+            node->lengths[idx] += delta;
+            node->chunkLength += delta;
+            return;
+        }
+
+        idx -= node->lengths.size();
+        node = node->right;
+    }
+    Q_ASSERT(false);
+}
+
+
+/// Creates a new tree node for the given chunk of line lengths
+/// @param lengths the line lengths
+/// @param priority the treap priority of the node
+LineOffsetTree::Node* LineOffsetTree::createNode(const QVector<TextOffset>& lengths, quint32 priority)
+{
+    Node* node = new Node();
+    node->lengths = lengths;
+    node->chunkLength = 0;
+    for( int i=0, cnt=lengths.size(); i < cnt; ++i ) { node->chunkLength += lengths.at(i); }
+    node->priority = priority;
+    node->left = nullptr;
+    node->right = nullptr;
+    update(node);
+    return node;
+}
+
+
+/// Recalculates the aggregated subtree values of the given node
+void LineOffsetTree::update(Node* node)
+{
+    node->totalCount  = node->lengths.size();
+    node->totalLength = node->chunkLength;
+    if( node->left ) {
+        node->totalCount  += node->left->totalCount;
+        node->totalLength += node->left->totalLength;
+    }
+    if( node->right ) {
+        node->totalCount  += node->right->totalCount;
+        node->totalLength += node->right->totalLength;
+    }
+}
+
+
+/// Splits the tree at the given line index. When the index is inside a chunk the chunk is split in 2 parts
+/// @param node the tree to split
+/// @param index the number of lines that should be placed in the left tree
+/// @param left (out) the tree with the first index lines
+/// @param right (out) the tree with the remaining lines
+void LineOffsetTree::split(Node* node, int index, Node*& left, Node*& right)
+{
+    if( !node ) {
+        left  = nullptr;
+        right = nullptr;
+        return;
+    }
+
+    int leftCount = node->left ? node->left->totalCount : 0;
+    int size = node->lengths.size();
+
+    if( index <= leftCount ) {
+        split( node->left, index, left, node->left );
+        update( node );
+        right = node;
+
+    } else if( index >= leftCount + size ) {
+        split( node->right, index - leftCount - size, node->right, right );
+        update( node );
+        left = node;
+
+    // the index is inside the chunk of this node
+    } else {
+        int pos = index - leftCount;
+        // the tail gets the same priority, so it can take the place of this node as root of the right subtree
+        Node* tail = createNode( node->lengths.mid(pos), node->priority );
+        tail->right = node->right;
+        update( tail );
+
+        node->lengths.resize(pos);
+        node->chunkLength -= tail->chunkLength;
+        node->right = nullptr;
+        update( node );
+
+        left  = node;
+        right = tail;
+    }
+}
+
+
+/// Removes the last chunk from the given tree
+/// @param tree (in/out) the tree to remove the last chunk from
+/// @return the node with the last chunk or 0 if the tree is empty
+LineOffsetTree::Node* LineOffsetTree::takeLastChunk(Node*& tree)
+{
+    if( !tree ) return nullptr;
+    const Node* last = NodeTreap::lastNode( tree );
+
+    Node* result = nullptr;
+    split( tree, tree->totalCount - last->lengths.size(), tree, result );
+    Q_ASSERT( result && !result->left && !result->right );
+    return result;
+}
+
+
+/// Removes the first chunk from the given tree
+/// @param tree (in/out) the tree to remove the first chunk from
+/// @return the node with the first chunk or 0 if the tree is empty
+LineOffsetTree::Node* LineOffsetTree::takeFirstChunk(Node*& tree)
+{
+    if( !tree ) return nullptr;
+    const Node* first = NodeTreap::firstNode( tree );
+
+    Node* result = nullptr;
+    split( tree, first->lengths.size(), result, tree );
+    Q_ASSERT( result && !result->left && !result->right );
+    return result;
+}
+
+
+/// Builds a tree with evenly sized chunks for the given line lengths
+/// @return the new tree (or 0 if there are no lengths)
+LineOffsetTree::Node* LineOffsetTree::buildChunks(const QVector<TextOffset>& lengths)
+{
+    int total = lengths.size();
+    if( total == 0 ) return nullptr;
+
+    int chunkCount = ( total + ChunkSize - 1 ) / ChunkSize;
+    int chunkLength = total / chunkCount;
+    int remainder = total % chunkCount;
+
+    Node* result = nullptr;
+    for( int i=0, pos=0; i < chunkCount; ++i ) {
+        int length = chunkLength + ( i < remainder ? 1 : 0 );
+        result = NodeTreap::merge( result, createNode( lengths.mid( pos, length ), priorities_.next() ) );
+        pos += length;
+    }
+    return result;
+}
+
+
+/// Replaces the given line lengths. The chunks around the change are rebuilt, so chunks never become too small
+/// @param index the index of the first length to replace
+/// @param count the number of lengths to replace
+/// @param lengths the new lengths
+void LineOffsetTree::replaceLengths(int index, int count, const QVector<TextOffset>& lengths)
+{
+    Node* left = nullptr;
+    Node* middle = nullptr;
+    Node* right = nullptr;
+    split( root_, index, left, right );
+    split( right, count, middle, right );
+    NodeTreap::deleteTree( middle );
+
+    Node* prefix = takeLastChunk( left );
+    Node* suffix = takeFirstChunk( right );
+
+    QVector<TextOffset> newLengths;
+    newLengths.reserve( ( prefix ? prefix->lengths.size() : 0 ) + lengths.size() + ( suffix ? suffix->lengths.size() : 0 ) );
+    if( prefix ) { newLengths += prefix->lengths; }
+    newLengths += lengths;
+    if( suffix ) { newLengths += suffix->lengths; }
+    delete prefix;
+    delete suffix;
+
+    root_ = NodeTreap::merge( NodeTreap::merge( left, buildChunks( newLengths ) ), right );
+}
+
+
+} // edbee
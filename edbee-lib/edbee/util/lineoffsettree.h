@@ -0,0 +1,73 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QString>
+#include <QVector>
+
+#include "edbee/textoffset.h"
+#include "edbee/util/treap.h"
+#include "edbee/util/xorshiftrandom.h"
+
+namespace edbee {
+
+class TextBufferChange;
+
+
+/// An alternative for the LineOffsetVector that stores the line lengths in a balanced tree.
+///
+/// The LineOffsetVector only has a single offset delta position. Edits that alternate between distant lines
+/// (like multi-caret edits spread over a large file) move this delta over all offsets in between.
+/// This tree makes applyChange, at and findLineFromOffset O(log n), independent of the location of the previous edit.
+///
+/// The tree is a treap (like the RopeTextBuffer) of chunks with the lengths of (at most ChunkSize) complete lines.
+/// Every node contains the aggregated line count and length of its subtree.
+/// The last line isn't stored, because it isn't terminated by a newline.
+class EDBEE_EXPORT LineOffsetTree {
+public:
+    LineOffsetTree();
+    ~LineOffsetTree();
+
+    void applyChange( const TextBufferChange& change );
+
+    TextOffset at( int idx ) const;
+    int length() const;
+
+    int findLineFromOffset( TextOffset offset ) const;
+
+    void appendOffset( TextOffset offset );
+    void clear();
+
+    int chunkCount() const;
+    QString toUnitTestString() const;
+
+    /// The maximum number of line lengths in a single chunk
+    static const int ChunkSize = 64;
+
+private:
+    struct Node;
+
+    Node* createNode( const QVector<TextOffset>& lengths, quint32 priority );
+
+    static void update( Node* node );
+    typedef Treap<Node, &LineOffsetTree::update> NodeTreap;
+
+    void split( Node* node, int index, Node*& left, Node*& right );
+    Node* takeLastChunk( Node*& tree );
+    Node* takeFirstChunk( Node*& tree );
+    Node* buildChunks( const QVector<TextOffset>& lengths );
+
+    void adjustLength( int idx, TextOffset delta );
+    void replaceLengths( int index, int count, const QVector<TextOffset>& lengths );
+
+private:
+    Node* root_;                    ///< The root node of the tree (0 when there's only a single line)
+    XorShiftRandom priorities_;     ///< The pseudo random number generator of the node priorities
+
+    Q_DISABLE_COPY(LineOffsetTree)
+};
+
+} // edbee
@@ -16,12 +16,12 @@ LineOffsetVector::LineOffsetVector()
     , offsetDeltaIndex_(0)
 {
     // make sure there's always line 0 in the buffer
-    int v=0;
+    TextOffset v=0;
     offsetList_.replace( 0, 0, &v, 1);
 }
 
 
-void LineOffsetVector::applyChange(TextBufferChange change)
+void LineOffsetVector::applyChange(const TextBufferChange& change)
 {
 //qlog_info() << "== [ applyChange ] =================";
 
@@ -41,7 +41,7 @@ void LineOffsetVector::applyChange(TextBufferChange change)
 
 //qlog_info() << "- before: " << toUnitTestString() ;
 //qlog_info() << "- offsetList_.replace(" << change.line() << "," << change.lineCount() << ": " << offsets << ")";
-    offsetList_.replace( line, change.lineCount(), change.newLineOffsets().constData(), change.newLineCount() );
+    offsetList_.replace( line, change.lineCount(), change.newLineOffsetData(), change.newLineCount() );
 //qlog_info() << "- after: " << toUnitTestString();
 
 
@@ -81,7 +81,7 @@ void LineOffsetVector::textReplaced(int offset, int length, const QChar *newData
 */
 
 /// this method returns the line offset at the given line offset
-int LineOffsetVector::at(int idx) const
+TextOffset LineOffsetVector::at(int idx) const
 {
     Q_ASSERT( idx < length() );
     if( idx >= offsetDeltaIndex_ ) {
@@ -92,17 +92,17 @@ int LineOffsetVector::at(int idx) const
 
 int LineOffsetVector::length() const
 {
-    return offsetList_.length();
+    return static_cast<int>( offsetList_.length() );
 }
 
 
 /// this method searches the line from the given offset
-int LineOffsetVector::findLineFromOffset(int offset)
+int LineOffsetVector::findLineFromOffset(TextOffset offset)
 {
 
     if( offset == 0 ) return 0;
-    int offsetListLength = offsetList_.length();
-    int offsetAtDelta = 0;
+    int offsetListLength = length();
+    TextOffset offsetAtDelta = 0;
     if( offsetDeltaIndex_ < offsetListLength ) {
         offsetAtDelta = offsetList_.at(offsetDeltaIndex_) + offsetDelta_;
     } else {
@@ -124,11 +124,46 @@ int LineOffsetVector::findLineFromOffset(int offset)
 
 /// This method appends an offset to the end of the list
 /// It simply applies the current offsetDelta because it will always be AFTER the current offsetDelta
-void LineOffsetVector::appendOffset(int offset)
+void LineOffsetVector::appendOffset(TextOffset offset)
 {
     this->offsetList_.append( offset - offsetDelta_ );
 }
 
+
+/// Removes all offsets, only line 0 remains
+void LineOffsetVector::clear()
+{
+    offsetList_.clear();
+    offsetDelta_ = 0;
+    offsetDeltaIndex_ = 0;
+    TextOffset v=0;
+    offsetList_.replace( 0, 0, &v, 1);
+}
+
+
+/// Swaps the offsets of this vector with the offsets of the given vector (without copying them)
+void LineOffsetVector::swap(LineOffsetVector& other)
+{
+    offsetList_.swap( other.offsetList_ );
+    qSwap( offsetDelta_, other.offsetDelta_ );
+    qSwap( offsetDeltaIndex_, other.offsetDeltaIndex_ );
+}
+
+
+/// Releases the unused memory of the offset list
+void LineOffsetVector::squeeze()
+{
+    offsetList_.squeeze();
+}
+
+
+/// Returns the number of bytes allocated for the offsets
+qint64 LineOffsetVector::memoryUsage() const
+{
+    return offsetList_.memoryUsage();
+}
+
+
 /// This method returns the offset to string
 QString LineOffsetVector::toUnitTestString()
 {
@@ -149,7 +184,7 @@ QString LineOffsetVector::toUnitTestString()
 /// @param offsetDelta the offsetDelta to use
 /// @param offsetDeltaIndex the offsetDeltaIndex to use
 /// @param a list of integer offsets. Close the list with -1 !!!
-void LineOffsetVector::initForUnitTesting(int offsetDelta, int offsetDeltaIndex, ... )
+void LineOffsetVector::initForUnitTesting(TextOffset offsetDelta, int offsetDeltaIndex, ... )
 {
     offsetDelta_ = offsetDelta;
     offsetDeltaIndex_ = offsetDeltaIndex;
@@ -170,7 +205,7 @@ void LineOffsetVector::initForUnitTesting(int offsetDelta, int offsetDeltaIndex,
 /// This method returns the line from the start position. This method uses
 /// a binary search. Warning this method uses RAW values from the offsetList it does NOT
 /// take in account the offsetDelta
-int LineOffsetVector::searchOffsetIgnoringOffsetDelta(int offset, int org_start, int org_end )
+int LineOffsetVector::searchOffsetIgnoringOffsetDelta(TextOffset offset, int org_start, int org_end )
 {
 //    const QList<int>& starts = lineOffsets_;
     // This search happens in binary below
@@ -190,7 +225,7 @@ int LineOffsetVector::searchOffsetIgnoringOffsetDelta(int offset, int org_start,
 
 
     int half = end;
-    int r = 0;
+    TextOffset r = 0;
     while( begin <= end  ) {
 
         // BINAIRY SEARCH:
@@ -230,7 +265,7 @@ void LineOffsetVector::moveDeltaToIndex(int index)
 
             // In this situation there are 2 solution.
             // (1) Make the delta 0 or (2) apply the 'negative index' to the items on the left
-            int length            = offsetList_.length();
+            int length            = this->length();
             int delta0cost        = length - offsetDeltaIndex_;
             int negativeDeltaCost = offsetDeltaIndex_ - index;
 
@@ -253,7 +288,7 @@ void LineOffsetVector::moveDeltaToIndex(int index)
 }
 
 /// This method moves the offset delta to the given location
-void LineOffsetVector::changeOffsetDelta(int index, int delta)
+void LineOffsetVector::changeOffsetDelta(int index, TextOffset delta)
 {
     // there are 3 situations.
     // (1) The delta is at the exact location of the previous delta
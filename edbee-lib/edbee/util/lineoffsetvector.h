@@ -37,36 +37,40 @@ public:
 
     LineOffsetVector();
 
-    void applyChange( TextBufferChange change );
+    void applyChange( const TextBufferChange& change );
 
-    int at( int idx ) const;
+    TextOffset at( int idx ) const;
     int length() const;
 
-    int findLineFromOffset( int offset );
+    int findLineFromOffset( TextOffset offset );
 
-    int offsetDelta() { return offsetDelta_; }
+    TextOffset offsetDelta() { return offsetDelta_; }
     int offsetDeltaIndex() { return offsetDeltaIndex_; }
 
-    void appendOffset( int offset );
+    void appendOffset( TextOffset offset );
+    void clear();
+    void squeeze();
+    void swap( LineOffsetVector& other );
+    qint64 memoryUsage() const;
 
     /// TODO: temporary method (remove)
-    GapVector<int> & offsetList() { return offsetList_; }
+    GapVector<TextOffset> & offsetList() { return offsetList_; }
 
 protected:
-    int searchOffsetIgnoringOffsetDelta(int offset, int org_start, int org_end );
+    int searchOffsetIgnoringOffsetDelta( TextOffset offset, int org_start, int org_end );
 
     void moveDeltaToIndex( int index );
-    void changeOffsetDelta( int index, int delta );
+    void changeOffsetDelta( int index, TextOffset delta );
 
 public:
     QString toUnitTestString();
-    void initForUnitTesting( int offsetDelta, int offsetDeltaIndex, ... );
+    void initForUnitTesting( TextOffset offsetDelta, int offsetDeltaIndex, ... );
 
 private:
 
-    GapVector<int> offsetList_;    ///< All offsets
-    int offsetDelta_;              ///< The offset delta at the given offset index
-    int offsetDeltaIndex_;         ///< The index that contains the offset delta
+    GapVector<TextOffset> offsetList_;    ///< All offsets
+    TextOffset offsetDelta_;              ///< The offset delta at the given offset index
+    int offsetDeltaIndex_;                ///< The index that contains the offset delta
 
 
 friend class LineOffsetVectorTest;
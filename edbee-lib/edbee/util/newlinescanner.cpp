@@ -0,0 +1,253 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "newlinescanner.h"
+
+#include <QtAlgorithms>
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// The functions of a single implementation. All functions work on UTF-16 code units
+struct NewlineScannerKernels {
+    /// Returns the first character that equals c1 or c2 (or end if not found)
+    const ushort* (*find)( const ushort* begin, const ushort* end, ushort c1, ushort c2 );
+    /// Counts the occurences of c
+    int (*count)( const ushort* begin, const ushort* end, ushort c );
+    /// Appends base + index of every occurence of c to offsets
+    void (*appendOffsets)( const ushort* begin, const ushort* end, ushort c, TextOffset base, QVector<TextOffset>& offsets );
+};
+
+
+//=============================================================================
+// Scalar implementation
+//=============================================================================
+
+static const ushort* scalarFind( const ushort* begin, const ushort* end, ushort c1, ushort c2 )
+{
+    for( const ushort* p = begin; p < end; ++p ) {
+        if( *p == c1 || *p == c2 ) { return p; }
+    }
+    return end;
+}
+
+
+static int scalarCount( const ushort* begin, const ushort* end, ushort c )
+{
+    int result = 0;
+    for( const ushort* p = begin; p < end; ++p ) {
+        if( *p == c ) { ++result; }
+    }
+    return result;
+}
+
+
+static void scalarAppendOffsets( const ushort* begin, const ushort* end, ushort c, TextOffset base, QVector<TextOffset>& offsets )
+{
+    for( const ushort* p = begin; p < end; ++p ) {
+        if( *p == c ) { offsets.append( base + ( p - begin ) ); }
+    }
+}
+
+
+static const NewlineScannerKernels scalarKernels = {
+    scalarFind, scalarCount, scalarAppendOffsets
+};
+
+
+//=============================================================================
+// SSE2 implementation (8 characters per step)
+//=============================================================================
+
+#ifdef EDBEE_SIMD_SSE2
+
+static const ushort* sse2Find( const ushort* begin, const ushort* end, ushort c1, ushort c2 )
+{
+    const __m128i needle1 = _mm_set1_epi16( static_cast<short>(c1) );
+    const __m128i needle2 = _mm_set1_epi16( static_cast<short>(c2) );
+    const ushort* p = begin;
+    for( ; end - p >= 8; p += 8 ) {
+        __m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+        __m128i match = _mm_or_si128( _mm_cmpeq_epi16( chars, needle1 ), _mm_cmpeq_epi16( chars, needle2 ) );
+        quint32 mask = static_cast<quint32>( _mm_movemask_epi8( match ) );
+        if( mask ) { return p + qCountTrailingZeroBits(mask) / 2; }
+    }
+    return scalarFind( p, end, c1, c2 );
+}
+
+
+static int sse2Count( const ushort* begin, const ushort* end, ushort c )
+{
+    const __m128i needle = _mm_set1_epi16( static_cast<short>(c) );
+    int result = 0;
+    const ushort* p = begin;
+    for( ; end - p >= 8; p += 8 ) {
+        __m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+        quint32 mask = static_cast<quint32>( _mm_movemask_epi8( _mm_cmpeq_epi16( chars, needle ) ) );
+        result += qPopulationCount(mask) / 2;       // every match sets 2 bits
+    }
+    return result + scalarCount( p, end, c );
+}
+
+
+static void sse2AppendOffsets( const ushort* begin, const ushort* end, ushort c, TextOffset base, QVector<TextOffset>& offsets )
+{
+    const __m128i needle = _mm_set1_epi16( static_cast<short>(c) );
+    const ushort* p = begin;
+    for( ; end - p >= 8; p += 8 ) {
+        __m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+        quint32 mask = static_cast<quint32>( _mm_movemask_epi8( _mm_cmpeq_epi16( chars, needle ) ) );
+        while( mask ) {
+            uint bit = qCountTrailingZeroBits(mask);
+            offsets.append( base + ( p - begin ) + bit / 2 );
+            mask &= ~( 3u << bit );
+        }
+    }
+    scalarAppendOffsets( p, end, c, base + ( p - begin ), offsets );
+}
+
+
+static const NewlineScannerKernels sse2Kernels = {
+    sse2Find, sse2Count, sse2AppendOffsets
+};
+
+#endif
+
+
+//=============================================================================
+// AVX2 implementation (16 characters per step)
+//=============================================================================
+
+#ifdef EDBEE_SIMD_AVX2
+
+EDBEE_TARGET_AVX2 static const ushort* avx2Find( const ushort* begin, const ushort* end, ushort c1, ushort c2 )
+{
+    const __m256i needle1 = _mm256_set1_epi16( static_cast<short>(c1) );
+    const __m256i needle2 = _mm256_set1_epi16( static_cast<short>(c2) );
+    const ushort* p = begin;
+    for( ; end - p >= 16; p += 16 ) {
+        __m256i chars = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) );
+        __m256i match = _mm256_or_si256( _mm256_cmpeq_epi16( chars, needle1 ), _mm256_cmpeq_epi16( chars, needle2 ) );
+        quint32 mask = static_cast<quint32>( _mm256_movemask_epi8( match ) );
+        if( mask ) { return p + qCountTrailingZeroBits(mask) / 2; }
+    }
+    return scalarFind( p, end, c1, c2 );
+}
+
+
+EDBEE_TARGET_AVX2 static int avx2Count( const ushort* begin, const ushort* end, ushort c )
+{
+    const __m256i needle = _mm256_set1_epi16( static_cast<short>(c) );
+    int result = 0;
+    const ushort* p = begin;
+    for( ; end - p >= 16; p += 16 ) {
+        __m256i chars = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) );
+        quint32 mask = static_cast<quint32>( _mm256_movemask_epi8( _mm256_cmpeq_epi16( chars, needle ) ) );
+        result += qPopulationCount(mask) / 2;       // every match sets 2 bits
+    }
+    return result + scalarCount( p, end, c );
+}
+
+
+EDBEE_TARGET_AVX2 static void avx2AppendOffsets( const ushort* begin, const ushort* end, ushort c, TextOffset base, QVector<TextOffset>& offsets )
+{
+    const __m256i needle = _mm256_set1_epi16( static_cast<short>(c) );
+    const ushort* p = begin;
+    for( ; end - p >= 16; p += 16 ) {
+        __m256i chars = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) );
+        quint32 mask = static_cast<quint32>( _mm256_movemask_epi8( _mm256_cmpeq_epi16( chars, needle ) ) );
+        while( mask ) {
+            uint bit = qCountTrailingZeroBits(mask);
+            offsets.append( base + ( p - begin ) + bit / 2 );
+            mask &= ~( 3u << bit );
+        }
+    }
+    scalarAppendOffsets( p, end, c, base + ( p - begin ), offsets );
+}
+
+
+static const NewlineScannerKernels avx2Kernels = {
+    avx2Find, avx2Count, avx2AppendOffsets
+};
+
+#endif
+
+
+//=============================================================================
+// Dispatching
+//=============================================================================
+
+/// The kernels of all implementations. The table is initialized on first use (thread-safe)
+static SimdKernelTable<NewlineScannerKernels>& kernelTable()
+{
+    static SimdKernelTable<NewlineScannerKernels> table( &scalarKernels, EDBEE_SSE2_KERNELS(sse2Kernels), EDBEE_AVX2_KERNELS(avx2Kernels) );
+    return table;
+}
+
+
+static inline const ushort* utf16( const QChar* c )
+{
+    return reinterpret_cast<const ushort*>(c);
+}
+
+
+/// Finds the first occurence of the given character
+/// @param begin the first character to search
+/// @param end the end of the range to search (exclusive)
+/// @param c the character to find
+/// @return the pointer to the character or end when it isn't found
+const QChar* NewlineScanner::find(const QChar* begin, const QChar* end, QChar c)
+{
+    return begin + ( kernelTable().active()->find( utf16(begin), utf16(end), c.unicode(), c.unicode() ) - utf16(begin) );
+}
+
+
+/// Finds the first line break character ('\n' or '\r')
+/// @param begin the first character to search
+/// @param end the end of the range to search (exclusive)
+/// @return the pointer to the line break or end when there isn't a line break
+const QChar* NewlineScanner::findLineBreak(const QChar* begin, const QChar* end)
+{
+    return begin + ( kernelTable().active()->find( utf16(begin), utf16(end), '\n', '\r' ) - utf16(begin) );
+}
+
+
+/// Counts the number of newlines ('\n') in the given data
+/// @param data the data to search
+/// @param length the number of characters
+int NewlineScanner::count(const QChar* data, TextOffset length)
+{
+    return kernelTable().active()->count( utf16(data), utf16(data) + length, '\n' );
+}
+
+
+/// Appends the offsets of all newlines ('\n') to the given vector
+/// @param data the data to search
+/// @param length the number of characters
+/// @param base the value that's added to the index of every newline
+/// @param offsets the vector that receives the offsets
+void NewlineScanner::appendOffsets(const QChar* data, TextOffset length, TextOffset base, QVector<TextOffset>& offsets)
+{
+    kernelTable().active()->appendOffsets( utf16(data), utf16(data) + length, '\n', base, offsets );
+}
+
+
+/// Returns the active implementation
+NewlineScanner::Implementation NewlineScanner::implementation()
+{
+    return kernelTable().implementation();
+}
+
+
+/// Changes the active implementation. This method isn't thread-safe, it's meant for testing and benchmarking
+/// @param implementation the implementation to use
+/// @return false if the implementation isn't supported (the active implementation isn't changed)
+bool NewlineScanner::setImplementation(Implementation implementation)
+{
+    return kernelTable().setImplementation( implementation );
+}
+
+
+} // edbee
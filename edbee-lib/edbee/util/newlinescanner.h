@@ -0,0 +1,36 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QChar>
+#include <QString>
+#include <QVector>
+
+#include "edbee/textoffset.h"
+#include "edbee/util/simdsupport.h"
+
+namespace edbee {
+
+
+/// Finds newlines (and other characters) in UTF-16 text.
+///
+/// Finding newlines is the hot path when large texts are inserted or loaded. This class contains
+/// vectorized (SSE2 and AVX2) implementations and a scalar fallback. The fastest implementation that's
+/// supported by the CPU is selected at runtime. On non-x86 platforms the scalar implementation is always used.
+///
+/// All methods are static and thread-safe (except setImplementation, which is meant for testing and benchmarking)
+class EDBEE_EXPORT NewlineScanner : public SimdSupport {
+public:
+    static const QChar* find( const QChar* begin, const QChar* end, QChar c );
+    static const QChar* findLineBreak( const QChar* begin, const QChar* end );
+    static int count( const QChar* data, TextOffset length );
+    static void appendOffsets( const QChar* data, TextOffset length, TextOffset base, QVector<TextOffset>& offsets );
+
+    static Implementation implementation();
+    static bool setImplementation( Implementation implementation );
+};
+
+} // edbee
@@ -0,0 +1,485 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "paralleltextdecoder.h"
+
+#include <QAtomicInt>
+#include <QChar>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QTextCodec>
+#include <QThread>
+#include <QThreadPool>
+
+#include <string.h>
+
+#include "edbee/util/textcodec.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// The shared state of a single pass. The workers share the ownership of the job, because a worker of the
+/// thread pool can be started after the pass is finished (it doesn't find any blocks to process then)
+struct ParallelTextDecoder::Job {
+    ParallelTextDecoder* decoder;        ///< The decoder
+    Pass pass;                           ///< The pass to run
+    int blockCount;                      ///< The number of blocks
+    QAtomicInt nextBlock;                ///< The next block to process
+    QSemaphore finished;                 ///< Released for every processed block
+};
+
+
+/// A worker of the thread pool, which processes blocks until all blocks are taken
+class ParallelTextDecoder::Worker : public QRunnable
+{
+public:
+    explicit Worker( const QSharedPointer<Job>& job ) : job_(job) {}
+
+    virtual void run()
+    {
+        processBlocks( job_.data() );
+    }
+
+    /// Processes the blocks of the given job, until all blocks are taken
+    static void processBlocks( Job* job )
+    {
+        for( int idx = job->nextBlock.fetchAndAddOrdered(1); idx < job->blockCount; idx = job->nextBlock.fetchAndAddOrdered(1) ) {
+            job->decoder->processBlock( idx, job->pass );
+            job->finished.release();
+        }
+    }
+
+private:
+    QSharedPointer<Job> job_;            ///< The job to process
+};
+
+
+//=============================================================================
+
+
+/// Returns true if the given 8 bytes contain the given byte
+static inline bool containsByte( quint64 word, uchar byte )
+{
+    quint64 x = word ^ ( Q_UINT64_C(0x0101010101010101) * byte );
+    return ( ( x - Q_UINT64_C(0x0101010101010101) ) & ~x & Q_UINT64_C(0x8080808080808080) ) != 0;
+}
+
+
+/// Returns true if the given 8 bytes don't contain a newline or carriage return
+static inline bool isWithoutLineBreak( quint64 word )
+{
+    return !containsByte( word, '\n' ) && !containsByte( word, '\r' );
+}
+
+
+/// Returns true if the given 8 bytes are ASCII characters, without a newline or carriage return
+static inline bool isAsciiWithoutLineBreak( quint64 word )
+{
+    return ( word & Q_UINT64_C(0x8080808080808080) ) == 0 && isWithoutLineBreak( word );
+}
+
+
+/// Returns true if the given byte is a UTF-8 continuation byte (10xxxxxx)
+static inline bool isContinuationByte( uchar byte )
+{
+    return ( byte & 0xC0 ) == 0x80;
+}
+
+
+/// Validates the UTF-8 multi-byte sequence at the given position
+/// @param p the first byte of the sequence (>= 0x80)
+/// @param end the end of the available data
+/// @param codePoint (out) the decoded code point
+/// @return the length of the sequence or 0 when the sequence is invalid (or incomplete)
+static inline int decodeUtf8Sequence( const uchar* p, const uchar* end, uint& codePoint )
+{
+    uint c = p[0];
+    qint64 available = end - p;
+    if( 0xC2 <= c && c <= 0xDF ) {
+        if( available < 2 || !isContinuationByte( p[1] ) ) { return 0; }
+        codePoint = ( ( c & 0x1F ) << 6 ) | ( p[1] & 0x3F );
+        return 2;
+    }
+    if( 0xE0 <= c && c <= 0xEF ) {
+        // reject overlong sequences (E0) and surrogates (ED)
+        uint low = c == 0xE0 ? 0xA0 : 0x80;
+        uint high = c == 0xED ? 0x9F : 0xBF;
+        if( available < 3 || p[1] < low || p[1] > high || !isContinuationByte( p[2] ) ) { return 0; }
+        codePoint = ( ( c & 0x0F ) << 12 ) | ( ( p[1] & 0x3F ) << 6 ) | ( p[2] & 0x3F );
+        return 3;
+    }
+    if( 0xF0 <= c && c <= 0xF4 ) {
+        // reject overlong sequences (F0) and code points above U+10FFFF (F4)
+        uint low = c == 0xF0 ? 0x90 : 0x80;
+        uint high = c == 0xF4 ? 0x8F : 0xBF;
+        if( available < 4 || p[1] < low || p[1] > high || !isContinuationByte( p[2] ) || !isContinuationByte( p[3] ) ) { return 0; }
+        codePoint = ( ( c & 0x07 ) << 18 ) | ( ( p[1] & 0x3F ) << 12 ) | ( ( p[2] & 0x3F ) << 6 ) | ( p[3] & 0x3F );
+        return 4;
+    }
+    return 0;
+}
+
+
+//=============================================================================
+
+
+/// Constructs the decoder
+/// @param encoding the encoding of the data
+/// @param data the data to decode. The data must stay valid while using the decoder
+/// @param length the number of bytes
+ParallelTextDecoder::ParallelTextDecoder(Encoding encoding, const char* data, qint64 length)
+    : encoding_(encoding)
+    , data_( reinterpret_cast<const uchar*>(data) )
+    , length_(length)
+    , skipByteOrderMark_(false)
+    , blockSize_(DefaultBlockSize)
+    , threadCount_( qMax( QThread::idealThreadCount(), 1 ) )
+    , decodedLength_(-1)
+    , target_(nullptr)
+    , baseOffset_(0)
+{
+    Q_ASSERT( data_ || length_ == 0 );
+    Q_ASSERT( length_ >= 0 );
+}
+
+
+/// Returns the encoding of the given codec, when it's supported by this decoder.
+/// The decoder supports UTF-8 and Latin-1 (ISO-8859-1)
+/// @param codec the codec to check
+/// @param encoding (out) the encoding of the codec
+/// @param skipByteOrderMark (out) should a leading byte order mark be skipped (like the decoder of the codec does)
+/// @return true if the codec is supported
+bool ParallelTextDecoder::encodingForCodec(TextCodec* codec, Encoding& encoding, bool& skipByteOrderMark)
+{
+    if( !codec || !codec->codec() ) { return false; }
+    switch( codec->codec()->mibEnum() ) {
+        case 106:   // UTF-8
+            encoding = Utf8Encoding;
+            skipByteOrderMark = !( codec->flags() & QTextCodec::IgnoreHeader );
+            return true;
+        case 4:     // ISO-8859-1
+            encoding = Latin1Encoding;
+            skipByteOrderMark = false;
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/// Returns the encoding of the data
+ParallelTextDecoder::Encoding ParallelTextDecoder::encoding() const
+{
+    return encoding_;
+}
+
+
+/// When enabled a leading UTF-8 byte order mark is skipped
+void ParallelTextDecoder::setSkipByteOrderMark(bool skip)
+{
+    Q_ASSERT( decodedLength_ < 0 );
+    skipByteOrderMark_ = skip;
+}
+
+
+/// Returns true if a leading UTF-8 byte order mark is skipped
+bool ParallelTextDecoder::skipByteOrderMark() const
+{
+    return skipByteOrderMark_;
+}
+
+
+/// Sets the (approximate) number of bytes of a block. Every block is decoded by a single thread
+void ParallelTextDecoder::setBlockSize(int size)
+{
+    Q_ASSERT( size >= 4 );
+    Q_ASSERT( decodedLength_ < 0 );
+    blockSize_ = size;
+}
+
+
+/// Returns the number of bytes of a block
+int ParallelTextDecoder::blockSize() const
+{
+    return blockSize_;
+}
+
+
+/// Sets the maximum number of threads that are used for decoding (including the calling thread)
+/// With a thread count of 1 the data is only decoded by the calling thread
+void ParallelTextDecoder::setThreadCount(int count)
+{
+    Q_ASSERT( count >= 1 );
+    threadCount_ = count;
+}
+
+
+/// Returns the maximum number of threads
+int ParallelTextDecoder::threadCount() const
+{
+    return threadCount_;
+}
+
+
+/// Returns the number of characters of the decoded data.
+/// The first call calculates the decoded length of all blocks (in parallel)
+qint64 ParallelTextDecoder::decodedLength()
+{
+    if( decodedLength_ < 0 ) {
+        splitBlocks();
+        runPass( CountPass );
+
+        decodedLength_ = 0;
+        for( int i=0, cnt=blocks_.size(); i < cnt; ++i ) {
+            blocks_[i].offset = decodedLength_;
+            decodedLength_ += blocks_[i].length;
+        }
+    }
+    return decodedLength_;
+}
+
+
+/// Decodes the data (in parallel) to the given target
+/// @param target the target, which should have room for decodedLength() characters
+/// @param baseOffset the offset of the target in the textbuffer. This offset is added to the line offsets
+/// @param lineOffsets the line offsets (the offsets of the characters after the newlines) are appended to this vector
+/// @param lineEndings the statistics to add the line endings of the data to (0 to skip)
+void ParallelTextDecoder::decode(QChar* target, TextOffset baseOffset, QVector<TextOffset>& lineOffsets, LineEndingStatistics* lineEndings)
+{
+    decodedLength();
+    for( int i=0, cnt=blocks_.size(); i < cnt; ++i ) {
+        blocks_[i].lineEndings.clear();
+        blocks_[i].lineEndings.setWindowsLinesRecorded( lineEndings && lineEndings->isWindowsLinesRecorded() );
+    }
+    target_ = target;
+    baseOffset_ = baseOffset;
+    runPass( DecodePass );
+    target_ = nullptr;
+
+    // merge the line offsets of all blocks
+    int lineCount = 0;
+    for( int i=0, cnt=blocks_.size(); i < cnt; ++i ) { lineCount += blocks_.at(i).lineOffsets.size(); }
+    lineOffsets.reserve( lineOffsets.size() + lineCount );
+    for( int i=0, cnt=blocks_.size(); i < cnt; ++i ) {
+        lineOffsets += blocks_.at(i).lineOffsets;
+        blocks_[i].lineOffsets = QVector<TextOffset>();
+        if( lineEndings ) { lineEndings->append( blocks_.at(i).lineEndings ); }
+        blocks_[i].lineEndings.clearWindowsLines();
+    }
+}
+
+
+/// Returns the number of blocks (available after calling decodedLength)
+int ParallelTextDecoder::blockCount() const
+{
+    return blocks_.size();
+}
+
+
+/// Splits the data in blocks. A block never ends in the middle of a UTF-8 sequence
+void ParallelTextDecoder::splitBlocks()
+{
+    const uchar* p = data_;
+    const uchar* end = data_ + length_;
+
+    // skip the byte order mark
+    if( encoding_ == Utf8Encoding && skipByteOrderMark_ && length_ >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF ) {
+        p += 3;
+    }
+
+    blocks_.clear();
+    blocks_.reserve( static_cast<int>( ( end - p ) / blockSize_ + 1 ) );
+    while( p < end ) {
+        const uchar* blockEnd = end - p > blockSize_ ? p + blockSize_ : end;
+
+        // a block should end before a byte that isn't a continuation byte. The decoder always (also with invalid data)
+        // starts a new sequence at such a byte, so the result doesn't depend on the block boundaries.
+        // Move the end before the continuation bytes of the sequence (a valid sequence is at most 4 bytes),
+        // with a longer (invalid) run of continuation bytes the end is moved after this run.
+        if( encoding_ == Utf8Encoding ) {
+            const uchar* sequenceEnd = blockEnd;
+            for( int i=0; i < 3 && blockEnd < end && blockEnd - p > 1 && isContinuationByte( *blockEnd ); ++i ) { --blockEnd; }
+            if( blockEnd < end && isContinuationByte( *blockEnd ) ) {
+                blockEnd = sequenceEnd;
+                while( blockEnd < end && isContinuationByte( *blockEnd ) ) { ++blockEnd; }
+            }
+        }
+
+        Block block;
+        block.begin = p;
+        block.end = blockEnd;
+        block.offset = 0;
+        block.length = 0;
+        blocks_.append( block );
+        p = blockEnd;
+    }
+}
+
+
+/// Runs the given pass for all blocks. The calling thread and (at most threadCount - 1) workers of
+/// the global thread pool process the blocks
+void ParallelTextDecoder::runPass(Pass pass)
+{
+    QSharedPointer<Job> job( new Job() );
+    job->decoder = this;
+    job->pass = pass;
+    job->blockCount = blocks_.size();
+
+    int workerCount = qMin( threadCount_, blocks_.size() ) - 1;
+    for( int i=0; i < workerCount; ++i ) {
+        QThreadPool::globalInstance()->start( new Worker( job ) );
+    }
+    Worker::processBlocks( job.data() );
+    job->finished.acquire( job->blockCount );
+}
+
+
+/// Processes a single block
+void ParallelTextDecoder::processBlock(int idx, Pass pass)
+{
+    Block& block = blocks_[idx];
+    if( pass == CountPass ) {
+        block.length = encoding_ == Utf8Encoding ? decodeUtf8<false>( block, nullptr, 0 ) : decodeLatin1<false>( block, nullptr, 0 );
+    } else {
+        QChar* out = target_ + block.offset;
+        TextOffset baseOffset = baseOffset_ + static_cast<TextOffset>( block.offset );
+        qint64 length = encoding_ == Utf8Encoding ? decodeUtf8<true>( block, out, baseOffset ) : decodeLatin1<true>( block, out, baseOffset );
+        Q_ASSERT( length == block.length );
+        Q_UNUSED( length );
+    }
+}
+
+
+/// Adds the line offset of a \n and counts the line ending. The \r of a \r\n is already counted (it's skipped),
+/// a \r without \n is a Mac classic line ending, which doesn't end the line
+/// @param block the block that's decoded
+/// @param p the \n or \r
+/// @param lineOffset the offset of the character after the \n
+void ParallelTextDecoder::addLineBreak(Block& block, const uchar* p, TextOffset lineOffset) const
+{
+    if( *p == '\r' ) {
+        block.lineEndings.addLineEnding( LineEnding::MacClassicType );
+        return;
+    }
+    block.lineOffsets.append( lineOffset );
+    if( p == data_ || p[-1] != '\r' ) { block.lineEndings.addLineEnding( LineEnding::UnixType ); }
+}
+
+
+/// Decodes an UTF-8 encoded block. Without writing only the decoded length is calculated
+/// @param block the block to decode
+/// @param out the target of the decoded characters
+/// @param baseOffset the offset of the target in the textbuffer
+/// @return the number of decoded characters
+template<bool Write>
+qint64 ParallelTextDecoder::decodeUtf8(Block& block, QChar* out, TextOffset baseOffset) const
+{
+    const uchar* p = block.begin;
+    const uchar* end = block.end;
+    const uchar* dataEnd = data_ + length_;
+    qint64 n = 0;
+    while( p < end ) {
+
+        // fast path: 8 ASCII characters without line breaks
+        if( end - p >= 8 ) {
+            quint64 word;
+            memcpy( &word, p, 8 );
+            if( isAsciiWithoutLineBreak( word ) ) {
+                if( Write ) {
+                    for( int i=0; i < 8; ++i ) { out[n+i] = QChar( static_cast<ushort>( p[i] ) ); }
+                }
+                n += 8;
+                p += 8;
+                continue;
+            }
+        }
+
+        uint c = *p;
+        if( c < 0x80 ) {
+            // translate \r\n to \n (the \n can be the first byte of the next block)
+            if( c == '\r' && p + 1 < dataEnd && p[1] == '\n' ) {
+                if( Write ) { block.lineEndings.addLineEnding( LineEnding::WindowsType ); }
+                ++p;
+                continue;
+            }
+            if( Write ) {
+                out[n] = QChar( static_cast<ushort>( c ) );
+                if( c == '\n' || c == '\r' ) { addLineBreak( block, p, baseOffset + static_cast<TextOffset>( n + 1 ) ); }
+            }
+            ++n;
+            ++p;
+            continue;
+        }
+
+        // multi-byte sequences
+        uint codePoint = 0;
+        int sequenceLength = decodeUtf8Sequence( p, end, codePoint );
+        if( sequenceLength == 0 ) {
+            codePoint = QChar::ReplacementCharacter;
+            sequenceLength = 1;
+        }
+        if( QChar::requiresSurrogates( codePoint ) ) {
+            if( Write ) {
+                out[n] = QChar( QChar::highSurrogate( codePoint ) );
+                out[n+1] = QChar( QChar::lowSurrogate( codePoint ) );
+            }
+            n += 2;
+        } else {
+            if( Write ) { out[n] = QChar( static_cast<ushort>( codePoint ) ); }
+            ++n;
+        }
+        p += sequenceLength;
+    }
+    return n;
+}
+
+
+/// Decodes a Latin-1 encoded block. Without writing only the decoded length is calculated
+/// @param block the block to decode
+/// @param out the target of the decoded characters
+/// @param baseOffset the offset of the target in the textbuffer
+/// @return the number of decoded characters
+template<bool Write>
+qint64 ParallelTextDecoder::decodeLatin1(Block& block, QChar* out, TextOffset baseOffset) const
+{
+    const uchar* p = block.begin;
+    const uchar* end = block.end;
+    const uchar* dataEnd = data_ + length_;
+    qint64 n = 0;
+    while( p < end ) {
+
+        // fast path: 8 characters without line breaks
+        if( end - p >= 8 ) {
+            quint64 word;
+            memcpy( &word, p, 8 );
+            if( isWithoutLineBreak( word ) ) {
+                if( Write ) {
+                    for( int i=0; i < 8; ++i ) { out[n+i] = QChar( static_cast<ushort>( p[i] ) ); }
+                }
+                n += 8;
+                p += 8;
+                continue;
+            }
+        }
+
+        uint c = *p;
+        if( c == '\r' && p + 1 < dataEnd && p[1] == '\n' ) {
+            if( Write ) { block.lineEndings.addLineEnding( LineEnding::WindowsType ); }
+            ++p;
+            continue;
+        }
+        if( Write ) {
+            out[n] = QChar( static_cast<ushort>( c ) );
+            if( c == '\n' || c == '\r' ) { addLineBreak( block, p, baseOffset + static_cast<TextOffset>( n + 1 ) ); }
+        }
+        ++n;
+        ++p;
+    }
+    return n;
+}
+
+
+} // edbee
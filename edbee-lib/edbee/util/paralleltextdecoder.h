@@ -0,0 +1,103 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QVector>
+
+#include "edbee/textoffset.h"
+#include "edbee/util/lineending.h"
+
+class QChar;
+
+namespace edbee {
+
+class TextCodec;
+
+
+/// Decodes a large block of UTF-8 or Latin-1 encoded data with multiple threads.
+///
+/// The data is split in blocks at safe boundaries (never inside a UTF-8 sequence). The blocks are decoded in two
+/// passes on the global QThreadPool: the first pass calculates the decoded length of every block, the second pass
+/// decodes every block directly at its final position in the target (for example the storage of a textbuffer) and
+/// collects the line offsets of the block. The line offsets of all blocks are merged afterwards.
+///
+/// Just like the TextDocumentSerializer, \\r\\n line endings are translated to \\n. The line endings can be counted
+/// while decoding (per block, the statistics are merged afterwards).
+/// Invalid UTF-8 sequences are replaced by the replacement character (U+FFFD).
+///
+/// The calling thread also decodes blocks, so the decoder never waits for a thread pool that's completely busy.
+class EDBEE_EXPORT ParallelTextDecoder {
+public:
+    enum Encoding {
+        Utf8Encoding,
+        Latin1Encoding
+    };
+
+    ParallelTextDecoder( Encoding encoding, const char* data, qint64 length );
+
+    static bool encodingForCodec( TextCodec* codec, Encoding& encoding, bool& skipByteOrderMark );
+
+    Encoding encoding() const;
+
+    void setSkipByteOrderMark( bool skip );
+    bool skipByteOrderMark() const;
+
+    void setBlockSize( int size );
+    int blockSize() const;
+
+    void setThreadCount( int count );
+    int threadCount() const;
+
+    qint64 decodedLength();
+    void decode( QChar* target, TextOffset baseOffset, QVector<TextOffset>& lineOffsets, LineEndingStatistics* lineEndings=0 );
+
+    int blockCount() const;
+
+    /// The default number of bytes of a single block
+    static const int DefaultBlockSize = 1024 * 1024;
+
+private:
+    /// A block of the data, which is decoded by a single thread
+    struct Block {
+        const uchar* begin;                  ///< The first byte of the block
+        const uchar* end;                    ///< The end of the block
+        qint64 offset;                       ///< The offset of the decoded block in the target
+        qint64 length;                       ///< The decoded length of the block
+        QVector<TextOffset> lineOffsets;     ///< The line offsets in the decoded block
+        LineEndingStatistics lineEndings;    ///< The line endings of the block
+    };
+
+    struct Job;
+    class Worker;
+
+    enum Pass {
+        CountPass,
+        DecodePass
+    };
+
+    void splitBlocks();
+    void runPass( Pass pass );
+    void processBlock( int idx, Pass pass );
+
+    void addLineBreak( Block& block, const uchar* p, TextOffset lineOffset ) const;
+    template<bool Write> qint64 decodeUtf8( Block& block, QChar* out, TextOffset baseOffset ) const;
+    template<bool Write> qint64 decodeLatin1( Block& block, QChar* out, TextOffset baseOffset ) const;
+
+private:
+    Encoding encoding_;                  ///< The encoding of the data
+    const uchar* data_;                  ///< The data to decode
+    qint64 length_;                      ///< The number of bytes of the data
+    bool skipByteOrderMark_;             ///< Should a leading UTF-8 byte order mark be skipped?
+    int blockSize_;                      ///< The (approximate) number of bytes of a block
+    int threadCount_;                    ///< The maximum number of threads to use (including the calling thread)
+
+    QVector<Block> blocks_;              ///< The blocks (after splitting)
+    qint64 decodedLength_;               ///< The total decoded length (-1 when not calculated yet)
+    QChar* target_;                      ///< The target of the decode pass
+    TextOffset baseOffset_;              ///< The offset of the target in the textbuffer (for the line offsets)
+};
+
+} // edbee
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 
 #include <QRegExp>
+#include <QVector>
 
 // This is required for windows, to prevent linkage errors (somehow the sources of oniguruma assumes we're linking with a dll)
 
@@ -40,7 +41,7 @@ private:
     OnigErrorInfo einfo_;       ///< The error information
     bool valid_;                ///< Is the reg-exp valid?
     QString error_;             ///< The current error as a qstring
-    OnigRegion *region_;        ///< The current found region
+    OnigRegion *region_;        ///< The found region, reused for every search (sized to the capture count)
     QString pattern_;           ///< The original regexp-pattern
     QString line_;              ///< The current line
     const QChar* lineRef_;      ///< A reference to the given line
@@ -104,6 +105,13 @@ public:
             &einfo_);
         valid_ = result == ONIG_NORMAL;
         fillError( result );
+
+        // the region is reused for every search, so it's allocated once with room for all groups
+        if( valid_ ) {
+            region_ = onig_region_new();
+            onig_region_resize( region_, onig_number_of_captures( reg_ ) + 1 );
+            onig_region_clear( region_ );
+        }
     }
 
 
@@ -135,10 +143,6 @@ public:
         // invalid reg-exp don't use it!
         if( !valid_ ) { return -2; }
 
-        // delete old regenion an make a new one
-        deleteRegion();
-        region_ = onig_region_new();
-
         lineRef_ = charPtr;
         OnigUChar* stringStart  = (OnigUChar*)charPtr;
         OnigUChar* stringEnd    = (OnigUChar*)(charPtr+length);
@@ -174,8 +178,8 @@ public:
     virtual int indexIn( const QString& str, int offset )
     {
         line_ = str;
-        int length = line_.length(); // very scary, calling line_.length() invalidates the line_.data() pointer :S
-        lineRef_ = line_.data();
+        int length = line_.length();
+        lineRef_ = line_.constData();   // constData never detaches, so strings that share (or wrap raw) data aren't copied
 
         return indexIn( lineRef_, offset, length, false );
     }
@@ -199,8 +203,8 @@ public:
     virtual int lastIndexIn( const QString& str, int offset )
     {
         line_ = str;
-        int length = line_.length(); // very scary, calling line_.length() invalidates the line_.data() pointer :S
-        lineRef_ = line_.data();
+        int length = line_.length();
+        lineRef_ = line_.constData();   // constData never detaches, so strings that share (or wrap raw) data aren't copied
         return lastIndexIn( lineRef_, offset, length);
     }
 
@@ -248,6 +252,7 @@ public:
 
     /// returns the length of the nth match
     /// @param nth the match number
+    /// @return the length of the nth match (0 for an unmatched group or after a failed match, -1 for an unknown group)
     virtual int len( int nth ) const
     {
         if( !region_ ) { return -1; } // no region
@@ -271,6 +276,18 @@ public:
         return QString( lineRef_+p,l);
     }
 
+
+    /// returns the capture at the given index as a view on the searched string (without copying it)
+    /// @param nth the position of the match
+    /// @return the match at the given position (only valid while the searched string exists)
+    virtual QStringView capView( int nth = 0 ) const
+    {
+        int p = pos(nth);
+        int l = len(nth);
+        if( p < 0 || l < 0 ) return QStringView();
+        return QStringView( lineRef_+p, l );
+    }
+
 };
 
 
@@ -282,6 +299,7 @@ public:
 class QtRegExpEngine : public RegExpEngine
 {
     QRegExp* reg_;      ///< The Qt QRegExp objet
+    QString line_;      ///< The searched string (for capView)
 
 public:
 
@@ -322,6 +340,7 @@ public:
     /// @return the index of the given match or < 0 if no match was found
     virtual int indexIn( const QString& str, int offset )
     {
+        line_ = str;
         return reg_->indexIn( str, offset );
     }
 
@@ -333,8 +352,8 @@ public:
     /// @return the index of the given match or < 0 if no match was found
     virtual int indexIn( const QChar* str, int offset, int length )
     {
-        QString realString( str+offset, length );
-        return reg_->indexIn( realString, offset );
+        line_ = QString::fromRawData( str, length );
+        return reg_->indexIn( line_, offset );
     }
 
 
@@ -344,6 +363,7 @@ public:
     /// @return the matched index or < 0 if not found
     virtual int lastIndexIn( const QString& str, int offset )
     {
+        line_ = str;
         return reg_->lastIndexIn( str, offset );
     }
 
@@ -355,8 +375,8 @@ public:
     /// @return the matched index or < 0 if not found
     virtual int lastIndexIn( const QChar* str, int offset, int length )
     {
-        QString realString( str+offset, length );
-        return reg_->lastIndexIn( realString, offset );
+        line_ = QString::fromRawData( str, length );
+        return reg_->lastIndexIn( line_, offset );
     }
 
 
@@ -366,10 +386,18 @@ public:
     virtual int pos( int nth = 0 ) const { return reg_->pos(nth); }
 
 
-    /// returns the length of the nth group match
+    /// returns the length of the nth group match.
+    /// QRegExp only has a length for the complete match, the length of a group requires the captured texts
+    /// (which QRegExp builds once per match)
     /// @param nth the group number to return
-    /// @return the length of the nth match
-    virtual int len( int nth = 0 ) const { return reg_->cap(nth).length(); }
+    /// @return the length of the nth match (0 for an unmatched group or after a failed match, -1 for an unknown group)
+    ///         (the same lengths as the Oniguruma engine)
+    virtual int len( int nth = 0 ) const
+    {
+        if( nth < 0 || nth > reg_->captureCount() ) { return -1; }
+        if( nth == 0 ) { return qMax( 0, reg_->matchedLength() ); }
+        return reg_->pos(nth) < 0 ? 0 : reg_->cap(nth).length();
+    }
 
 
     /// returns the nth group
@@ -377,6 +405,18 @@ public:
     /// @return the content of the given match
     virtual QString cap( int nth= 0 ) const { return reg_->cap(nth); }
 
+
+    /// returns the nth group as a view on the searched string
+    /// @param nth the group number to return
+    /// @return the content of the given match (only valid while the searched string exists)
+    virtual QStringView capView( int nth = 0 ) const
+    {
+        int p = pos(nth);
+        int l = len(nth);
+        if( p < 0 || l < 0 ) { return QStringView(); }
+        return QStringView( line_.constData() + p, l );
+    }
+
 };
 
 
@@ -467,6 +507,17 @@ int RegExp::indexIn(const QChar* str, int offset, int length)
 
 
 
+/// Searches for the regular expression in the given string view. The string isn't copied or referenced,
+/// so the view must stay valid while the captures (cap/capView) are used
+/// @param str the string to search in
+/// @param offset the offset to start searching
+/// @return the found index of the regular expression
+int RegExp::indexIn( QStringView str, int offset )
+{
+    return d_->indexIn( str.data(), offset, int( str.size() ) );
+}
+
+
 /// Searcher for the last match of the regular expression in the given string
 /// @param str the string to search in
 /// @param offset the offset to start searching
@@ -508,4 +559,179 @@ QString RegExp::cap(int nth) const
     return d_->cap(nth);
 }
 
+
+/// Returns the nth captured text as a view on the searched string, without allocating a new string.
+/// The view is only valid while the searched string exists (and isn't changed)
+QStringView RegExp::capView(int nth) const
+{
+    return d_->capView(nth);
+}
+
+
+//====================================================================================================================
+
+
+/// Converts the given oniguruma error code to a message
+/// @param code the ONIG error code
+/// @param einfo the error information (of onig_new)
+static QString onigErrorString( int code, OnigErrorInfo* einfo )
+{
+    unsigned char s[ONIG_MAX_ERROR_MESSAGE_LEN];
+    onig_error_code_to_str( s, code, einfo );
+    return QString::fromLatin1((char*)s);
+}
+
+
+/// Constructs the regular expression set. The patterns are compiled with the same options and syntax as
+/// an oniguruma RegExp with the default syntax
+/// @param patterns the patterns of the set (the index of a pattern is the matchedIndex)
+/// @param caseSensitive should the matches be case sensitive
+RegExpSet::RegExpSet( const QStringList& patterns, bool caseSensitive )
+    : set_(0)
+    , patterns_(patterns)
+    , matchedIndex_(-1)
+{
+    OnigOptionType onigOptions = ONIG_OPTION_NONE|ONIG_OPTION_CAPTURE_GROUP;
+    if( !caseSensitive ) { onigOptions = onigOptions | ONIG_OPTION_IGNORECASE;}
+
+    QVector<regex_t*> regs;
+    regs.reserve( patterns.size() );
+    foreach( const QString& pattern, patterns ) {
+        const QChar* patternChars = pattern.constData();
+        regex_t* reg = 0;
+        OnigErrorInfo einfo;
+        int result = onig_new(
+            &reg,
+            (OnigUChar*)patternChars,
+            (OnigUChar*)(patternChars + pattern.length()),
+            onigOptions,
+            ONIG_ENCODING_UTF16_LE,
+            &OnigSyntaxRuby,
+            &einfo);
+        if( result != ONIG_NORMAL ) {
+            error_ = onigErrorString( result, &einfo );
+            foreach( regex_t* compiledReg, regs ) { onig_free( compiledReg ); }
+            return;
+        }
+        regs.append( reg );
+    }
+
+    // the set becomes the owner of the regexps
+    int result = onig_regset_new( &set_, regs.size(), regs.data() );
+    if( result != ONIG_NORMAL ) {
+        error_ = onigErrorString( result, 0 );
+        foreach( regex_t* compiledReg, regs ) { onig_free( compiledReg ); }
+        set_ = 0;
+    }
+}
+
+
+/// destructs the regular expression set
+RegExpSet::~RegExpSet()
+{
+    if( set_ ) { onig_regset_free( set_ ); }
+}
+
+
+/// returns true if all patterns are valid
+bool RegExpSet::isValid() const
+{
+    return set_ != 0;
+}
+
+
+/// returns the error message of the last call
+QString RegExpSet::errorString() const
+{
+    return error_;
+}
+
+
+/// returns the patterns of this set
+QStringList RegExpSet::patterns() const
+{
+    return patterns_;
+}
+
+
+/// returns the number of patterns
+int RegExpSet::size() const
+{
+    return patterns_.size();
+}
+
+
+/// Searches for the leftmost match of all patterns in the given string
+/// @param str the string to search in
+/// @param offset the offset to start searching
+/// @return the position of the match (-1 if not found, -2 on error)
+int RegExpSet::indexIn( const QString& str, int offset )
+{
+    return indexIn( str.constData(), offset, str.length() );
+}
+
+
+/// Searches for the leftmost match of all patterns in the given string
+/// @param str the pointer to the string data
+/// @param offset the offset to start searching
+/// @param length the length of the string data
+/// @return the position of the match (-1 if not found, -2 on error)
+int RegExpSet::indexIn( const QChar* str, int offset, int length )
+{
+    matchedIndex_ = -1;
+    if( !set_ ) { return -2; }
+
+    error_.clear();
+    OnigUChar* stringStart  = (OnigUChar*)str;
+    OnigUChar* stringEnd    = (OnigUChar*)(str+length);
+    OnigUChar* stringOffset = (OnigUChar*)(str+offset);
+    int matchPos = 0;
+
+    int result = onig_regset_search( set_, stringStart, stringEnd, stringOffset, stringEnd, ONIG_REGSET_POSITION_LEAD, ONIG_OPTION_NONE, &matchPos );
+    if( result >= 0 ) {
+        Q_ASSERT(matchPos%2==0);
+        matchedIndex_ = result;
+        return matchPos >> 1;
+
+    } else if( result == ONIG_MISMATCH ) {
+        return -1;
+
+    } else { // error
+        error_ = onigErrorString( result, 0 );
+        return -2;
+    }
+}
+
+
+/// returns the index of the pattern that matched in the last search (-1 if not found)
+int RegExpSet::matchedIndex() const
+{
+    return matchedIndex_;
+}
+
+
+/// returns the position of the nth group of the last match
+/// @param nth the group number (0 is the complete match)
+/// @return the position (-1 if not matched)
+int RegExpSet::pos( int nth ) const
+{
+    if( matchedIndex_ < 0 ) { return -1; }
+    OnigRegion* region = onig_regset_get_region( set_, matchedIndex_ );
+    if( !region || nth >= region->num_regs || region->beg[nth] < 0 ) { return -1; }
+    return region->beg[nth] >> 1;
+}
+
+
+/// returns the length of the nth group of the last match
+/// @param nth the group number (0 is the complete match)
+/// @return the length (-1 if not matched)
+int RegExpSet::len( int nth ) const
+{
+    if( matchedIndex_ < 0 ) { return -1; }
+    OnigRegion* region = onig_regset_get_region( set_, matchedIndex_ );
+    if( !region || nth >= region->num_regs || region->beg[nth] < 0 ) { return -1; }
+    return ( region->end[nth] - region->beg[nth] ) >> 1;
+}
+
+
 } // edbee
@@ -6,6 +6,10 @@
 #include "edbee/exports.h"
 
 #include <QString>
+#include <QStringList>
+#include <QStringView>
+
+struct OnigRegSetStruct;
 
 namespace edbee {
 
@@ -25,6 +29,7 @@ public:
     virtual int pos( int nth = 0 ) const = 0;
     virtual int len( int nth = 0 ) const = 0;
     virtual QString cap( int nth = 0 ) const = 0;
+    virtual QStringView capView( int nth = 0 ) const = 0;
 };
 
 
@@ -64,11 +69,13 @@ public:
 
     int	indexIn( const QString& str, int offset = 0 ); // const;
     int indexIn( const QChar* str, int offset, int length );
+    int indexIn( QStringView str, int offset = 0 );
     int lastIndexIn( const QString& str, int offset=-1 );
     int lastIndexIn( const QChar* str, int offset, int length );
     int pos( int nth = 0 ) const;
     int len( int nth = 0 ) const;
     QString cap( int nth = 0) const;
+    QStringView capView( int nth = 0 ) const;
 
 
     /// matched length is equal to pos-0-length
@@ -80,4 +87,33 @@ private:
     RegExpEngine* d_;       ///< The private data member
 };
 
+
+/// A set of regular expressions that's searched in a single pass (with the Oniguruma OnigRegSet API)
+/// A search returns the leftmost match of all patterns. When several patterns match at the same position,
+/// the pattern with the lowest index wins. This is a lot faster than searching every pattern on its own.
+///
+/// The set always uses the Oniguruma engine. When one of the patterns is invalid, the set is invalid.
+class EDBEE_EXPORT RegExpSet {
+public:
+    RegExpSet( const QStringList& patterns, bool caseSensitive=true );
+    virtual ~RegExpSet();
+
+    bool isValid() const;
+    QString errorString() const;
+    QStringList patterns() const;
+    int size() const;
+
+    int indexIn( const QString& str, int offset = 0 );
+    int indexIn( const QChar* str, int offset, int length );
+    int matchedIndex() const;
+    int pos( int nth = 0 ) const;
+    int len( int nth = 0 ) const;
+
+private:
+    OnigRegSetStruct* set_;         ///< The oniguruma regset (0 when invalid)
+    QStringList patterns_;          ///< The patterns of the set
+    QString error_;                 ///< The error of the last call
+    int matchedIndex_;              ///< The index of the pattern of the last match (-1 if not found)
+};
+
 } // edbee
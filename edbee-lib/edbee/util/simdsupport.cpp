@@ -0,0 +1,78 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "simdsupport.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+#ifdef EDBEE_SIMD_AVX2
+
+/// Returns true if the CPU and the operating system support AVX2
+static bool cpuSupportsAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid( info, 0 );
+    if( info[0] < 7 ) { return false; }
+    __cpuid( info, 1 );
+    bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+    bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+    if( !osxsave || !avx || ( _xgetbv(0) & 6 ) != 6 ) { return false; }   // the OS must save the YMM registers
+    __cpuidex( info, 7, 0 );
+    return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+
+/// Returns true if the given implementation is compiled and supported by this CPU
+bool SimdSupport::isSupported(Implementation implementation)
+{
+    switch( implementation ) {
+        case ScalarImplementation:
+            return true;
+#ifdef EDBEE_SIMD_SSE2
+        case Sse2Implementation:
+            return true;
+#endif
+#ifdef EDBEE_SIMD_AVX2
+        case Avx2Implementation: {
+            static const bool avx2 = cpuSupportsAvx2();    // the CPU is only queried once (thread-safe)
+            return avx2;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+
+/// Returns the fastest implementation that's supported by this CPU
+SimdSupport::Implementation SimdSupport::bestImplementation()
+{
+    if( isSupported( Avx2Implementation ) ) { return Avx2Implementation; }
+    if( isSupported( Sse2Implementation ) ) { return Sse2Implementation; }
+    return ScalarImplementation;
+}
+
+
+/// Returns the name of the given implementation
+QString SimdSupport::implementationName(Implementation implementation)
+{
+    switch( implementation ) {
+        case ScalarImplementation: return QStringLiteral("scalar");
+        case Sse2Implementation: return QStringLiteral("SSE2");
+        case Avx2Implementation: return QStringLiteral("AVX2");
+    }
+    return QString();
+}
+
+
+} // edbee
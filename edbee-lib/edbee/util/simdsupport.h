@@ -0,0 +1,108 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QString>
+
+// SSE2 is part of every x86-64 CPU. AVX2 is compiled per function and only used when the CPU supports it
+#if defined(__x86_64__) || defined(_M_X64) || ( defined(__i386__) && defined(__SSE2__) ) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define EDBEE_SIMD_SSE2
+    #include <emmintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #define EDBEE_SIMD_AVX2
+        #define EDBEE_TARGET_AVX2
+        #include <immintrin.h>
+        #include <intrin.h>
+    #elif defined(__GNUC__) || defined(__clang__)
+        #define EDBEE_SIMD_AVX2
+        #define EDBEE_TARGET_AVX2 __attribute__((target("avx2")))
+        #include <immintrin.h>
+    #endif
+#endif
+
+// The address of the given SSE2 / AVX2 kernels, or nullptr when the implementation isn't compiled
+#ifdef EDBEE_SIMD_SSE2
+    #define EDBEE_SSE2_KERNELS(kernels) (&kernels)
+#else
+    #define EDBEE_SSE2_KERNELS(kernels) nullptr
+#endif
+#ifdef EDBEE_SIMD_AVX2
+    #define EDBEE_AVX2_KERNELS(kernels) (&kernels)
+#else
+    #define EDBEE_AVX2_KERNELS(kernels) nullptr
+#endif
+
+namespace edbee {
+
+
+/// The runtime detection of the vectorized (SSE2 and AVX2) implementations.
+///
+/// Classes with vectorized implementations (like NewlineScanner and Utf8Validator) derive from this class,
+/// so they share the implementation enum and the CPU detection. The implementations are selected with a SimdKernelTable.
+class EDBEE_EXPORT SimdSupport {
+public:
+    enum Implementation {
+        ScalarImplementation,
+        Sse2Implementation,
+        Avx2Implementation
+    };
+
+    /// The number of implementations
+    static const int ImplementationCount = Avx2Implementation + 1;
+
+    static bool isSupported( Implementation implementation );
+    static Implementation bestImplementation();
+    static QString implementationName( Implementation implementation );
+};
+
+
+/// The kernels (a struct with function pointers) of every implementation of a vectorized algorithm,
+/// and the kernels that are currently active. The fastest supported kernels are active by default.
+/// Kernels that aren't compiled for the current platform are passed as nullptr (see EDBEE_SSE2_KERNELS).
+template<typename Kernels>
+class SimdKernelTable {
+public:
+    SimdKernelTable( const Kernels* scalar, const Kernels* sse2, const Kernels* avx2 )
+        : implementation_( SimdSupport::ScalarImplementation )
+    {
+        Q_ASSERT( scalar );
+        kernels_[SimdSupport::ScalarImplementation] = scalar;
+        kernels_[SimdSupport::Sse2Implementation] = sse2;
+        kernels_[SimdSupport::Avx2Implementation] = avx2;
+        for( int impl = SimdSupport::Avx2Implementation; impl > SimdSupport::ScalarImplementation; --impl ) {
+            if( setImplementation( static_cast<SimdSupport::Implementation>(impl) ) ) { break; }
+        }
+    }
+
+    /// Returns the kernels of the given implementation (or nullptr if it isn't supported)
+    const Kernels* kernelsFor( SimdSupport::Implementation implementation ) const
+    {
+        if( implementation < 0 || implementation >= SimdSupport::ImplementationCount ) { return nullptr; }
+        return SimdSupport::isSupported( implementation ) ? kernels_[implementation] : nullptr;
+    }
+
+    /// Returns the active kernels
+    const Kernels* active() const { return kernels_[implementation_]; }
+
+    /// Returns the active implementation
+    SimdSupport::Implementation implementation() const { return implementation_; }
+
+    /// Activates the given implementation (this isn't thread-safe)
+    /// @return false if the implementation isn't supported (the active implementation isn't changed)
+    bool setImplementation( SimdSupport::Implementation implementation )
+    {
+        if( !kernelsFor( implementation ) ) { return false; }
+        implementation_ = implementation;
+        return true;
+    }
+
+private:
+    const Kernels* kernels_[SimdSupport::ImplementationCount];  ///< The kernels per implementation
+    SimdSupport::Implementation implementation_;                ///< The active implementation
+};
+
+
+} // edbee
@@ -3,9 +3,20 @@
 
 #include <QTextCodec>
 #include <QApplication>
+#include <QtAlgorithms>
 
 #include "textcodec.h"
 
+#include <string.h>
+
+#include "edbee/util/newlinescanner.h"
+
+// SSE2 is part of every x86-64 CPU
+#if defined(__x86_64__) || defined(_M_X64) || ( defined(__i386__) && defined(__SSE2__) ) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define EDBEE_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
 #include "edbee/debug.h"
 
 namespace edbee {
@@ -103,4 +114,435 @@ QTextDecoder* TextCodec::makeDecoder()
 }
 
 
+/// Returns the converter of this codec. UTF-8 and Latin-1 have a built-in converter
+TextCodec::Converter TextCodec::converter()
+{
+    if( !codecRef_ ) { return QtConverter; }
+    switch( codecRef_->mibEnum() ) {
+        case 106: return Utf8Converter;     // UTF-8
+        case 4: return Latin1Converter;     // ISO-8859-1
+        default: return QtConverter;
+    }
+}
+
+
+//----------------------------------------------------------
+
+
+/// Returns true if the given byte is a UTF-8 continuation byte (10xxxxxx)
+static inline bool isContinuationByte( uchar byte )
+{
+    return ( byte & 0xC0 ) == 0x80;
+}
+
+
+/// Decodes the UTF-8 multi-byte sequence at the given position.
+/// Overlong sequences, surrogates and code points above U+10FFFF are invalid
+/// @param p the first byte of the sequence (>= 0x80)
+/// @param end the end of the available data
+/// @param out the target, which is moved after the written characters
+/// @return the number of bytes consumed, or -1 if the data ends with the start of a valid sequence
+static inline int decodeUtf8Sequence( const uchar* p, const uchar* end, QChar*& out )
+{
+    uint c = p[0];
+    int length = c < 0xC2 ? 0 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : c < 0xF5 ? 4 : 0;
+    if( length > 0 ) {
+        qptrdiff available = end - p;
+        uint low = c == 0xE0 ? 0xA0 : c == 0xF0 ? 0x90 : 0x80;
+        uint high = c == 0xED ? 0x9F : c == 0xF4 ? 0x8F : 0xBF;
+        int valid = 1;
+        if( available > 1 && low <= p[1] && p[1] <= high ) {
+            for( valid = 2; valid < length && valid < available && isContinuationByte( p[valid] ); ++valid ) {}
+        }
+        if( valid == length ) {
+            uint codePoint;
+            if( length == 2 ) {
+                codePoint = ( ( c & 0x1F ) << 6 ) | ( p[1] & 0x3F );
+            } else if( length == 3 ) {
+                codePoint = ( ( c & 0x0F ) << 12 ) | ( ( p[1] & 0x3F ) << 6 ) | ( p[2] & 0x3F );
+            } else {
+                codePoint = ( ( c & 0x07 ) << 18 ) | ( ( p[1] & 0x3F ) << 12 ) | ( ( p[2] & 0x3F ) << 6 ) | ( p[3] & 0x3F );
+                *out++ = QChar( QChar::highSurrogate( codePoint ) );
+                codePoint = QChar::lowSurrogate( codePoint );
+            }
+            *out++ = QChar( static_cast<ushort>( codePoint ) );
+            return length;
+        }
+        if( valid == available ) { return -1; }
+    }
+    *out++ = QChar( QChar::ReplacementCharacter );
+    return 1;
+}
+
+
+/// Decodes UTF-8 data. ASCII characters are widened 16 at a time (with SSE2)
+/// @param out the target, which is moved after the written characters
+/// @return the start of the incomplete sequence at the end of the data (or end)
+static const uchar* decodeUtf8( const uchar* p, const uchar* end, QChar*& out )
+{
+    while( p < end ) {
+#ifdef EDBEE_SIMD_SSE2
+        if( end - p >= 16 ) {
+            __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+            quint32 mask = static_cast<quint32>( _mm_movemask_epi8( chunk ) );
+            if( !mask ) {
+                __m128i zero = _mm_setzero_si128();
+                _mm_storeu_si128( reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8( chunk, zero ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8( chunk, zero ) );
+                p += 16;
+                out += 16;
+                continue;
+            }
+            // the ASCII characters before the first non-ASCII byte
+            for( uint i = qCountTrailingZeroBits(mask); i > 0; --i ) { *out++ = QChar( static_cast<ushort>( *p++ ) ); }
+        }
+#endif
+        if( *p < 0x80 ) {
+            *out++ = QChar( static_cast<ushort>( *p++ ) );
+            continue;
+        }
+        int length = decodeUtf8Sequence( p, end, out );
+        if( length < 0 ) { break; }
+        p += length;
+    }
+    return p;
+}
+
+
+/// Decodes Latin-1 data, every byte is a single character
+/// @param out the target, which is moved after the written characters
+static void decodeLatin1( const uchar* p, const uchar* end, QChar*& out )
+{
+#ifdef EDBEE_SIMD_SSE2
+    __m128i zero = _mm_setzero_si128();
+    for( ; end - p >= 16; p += 16, out += 16 ) {
+        __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8( chunk, zero ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8( chunk, zero ) );
+    }
+#endif
+    while( p < end ) { *out++ = QChar( static_cast<ushort>( *p++ ) ); }
+}
+
+
+/// Constructs a decoder for the given codec
+/// @param codec the codec of the data
+TextDecoder::TextDecoder( TextCodec* codec )
+    : converter_( codec->converter() )
+    , skipByteOrderMark_( converter_ == TextCodec::Utf8Converter && !( codec->flags() & QTextCodec::IgnoreHeader ) )
+    , atStart_(true)
+    , pendingLength_(0)
+    , decoder_( converter_ == TextCodec::QtConverter ? codec->makeDecoder() : nullptr )
+{
+}
+
+
+/// The destructor
+TextDecoder::~TextDecoder()
+{
+    delete decoder_;
+}
+
+
+/// Returns the maximum number of characters that decode writes for the given number of bytes
+qint64 TextDecoder::maxDecodedLength(qint64 length) const
+{
+    return length + pendingLength_;
+}
+
+
+/// Decodes the given block of data with the built-in converter.
+/// An incomplete UTF-8 sequence at the end is kept until the next call (or finish)
+/// @param data the data to decode
+/// @param length the number of bytes
+/// @param target the target, with room for maxDecodedLength(length) characters
+/// @return the number of written characters
+qint64 TextDecoder::decode(const char* data, qint64 length, QChar* target)
+{
+    Q_ASSERT( isBuiltin() );
+    const uchar* p = reinterpret_cast<const uchar*>( data );
+    const uchar* end = p + length;
+    QChar* out = target;
+    if( converter_ == TextCodec::Latin1Converter ) {
+        decodeLatin1( p, end, out );
+    } else {
+        if( pendingLength_ > 0 ) { p = decodePending( p, end, out ); }
+        if( p < end ) {
+            const uchar* tail = decodeUtf8( p, end, out );
+            pendingLength_ = static_cast<int>( end - tail );
+            if( pendingLength_ > 0 ) { memcpy( pending_, tail, pendingLength_ ); }
+        }
+    }
+    return skipByteOrderMark( target, out - target );
+}
+
+
+/// Finishes decoding, every byte of an incomplete sequence at the end of the data is replaced by
+/// the replacement character
+/// @param target the target, with room for MaxFinishLength characters
+/// @return the number of written characters
+qint64 TextDecoder::finish(QChar* target)
+{
+    Q_ASSERT( isBuiltin() );
+    for( int i=0; i < pendingLength_; ++i ) { target[i] = QChar( QChar::ReplacementCharacter ); }
+    qint64 length = pendingLength_;
+    pendingLength_ = 0;
+    return skipByteOrderMark( target, length );
+}
+
+
+/// Decodes the given block of data to a string. This works for all codecs
+/// @param data the data to decode
+/// @param length the number of bytes
+/// @return the decoded text
+QString TextDecoder::toUnicode(const char* data, int length)
+{
+    if( decoder_ ) { return decoder_->toUnicode( data, length ); }
+    QString text( static_cast<int>( maxDecodedLength( length ) ), Qt::Uninitialized );
+    text.resize( static_cast<int>( decode( data, length, text.data() ) ) );
+    return text;
+}
+
+
+/// Decodes the sequence(s) that start in the pending bytes of the previous block
+/// @param p the data of the current block
+/// @param end the end of the current block
+/// @param out the target, which is moved after the written characters
+/// @return the first byte of the current block that isn't decoded yet
+const uchar* TextDecoder::decodePending(const uchar* p, const uchar* end, QChar*& out)
+{
+    // a sequence is at most 4 bytes, so at most 3 bytes of the current block are required
+    uchar sequence[sizeof(pending_) + 3];
+    int extra = static_cast<int>( qMin<qptrdiff>( end - p, 3 ) );
+    memcpy( sequence, pending_, pendingLength_ );
+    memcpy( sequence + pendingLength_, p, extra );
+
+    const uchar* s = sequence;
+    const uchar* pendingEnd = sequence + pendingLength_;
+    const uchar* sequenceEnd = pendingEnd + extra;
+    while( s < pendingEnd ) {
+        int length = decodeUtf8Sequence( s, sequenceEnd, out );
+        if( length < 0 ) {
+            // still incomplete, this only happens when the complete block is used
+            pendingLength_ = static_cast<int>( sequenceEnd - s );
+            memmove( pending_, s, pendingLength_ );
+            return end;
+        }
+        s += length;
+    }
+    pendingLength_ = 0;
+    return p + ( s - pendingEnd );
+}
+
+
+/// Removes the byte order mark from the first decoded characters (when required)
+/// @return the new length
+qint64 TextDecoder::skipByteOrderMark(QChar* target, qint64 length)
+{
+    if( atStart_ && length > 0 ) {
+        atStart_ = false;
+        if( skipByteOrderMark_ && target[0].unicode() == 0xFEFF ) {
+            memmove( target, target + 1, ( length - 1 ) * sizeof(QChar) );
+            --length;
+        }
+    }
+    return length;
+}
+
+
+//----------------------------------------------------------
+
+
+/// Encodes a single UTF-16 character (or surrogate pair) to UTF-8. Lone surrogates are replaced by a question mark
+/// @param p the character to encode, which is moved to the next character
+/// @param end the end of the text
+/// @param out the output, which is moved after the written bytes
+/// @param highSurrogate is set when the text ends with a high surrogate (which is consumed)
+static inline void encodeUtf8Character( const ushort*& p, const ushort* end, uchar*& out, ushort& highSurrogate )
+{
+    uint c = *p++;
+    if( c < 0x80 ) {
+        *out++ = static_cast<uchar>( c );
+    } else if( c < 0x800 ) {
+        *out++ = static_cast<uchar>( 0xC0 | ( c >> 6 ) );
+        *out++ = static_cast<uchar>( 0x80 | ( c & 0x3F ) );
+    } else if( !QChar::isSurrogate( c ) ) {
+        *out++ = static_cast<uchar>( 0xE0 | ( c >> 12 ) );
+        *out++ = static_cast<uchar>( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+        *out++ = static_cast<uchar>( 0x80 | ( c & 0x3F ) );
+    } else if( QChar::isHighSurrogate( c ) && p == end ) {
+        highSurrogate = static_cast<ushort>( c );
+    } else if( QChar::isHighSurrogate( c ) && QChar::isLowSurrogate( *p ) ) {
+        uint codePoint = QChar::surrogateToUcs4( static_cast<ushort>( c ), *p++ );
+        *out++ = static_cast<uchar>( 0xF0 | ( codePoint >> 18 ) );
+        *out++ = static_cast<uchar>( 0x80 | ( ( codePoint >> 12 ) & 0x3F ) );
+        *out++ = static_cast<uchar>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+        *out++ = static_cast<uchar>( 0x80 | ( codePoint & 0x3F ) );
+    } else {
+        *out++ = '?';
+    }
+}
+
+
+#ifdef EDBEE_SIMD_SSE2
+
+/// Packs the 16 characters at p to 16 bytes when all characters are below the given limit
+/// @param limit the limit (a power of 2)
+/// @param stopAtNewline when true nothing is packed when one of the characters is a newline
+/// @return false if nothing is written
+static inline bool packCharacters( const ushort* p, uchar* out, ushort limit, bool stopAtNewline )
+{
+    __m128i low = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+    __m128i high = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p + 8) );
+    __m128i outside = _mm_and_si128( _mm_or_si128( low, high ), _mm_set1_epi16( static_cast<short>( ~( limit - 1 ) ) ) );
+    __m128i packable = _mm_cmpeq_epi16( outside, _mm_setzero_si128() );
+    if( stopAtNewline ) {
+        __m128i newline = _mm_set1_epi16( '\n' );
+        packable = _mm_andnot_si128( _mm_or_si128( _mm_cmpeq_epi16( low, newline ), _mm_cmpeq_epi16( high, newline ) ), packable );
+    }
+    if( _mm_movemask_epi8( packable ) != 0xFFFF ) { return false; }
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(out), _mm_packus_epi16( low, high ) );
+    return true;
+}
+
+#endif
+
+
+/// Constructs an encoder for the given codec
+/// @param codec the codec to encode to
+TextEncoder::TextEncoder( TextCodec* codec )
+    : converter_( codec->converter() )
+    , writeByteOrderMark_( converter_ == TextCodec::Utf8Converter && !( codec->flags() & QTextCodec::IgnoreHeader ) )
+    , highSurrogate_(0)
+    , encoder_( converter_ == TextCodec::QtConverter ? codec->makeEncoder() : nullptr )
+{
+}
+
+
+/// The destructor
+TextEncoder::~TextEncoder()
+{
+    delete encoder_;
+}
+
+
+/// Replaces every newline by the given line ending while encoding.
+/// (The text of a document always uses \n, the line ending of the file can be different)
+/// @param chars the line ending characters, \n to disable replacing
+void TextEncoder::setLineEnding(const QString& chars)
+{
+    lineEnding_ = chars == QStringLiteral("\n") ? QString() : chars;
+    lineEndingBytes_ = lineEnding_.toLatin1();
+}
+
+
+/// Encodes the given characters and appends them to the output.
+/// The built-in converters write directly in the output, so the capacity of the output is reused
+/// @param data the characters to encode
+/// @param length the number of characters
+/// @param output the bytes are appended to this array
+void TextEncoder::encode(const QChar* data, int length, QByteArray& output)
+{
+    if( encoder_ ) {
+        encodeWithQt( data, length, output );
+        return;
+    }
+
+    // UTF-8: at most 3 bytes per character, a byte order mark and a completed surrogate pair of the previous call
+    bool utf8 = converter_ == TextCodec::Utf8Converter;
+    int maxCharacterSize = qMax( utf8 ? 3 : 1, lineEndingBytes_.size() );
+    int start = output.size();
+    output.resize( start + maxCharacterSize * length + ( utf8 ? 4 : 0 ) );
+    uchar* begin = reinterpret_cast<uchar*>( output.data() + start );
+    uchar* out = begin;
+    const ushort* p = reinterpret_cast<const ushort*>( data );
+    const ushort* end = p + length;
+
+    if( utf8 ) {
+        if( writeByteOrderMark_ ) {
+            *out++ = 0xEF;
+            *out++ = 0xBB;
+            *out++ = 0xBF;
+            writeByteOrderMark_ = false;
+        }
+        if( highSurrogate_ && p < end ) {
+            if( QChar::isLowSurrogate( *p ) ) {
+                const ushort pair[2] = { highSurrogate_, *p++ };
+                const ushort* pairPtr = pair;
+                encodeUtf8Character( pairPtr, pair + 2, out, highSurrogate_ );
+            } else {
+                *out++ = '?';
+            }
+            highSurrogate_ = 0;
+        }
+    }
+
+    // ASCII (UTF-8) or Latin-1 characters without newlines are packed 16 at a time
+#ifdef EDBEE_SIMD_SSE2
+    ushort limit = utf8 ? 0x80 : 0x100;
+    bool replaceNewlines = !lineEndingBytes_.isEmpty();
+#endif
+    while( p < end ) {
+#ifdef EDBEE_SIMD_SSE2
+        if( end - p >= 16 ) {
+            if( !packCharacters( p, out, limit, replaceNewlines ) ) {
+                for( const ushort* blockEnd = p + 16; p < blockEnd; ) { encodeCharacter( p, end, out ); }
+                continue;
+            }
+            p += 16;
+            out += 16;
+            continue;
+        }
+#endif
+        encodeCharacter( p, end, out );
+    }
+    output.resize( start + static_cast<int>( out - begin ) );
+}
+
+
+/// Encodes the given text and appends it to the output
+void TextEncoder::encode(const QString& text, QByteArray& output)
+{
+    encode( text.constData(), text.length(), output );
+}
+
+
+/// Encodes a single character (or surrogate pair) with the built-in converter
+/// @param p the character to encode, which is moved to the next character
+/// @param end the end of the text
+/// @param out the output, which is moved after the written bytes
+void TextEncoder::encodeCharacter(const ushort*& p, const ushort* end, uchar*& out)
+{
+    if( *p == '\n' && !lineEndingBytes_.isEmpty() ) {
+        memcpy( out, lineEndingBytes_.constData(), lineEndingBytes_.size() );
+        out += lineEndingBytes_.size();
+        ++p;
+    } else if( converter_ == TextCodec::Latin1Converter ) {
+        *out++ = *p < 0x100 ? static_cast<uchar>( *p ) : '?';
+        ++p;
+    } else {
+        encodeUtf8Character( p, end, out, highSurrogate_ );
+    }
+}
+
+
+/// Encodes the given characters with the QTextEncoder. The text is encoded line by line when
+/// newlines are replaced
+void TextEncoder::encodeWithQt(const QChar* data, int length, QByteArray& output)
+{
+    if( lineEnding_.isEmpty() ) {
+        output.append( encoder_->fromUnicode( data, length ) );
+        return;
+    }
+    const QChar* start = data;
+    const QChar* end = data + length;
+    for( const QChar* c = NewlineScanner::find( data, end, '\n' ); c < end; c = NewlineScanner::find( c + 1, end, '\n' ) ) {
+        output.append( encoder_->fromUnicode( start, static_cast<int>( c - start ) ) );
+        output.append( encoder_->fromUnicode( lineEnding_ ) );
+        start = c + 1;
+    }
+    output.append( encoder_->fromUnicode( start, static_cast<int>( end - start ) ) );
+}
+
+
 } // edbee
@@ -37,12 +37,21 @@ private:
 /// The codec has a name and contains methods to create encoders and decoders
 class EDBEE_EXPORT TextCodec {
 public:
+    /// The converter that's used by the TextDecoder and TextEncoder
+    enum Converter {
+        QtConverter,            ///< The QTextCodec is used
+        Utf8Converter,          ///< The built-in UTF-8 converter
+        Latin1Converter         ///< The built-in Latin-1 (ISO-8859-1) converter
+    };
+
     TextCodec( const QString& name, const QTextCodec* codec, QTextCodec::ConversionFlags flags );
     const QTextCodec* codec();
     QTextEncoder* makeEncoder();
     QTextDecoder* makeDecoder();
+    Converter converter();
 
     QString name() { return name_; }
+    QTextCodec::ConversionFlags flags() const { return flags_; }
 
 private:
     QString name_;                          ///< The name of this codec
@@ -51,4 +60,78 @@ private:
 
 };
 
+
+/// Decodes text with the given codec.
+/// UTF-8 and Latin-1 are decoded with built-in (vectorized) converters, which can decode directly in a
+/// given target, like the storage of a textbuffer. Other encodings are decoded with a QTextDecoder.
+///
+/// The data can be decoded block by block, an incomplete UTF-8 sequence at the end of a block is completed
+/// with the next block. Invalid UTF-8 is replaced the same way as the ParallelTextDecoder does: every byte
+/// that doesn't start a valid sequence is replaced by the replacement character (U+FFFD).
+class EDBEE_EXPORT TextDecoder {
+public:
+    explicit TextDecoder( TextCodec* codec );
+    ~TextDecoder();
+
+    /// Returns true if the codec has a built-in converter (only then decode and finish can be used)
+    bool isBuiltin() const { return !decoder_; }
+
+    qint64 maxDecodedLength( qint64 length ) const;
+    qint64 decode( const char* data, qint64 length, QChar* target );
+    qint64 finish( QChar* target );
+    QString toUnicode( const char* data, int length );
+
+    /// The maximum number of characters that's written by finish
+    static const int MaxFinishLength = 3;
+
+private:
+    const uchar* decodePending( const uchar* p, const uchar* end, QChar*& out );
+    qint64 skipByteOrderMark( QChar* target, qint64 length );
+
+    TextCodec::Converter converter_;    ///< The converter to use
+    bool skipByteOrderMark_;            ///< Should a leading byte order mark be skipped?
+    bool atStart_;                      ///< Is nothing decoded yet?
+    uchar pending_[4];                  ///< The incomplete UTF-8 sequence at the end of the last block
+    int pendingLength_;                 ///< The number of bytes in pending_
+    QTextDecoder* decoder_;             ///< The Qt decoder (only for codecs without a built-in converter)
+
+    Q_DISABLE_COPY(TextDecoder)
+};
+
+
+/// Encodes text with the given codec.
+/// UTF-8 and Latin-1 are encoded with built-in (vectorized) converters, which encode directly in the
+/// output buffer. Other encodings are encoded with a QTextEncoder.
+///
+/// The output is identical to the output of the QTextEncoder: a byte order mark is written by the first
+/// call (when the codec has one), characters that can't be encoded are replaced by a question mark and
+/// a surrogate pair can be split over two calls.
+///
+/// The newlines can be replaced by another line ending while encoding, this happens in the same (vectorized) pass.
+class EDBEE_EXPORT TextEncoder {
+public:
+    explicit TextEncoder( TextCodec* codec );
+    ~TextEncoder();
+
+    /// Returns true if the codec has a built-in converter
+    bool isBuiltin() const { return !encoder_; }
+
+    void setLineEnding( const QString& chars );
+    void encode( const QChar* data, int length, QByteArray& output );
+    void encode( const QString& text, QByteArray& output );
+
+private:
+    void encodeCharacter( const ushort*& p, const ushort* end, uchar*& out );
+    void encodeWithQt( const QChar* data, int length, QByteArray& output );
+
+    TextCodec::Converter converter_;    ///< The converter to use
+    bool writeByteOrderMark_;           ///< Should a byte order mark be written by the next call?
+    ushort highSurrogate_;              ///< The high surrogate at the end of the last call (0 if none)
+    QString lineEnding_;                ///< The line ending that replaces the newlines (empty if not replaced)
+    QByteArray lineEndingBytes_;        ///< The line ending for the built-in converters
+    QTextEncoder* encoder_;             ///< The Qt encoder (only for codecs without a built-in converter)
+
+    Q_DISABLE_COPY(TextEncoder)
+};
+
 } // edbee
@@ -41,6 +41,7 @@ void TextCodecDetector::setGlobalPreferedCodec(TextCodec *codec)
 TextCodecDetector::TextCodecDetector(const QByteArray* buffer, TextCodec *preferedCodec)
     : bufferRef_(buffer->constData())
     , bufferLength_(buffer->size())
+    , wholeFile_(false)
     , preferedCodecRef_(0)
     , fallbackCodecRef_(0)
 {
@@ -48,9 +49,10 @@ TextCodecDetector::TextCodecDetector(const QByteArray* buffer, TextCodec *prefer
     setFallbackCodec( 0 );
 }
 
-TextCodecDetector::TextCodecDetector(const char* buffer, int length, TextCodec *preferedCodec)
+TextCodecDetector::TextCodecDetector(const char* buffer, qint64 length, TextCodec *preferedCodec)
     : bufferRef_(buffer)
     , bufferLength_(length)
+    , wholeFile_(false)
     , preferedCodecRef_(0)
     , fallbackCodecRef_(0)
 {
@@ -98,9 +100,8 @@ void TextCodecDetector::setFallbackCodec(TextCodec* codec)
 /// return the charset implied by this BOM. Otherwise, the file would not be a human
 ///  readable text file.
 ///
-/// If there is no BOM, this method tries to discern whether the file is UTF-8 or not.
-/// If it is not UTF-8, we assume the encoding is the default system encoding
-/// (of course, it might be any 8-bit charset, but usually, an 8-bit charset is the default one)
+/// If there is no BOM, this method validates if the buffer is UTF-8 (see codecForValidationResult)
+/// When the buffer isn't the whole file (see setWholeFile), the buffer may end in the middle of a multi-byte sequence.
 ///
 /// It is possible to discern UTF-8 thanks to the pattern of characters with a multi-byte sequence
 ///
@@ -109,12 +110,10 @@ void TextCodecDetector::setFallbackCodec(TextCodec* codec)
 /// 0000 0000-0000 007F       0xxxxxxx
 /// 0000 0080-0000 07FF       110xxxxx 10xxxxxx
 /// 0000 0800-0000 FFFF       1110xxxx 10xxxxxx 10xxxxxx
-/// 0001 0000-001F FFFF       11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
-/// 0020 0000-03FF FFFF       111110xx 10xxxxxx 10xxxxxx 10xxxxxx 10xxxxxx
-/// 0400 0000-7FFF FFFF       1111110x 10xxxxxx 10xxxxxx 10xxxxxx 10xxxxxx 10xxxxxx
+/// 0001 0000-0010 FFFF       11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
 /// @endcode
 ///
-/// With UTF-8, 0xFE and 0xFF never appear.
+/// With UTF-8, 0xC0, 0xC1 and 0xF5-0xFF never appear. Overlong sequences and surrogates are invalid too.
 ///
 /// @return the QTextCodec that is 'detected'
 TextCodec* TextCodecDetector::detectCodec()
@@ -127,110 +126,45 @@ TextCodec* TextCodecDetector::detectCodec()
     if( hasUTF32LEBom(bufferRef_,bufferLength_) ) return codecManager()->codecForName("UTF-32LE with BOM");
     if( hasUTF32BEBom(bufferRef_,bufferLength_) ) return codecManager()->codecForName("UTF-32BE with BOM");
 
-    // if a byte has its most significant bit set, the file is in UTF-8 or in the default encoding
-    // otherwise, the file is in US-ASCII
-    bool highOrderBit = false;
-
-    // if the file is in UTF-8, high order bytes must have a certain value, in order to be valid
-    // if it's not the case, we can assume the encoding is the default encoding of the system
-    bool validU8Char = true;
-
-    // TODO the buffer is not read up to the end, but up to length - 6
-    int length = bufferLength_;
-    int i = 0;
-    while( i < length - 6 )
-    {
-        char b0 = bufferRef_[i];
-        char b1 = bufferRef_[i + 1];
-        char b2 = bufferRef_[i + 2];
-        char b3 = bufferRef_[i + 3];
-        char b4 = bufferRef_[i + 4];
-        char b5 = bufferRef_[i + 5];
-        if (b0 < 0)
-        {
-            // a high order bit was encountered, thus the encoding is not US-ASCII
-            // it may be either an 8-bit encoding or UTF-8
-            highOrderBit = true;
-
-            // a two-bytes sequence was encoutered
-            if (isTwoBytesSequence(b0))
-            {
-                // there must be one continuation byte of the form 10xxxxxx,
-                // otherwise the following characteris is not a valid UTF-8 construct
-                if (!isContinuationChar(b1))
-                    validU8Char = false;
-                else
-                    i++;
-            }
-            // a three-bytes sequence was encoutered
-            else if (isThreeBytesSequence(b0))
-            {
-                // there must be two continuation bytes of the form 10xxxxxx,
-                // otherwise the following characteris is not a valid UTF-8 construct
-                if (!(isContinuationChar(b1) && isContinuationChar(b2)))
-                    validU8Char = false;
-                else
-                    i += 2;
-            }
-            // a four-bytes sequence was encoutered
-            else if (isFourBytesSequence(b0))
-            {
-                // there must be three continuation bytes of the form 10xxxxxx,
-                // otherwise the following characteris is not a valid UTF-8 construct
-                if (!(isContinuationChar(b1) && isContinuationChar(b2) && isContinuationChar(b3)))
-                    validU8Char = false;
-                else
-                    i += 3;
-            }
-            // a five-bytes sequence was encoutered
-            else if (isFiveBytesSequence(b0))
-            {
-                // there must be four continuation bytes of the form 10xxxxxx,
-                // otherwise the following characteris is not a valid UTF-8 construct
-                if (!(isContinuationChar(b1) && isContinuationChar(b2) && isContinuationChar(b3) && isContinuationChar(b4)))
-                    validU8Char = false;
-                else
-                    i += 4;
-            }
-            // a six-bytes sequence was encoutered
-            else if (isSixBytesSequence(b0))
-            {
-                // there must be five continuation bytes of the form 10xxxxxx,
-                // otherwise the following characteris is not a valid UTF-8 construct
-                if (!(isContinuationChar(b1) && isContinuationChar(b2) && isContinuationChar(b3) && isContinuationChar(b4) && isContinuationChar(b5)))
-                    validU8Char = false;
-                else
-                    i += 5;
-            }
-            else
-                validU8Char = false;
-        }
-        if (!validU8Char) break;
-        i++;
-    }
+    return codecForValidationResult( Utf8Validator::validate( bufferRef_, bufferLength_, wholeFile_ ) );
+}
 
-    // if no byte with an high order bit set, the encoding is US-ASCII
-    // (it might have been UTF-7, but this encoding is usually internally used only by mail systems)
-    if (!highOrderBit)
-    {
-        return preferedCodec();
-        //return fallbackCodec(); /// This could be US-ASCII
-    }
 
-    // if no invalid UTF-8 were encountered, we can assume the encoding is UTF-8,
-    // otherwise the file would not be human readable
-    if( validU8Char ) {
-//        return QTextCodec::codecForName("UTF-8");
-        return preferedCodec(); // we sort of assume prefered codec is UTF-8 :P
+/// Returns the codec for data without a Byte Order Marker, with the given UTF-8 validation result.
+/// This makes it possible to validate data that isn't available in a single buffer with an Utf8Validator
+/// @param result the result of the UTF-8 validation
+/// @return the prefered codec for ASCII and UTF-8 data, the fallback codec for other data
+TextCodec* TextCodecDetector::codecForValidationResult(Utf8Validator::Result result)
+{
+    switch( result ) {
+        // if no byte with an high order bit set, the encoding is US-ASCII
+        // (it might have been UTF-7, but this encoding is usually internally used only by mail systems)
+        case Utf8Validator::AsciiResult:
+            return preferedCodec();
+
+        // if no invalid UTF-8 were encountered, we can assume the encoding is UTF-8,
+        // otherwise the file would not be human readable
+        case Utf8Validator::Utf8Result:
+            return preferedCodec(); // we sort of assume prefered codec is UTF-8 :P
+
+        // finally, if it's not UTF-8 nor US-ASCII, let's assume the encoding is the default encoding
+        case Utf8Validator::InvalidResult:
+            break;
     }
-
-    // finally, if it's not UTF-8 nor US-ASCII, let's assume the encoding is the default encoding
     return fallbackCodec();
 }
 
 
+/// Returns true if the buffer starts with one of the supported Byte Order Markers
+bool TextCodecDetector::hasByteOrderMark(const char* buffer, qint64 length)
+{
+    return hasUTF8Bom( buffer, length ) || hasUTF16LEBom( buffer, length ) || hasUTF16BEBom( buffer, length )
+        || hasUTF32LEBom( buffer, length ) || hasUTF32BEBom( buffer, length );
+}
+
+
 /// Has a Byte Order Marker for UTF-8
-bool TextCodecDetector::hasUTF8Bom( const char* bom, int length )
+bool TextCodecDetector::hasUTF8Bom( const char* bom, qint64 length )
 {
     if( length < 3 ) return false;
     return (bom[0] == -17 && bom[1] == -69 && bom[2] == -65);
@@ -238,7 +172,7 @@ bool TextCodecDetector::hasUTF8Bom( const char* bom, int length )
 
 /// Has a Byte Order Marker for UTF-16 Low Endian
 /// (ucs-2le, ucs-4le, and ucs-16le).
-bool TextCodecDetector::hasUTF16LEBom( const char* bom, int length )
+bool TextCodecDetector::hasUTF16LEBom( const char* bom, qint64 length )
 {
     if( length < 2 ) return false;
     return (bom[0] == -1 && bom[1] == -2);
@@ -246,7 +180,7 @@ bool TextCodecDetector::hasUTF16LEBom( const char* bom, int length )
 
 /// Has a Byte Order Marker for UTF-16 Big Endian
 /// (utf-16 and ucs-2).
-bool TextCodecDetector::hasUTF16BEBom( const char* bom, int length )
+bool TextCodecDetector::hasUTF16BEBom( const char* bom, qint64 length )
 {
     if( length < 2 ) return false;
     return (bom[0] == -2 && bom[1] == -1);
@@ -255,14 +189,14 @@ bool TextCodecDetector::hasUTF16BEBom( const char* bom, int length )
 
 
 /// Has a Byte Order Marker for UTF-32 Low Endian
-bool TextCodecDetector::hasUTF32LEBom( const char* bom, int length )
+bool TextCodecDetector::hasUTF32LEBom( const char* bom, qint64 length )
 {
     if( length < 4 ) return false;
     return (bom[0] == -1 && bom[1] == -2 && bom[2] == 0 && bom[3] == 0 );
 }
 
 /// Has a Byte Order Marker for UTF-32 Big Endian
-bool TextCodecDetector::hasUTF32BEBom( const char* bom, int length )
+bool TextCodecDetector::hasUTF32BEBom( const char* bom, qint64 length )
 {
     if( length < 4 ) return false;
     return (bom[0] == 0 && bom[1] == 0 && bom[2] == -2 && bom[3] == -1);
@@ -5,6 +5,7 @@
 
 #include "edbee/exports.h"
 
+#include "edbee/util/utf8validator.h"
 
 class QByteArray;
 
@@ -24,7 +25,9 @@ class TextCodec;
 /// with a Byte Order Marker are easy to find. For UTF-8 files with no BOM, if the buffer
 /// is wide enough, it's easy to guess.
 ///
-/// A byte buffer of 4KB or 8KB is sufficient to be able to guess the encoding.
+/// A byte buffer of 4KB or 8KB is usually sufficient to be able to guess the encoding. But files that only contain
+/// non-ASCII characters after the first block are mis-detected. The UTF-8 validation is vectorized (Utf8Validator),
+/// so it's possible to validate complete files. Use setWholeFile when the buffer contains the complete file.
 ///
 /// TextCodecDetector detector( QByteArray)  ;
 /// TextCodec encoding = detector.guessEncoding( QByteArray arr, QTextCode fallback );
@@ -37,14 +40,15 @@ public:
 
 
     explicit TextCodecDetector( const QByteArray* buffer=0,  TextCodec* preferedCodec=0 );
-    explicit TextCodecDetector( const char* buffer, int length=0, TextCodec* preferedCodec=0 );
+    explicit TextCodecDetector( const char* buffer, qint64 length=0, TextCodec* preferedCodec=0 );
     virtual ~TextCodecDetector();
 
 
     virtual TextCodec* detectCodec();
+    virtual TextCodec* codecForValidationResult( Utf8Validator::Result result );
 
     /// Sets the buffer reference
-    virtual void setBuffer( const char* buf, int length )
+    virtual void setBuffer( const char* buf, qint64 length )
     {
         bufferRef_ = buf;
         bufferLength_ = length;
@@ -54,7 +58,12 @@ public:
     virtual const char*buffer() const { return bufferRef_; }
 
     /// Returns the buffer length
-    virtual int bufferLength() { return bufferLength_; }
+    virtual qint64 bufferLength() { return bufferLength_; }
+
+    /// When the buffer contains the whole file, an incomplete UTF-8 sequence at the end of the buffer is invalid.
+    /// (By default the buffer is the first block of a file)
+    virtual void setWholeFile( bool wholeFile ) { wholeFile_ = wholeFile; }
+    virtual bool isWholeFile() const { return wholeFile_; }
 
     virtual void setPreferedCodec( TextCodec* codec=0 );
     virtual TextCodec* preferedCodec() { return preferedCodecRef_; }
@@ -63,41 +72,21 @@ public:
     virtual void setFallbackCodec( TextCodec* codec=0 );
     virtual TextCodec* fallbackCodec() const { return fallbackCodecRef_; }
 
-
-
-protected:
-
-    ///  If the byte has the form 10xxxxx, then it's a continuation byte of a multiple byte character;
-    virtual bool isContinuationChar( char b) { return /*-128 <= b && */ b <= -65; }
-
-    /// If the byte has the form 110xxxx, then it's the first byte of a two-bytes sequence character.
-    virtual bool  isTwoBytesSequence(char b) { return -64 <= b && b <= -33; }
-
-    /// If the byte has the form 1110xxx, then it's the first byte of a three-bytes sequence character.
-    virtual bool isThreeBytesSequence(char b) { return -32 <= b && b <= -17; }
-
-    /// If the byte has the form 11110xx, then it's the first byte of a four-bytes sequence character.
-    virtual bool  isFourBytesSequence(char b) { return -16 <= b && b <= -9; }
-
-    /// If the byte has the form 11110xx, then it's the first byte of a five-bytes sequence character.
-    virtual bool  isFiveBytesSequence(char b) { return -8 <= b && b <= -5; }
-
-    // If the byte has the form 1110xxx, then it's the first byte of a six-bytes sequence character.
-    virtual bool isSixBytesSequence(char b){  return -4 <= b && b <= -3; }
-
 public:
-    static bool hasUTF8Bom( const char* buffer, int length );
-    static bool hasUTF16LEBom( const char* buffer, int length );
-    static bool hasUTF16BEBom( const char* buffer, int length );
-    static bool hasUTF32LEBom( const char* buffer, int length );
-    static bool hasUTF32BEBom( const char* buffer, int length );
+    static bool hasByteOrderMark( const char* buffer, qint64 length );
+    static bool hasUTF8Bom( const char* buffer, qint64 length );
+    static bool hasUTF16LEBom( const char* buffer, qint64 length );
+    static bool hasUTF16BEBom( const char* buffer, qint64 length );
+    static bool hasUTF32LEBom( const char* buffer, qint64 length );
+    static bool hasUTF32BEBom( const char* buffer, qint64 length );
 
 
 private:
 
     //const QByteArray *bufferRef_;   ///< A reference to the current buffer of data
     const char* bufferRef_;         ///< A reference to the buffer
-    int bufferLength_;              ///< The size of the buffer
+    qint64 bufferLength_;           ///< The size of the buffer
+    bool wholeFile_;                ///< Does the buffer contain the whole file?
 
     TextCodec* preferedCodecRef_;  ///< The prefered codec to use
     TextCodec* fallbackCodecRef_;   ///< The default codec to return. This is the codec to use if there's a problem detecting the codec or returning the prefered codec
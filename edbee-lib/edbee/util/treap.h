@@ -0,0 +1,73 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <QtGlobal>
+
+namespace edbee {
+
+
+/// The shared operations of the treaps (randomized balanced binary trees) of the RopeTextBuffer and the LineOffsetTree.
+///
+/// Every node is a chunk (of text or of line lengths) with a priority and an owned left and right subtree.
+/// A node always has a higher (or equal) priority than its children. Update recalculates the aggregated subtree
+/// values of a node after its children have been changed. Splitting a tree depends on the content of the chunks,
+/// so that's implemented by the trees themselves.
+template<typename Node, void (*Update)( Node* )>
+class Treap {
+public:
+
+    /// Merges the 2 given trees. All chunks of the left tree are placed before the chunks of the right tree
+    /// @return the merged tree
+    static Node* merge( Node* left, Node* right )
+    {
+        if( !left ) return right;
+        if( !right ) return left;
+
+        if( left->priority > right->priority ) {
+            left->right = merge( left->right, right );
+            Update( left );
+            return left;
+        } else {
+            right->left = merge( left, right->left );
+            Update( right );
+            return right;
+        }
+    }
+
+    /// Deletes the given node and all its children
+    static void deleteTree( Node* node )
+    {
+        if( !node ) return;
+        deleteTree( node->left );
+        deleteTree( node->right );
+        delete node;
+    }
+
+    /// Returns the number of nodes in the given subtree
+    static int nodeCount( const Node* node )
+    {
+        if( !node ) return 0;
+        return nodeCount( node->left ) + 1 + nodeCount( node->right );
+    }
+
+    /// Returns the first node (chunk) of the given tree (the tree may not be empty)
+    static const Node* firstNode( const Node* node )
+    {
+        Q_ASSERT( node );
+        while( node->left ) { node = node->left; }
+        return node;
+    }
+
+    /// Returns the last node (chunk) of the given tree (the tree may not be empty)
+    static const Node* lastNode( const Node* node )
+    {
+        Q_ASSERT( node );
+        while( node->right ) { node = node->right; }
+        return node;
+    }
+};
+
+
+} // edbee
@@ -0,0 +1,365 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "utf8validator.h"
+
+#include <QtAlgorithms>
+
+#include <string.h>
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// The functions of a single implementation
+struct Utf8ValidatorKernels {
+    /// Validates the given data. An incomplete sequence at the end of the data isn't an error.
+    /// @param nonAscii is set to true when a non-ASCII byte is found
+    /// @param tail is set to the start of the incomplete sequence at the end (end when the last sequence is complete)
+    /// @return false if the data is invalid
+    bool (*validate)( const uchar* begin, const uchar* end, bool& nonAscii, const uchar*& tail );
+};
+
+
+//=============================================================================
+// Scalar implementation
+//=============================================================================
+
+/// Returns the length of the sequence that starts with the given byte (0 if it can't start a sequence)
+static inline int sequenceLength( uchar lead )
+{
+    if( lead < 0x80 ) { return 1; }
+    if( lead < 0xC2 ) { return 0; }     // continuation bytes and overlong 2 byte sequences
+    if( lead < 0xE0 ) { return 2; }
+    if( lead < 0xF0 ) { return 3; }
+    if( lead < 0xF5 ) { return 4; }
+    return 0;                           // above U+10FFFF or the obsolete 5 and 6 byte sequences
+}
+
+
+/// Returns true if the byte is valid after the given lead byte. The second byte excludes overlong
+/// sequences, surrogates and code points above U+10FFFF
+static inline bool isValidSecondByte( uchar lead, uchar byte )
+{
+    switch( lead ) {
+        case 0xE0: return 0xA0 <= byte && byte <= 0xBF;
+        case 0xED: return 0x80 <= byte && byte <= 0x9F;
+        case 0xF0: return 0x90 <= byte && byte <= 0xBF;
+        case 0xF4: return 0x80 <= byte && byte <= 0x8F;
+        default: return ( byte & 0xC0 ) == 0x80;
+    }
+}
+
+
+/// Validates the (possibly incomplete) sequence that starts at p
+/// @return the length of the sequence, 0 if it's invalid or -1 if the data ends before the sequence is complete
+static inline int validateSequence( const uchar* p, const uchar* end )
+{
+    int length = sequenceLength( *p );
+    if( length <= 1 ) { return length; }
+    qptrdiff available = end - p;
+    if( available > 1 && !isValidSecondByte( p[0], p[1] ) ) { return 0; }
+    for( int i=2; i < length && i < available; ++i ) {
+        if( ( p[i] & 0xC0 ) != 0x80 ) { return 0; }
+    }
+    return available < length ? -1 : length;
+}
+
+
+/// Returns the first non-ASCII byte (or end). The data is tested 8 bytes at a time
+static inline const uchar* scalarSkipAscii( const uchar* p, const uchar* end )
+{
+    for( ; end - p >= 8; p += 8 ) {
+        quint64 word;
+        memcpy( &word, p, sizeof(word) );
+        if( word & Q_UINT64_C(0x8080808080808080) ) { break; }
+    }
+    while( p < end && *p < 0x80 ) { ++p; }
+    return p;
+}
+
+
+/// Skips the ASCII parts with the given function and validates the other sequences one by one
+template<const uchar* (*skipAscii)( const uchar*, const uchar* )>
+static bool validateSequences( const uchar* begin, const uchar* end, bool& nonAscii, const uchar*& tail )
+{
+    const uchar* p = begin;
+    while( ( p = skipAscii( p, end ) ) < end ) {
+        nonAscii = true;
+        int length = validateSequence( p, end );
+        if( length == 0 ) { return false; }
+        if( length < 0 ) {
+            tail = p;
+            return true;
+        }
+        p += length;
+    }
+    tail = end;
+    return true;
+}
+
+
+static const Utf8ValidatorKernels scalarKernels = {
+    validateSequences<scalarSkipAscii>
+};
+
+
+//=============================================================================
+// SSE2 implementation (ASCII is skipped 16 bytes at a time)
+//=============================================================================
+
+#ifdef EDBEE_SIMD_SSE2
+
+static inline const uchar* sse2SkipAscii( const uchar* p, const uchar* end )
+{
+    for( ; end - p >= 16; p += 16 ) {
+        quint32 mask = static_cast<quint32>( _mm_movemask_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ) ) );
+        if( mask ) { return p + qCountTrailingZeroBits(mask); }
+    }
+    return scalarSkipAscii( p, end );
+}
+
+
+static const Utf8ValidatorKernels sse2Kernels = {
+    validateSequences<sse2SkipAscii>
+};
+
+#endif
+
+
+//=============================================================================
+// AVX2 implementation (32 bytes per step)
+//=============================================================================
+
+#ifdef EDBEE_SIMD_AVX2
+
+// Every byte is classified with the high and low nibble of the previous byte and the high nibble of the byte itself.
+// Every lookup returns the set of errors that are possible with that nibble, the byte pair is invalid when an error
+// is possible for all three nibbles.
+static const uchar TooShort = 1 << 0;        ///< A lead byte or ASCII after a lead byte
+static const uchar TooLong = 1 << 1;         ///< A continuation byte after ASCII
+static const uchar Overlong3 = 1 << 2;       ///< An overlong 3 byte sequence (E0 80..9F)
+static const uchar TooLarge = 1 << 3;        ///< A code point above U+10FFFF (F4 90..BF, F5..FF)
+static const uchar Surrogate = 1 << 4;       ///< A surrogate code point (ED A0..BF)
+static const uchar Overlong2 = 1 << 5;       ///< An overlong 2 byte sequence (C0, C1)
+static const uchar TooLarge1000 = 1 << 6;    ///< A code point above U+10FFFF (F5..FF 80..8F)
+static const uchar Overlong4 = 1 << 6;       ///< An overlong 4 byte sequence (F0 80..8F)
+static const uchar TwoConts = 1 << 7;        ///< Two continuation bytes (only valid in 3 and 4 byte sequences)
+static const uchar Carry = TooShort | TooLong | TwoConts;
+
+/// The errors indexed by the high nibble of the previous byte
+static const uchar byte1HighTable[16] = {
+    TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+    TwoConts, TwoConts, TwoConts, TwoConts,
+    TooShort | Overlong2,
+    TooShort,
+    TooShort | Overlong3 | Surrogate,
+    TooShort | TooLarge | TooLarge1000 | Overlong4
+};
+
+/// The errors indexed by the low nibble of the previous byte
+static const uchar byte1LowTable[16] = {
+    Carry | Overlong3 | Overlong2 | Overlong4,
+    Carry | Overlong2,
+    Carry,
+    Carry,
+    Carry | TooLarge,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000 | Surrogate,
+    Carry | TooLarge | TooLarge1000,
+    Carry | TooLarge | TooLarge1000
+};
+
+/// The errors indexed by the high nibble of the byte itself
+static const uchar byte2HighTable[16] = {
+    TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+    TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4,
+    TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge,
+    TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+    TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+    TooShort, TooShort, TooShort, TooShort
+};
+
+/// A block that ends with a byte above these values ends with an incomplete sequence
+static const uchar incompleteTable[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+
+
+EDBEE_TARGET_AVX2 static inline __m256i avx2Table( const uchar* table )
+{
+    return _mm256_broadcastsi128_si256( _mm_loadu_si128( reinterpret_cast<const __m128i*>(table) ) );
+}
+
+
+EDBEE_TARGET_AVX2 static bool avx2Validate( const uchar* begin, const uchar* end, bool& nonAscii, const uchar*& tail )
+{
+    const __m256i byte1High = avx2Table( byte1HighTable );
+    const __m256i byte1Low = avx2Table( byte1LowTable );
+    const __m256i byte2High = avx2Table( byte2HighTable );
+    const __m256i incompleteMax = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(incompleteTable) );
+    const __m256i lowNibble = _mm256_set1_epi8( 0x0F );
+    const __m256i thirdByte = _mm256_set1_epi8( static_cast<char>( 0xE0 - 0x80 ) );
+    const __m256i fourthByte = _mm256_set1_epi8( static_cast<char>( 0xF0 - 0x80 ) );
+    const __m256i highBit = _mm256_set1_epi8( static_cast<char>(0x80) );
+
+    __m256i error = _mm256_setzero_si256();
+    __m256i prevInput = _mm256_setzero_si256();
+    __m256i prevIncomplete = _mm256_setzero_si256();
+    const uchar* p = begin;
+    for( ; end - p >= 32; p += 32 ) {
+        __m256i input = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) );
+        if( _mm256_movemask_epi8( input ) == 0 ) {
+            // an ASCII block is only invalid when the previous block ends with an incomplete sequence
+            error = _mm256_or_si256( error, prevIncomplete );
+        } else {
+            nonAscii = true;
+
+            // the input shifted by 1, 2 and 3 bytes (with the last bytes of the previous block)
+            __m256i shifted = _mm256_permute2x128_si256( prevInput, input, 0x21 );
+            __m256i prev1 = _mm256_alignr_epi8( input, shifted, 15 );
+            __m256i prev2 = _mm256_alignr_epi8( input, shifted, 14 );
+            __m256i prev3 = _mm256_alignr_epi8( input, shifted, 13 );
+
+            __m256i special = _mm256_and_si256(
+                _mm256_and_si256(
+                    _mm256_shuffle_epi8( byte1High, _mm256_and_si256( _mm256_srli_epi16( prev1, 4 ), lowNibble ) ),
+                    _mm256_shuffle_epi8( byte1Low, _mm256_and_si256( prev1, lowNibble ) ) ),
+                _mm256_shuffle_epi8( byte2High, _mm256_and_si256( _mm256_srli_epi16( input, 4 ), lowNibble ) ) );
+
+            // the third and fourth byte of a sequence must be continuation bytes (which have the TwoConts bit)
+            __m256i mustBeContinuation = _mm256_and_si256( _mm256_or_si256( _mm256_subs_epu8( prev2, thirdByte ), _mm256_subs_epu8( prev3, fourthByte ) ), highBit );
+            error = _mm256_or_si256( error, _mm256_xor_si256( mustBeContinuation, special ) );
+            if( !_mm256_testz_si256( error, error ) ) { return false; }
+
+            prevIncomplete = _mm256_subs_epu8( input, incompleteMax );
+        }
+        prevInput = input;
+    }
+    if( !_mm256_testz_si256( error, error ) ) { return false; }
+
+    // the last sequence of the blocks can continue after the blocks, validate it with the remaining bytes
+    const uchar* start = p;
+    for( int i=0; i < 3 && start > begin && ( start[-1] & 0xC0 ) == 0x80; ++i ) { --start; }
+    if( start > begin && start[-1] >= 0xC0 ) { --start; }
+    return validateSequences<scalarSkipAscii>( start, end, nonAscii, tail );
+}
+
+
+static const Utf8ValidatorKernels avx2Kernels = {
+    avx2Validate
+};
+
+#endif
+
+
+//=============================================================================
+// Dispatching
+//=============================================================================
+
+/// The kernels of all implementations. The table is initialized on first use (thread-safe)
+static SimdKernelTable<Utf8ValidatorKernels>& kernelTable()
+{
+    static SimdKernelTable<Utf8ValidatorKernels> table( &scalarKernels, EDBEE_SSE2_KERNELS(sse2Kernels), EDBEE_AVX2_KERNELS(avx2Kernels) );
+    return table;
+}
+
+
+Utf8Validator::Utf8Validator()
+    : nonAscii_(false)
+    , invalid_(false)
+    , pendingLength_(0)
+{
+}
+
+
+/// Validates the next block of data. A sequence is allowed to continue in the next block
+/// @param data the data to validate
+/// @param length the number of bytes
+void Utf8Validator::append(const char* data, qint64 length)
+{
+    if( invalid_ ) { return; }
+    const uchar* p = reinterpret_cast<const uchar*>(data);
+    const uchar* end = p + length;
+
+    // complete the incomplete sequence of the previous block
+    if( pendingLength_ > 0 ) {
+        int sequenceLen = sequenceLength( pending_[0] );
+        while( pendingLength_ < sequenceLen && p < end ) { pending_[pendingLength_++] = *p++; }
+        int result = validateSequence( pending_, pending_ + pendingLength_ );
+        if( result == 0 ) {
+            invalid_ = true;
+            return;
+        }
+        if( result < 0 ) { return; }
+        pendingLength_ = 0;
+    }
+
+    const uchar* tail = end;
+    if( !kernelTable().active()->validate( p, end, nonAscii_, tail ) ) {
+        invalid_ = true;
+        return;
+    }
+    pendingLength_ = static_cast<int>( end - tail );
+    Q_ASSERT( pendingLength_ < 4 );
+    if( pendingLength_ > 0 ) { memcpy( pending_, tail, pendingLength_ ); }
+}
+
+
+/// Returns the result of the appended data
+/// @param complete when true an incomplete sequence at the end of the data is invalid. Use false when the data is
+///                 the start of a larger block of data
+Utf8Validator::Result Utf8Validator::result(bool complete) const
+{
+    if( invalid_ || ( complete && pendingLength_ > 0 ) ) { return InvalidResult; }
+    return nonAscii_ ? Utf8Result : AsciiResult;
+}
+
+
+/// Resets the validator, so it can be used for other data
+void Utf8Validator::reset()
+{
+    nonAscii_ = false;
+    invalid_ = false;
+    pendingLength_ = 0;
+}
+
+
+/// Validates the given data
+/// @param data the data to validate
+/// @param length the number of bytes
+/// @param complete when false the data may end with an incomplete sequence (for example the first block of a file)
+Utf8Validator::Result Utf8Validator::validate(const char* data, qint64 length, bool complete)
+{
+    Utf8Validator validator;
+    validator.append( data, length );
+    return validator.result( complete );
+}
+
+
+/// Returns the active implementation
+Utf8Validator::Implementation Utf8Validator::implementation()
+{
+    return kernelTable().implementation();
+}
+
+
+/// Changes the active implementation. This method isn't thread-safe, it's meant for testing and benchmarking
+/// @param implementation the implementation to use
+/// @return false if the implementation isn't supported (the active implementation isn't changed)
+bool Utf8Validator::setImplementation(Implementation implementation)
+{
+    return kernelTable().setImplementation( implementation );
+}
+
+
+} // edbee
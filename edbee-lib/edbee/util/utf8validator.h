@@ -0,0 +1,55 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/exports.h"
+
+#include <QString>
+
+#include "edbee/util/simdsupport.h"
+
+namespace edbee {
+
+
+/// Validates UTF-8 encoded data.
+///
+/// The validator is fast enough to validate complete files, so the encoding detection doesn't need to guess with
+/// the first block of a file. It contains vectorized implementations: SSE2 skips ASCII 16 bytes at a time and AVX2
+/// validates 32 bytes at a time with nibble lookup tables (the algorithm of simdjson/simdutf by John Keiser and
+/// Daniel Lemire). The fastest implementation that's supported by the CPU is selected at runtime.
+///
+/// Only well-formed UTF-8 is accepted (table 3-7 of the Unicode standard): overlong encodings, surrogates,
+/// code points above U+10FFFF and the obsolete 5 and 6 byte sequences are invalid.
+///
+/// Data can be validated with a single validate call or block by block with the append method.
+class EDBEE_EXPORT Utf8Validator : public SimdSupport {
+public:
+    enum Result {
+        AsciiResult,        ///< The data only contains ASCII characters
+        Utf8Result,         ///< The data is valid UTF-8 and contains non-ASCII characters
+        InvalidResult       ///< The data isn't valid UTF-8
+    };
+
+    Utf8Validator();
+
+    void append( const char* data, qint64 length );
+    Result result( bool complete=true ) const;
+    void reset();
+
+    /// Returns true if invalid data has been appended
+    bool isInvalid() const { return invalid_; }
+
+    static Result validate( const char* data, qint64 length, bool complete=true );
+
+    static Implementation implementation();
+    static bool setImplementation( Implementation implementation );
+
+private:
+    bool nonAscii_;             ///< Has a non-ASCII byte been appended?
+    bool invalid_;              ///< Has invalid data been appended?
+    uchar pending_[4];          ///< The incomplete sequence at the end of the appended data
+    int pendingLength_;         ///< The number of bytes in pending_
+};
+
+} // edbee
@@ -0,0 +1,32 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <QtGlobal>
+
+namespace edbee {
+
+
+/// A small and fast pseudo random number generator (xorshift32).
+/// The sequence only depends on the seed, which makes it usable for treap priorities and reproducible random tests.
+class XorShiftRandom {
+public:
+    /// Constructs the generator with the given seed (which may not be 0)
+    explicit XorShiftRandom( quint32 seed ) : seed_(seed) { Q_ASSERT( seed != 0 ); }
+
+    /// Returns the next pseudo random number
+    quint32 next()
+    {
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        return seed_;
+    }
+
+private:
+    quint32 seed_;      ///< The current state of the generator
+};
+
+
+} // edbee
@@ -117,7 +117,7 @@ static const QString VTEXT_PART(TextDocument* doc, int offset, int length)
         return QString();
     }
 
-    return doc->textPart(offset, qMin(length, doc->length() - offset));
+    return doc->textPart(offset, qMin<TextOffset>(length, doc->length() - offset));
 #else
     int docLength = doc->length();
 #if defined(WINDOWS_LAST_LINE_ERROR_FIX)
@@ -217,7 +217,7 @@ void AccessibleTextEditorWidget::notifyTextChangeEvent(TextEditorWidget *widget,
     QWidget* eventWidget = eventWidgetForTextEditor(widget);
 
     QString oldText = VTEXT(oldDocText);
-    QString newText = VTEXT(QString(change->newText()));
+    QString newText = VTEXT(QString(change->newText(), change->newTextLength()));
 
     QAccessibleTextUpdateEvent ev(eventWidget, D2V(widget, change->offset()), oldText, newText);
     // TODO: When a caret is included, (Inherited change, use this caret position)
@@ -225,7 +225,7 @@ void AccessibleTextEditorWidget::notifyTextChangeEvent(TextEditorWidget *widget,
 //    qDebug() << "-- change: length: " << change->length()
 //             << ", newTextLength: " << change->newTextLength()
 //             << ", offset :" << change->offset()
-//             << ", newText: " << QString(change->newText())
+//             << ", newText: " << QString(change->newText(), change->newTextLength())
 //             << ", CONTENT: " << widget->textDocument()->text();
 //    qDebug() << "!! updateAccessibility: QAccessibleTextUpdateEvent: " << change->offset()<< ", oldText: " << oldText << ", newText: " << newText;
 
@@ -212,7 +212,7 @@ void TextEditorAutoCompleteComponent::showInfoTip()
     infoTipRef_->resize(tipSize.width(), tipSize.height() - 4);
 
     //position the list
-    positionWidgetForCaretOffset( qMax(0,range.caret() - currentWord_.length()) );
+    positionWidgetForCaretOffset( qMax<TextOffset>(0,range.caret() - currentWord_.length()) );
 
     QPoint newLoc(listWidgetRef_->parentWidget()->mapToGlobal(r.topRight()).x() + xOffset, listWidgetRef_->parentWidget()->mapToGlobal(r.topRight()).y() + 1);
 
@@ -17,6 +17,7 @@
 #include "edbee/models/textdocument.h"
 #include "edbee/models/texteditorconfig.h"
 #include "edbee/models/textlexer.h"
+#include "edbee/models/textlexerscheduler.h"
 #include "edbee/views/textlayout.h"
 #include "edbee/views/textselection.h"
 #include "edbee/views/texttheme.h"
@@ -40,6 +41,7 @@ TextRenderer::TextRenderer(TextEditorController* controller)
     , caretBlinkRate_(0)
     , totalWidthCache_(0)
     , textThemeStyler_(nullptr)
+    , lexerScheduler_(nullptr)
     , clipRectRef_(nullptr)
     , startOffset_(0)
     , endOffset_(0)
@@ -50,6 +52,8 @@ TextRenderer::TextRenderer(TextEditorController* controller)
     connect( controller, SIGNAL(textDocumentChanged(edbee::TextDocument*,edbee::TextDocument*)), this, SLOT(textDocumentChanged(edbee::TextDocument*,edbee::TextDocument*)));
     textThemeStyler_ = new TextThemeStyler(controller);
     placeHolderDocument_ = new CharTextDocument();
+    lexerScheduler_ = new TextLexerScheduler(this);
+    connect( lexerScheduler_, SIGNAL(batchLexed(edbee::TextOffset,edbee::TextOffset)), this, SLOT(batchLexed(edbee::TextOffset,edbee::TextOffset)) );
 }
 
 
@@ -480,10 +484,12 @@ void TextRenderer::renderBegin( const QRect& rect )
 //PROF_END
 
 /// TODO: move this lexing stuff to the controller
-    // prepare the style
+    // prepare the style. When the lines before the visible lines aren't lexed (after jumping to the end of a
+    // large document), the lexing continues after painting and the lines are painted without styling
     if( textDocument()->textLexer() ) {
 //PROF_BEGIN_NAMED("lexer")
-        textDocument()->textLexer()->lexRange( startOffset_, endOffset_ );
+        lexerScheduler_->setDocument( textDocument() );
+        lexerScheduler_->lexRange( startOffset_, endOffset_ );
 //PROF_END
     }
 
@@ -624,7 +630,7 @@ void TextRenderer::textDocumentChanged(edbee::TextDocument *oldDocument, edbee::
 
     // connect with the new dpcument
     connect( newDocument, SIGNAL(textChanged(edbee::TextBufferChange, QString)), this, SLOT(textChanged(edbee::TextBufferChange, QString)));
-    connect( newDocument, SIGNAL(lastScopedOffsetChanged(int,int)), this, SLOT(lastScopedOffsetChanged(int,int)) );
+    connect( newDocument, SIGNAL(lastScopedOffsetChanged(edbee::TextOffset,edbee::TextOffset)), this, SLOT(lastScopedOffsetChanged(edbee::TextOffset,edbee::TextOffset)) );
 }
 
 
@@ -653,7 +659,7 @@ void TextRenderer::textChanged(edbee::TextBufferChange change, QString oldText)
 
 
 /// The scoped to offset has been changed
-void TextRenderer::lastScopedOffsetChanged(int previousOffset, int newOffset)
+void TextRenderer::lastScopedOffsetChanged(edbee::TextOffset previousOffset, edbee::TextOffset newOffset)
 {
 //qlog_info() << "** lastScopedOffsetChanged("<<previousOffset<<","<<newOffset<<") **";
     Q_UNUSED(newOffset)
@@ -663,6 +669,18 @@ void TextRenderer::lastScopedOffsetChanged(int previousOffset, int newOffset)
 }
 
 
+/// A time slice is lexed after painting, the visible lines that are lexed are repainted
+void TextRenderer::batchLexed(edbee::TextOffset previousOffset, edbee::TextOffset lastScopedOffset)
+{
+    if( !textWidget() ) { return; }
+    int firstLine = qMax( textDocument()->lineFromOffset( previousOffset ), firstVisibleLine() );
+    int lastLine = qMin( textDocument()->lineFromOffset( lastScopedOffset ), firstVisibleLine() + viewHeightInLines() + 1 );
+    if( firstLine <= lastLine ) {
+        textWidget()->updateLine( firstLine, lastLine - firstLine + 1 );
+    }
+}
+
+
 /// Invalidates the QTextLayout caches
 void TextRenderer::invalidateTextLayoutCaches(int fromLine)
 {
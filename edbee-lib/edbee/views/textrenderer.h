@@ -23,6 +23,7 @@ class TextDocument;
 class TextEditorConfig;
 class TextEditorController;
 class TextEditorWidget;
+class TextLexerScheduler;
 class TextRangeSet;
 class TextSelection;
 class TextTheme;
@@ -95,6 +96,8 @@ public:
 // theme support
     TextThemeStyler* themeStyler() { return textThemeStyler_; }
 
+    TextLexerScheduler* lexerScheduler() { return lexerScheduler_; }
+
     QString themeName() const;
     TextTheme* theme();
     void setThemeByName( const QString& name );
@@ -115,7 +118,8 @@ protected slots:
     void textDocumentChanged( edbee::TextDocument* oldDocument, edbee::TextDocument* newDocument );
     void textChanged( edbee::TextBufferChange change, QString oldText = QString() );
 
-    void lastScopedOffsetChanged( int previousOffset, int newOffset );
+    void lastScopedOffsetChanged( edbee::TextOffset previousOffset, edbee::TextOffset newOffset );
+    void batchLexed( edbee::TextOffset previousOffset, edbee::TextOffset lastScopedOffset );
 
 public slots:
 
@@ -138,6 +142,7 @@ private:
     int totalWidthCache_;                           ///< The total width cache
 
     TextThemeStyler* textThemeStyler_;              ///< The current theme styler
+    TextLexerScheduler* lexerScheduler_;            ///< Lexes the visible lines in time slices
 
     // temporary variables only valid the int the current context
     const QRect* clipRectRef_;                ///< A reference to the clipping rectangle
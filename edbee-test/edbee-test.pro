@@ -20,6 +20,8 @@ INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 DEFINES += QT_NODLL
 
+# Must match the edbee-lib configuration (see edbee/textoffset.h)
+edbee_64bit_offsets: DEFINES += EDBEE_64BIT_OFFSETS
 
 # The test sources
 SOURCES += \
@@ -50,7 +52,33 @@ SOURCES += \
   edbee/util/rangesetlineiteratortest.cpp \
   edbee/models/dynamicvariablestest.cpp \
   edbee/util/rangelineiteratortest.cpp \
-  edbee/views/textthememanagertest.cpp
+  edbee/views/textthememanagertest.cpp \
+  edbee/models/ropedocument/ropetextbuffertest.cpp \
+  edbee/models/textoffsettest.cpp \
+  edbee/models/mappeddocument/mappedtextbuffertest.cpp \
+  edbee/benchmarkcase.cpp \
+  edbee/util/lineoffsettreetest.cpp \
+  edbee/util/lineoffsetbenchmark.cpp \
+  edbee/util/newlinescannertest.cpp \
+  edbee/util/newlinescannerbenchmark.cpp \
+  edbee/allocationcounter.cpp \
+  edbee/models/typingbenchmark.cpp \
+  edbee/models/textsnapshottest.cpp \
+  edbee/util/paralleltextdecodertest.cpp \
+  edbee/textdocumentserializerbenchmark.cpp \
+  edbee/textdocumentserializerjobtest.cpp \
+  edbee/util/utf8validatortest.cpp \
+  edbee/util/utf8validatorbenchmark.cpp \
+  edbee/util/textcodecdetectortest.cpp \
+  edbee/util/textcodectest.cpp \
+  edbee/textdocumentfollowertest.cpp \
+  edbee/textdocumentcachetest.cpp \
+  edbee/models/textlexerschedulertest.cpp \
+  edbee/lexers/grammartextlexerbenchmark.cpp \
+  edbee/util/regexpbenchmark.cpp \
+  edbee/models/chardocument/chartextbuffertest.cpp \
+  edbee/models/ropedocument/ropetextdocumenttest.cpp \
+  edbee/testsupport.cpp
 
 HEADERS += \
 	edbee/commands/replaceselectioncommandtest.h \
@@ -79,7 +107,33 @@ HEADERS += \
   edbee/util/rangesetlineiteratortest.h \
   edbee/models/dynamicvariablestest.h \
   edbee/util/rangelineiteratortest.h \
-  edbee/views/textthememanagertest.h
+  edbee/views/textthememanagertest.h \
+  edbee/models/ropedocument/ropetextbuffertest.h \
+  edbee/models/textoffsettest.h \
+  edbee/models/mappeddocument/mappedtextbuffertest.h \
+  edbee/benchmarkcase.h \
+  edbee/util/lineoffsettreetest.h \
+  edbee/util/lineoffsetbenchmark.h \
+  edbee/util/newlinescannertest.h \
+  edbee/util/newlinescannerbenchmark.h \
+  edbee/allocationcounter.h \
+  edbee/models/typingbenchmark.h \
+  edbee/models/textsnapshottest.h \
+  edbee/util/paralleltextdecodertest.h \
+  edbee/textdocumentserializerbenchmark.h \
+  edbee/textdocumentserializerjobtest.h \
+  edbee/util/utf8validatortest.h \
+  edbee/util/utf8validatorbenchmark.h \
+  edbee/util/textcodecdetectortest.h \
+  edbee/util/textcodectest.h \
+  edbee/textdocumentfollowertest.h \
+  edbee/textdocumentcachetest.h \
+  edbee/models/textlexerschedulertest.h \
+  edbee/lexers/grammartextlexerbenchmark.h \
+  edbee/util/regexpbenchmark.h \
+  edbee/models/chardocument/chartextbuffertest.h \
+  edbee/models/ropedocument/ropetextdocumenttest.h \
+  edbee/testsupport.h
 
 ##OTHER_FILES += ../edbee-data/config/*
 ##OTHER_FILES += ../edbee-data/keymaps/*
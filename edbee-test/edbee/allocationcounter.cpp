@@ -0,0 +1,157 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstddef>
+
+#if defined(__has_feature)
+    #if __has_feature(address_sanitizer)
+        #define EDBEE_ADDRESS_SANITIZER
+    #endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+    #define EDBEE_ADDRESS_SANITIZER
+#endif
+
+#if defined(__GLIBC__) && !defined(EDBEE_ADDRESS_SANITIZER)
+    #define EDBEE_COUNT_ALLOCATIONS
+#endif
+
+// edbee/debug.h isn't included, the debug new macros would replace the malloc functions below
+
+namespace edbee {
+
+static std::atomic<bool> countingAllocations(false);     ///< Is an allocation counter active?
+static std::atomic<qint64> allocationCount(0);           ///< The number of counted allocations
+static std::atomic<qint64> allocatedBytes(0);            ///< The number of allocated bytes minus the freed bytes
+static std::atomic<qint64> peakAllocatedBytes(0);        ///< The maximum of allocatedBytes
+
+} // edbee
+
+
+#ifdef EDBEE_COUNT_ALLOCATIONS
+
+#include <malloc.h>
+
+// The malloc implementation of glibc, the replacements forward to these functions
+extern "C" void* __libc_malloc( size_t size );
+extern "C" void* __libc_calloc( size_t count, size_t size );
+extern "C" void* __libc_realloc( void* pointer, size_t size );
+extern "C" void __libc_free( void* pointer );
+
+static inline void countAllocation()
+{
+    if( edbee::countingAllocations.load( std::memory_order_relaxed ) ) {
+        edbee::allocationCount.fetch_add( 1, std::memory_order_relaxed );
+    }
+}
+
+/// Adds the given number of bytes to the allocated bytes and updates the peak
+static inline void countBytes( qint64 bytes )
+{
+    if( bytes == 0 || !edbee::countingAllocations.load( std::memory_order_relaxed ) ) { return; }
+    qint64 allocated = edbee::allocatedBytes.fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+    qint64 peak = edbee::peakAllocatedBytes.load( std::memory_order_relaxed );
+    while( allocated > peak && !edbee::peakAllocatedBytes.compare_exchange_weak( peak, allocated, std::memory_order_relaxed ) ) {}
+}
+
+/// Returns the size of the given block (0 for a null pointer)
+static inline qint64 blockSize( void* pointer )
+{
+    return pointer ? static_cast<qint64>( malloc_usable_size( pointer ) ) : 0;
+}
+
+extern "C" void* malloc( size_t size )
+{
+    countAllocation();
+    void* result = __libc_malloc( size );
+    countBytes( blockSize( result ) );
+    return result;
+}
+
+extern "C" void* calloc( size_t count, size_t size )
+{
+    countAllocation();
+    void* result = __libc_calloc( count, size );
+    countBytes( blockSize( result ) );
+    return result;
+}
+
+extern "C" void* realloc( void* pointer, size_t size )
+{
+    countAllocation();
+    qint64 oldSize = blockSize( pointer );
+    void* result = __libc_realloc( pointer, size );
+    if( result || size == 0 ) { countBytes( blockSize( result ) - oldSize ); }
+    return result;
+}
+
+extern "C" void free( void* pointer )
+{
+    countBytes( -blockSize( pointer ) );
+    __libc_free( pointer );
+}
+
+#endif
+
+
+namespace edbee {
+
+
+/// Starts counting the allocations
+AllocationCounter::AllocationCounter()
+{
+    Q_ASSERT( !countingAllocations.load() );
+    allocationCount.store( 0 );
+    allocatedBytes.store( 0 );
+    peakAllocatedBytes.store( 0 );
+    countingAllocations.store( true );
+}
+
+
+/// Stops counting
+AllocationCounter::~AllocationCounter()
+{
+    countingAllocations.store( false );
+}
+
+
+/// Returns the number of allocations since the construction (or the last reset)
+qint64 AllocationCounter::count() const
+{
+    return allocationCount.load();
+}
+
+
+/// Returns the peak of the allocated (and not yet freed) bytes since the construction (or the last reset).
+/// Memory that was allocated before and is freed while counting lowers the allocated bytes, so this is the
+/// peak growth of the heap. The bytes are the usable size of the blocks (including the rounding of malloc)
+qint64 AllocationCounter::peakBytes() const
+{
+    return peakAllocatedBytes.load();
+}
+
+
+/// Resets the number of allocations and the allocated bytes to 0
+void AllocationCounter::reset()
+{
+    allocationCount.store( 0 );
+    allocatedBytes.store( 0 );
+    peakAllocatedBytes.store( 0 );
+}
+
+
+/// Returns true if the allocations are counted on this platform
+bool AllocationCounter::isAvailable()
+{
+#ifdef EDBEE_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+} // edbee
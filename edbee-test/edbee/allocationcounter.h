@@ -0,0 +1,31 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <QtGlobal>
+
+namespace edbee {
+
+/// Counts the heap allocations (malloc, calloc, realloc and new) of the current process while the counter exists.
+/// The counter also tracks the peak of the allocated (and not yet freed) bytes, relative to the start of counting.
+///
+/// The counting replaces the malloc functions of the C library, this is only available with glibc and
+/// without address sanitizer. Use isAvailable to check if the allocations are counted.
+/// Only a single counter can be active at a time.
+class AllocationCounter {
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+
+    qint64 count() const;
+    qint64 peakBytes() const;
+    void reset();
+
+    static bool isAvailable();
+
+private:
+    Q_DISABLE_COPY(AllocationCounter)
+};
+
+} // edbee
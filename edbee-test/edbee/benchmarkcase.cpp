@@ -0,0 +1,61 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "benchmarkcase.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+const int BenchmarkCase::DataSize;
+
+/// The environment variable that enables the benchmarks
+static const char* BenchmarksEnvVar = "EDBEE_BENCHMARKS";
+
+
+/// Skips the current test when the benchmarks aren't enabled
+/// @return true if the test is skipped
+bool BenchmarkCase::skipWithoutBenchmarks()
+{
+    if( qEnvironmentVariableIsSet( BenchmarksEnvVar ) ) { return false; }
+    testSkip( QStringLiteral("Set %1 to run this benchmark").arg( BenchmarksEnvVar ) );
+    return true;
+}
+
+
+/// Writes the result of a benchmark to the log
+/// @param name the name of the measured operation
+/// @param nsecs the total time in nanoseconds
+/// @param operationCount the number of operations (when > 0 the time per operation is reported)
+void BenchmarkCase::reportBenchmark(const QString& name, qint64 nsecs, qint64 operationCount)
+{
+    QString result = QStringLiteral("[benchmark] %1::%2 %3: %4 ms").arg( metaObject()->className() ).arg( currentMethodName() ).arg( name ).arg( nsecs / 1000000.0, 0, 'f', 2 );
+    if( operationCount > 0 ) {
+        result.append( QStringLiteral(" (%1 ns per operation)").arg( nsecs / operationCount ) );
+    }
+    qlog_info() << result;
+}
+
+
+/// Writes the throughput of a benchmark to the log
+/// @param name the name of the measured operation
+/// @param nsecs the total time in nanoseconds
+/// @param byteCount the number of processed bytes
+void BenchmarkCase::reportThroughput(const QString& name, qint64 nsecs, qint64 byteCount)
+{
+    double megabytesPerSecond = nsecs > 0 ? ( byteCount / ( 1024.0 * 1024.0 ) ) / ( nsecs / 1000000000.0 ) : 0;
+    reportBenchmark( QStringLiteral("%1 (%2 MB/s)").arg( name ).arg( megabytesPerSecond, 0, 'f', 1 ), nsecs );
+}
+
+
+/// Returns the benchmark data: the given line repeated until the data is at least the given number of bytes
+/// (so the data always ends with a complete line)
+/// @param line the line to repeat
+/// @param size the minimal size of the data
+QByteArray BenchmarkCase::benchmarkData(const QByteArray& line, int size)
+{
+    return line.repeated( ( size + line.size() - 1 ) / line.size() );
+}
+
+
+} // edbee
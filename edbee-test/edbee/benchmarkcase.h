@@ -0,0 +1,30 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <QByteArray>
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+/// The base class for benchmarks. Benchmarks take a lot of time, so they only run when the
+/// EDBEE_BENCHMARKS environment variable is set. The timings are written to the log.
+class BenchmarkCase : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+protected:
+    /// The default number of bytes of the benchmark data
+    static const int DataSize = 64 * 1024 * 1024;
+
+    bool skipWithoutBenchmarks();
+    void reportBenchmark( const QString& name, qint64 nsecs, qint64 operationCount=0 );
+    void reportThroughput( const QString& name, qint64 nsecs, qint64 byteCount );
+
+    static QByteArray benchmarkData( const QByteArray& line, int size=DataSize );
+};
+
+
+} // edbee
@@ -0,0 +1,121 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "grammartextlexerbenchmark.h"
+
+#include <QElapsedTimer>
+
+#include "edbee/lexers/grammartextlexer.h"
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textdocumentscopes.h"
+#include "edbee/models/textgrammar.h"
+#include "edbee/edbee.h"
+#include "edbee/testsupport.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// The number of times the sample text is repeated
+static const int RepeatCount = 500;
+
+/// A sample of C++ code
+static const char* CppSample =
+    "#include <vector>\n"
+    "/* a block\n"
+    "   comment */\n"
+    "namespace sample {\n"
+    "template<typename T> class Buffer : public Base {\n"
+    "public:\n"
+    "    explicit Buffer( int size ) : size_(size), data_(new T[size]) {}\n"
+    "    virtual ~Buffer() { delete[] data_; }   // the destructor\n"
+    "    int find( const T& value ) const {\n"
+    "        for( int i=0; i < size_; ++i ) { if( data_[i] == value ) { return i; } }\n"
+    "        return -1;\n"
+    "    }\n"
+    "private:\n"
+    "    static const char* name() { return \"buffer\\n\"; }\n"
+    "    int size_; T* data_; double ratio_ = 0.5e-3; unsigned long mask_ = 0xff00ff;\n"
+    "};\n"
+    "}\n";
+
+/// A sample of HTML with embedded CSS and JavaScript
+static const char* HtmlSample =
+    "<!DOCTYPE html>\n"
+    "<html lang=\"en\"><head><title>Sample &amp; test</title>\n"
+    "<style type=\"text/css\">body { margin: 0; color: #333; } .item > a:hover { color: red; }</style>\n"
+    "<script>function add( a, b ) { var c = a + b; return c * 2; /* done */ }</script>\n"
+    "</head><body class=\"main\">\n"
+    "<!-- a comment -->\n"
+    "<div id=\"content\"><p>Some <b>bold</b> and <i>italic</i> text, <a href=\"#top\">a link</a>.</p>\n"
+    "<ul><li>one</li><li>two</li><li><img src=\"a.png\" alt=\"an image\"/></li></ul>\n"
+    "<table><tr><td>1</td><td>2</td></tr></table></div>\n"
+    "</body></html>\n";
+
+
+/// Returns a grammar with many keyword rules, like the keyword lists of large language grammars
+static TextGrammar* keywordGrammar()
+{
+    QStringList keywords = QStringLiteral("if else for while do switch case return break continue "
+        "class struct namespace template typename public private protected virtual static "
+        "const int char double unsigned long explicit delete new this").split(' ');
+    return TestSupport::grammar( QStringLiteral("benchmarkkeywords"), keywords );
+}
+
+
+/// Lexes the C++ and HTML samples without and with the match cache and the regexp sets. The C++ and HTML grammars are only
+/// available when the grammars are loaded (the syntaxfiles of the data path)
+void GrammarTextLexerBenchmark::benchmarkGrammarLexing()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    TextGrammarManager* manager = Edbee::instance()->grammarManager();
+    QString cppText = QString::fromLatin1( CppSample ).repeated( RepeatCount );
+    QString htmlText = QString::fromLatin1( HtmlSample ).repeated( RepeatCount );
+
+    benchmarkLexing( QStringLiteral("keywords"), keywordGrammar(), cppText );
+    TextGrammar* cppGrammar = manager->detectGrammarWithFilename( QStringLiteral("sample.cpp") );
+    if( cppGrammar && cppGrammar != manager->defaultGrammar() ) {
+        benchmarkLexing( QStringLiteral("c++"), cppGrammar, cppText );
+    }
+    TextGrammar* htmlGrammar = manager->detectGrammarWithFilename( QStringLiteral("sample.html") );
+    if( htmlGrammar && htmlGrammar != manager->defaultGrammar() ) {
+        benchmarkLexing( QStringLiteral("html"), htmlGrammar, htmlText );
+    }
+}
+
+
+/// Lexes the text with the grammar, without the match cache, with the match cache and with the regexp sets.
+/// Reports the time and the counters of every mode
+/// @param name the name of the benchmark
+/// @param grammar the grammar to use
+/// @param text the text to lex
+void GrammarTextLexerBenchmark::benchmarkLexing(const QString& name, TextGrammar* grammar, const QString& text)
+{
+    static const char* modeNames[] = { "without match cache", "with match cache", "with regexp sets" };
+    QString scopes[3];
+    for( int mode=0; mode < 3; ++mode ) {
+        CharTextDocument doc;
+        doc.setText( text );
+        doc.setLanguageGrammar( grammar );
+        GrammarTextLexer* lexer = dynamic_cast<GrammarTextLexer*>( doc.textLexer() );
+        testTrue( lexer != 0 );
+        lexer->setMatchCacheEnabled( mode >= 1 );
+        lexer->setRegExpSetEnabled( mode >= 2 );
+        lexer->resetCounters();
+
+        QElapsedTimer timer;
+        timer.start();
+        lexer->lexRange( 0, doc.length() );
+        qint64 time = timer.nsecsElapsed();
+
+        reportBenchmark( QStringLiteral("%1 %2 (%3 rules evaluated, %4 searches)").arg( name ).arg( modeNames[mode] )
+            .arg( lexer->ruleEvaluationCount() ).arg( lexer->regExpSearchCount() ), time, doc.lineCount() );
+        scopes[mode] = doc.scopes()->scopesAsStringList().join("\n");
+    }
+    testEqual( scopes[1], scopes[0] );
+    testEqual( scopes[2], scopes[0] );
+}
+
+
+} // edbee
@@ -0,0 +1,28 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/benchmarkcase.h"
+
+namespace edbee {
+
+class TextGrammar;
+
+/// Measures the time and the number of regexp searches of lexing documents with large grammars
+class GrammarTextLexerBenchmark : public BenchmarkCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void benchmarkGrammarLexing();
+
+private:
+    void benchmarkLexing( const QString& name, TextGrammar* grammar, const QString& text );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::GrammarTextLexerBenchmark);
@@ -3,6 +3,8 @@
 
 #include "grammartextlexertest.h"
 
+#include <QSet>
+
 #include "edbee/io/tmlanguageparser.h"
 #include "edbee/lexers/grammartextlexer.h"
 #include "edbee/models/chardocument/chartextdocument.h"
@@ -10,13 +12,83 @@
 #include "edbee/models/textdocumentscopes.h"
 #include "edbee/models/textgrammar.h"
 #include "edbee/models/textlexer.h"
+#include "edbee/util/xorshiftrandom.h"
 #include "edbee/edbee.h"
+#include "edbee/testsupport.h"
 
 #include "edbee/debug.h"
 
 namespace edbee {
 
 
+/// Returns the scopes of the document as a string
+static QString scopesString( TextDocument* doc )
+{
+    return doc->scopes()->scopesAsStringList().join("\n");
+}
+
+
+/// Returns the scopes of the text of the document, lexed from scratch
+static QString lexedScopesString( TextDocument* doc )
+{
+    CharTextDocument lexedDoc;
+    lexedDoc.setText( doc->text() );
+    lexedDoc.setLanguageGrammar( TestSupport::grammar( QStringLiteral("relextest") ) );
+    lexedDoc.textLexer()->lexRange( 0, lexedDoc.length() );
+    return scopesString( &lexedDoc );
+}
+
+
+/// Returns true if all lexed lines refer to multi-line ranges of the document
+static bool hasValidReferences( TextDocument* doc )
+{
+    TextDocumentScopes* scopes = doc->scopes();
+    QSet<MultiLineScopedTextRange*> ranges;
+    ranges.insert( &scopes->defaultScopedRange() );
+    for( int i=0; i < scopes->multiLineScopedRangeCount(); ++i ) {
+        ranges.insert( &scopes->multiLineScopedRange(i) );
+    }
+    for( int line=0; line < scopes->scopedLineCount() && doc->offsetFromLine( line ) < scopes->lastScopedOffset(); ++line ) {
+        ScopedTextRangeList* list = scopes->scopedRangesAtLine( line );
+        if( !list ) { continue; }
+        for( int idx=0; idx < list->size(); ++idx ) {
+            MultiLineScopedTextRange* range = list->at(idx)->multiLineScopedTextRange();
+            if( range && !ranges.contains( range ) ) { return false; }
+        }
+        foreach( MultiLineScopedTextRange* range, list->endState() ) {
+            if( !ranges.contains( range ) ) { return false; }
+        }
+    }
+    return true;
+}
+
+
+/// Creates a document with the given text and lexes it completely
+static void lexDocument( TextDocument* doc, const QString& text )
+{
+    doc->setText( text );
+    doc->setLanguageGrammar( TestSupport::grammar( QStringLiteral("relextest") ) );
+    doc->textLexer()->lexRange( 0, doc->length() );
+}
+
+
+/// Returns a text with the given number of lines, with comments and strings
+static QString relexText( int lineCount )
+{
+    QString text;
+    for( int i=0; i < lineCount; ++i ) {
+        switch( i % 7 ) {
+            case 0: text.append( QStringLiteral("if a /* comment\n") ); break;
+            case 2: text.append( QStringLiteral("  end */ b 'str'\n") ); break;
+            case 4: text.append( QStringLiteral("x = \"multi\n") ); break;
+            case 5: text.append( QStringLiteral("line\" if\n") ); break;
+            default: text.append( QStringLiteral("plain if text\n") );
+        }
+    }
+    return text;
+}
+
+
 /// This method test the basic matching algorithm
 GrammarTextLexerTest::GrammarTextLexerTest()
     : doc_(0)
@@ -82,6 +154,241 @@ void GrammarTextLexerTest::testHamlLexer()
 }
 
 
+/// Changing a line that doesn't change the lexer state only lexes that line
+void GrammarTextLexerTest::testRelexChangedLine()
+{
+    CharTextDocument doc;
+    lexDocument( &doc, relexText(100) );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+
+    // a plain line
+    doc.replace( doc.offsetFromLine(50) + 2, 0, QStringLiteral("if ") );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+    testTrue( hasValidReferences( &doc ) );
+
+    // inserting and removing lines
+    doc.replace( doc.offsetFromLine(10), 0, QStringLiteral("new\nlines if\n") );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+    doc.replace( doc.offsetFromLine(30), doc.offsetFromLine(33) - doc.offsetFromLine(30), QString() );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+    testTrue( hasValidReferences( &doc ) );
+}
+
+
+/// Changing the lines of multi-line ranges keeps the ranges that continue after the lexed lines
+void GrammarTextLexerTest::testRelexMultiLineRanges()
+{
+    CharTextDocument doc;
+    lexDocument( &doc, relexText(100) );
+
+    // inside a comment (the comment is active at the start of the line)
+    doc.replace( doc.offsetFromLine(71) + 3, 0, QStringLiteral("/* if") );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+    testTrue( hasValidReferences( &doc ) );
+
+    // before the start of a comment and a string (the ranges start on the changed line)
+    doc.replace( doc.offsetFromLine(42), 0, QStringLiteral("if ") );
+    doc.replace( doc.offsetFromLine(46), 0, QStringLiteral("y") );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+    testTrue( hasValidReferences( &doc ) );
+
+    // closing a comment and opening another comment
+    doc.replace( doc.offsetFromLine(15), 0, QStringLiteral("*/ if /*") );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+    testTrue( hasValidReferences( &doc ) );
+}
+
+
+/// When the lexer state doesn't converge, the scopes after the lexed lines are removed
+void GrammarTextLexerTest::testRelexWithoutConvergence()
+{
+    CharTextDocument doc;
+    lexDocument( &doc, relexText(100) );
+    GrammarTextLexer* lexer = dynamic_cast<GrammarTextLexer*>( doc.textLexer() );
+    testTrue( lexer != 0 );
+    lexer->setMaxRelexLineCount(3);
+
+    // an unclosed string changes the state of all next lines
+    doc.replace( doc.offsetFromLine(20), 0, QStringLiteral("\"") );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.offsetFromLine(23) );
+    testTrue( hasValidReferences( &doc ) );
+    doc.textLexer()->lexRange( 0, doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+
+    // disabled
+    lexer->setMaxRelexLineCount(0);
+    doc.replace( doc.offsetFromLine(50), 0, QStringLiteral("x") );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.offsetFromLine(50) );
+    testTrue( hasValidReferences( &doc ) );
+}
+
+
+/// Random changes are lexed the same as lexing the document from scratch
+void GrammarTextLexerTest::testRelexRandomChanges()
+{
+    static const char* texts[] = { "x", "/*", "*/", "'", "\"", "if ", "\n", "a\n/* b\n", "*/\n'\n", "" };
+    XorShiftRandom random(2166136261u);
+
+    CharTextDocument doc;
+    lexDocument( &doc, relexText(60) );
+    GrammarTextLexer* lexer = dynamic_cast<GrammarTextLexer*>( doc.textLexer() );
+    testTrue( lexer != 0 );
+    for( int i=0; i < 200; ++i ) {
+        lexer->setMaxRelexLineCount( static_cast<int>( random.next() % 40 ) );
+        TextOffset offset = static_cast<TextOffset>( random.next() % static_cast<quint32>( doc.length() + 1 ) );
+        TextOffset length = qMin( static_cast<TextOffset>( random.next() % 20 ), doc.length() - offset );
+        if( random.next() % 2 ) { length = 0; }
+        doc.replace( offset, length, QString::fromLatin1( texts[ random.next() % 10 ] ) );
+        testTrue( hasValidReferences( &doc ) );
+
+        // lex the remaining lines (sometimes)
+        if( random.next() % 3 == 0 ) {
+            doc.textLexer()->lexRange( 0, doc.length() );
+            testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+        }
+    }
+    doc.textLexer()->lexRange( 0, doc.length() );
+    testEqual( scopesString( &doc ), lexedScopesString( &doc ) );
+}
+
+
+/// Lexes the given text with the given match cache setting and returns the scopes and the counters
+static QString lexWithMatchCache( const QString& text, bool enabled, qint64& ruleEvaluationCount, qint64& regExpSearchCount )
+{
+    CharTextDocument doc;
+    doc.setText( text );
+    doc.setLanguageGrammar( TestSupport::grammar( QStringLiteral("relextest") ) );
+    GrammarTextLexer* lexer = dynamic_cast<GrammarTextLexer*>( doc.textLexer() );
+    lexer->setMatchCacheEnabled( enabled );
+    lexer->setRegExpSetEnabled( false );
+    lexer->resetCounters();
+    lexer->lexRange( 0, doc.length() );
+    ruleEvaluationCount = lexer->ruleEvaluationCount();
+    regExpSearchCount = lexer->regExpSearchCount();
+    return scopesString( &doc );
+}
+
+
+/// The match cache should give the same scopes with less regexp searches
+void GrammarTextLexerTest::testMatchCache()
+{
+    QString text = QStringLiteral("if a if b 'if' c if /* if\n if */ d if 'e' if\n").repeated( 20 );
+    qint64 uncachedEvaluations = 0, uncachedSearches = 0, cachedEvaluations = 0, cachedSearches = 0;
+    QString uncachedScopes = lexWithMatchCache( text, false, uncachedEvaluations, uncachedSearches );
+    QString cachedScopes = lexWithMatchCache( text, true, cachedEvaluations, cachedSearches );
+
+    testEqual( cachedScopes, uncachedScopes );
+    testEqual( cachedEvaluations, uncachedEvaluations );
+    testTrue( uncachedSearches > uncachedEvaluations );     // the end regexps are searched too
+    testTrue( cachedSearches < uncachedSearches );
+}
+
+
+/// Tests the flattening of the rules with includes (with a cycle, duplicates and a missing include)
+void GrammarTextLexerTest::testCompiledRules()
+{
+    TextGrammarManager* manager = Edbee::instance()->grammarManager();
+    TextGrammar* grammar = new TextGrammar( QStringLiteral("source.compiletest"), QStringLiteral("Compile test") );
+    TextGrammarRule* mainRule = TextGrammarRule::createMainRule( grammar, QStringLiteral("source.compiletest") );
+    TextGrammarRule* firstRule = TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("keyword.first"), QStringLiteral("\\bfirst\\b") );
+    TextGrammarRule* lastRule = TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("keyword.last"), QStringLiteral("\\blast\\b") );
+    mainRule->giveRule( firstRule );
+    mainRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("#list") ) );
+    mainRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("#string") ) );
+    mainRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("#string") ) );
+    mainRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("#missing") ) );
+    mainRule->giveRule( lastRule );
+
+    TextGrammarRule* listRule = TextGrammarRule::createRuleList( grammar );
+    TextGrammarRule* listedRule = TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("keyword.listed"), QStringLiteral("\\blisted\\b") );
+    listRule->giveRule( listedRule );
+    listRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("#list") ) );
+    listRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("$self") ) );
+    grammar->giveToRepos( QStringLiteral("list"), listRule );
+
+    TextGrammarRule* stringRule = TextGrammarRule::createMultiLineRegExp( grammar, QStringLiteral("string.quoted"), QString(), QStringLiteral("\""), QStringLiteral("\"") );
+    stringRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("#list") ) );
+    grammar->giveToRepos( QStringLiteral("string"), stringRule );
+    grammar->giveMainRule( mainRule );
+    manager->giveGrammar( grammar );
+
+    // the included rules are flattened in order, without duplicates
+    const QVector<TextGrammarRule*>& rules = manager->compiledRules( grammar, mainRule );
+    testEqual( rules.size(), 4 );
+    testTrue( rules.value(0) == firstRule );
+    testTrue( rules.value(1) == listedRule );
+    testTrue( rules.value(2) == stringRule );
+    testTrue( rules.value(3) == lastRule );
+    testTrue( &manager->compiledRules( grammar, mainRule ) == &rules );
+
+    // the $self include of the rules in the string refers to the main rule
+    const QVector<TextGrammarRule*>& stringRules = manager->compiledRules( grammar, stringRule );
+    testEqual( stringRules.size(), 4 );
+    testTrue( stringRules.value(0) == listedRule );
+    testTrue( stringRules.value(1) == firstRule );
+    testTrue( stringRules.value(2) == stringRule );
+    testTrue( stringRules.value(3) == lastRule );
+
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("first \"listed last\" last") );
+    doc.setLanguageGrammar( grammar );
+    doc.textLexer()->lexRange( 0, doc.length() );
+    testTrue( doc.scopes()->scopesAtOffset( 1 ).toString().contains( QStringLiteral("keyword.first") ) );
+    testTrue( doc.scopes()->scopesAtOffset( 8 ).toString().contains( QStringLiteral("keyword.listed") ) );
+    testTrue( doc.scopes()->scopesAtOffset( 8 ).toString().contains( QStringLiteral("string.quoted") ) );
+    testTrue( doc.scopes()->scopesAtOffset( 15 ).toString().contains( QStringLiteral("keyword.last") ) );
+    testFalse( doc.scopes()->scopesAtOffset( 21 ).toString().contains( QStringLiteral("string.quoted") ) );
+}
+
+
+/// Searching the candidate rules with a regexp set should give the same scopes (and captures) with less searches
+void GrammarTextLexerTest::testRegExpSet()
+{
+    TextGrammarManager* manager = Edbee::instance()->grammarManager();
+    TextGrammar* grammar = new TextGrammar( QStringLiteral("source.regexpsettest"), QStringLiteral("RegExpSet test") );
+    TextGrammarRule* mainRule = TextGrammarRule::createMainRule( grammar, QStringLiteral("source.regexpsettest") );
+    mainRule->giveRule( TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("keyword.control"), QStringLiteral("\\b(if|else|while)\\b") ) );
+    mainRule->giveRule( TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("constant.numeric"), QStringLiteral("\\b\\d+\\b") ) );
+    mainRule->giveRule( TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("constant.numeric.hex"), QStringLiteral("\\b0x[0-9a-f]+\\b") ) );
+    TextGrammarRule* callRule = TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("meta.call"), QStringLiteral("(\\w+)\\(") );
+    callRule->setCapture( 1, QStringLiteral("entity.name.function") );
+    mainRule->giveRule( callRule );
+    TextGrammarRule* stringRule = TextGrammarRule::createMultiLineRegExp( grammar, QStringLiteral("string.quoted"), QString(), QStringLiteral("(['\"])"), QStringLiteral("\\1") );
+    stringRule->giveRule( TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("constant.character.escape"), QStringLiteral("\\\\.") ) );
+    mainRule->giveRule( stringRule );
+    mainRule->giveRule( TextGrammarRule::createMultiLineRegExp( grammar, QStringLiteral("comment.block"), QString(), QStringLiteral("/\\*"), QStringLiteral("\\*/") ) );
+    grammar->giveMainRule( mainRule );
+    manager->giveGrammar( grammar );
+    testTrue( manager->compiledRegExpSet( grammar, mainRule )->isValid() );
+    testEqual( manager->compiledRegExpSet( grammar, mainRule )->size(), 6 );
+
+    QString text = QStringLiteral("if( call(12) ) { x = 0x1f; } else /* 12\n if */ while( 'a\\'b' ) \"x\" f(2)\n").repeated( 10 );
+    QString scopes[2];
+    qint64 searchCount[2];
+    for( int useSet=0; useSet < 2; ++useSet ) {
+        CharTextDocument doc;
+        doc.setText( text );
+        doc.setLanguageGrammar( grammar );
+        GrammarTextLexer* lexer = dynamic_cast<GrammarTextLexer*>( doc.textLexer() );
+        lexer->setMatchCacheEnabled( false );
+        lexer->setRegExpSetEnabled( useSet != 0 );
+        lexer->resetCounters();
+        lexer->lexRange( 0, doc.length() );
+        scopes[useSet] = scopesString( &doc );
+        searchCount[useSet] = lexer->regExpSearchCount();
+    }
+    testEqual( scopes[1], scopes[0] );
+    testTrue( scopes[1].contains( QStringLiteral("entity.name.function") ) );
+    testTrue( searchCount[1] < searchCount[0] );
+}
+
+
 /// creates the main fixture document
 void GrammarTextLexerTest::createFixtureDocument( const QString& data )
 {
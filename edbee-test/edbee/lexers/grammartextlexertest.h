@@ -25,6 +25,13 @@ private slots:
     void clean();
 
     void testHamlLexer();
+    void testRelexChangedLine();
+    void testRelexMultiLineRanges();
+    void testRelexWithoutConvergence();
+    void testRelexRandomChanges();
+    void testMatchCache();
+    void testCompiledRules();
+    void testRegExpSet();
 
 private:
 
@@ -0,0 +1,303 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "chartextbuffertest.h"
+
+#include <QStringList>
+
+#include "edbee/models/chardocument/chartextbuffer.h"
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textrange.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Asserts the buffer
+#define testBuffer( buf, txt, markers ) \
+do { \
+    testEqual( buf->text(), txt );  \
+    QString lineOffsets = buf->lineOffsetsAsString(); \
+    testEqual( lineOffsets, markers ); \
+} while(false)
+
+
+/// Tests the chunk access. Reading chunks may never alter the buffer layout (move the gap)
+void CharTextBufferTest::testChunkAt()
+{
+    CharTextDocument doc;
+    CharTextBuffer* buf = dynamic_cast<CharTextBuffer*>( doc.buffer() );
+    TextOffset start = -1, length = -1;
+    testTrue( buf->chunkAt( 0, start, length ) == nullptr );
+
+    buf->appendText("1234\n5678");
+    buf->replaceText(2,0,"ab");      // 12ab|34\n5678  the gap is after 'ab'
+
+    const QChar* chunk = buf->chunkAt( 0, start, length );
+    testEqual( start, 0 );
+    testEqual( QString( chunk, length ), "12ab" );
+
+    chunk = buf->chunkAt( 6, start, length );
+    testEqual( start, 4 );
+    testEqual( QString( chunk, length ), "34\n5678" );
+
+    // a range within a chunk is returned without copying
+    QString storage;
+    TextOffset dataOffset = -1;
+    const QChar* data = buf->rangeData( 5, 3, storage, dataOffset );
+    testEqual( dataOffset, 4 );
+    testTrue( storage.isEmpty() );
+    testEqual( QString( data + 5 - dataOffset, 3 ), "4\n5" );
+
+    // a range over multiple chunks is copied
+    data = buf->rangeData( 1, 5, storage, dataOffset );
+    testEqual( dataOffset, 1 );
+    testEqual( QString( data, 5 ), "2ab34" );
+
+    // the gap should not have been moved
+    chunk = buf->chunkAt( 0, start, length );
+    testEqual( length, 4 );
+}
+
+
+/// Tests the chunk iterator
+void CharTextBufferTest::testChunkIterator()
+{
+    CharTextDocument doc;
+    TextBuffer* buf = doc.buffer();
+    buf->appendText("1234\n5678");
+    buf->replaceText(2,0,"ab");      // 12ab|34\n5678
+
+    QString result;
+    QStringList chunks;
+    TextBufferChunkIterator itr( buf, 1, 8 );
+    while( itr.hasNext() ) {
+        const QChar* chunk = itr.next();
+        chunks.append( QStringLiteral("%1:%2").arg(itr.offset()).arg(itr.length()) );
+        result.append( chunk, itr.length() );
+    }
+    testEqual( result, "2ab34\n56" );
+    testEqual( chunks.join(","), "1:3,4:5" );
+
+    // an empty range doesn't return chunks
+    TextBufferChunkIterator emptyItr( buf, 3, 0 );
+    testTrue( !emptyItr.hasNext() );
+}
+
+
+/// Tests the compact (Latin-1) storage of the char textbuffer
+void CharTextBufferTest::testCompactStorage()
+{
+    CharTextDocument doc;
+    CharTextBuffer* buf = dynamic_cast<CharTextBuffer*>( doc.buffer() );
+    buf->setCompactStorageEnabled( true );
+    testFalse( buf->isLatin1Storage() );
+
+    buf->appendText( QString::fromLatin1("caf\xe9\nb2\nc3") );
+    testTrue( buf->isLatin1Storage() );
+    testBuffer( buf, QString::fromLatin1("caf\xe9\nb2\nc3"), "0,5,8" );
+    testEqual( buf->charAt(3), QChar(0xE9) );
+    testEqual( buf->lineFromOffset(6), 1 );
+
+    buf->replaceText( 5, 2, "xyz" );
+    testBuffer( buf, QString::fromLatin1("caf\xe9\nxyz\nc3"), "0,5,9" );
+    testEqual( buf->findCharPos( 0, 1, "z", true ), 7 );
+
+    // the chunks are decoded
+    TextOffset start = -1, length = -1;
+    const QChar* chunk = buf->chunkAt( 6, start, length );
+    testEqual( start, 0 );
+    testEqual( QString( chunk, length ), QString::fromLatin1("caf\xe9\nxyz\nc3") );
+
+    // the raw data pointer returns the decoded text
+    testEqual( QString( buf->rawDataPointer(), buf->length() ), QString::fromLatin1("caf\xe9\nxyz\nc3") );
+
+    // raw appending
+    doc.rawAppendBegin();
+    doc.rawAppend( QStringLiteral("\nd4").constData(), 3 );
+    doc.rawAppendEnd();
+    testTrue( buf->isLatin1Storage() );
+    testBuffer( buf, QString::fromLatin1("caf\xe9\nxyz\nc3\nd4"), "0,5,9,12" );
+}
+
+
+/// A character that doesn't fit in Latin-1 should promote the buffer to UTF-16
+void CharTextBufferTest::testCompactStoragePromotion()
+{
+    CharTextDocument doc;
+    CharTextBuffer* buf = dynamic_cast<CharTextBuffer*>( doc.buffer() );
+    buf->setCompactStorageEnabled( true );
+    buf->appendText( "a1\nb2" );
+    testTrue( buf->isLatin1Storage() );
+
+    QString euro( QChar(0x20AC) );
+    buf->replaceText( 1, 0, euro );
+    testFalse( buf->isLatin1Storage() );
+    testBuffer( buf, QStringLiteral("a") + euro + QStringLiteral("1\nb2"), "0,4" );
+
+    // removing the character doesn't convert the buffer back
+    buf->replaceText( 1, 1, "" );
+    testFalse( buf->isLatin1Storage() );
+
+    // enabling the compact storage again converts the text when it fits
+    buf->setCompactStorageEnabled( false );
+    buf->setCompactStorageEnabled( true );
+    testTrue( buf->isLatin1Storage() );
+    testBuffer( buf, "a1\nb2", "0,3" );
+
+    // disabling converts to UTF-16
+    buf->setCompactStorageEnabled( false );
+    testFalse( buf->isLatin1Storage() );
+    testBuffer( buf, "a1\nb2", "0,3" );
+}
+
+
+/// The old text is passed to the textChanged signal when it's required (the default) and the signal has receivers
+void CharTextBufferTest::testOldTextRequired()
+{
+    CharTextBuffer charBuf;
+    TextBuffer* buf = &charBuf;
+    testTrue( buf->isOldTextRequired() );
+
+    buf->appendText( "abc\ndefg" );
+    connect( buf, &TextBuffer::textChanged, this, &CharTextBufferTest::storeOldText );
+    buf->replaceText( 1, 3, "X" );
+    testEqual( oldText_, QStringLiteral("bc\n") );
+
+    // inserts never copy text
+    buf->replaceText( 1, 0, "Y" );
+    testTrue( oldText_.isNull() );
+
+    buf->setOldTextRequired( false );
+    buf->replaceText( 1, 1, "" );
+    testTrue( oldText_.isNull() );
+    buf->setOldTextRequired( true );
+
+    // without receivers the old text isn't copied (see TypingBenchmark::testTypingWithoutAllocations)
+    disconnect( buf, &TextBuffer::textChanged, this, &CharTextBufferTest::storeOldText );
+    buf->replaceText( 1, 1, "" );
+    testEqual( buf->text(), QStringLiteral("adefg") );
+
+    // a new receiver gets the old text again
+    connect( buf, &TextBuffer::textChanged, this, &CharTextBufferTest::storeOldText );
+    buf->replaceText( 1, 2, "" );
+    testEqual( oldText_, QStringLiteral("de") );
+    testEqual( buf->text(), QStringLiteral("afg") );
+}
+
+
+/// Tests replacing multiple ranges in a single pass, every range is reported with its own change
+void CharTextBufferTest::testReplaceRanges()
+{
+    for( int i=0; i < 2; ++i ) {
+        CharTextBuffer charBuf;
+        charBuf.setCompactStorageEnabled( i == 1 );
+        TextBuffer* buf = &charBuf;
+        buf->appendText("aa\nbb\ncc\ndd");
+        connect( buf, &TextBuffer::textChanged, this, &CharTextBufferTest::storeOldText );
+        changeCount_ = 0;
+
+        // a|a\n[bb]\ncc\n[d]d => aX|a\nY\nZ|\ncc\n|d
+        QVector<TextRange> ranges;
+        ranges << TextRange(1,1) << TextRange(3,5) << TextRange(9,10);
+        buf->replaceRanges( ranges, QStringList() << "X" << "Y\nZ" << "" );
+        testBuffer( buf, "aXa\nY\nZ\ncc\nd", "0,4,6,8,11" );
+        testEqual( changeCount_, 3 );
+        testEqual( lastChange_, "11,1,0" );
+        testEqual( oldText_, "d" );
+
+        // a single text is used for all ranges
+        ranges.clear();
+        ranges << TextRange(0,0) << TextRange(4,4) << TextRange(12,12);
+        buf->replaceRanges( ranges, QStringList("-") );
+        testBuffer( buf, "-aXa\n-Y\nZ\ncc\nd-", "0,5,8,10,13" );
+        testEqual( changeCount_, 6 );
+        testEqual( lastChange_, "14,0,1" );
+    }
+}
+
+
+/// Tests releasing the memory after truncating a large text
+void CharTextBufferTest::testSqueeze()
+{
+    CharTextBuffer buf;
+    buf.appendText( QStringLiteral("line\n").repeated(10000) );
+    qint64 memoryUsage = buf.memoryUsage();
+    testTrue( buf.capacity() >= 50000 );
+
+    buf.replaceText( 10, buf.length() - 10, QString() );
+    buf.squeeze();
+    testEqual( buf.capacity(), 10 );
+    testEqual( buf.gapSize(), 0 );
+    testTrue( buf.memoryUsage() < memoryUsage / 100 );
+
+    // the buffer still works after squeezing
+    buf.replaceText( 4, 0, "X\n" );
+    testBuffer( (&buf), "lineX\n\nline\n", "0,6,7,12" );
+}
+
+
+/// Tests the growth and release policy of the buffer storage
+void CharTextBufferTest::testGrowthPolicy()
+{
+    for( int i=0; i < 2; ++i ) {
+        CharTextBuffer buf;
+        buf.setCompactStorageEnabled( i == 1 );
+        buf.setMaxGrowSize( 100 );
+        buf.setReleaseThreshold( 1000 );
+        testEqual( buf.maxGrowSize(), 100 );
+        testEqual( buf.releaseThreshold(), 1000 );
+
+        buf.appendText( QStringLiteral("line\n").repeated(1000) );
+        testTrue( buf.capacity() <= 5000 + 100 );
+
+        // the unused memory is released after the deletion
+        buf.replaceText( 10, buf.length() - 10, QString() );
+        testEqual( buf.length(), 10 );
+        testTrue( buf.capacity() < 1000 );
+        testBuffer( (&buf), "line\nline\n", "0,5,10" );
+    }
+}
+
+
+/// Takes the text of a detached buffer with a single change
+void CharTextBufferTest::testTakeText()
+{
+    CharTextBuffer buf;
+    buf.appendText( "old\ntext" );
+    buf.setLineOffsetTreeEnabled( true );
+    connect( &buf, &TextBuffer::textChanged, this, &CharTextBufferTest::storeOldText );
+    changeCount_ = 0;
+
+    CharTextBuffer loaded;
+    loaded.setCompactStorageEnabled( true );
+    loaded.appendText( "a\nb\nc" );
+    buf.takeText( &loaded );
+    testEqual( changeCount_, 1 );
+    testEqual( lastChange_, "0,8,5" );
+    testBuffer( (&buf), "a\nb\nc", "0,2,4" );
+    testTrue( buf.isLineOffsetTreeEnabled() );
+    testFalse( buf.isLatin1Storage() );
+
+    // the source is empty and still usable
+    testBuffer( (&loaded), "", "0" );
+    loaded.appendText( "x\ny" );
+    testBuffer( (&loaded), "x\ny", "0,2" );
+
+    // the buffer still works after taking the text
+    buf.replaceText( 1, 0, "X\n" );
+    testBuffer( (&buf), "aX\n\nb\nc", "0,3,4,6" );
+}
+
+
+/// Stores the old text of a textChanged signal
+void CharTextBufferTest::storeOldText( TextBufferChange change, QString oldText )
+{
+    oldText_ = oldText;
+    lastChange_ = QStringLiteral("%1,%2,%3").arg( change.offset() ).arg( change.length() ).arg( change.newTextLength() );
+    ++changeCount_;
+}
+
+
+} // edbee
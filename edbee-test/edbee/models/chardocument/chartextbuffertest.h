@@ -0,0 +1,41 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class TextBufferChange;
+
+
+/// The class for testing the CharTextBuffer specific features (the gap storage, the compact storage and the memory management)
+/// The generic buffer tests are in TextBufferTest
+class CharTextBufferTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testChunkAt();
+    void testChunkIterator();
+    void testCompactStorage();
+    void testCompactStoragePromotion();
+    void testOldTextRequired();
+    void testReplaceRanges();
+    void testSqueeze();
+    void testGrowthPolicy();
+    void testTakeText();
+
+private:
+    void storeOldText( edbee::TextBufferChange change, QString oldText );
+
+    QString oldText_;       ///< The old text of the last textChanged signal
+    QString lastChange_;    ///< The last textChanged change as "offset,length,newTextLength"
+    int changeCount_;       ///< The number of textChanged signals (since it was reset by a test)
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::CharTextBufferTest);
@@ -0,0 +1,252 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "mappedtextbuffertest.h"
+
+#include <QTemporaryFile>
+
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/mappeddocument/mappedtextbuffer.h"
+#include "edbee/models/mappeddocument/mappedtextdocument.h"
+#include "edbee/models/textlinedata.h"
+#include "edbee/models/textrange.h"
+#include "edbee/models/textundostack.h"
+#include "edbee/util/lineending.h"
+#include "edbee/util/textcodec.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// A text with 1, 2, 3 and 4 byte UTF-8 sequences and mixed line endings
+static const char* Utf8Text = "a\xe2\x82\xac" "b\r\nc\xf0\x9f\x98\x80\n\n\xc3\xa9\rx\r\nlast";
+
+
+/// Returns the text as it should be in the buffer ("\r\n" is read as "\n")
+static QString expectedText( const QByteArray& data )
+{
+    return QString::fromUtf8( data ).replace( QStringLiteral("\r\n"), QStringLiteral("\n") );
+}
+
+
+/// Tests opening an UTF-8 file
+void MappedTextBufferTest::testOpenUtf8()
+{
+    QTemporaryFile file;
+    testTrue( writeFile( file, Utf8Text ) );
+
+    MappedTextDocument doc;
+    testTrue( doc.open( file.fileName() ) );
+    doc.mappedBuffer()->indexAll();
+
+    TextBuffer* buf = doc.buffer();
+    testEqual( doc.encoding()->name(), "UTF-8" );
+    testEqual( buf->text(), expectedText( Utf8Text ) );
+    testEqual( buf->lineCount(), 5 );
+    testEqual( buf->lineOffsetsAsString(), "0,4,8,9,13" );
+    testEqual( buf->line(3), QString::fromUtf8("\xc3\xa9\rx\n") );
+    testEqual( buf->charAt(6), QChar( QChar::lowSurrogate( 0x1F600 ) ) );
+}
+
+
+/// Tests opening a file that isn't valid UTF-8
+void MappedTextBufferTest::testOpenLatin1()
+{
+    QTemporaryFile file;
+    testTrue( writeFile( file, "caf\xe9\nna\xefve\nlast line" ) );
+
+    MappedTextDocument doc;
+    testTrue( doc.open( file.fileName() ) );
+    doc.mappedBuffer()->indexAll();
+
+    testEqual( doc.encoding()->name(), "ISO-8859-1" );
+    testEqual( doc.lineEnding()->type(), LineEnding::UnixType );
+    testEqual( doc.buffer()->text(), QString::fromLatin1("caf\xe9\nna\xefve\nlast line") );
+}
+
+
+/// The byte order mark shouldn't be part of the text
+void MappedTextBufferTest::testOpenWithByteOrderMark()
+{
+    QTemporaryFile file;
+    testTrue( writeFile( file, "\xef\xbb\xbfline1\r\nline2\r\n" ) );
+
+    MappedTextDocument doc;
+    testTrue( doc.open( file.fileName() ) );
+    doc.mappedBuffer()->indexAll();
+
+    testEqual( doc.encoding()->name(), "UTF-8 with BOM" );
+    testEqual( doc.lineEnding()->type(), LineEnding::WindowsType );
+    testEqual( doc.buffer()->text(), "line1\nline2\n" );
+}
+
+
+/// Tests opening a file that doesn't exist
+void MappedTextBufferTest::testOpenFailure()
+{
+    MappedTextDocument doc;
+    testFalse( doc.open( "/this/file/does/not/exist.txt" ) );
+    testFalse( doc.errorString().isEmpty() );
+    testFalse( doc.mappedBuffer()->isOpen() );
+    testEqual( doc.length(), 0 );
+}
+
+
+/// Only the indexed blocks should be part of the buffer
+void MappedTextBufferTest::testLazyIndexing()
+{
+    QByteArray data;
+    for( int i=0; i < 100; ++i ) { data.append( "0123456789\n" ); }
+    QTemporaryFile file;
+    testTrue( writeFile( file, data ) );
+
+    MappedTextDocument doc;
+    MappedTextBuffer* buf = doc.mappedBuffer();
+    buf->setBlockSize( 110 );
+    testTrue( doc.open( file.fileName() ) );
+    testTrue( doc.isIndexing() );
+    testEqual( buf->blockCount(), MappedTextDocument::InitialBlockCount );
+    testEqual( buf->length(), 440 );
+    testEqual( buf->lineCount(), 41 );
+
+    testTrue( buf->indexBlocks(1) );
+    testEqual( buf->length(), 550 );
+    testEqual( buf->lineCount(), 51 );
+    testEqual( buf->offsetFromLine(50), 550 );
+
+    // the line data of the document should grow with the indexed blocks
+    doc.giveLineData( 45, 0, new QStringTextLineData("test") );
+    testTrue( doc.getLineData( 45, 0 ) != 0 );
+
+    buf->indexAll();
+    testTrue( buf->isFullyIndexed() );
+    testEqual( buf->indexedByteCount(), data.length() );
+    testEqual( buf->text(), QString::fromLatin1( data ) );
+    testEqual( buf->lineCount(), 101 );
+}
+
+
+/// Tests the chunk access, every block is a chunk
+void MappedTextBufferTest::testChunkAt()
+{
+    QTemporaryFile file;
+    testTrue( writeFile( file, "aaaa\nbbbb\ncccc\ndddd" ) );
+
+    MappedTextDocument doc;
+    MappedTextBuffer* buf = doc.mappedBuffer();
+    buf->setBlockSize( 5 );
+    testTrue( doc.open( file.fileName() ) );
+    buf->indexAll();
+    testEqual( buf->blockCount(), 4 );
+
+    TextOffset chunkStart = -1, chunkLength = -1;
+    const QChar* chunk = buf->chunkAt( 7, chunkStart, chunkLength );
+    testEqual( chunkStart, 5 );
+    testEqual( chunkLength, 5 );
+    testEqual( QString( chunk, static_cast<int>( chunkLength ) ), "bbbb\n" );
+
+    // the end of the buffer returns the last chunk
+    chunk = buf->chunkAt( buf->length(), chunkStart, chunkLength );
+    testEqual( chunkStart, 15 );
+    testEqual( QString( chunk, static_cast<int>( chunkLength ) ), "dddd" );
+
+    // walking over all chunks should result in the complete text
+    QString text;
+    TextBufferChunkIterator itr( buf, 2, buf->length() - 4 );
+    while( itr.hasNext() ) {
+        const QChar* data = itr.next();
+        text.append( data, static_cast<int>( itr.length() ) );
+    }
+    testEqual( text, "aa\nbbbb\ncccc\ndd" );
+}
+
+
+/// A mapped document can't be changed
+void MappedTextBufferTest::testReadonly()
+{
+    QTemporaryFile file;
+    testTrue( writeFile( file, "abc" ) );
+
+    MappedTextDocument doc;
+    testTrue( doc.open( file.fileName() ) );
+    testTrue( doc.isReadonly() );
+
+    doc.buffer()->replaceText( 0, 1, "x" );
+    testEqual( doc.buffer()->text(), "abc" );
+
+    CharTextDocument charDoc;
+    testFalse( charDoc.isReadonly() );
+}
+
+
+/// Tests that the changes of a read-only document are rejected before a change or an undo entry is created
+void MappedTextBufferTest::testReadonlyDocumentChanges()
+{
+    QTemporaryFile file;
+    testTrue( writeFile( file, "abc" ) );
+
+    MappedTextDocument doc;
+    testTrue( doc.open( file.fileName() ) );
+
+    doc.replace( 0, 1, "x" );
+    doc.append( "def" );
+    doc.setText( "xyz" );
+    TextRangeSet ranges( &doc );
+    ranges.addRange( 0, 1 );
+    ranges.addRange( 2, 3 );
+    doc.replaceRangeSet( ranges, "x" );
+
+    testEqual( doc.text(), "abc" );
+    testEqual( ranges.rangesAsString(), "0>1,2>3" );
+    testEqual( doc.textUndoStack()->size(), 0 );
+    testTrue( doc.isPersisted() );
+}
+
+
+/// Tests all block sizes with the multi-byte UTF-8 text. Blocks may never split a character or a "\r\n" pair
+void MappedTextBufferTest::testCompareWithCharTextBuffer()
+{
+    QByteArray data;
+    for( int i=0; i < 20; ++i ) { data.append( Utf8Text ); }
+    QTemporaryFile file;
+    testTrue( writeFile( file, data ) );
+
+    CharTextDocument charDoc;
+    TextBuffer* charBuf = charDoc.buffer();
+    charBuf->setText( expectedText( data ) );
+
+    for( int blockSize=1; blockSize < 12; ++blockSize ) {
+        MappedTextDocument doc;
+        MappedTextBuffer* buf = doc.mappedBuffer();
+        buf->setBlockSize( blockSize );
+        testTrue( doc.open( file.fileName() ) );
+        buf->indexAll();
+
+        testEqual( buf->length(), charBuf->length() );
+        testEqual( buf->text(), charBuf->text() );
+        testEqual( buf->lineCount(), charBuf->lineCount() );
+        testEqual( buf->lineOffsetsAsString(), charBuf->lineOffsetsAsString() );
+        for( TextOffset offset=0, len=charBuf->length(); offset <= len; ++offset ) {
+            testEqual( buf->lineFromOffset(offset), charBuf->lineFromOffset(offset) );
+        }
+        for( int line=0, cnt=charBuf->lineCount(); line <= cnt; ++line ) {
+            testEqual( buf->offsetFromLine(line), charBuf->offsetFromLine(line) );
+        }
+        testEqual( buf->textPart( 3, 40 ), charBuf->textPart( 3, 40 ) );
+    }
+}
+
+
+/// Writes the given data to the temporary file
+/// @return true on success
+bool MappedTextBufferTest::writeFile(QTemporaryFile& file, const QByteArray& data)
+{
+    if( !file.open() ) { return false; }
+    bool result = file.write( data ) == data.length();
+    file.close();
+    return result;
+}
+
+
+} // edbee
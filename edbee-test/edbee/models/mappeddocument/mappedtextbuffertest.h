@@ -0,0 +1,36 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+class QTemporaryFile;
+
+namespace edbee {
+
+
+/// The class for testing the memory mapped textbuffer and document
+class MappedTextBufferTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testOpenUtf8();
+    void testOpenLatin1();
+    void testOpenWithByteOrderMark();
+    void testOpenFailure();
+    void testLazyIndexing();
+    void testChunkAt();
+    void testReadonly();
+    void testReadonlyDocumentChanges();
+    void testCompareWithCharTextBuffer();
+
+private:
+    bool writeFile( QTemporaryFile& file, const QByteArray& data );
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::MappedTextBufferTest);
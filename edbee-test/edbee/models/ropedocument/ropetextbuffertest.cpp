@@ -0,0 +1,139 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "ropetextbuffertest.h"
+
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/ropedocument/ropetextbuffer.h"
+#include "edbee/models/ropedocument/ropetextdocument.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Asserts the buffer
+#define testBuffer( buf, txt, markers ) \
+do { \
+    testEqual( buf->text(), txt );  \
+    QString lineOffsets = buf->lineOffsetsAsString(); \
+    testEqual( lineOffsets, markers ); \
+} while(false)
+
+
+/// Returns a new rope document, so the TextBufferTest tests are performed on the rope buffer
+TextDocument* RopeTextBufferTest::createDocument()
+{
+    return new RopeTextDocument();
+}
+
+
+/// Tests the raw appending of data
+void RopeTextBufferTest::testRawAppend()
+{
+    RopeTextDocument doc;
+    doc.setText("abc\n");
+
+    doc.rawAppendBegin();
+    doc.rawAppend( QChar('d') );
+    QString str("e\nf");
+    doc.rawAppend( str.constData(), str.length() );
+    doc.rawAppendEnd();
+
+    testBuffer( doc.buffer(), "abc\nde\nf", "0,4,7" );
+    testEqual( QString( doc.buffer()->rawDataPointer(), doc.length() ), "abc\nde\nf" );
+}
+
+
+/// Tests if big texts are split in chunks and if the chunk boundaries are handled correctly
+void RopeTextBufferTest::testBigTextAndChunking()
+{
+    RopeTextDocument doc;
+    RopeTextBuffer* buf = dynamic_cast<RopeTextBuffer*>( doc.buffer() );
+    testTrue( buf != nullptr );
+
+    QString line("0123456789abcdefghijklmnopqrstuvwxyz\n");     // 37 chars
+    QString text;
+    for( int i=0; i<1000; ++i ) { text.append(line); }
+    buf->setText( text );
+
+    testEqual( buf->length(), 37000 );
+    testEqual( buf->lineCount(), 1001 );
+    testTrue( buf->chunkCount() >= 37000 / RopeTextBuffer::ChunkSize );
+    testEqual( buf->offsetFromLine(500), 500*37 );
+    testEqual( buf->lineFromOffset(500*37-1), 499 );
+    testEqual( buf->lineFromOffset(500*37), 500 );
+    testEqual( buf->charAt(500*37+10), QChar('a') );
+    testEqual( buf->textPart(1020, 40), text.mid(1020, 40) );
+
+    // typing a lot of characters at one location should not fragment the tree
+    for( int i=0; i<1000; ++i ) { buf->replaceText( 100+i, 0, "x" ); }
+    testEqual( buf->length(), 38000 );
+    testTrue( buf->chunkCount() < 38000 / (RopeTextBuffer::ChunkSize/4) );
+}
+
+
+/// Tests if the chunks of the rope can be iterated
+void RopeTextBufferTest::testChunkAt()
+{
+    RopeTextDocument doc;
+    TextBuffer* buf = doc.buffer();
+    TextOffset start = -1, length = -1;
+    testTrue( buf->chunkAt( 0, start, length ) == nullptr );
+
+    QString text;
+    for( int i=0; i<5000; ++i ) { text.append( QChar( 'a' + i % 26 ) ); }
+    buf->setText( text );
+
+    const QChar* chunk = buf->chunkAt( 3000, start, length );
+    testTrue( start <= 3000 && 3000 < start + length );
+    testEqual( QString( chunk, length ), text.mid( start, length ) );
+
+    // the end offset returns the last chunk
+    buf->chunkAt( 5000, start, length );
+    testEqual( start + length, 5000 );
+
+    // iterating over all chunks should result in the complete text
+    QString result;
+    TextBufferChunkIterator itr( buf, 10, 4980 );
+    while( itr.hasNext() ) {
+        const QChar* data = itr.next();
+        result.append( data, itr.length() );
+    }
+    testEqual( result, text.mid( 10, 4980 ) );
+}
+
+
+/// Performs a lot of pseudo random changes on a CharTextBuffer and a RopeTextBuffer and compares the results
+void RopeTextBufferTest::testCompareWithCharTextBuffer()
+{
+    CharTextDocument charDoc;
+    RopeTextDocument ropeDoc;
+    TextBuffer* charBuf = charDoc.buffer();
+    TextBuffer* ropeBuf = ropeDoc.buffer();
+
+    quint32 seed = 1234;
+    for( int i=0; i < 2000; ++i ) {
+        seed = seed * 1103515245u + 12345u;
+        int offset = charBuf->length() ? static_cast<int>( (seed >> 8) % static_cast<quint32>( charBuf->length() + 1 ) ) : 0;
+        int length = static_cast<int>( (seed >> 4) % 8 );
+        QString text;
+        int textLength = static_cast<int>( (seed >> 12) % ( i % 50 == 0 ? 3000 : 6 ) );
+        for( int j=0; j<textLength; ++j ) {
+            text.append( (j+i) % 7 == 0 ? QChar('\n') : QChar('a' + (j % 26) ) );
+        }
+        charBuf->replaceText( offset, length, text );
+        ropeBuf->replaceText( offset, length, text );
+    }
+
+    testEqual( ropeBuf->length(), charBuf->length() );
+    testEqual( ropeBuf->text(), charBuf->text() );
+    testEqual( ropeBuf->lineCount(), charBuf->lineCount() );
+    testEqual( ropeBuf->lineOffsetsAsString(), charBuf->lineOffsetsAsString() );
+    for( int offset=0, len=charBuf->length(); offset < len; offset += 97 ) {
+        testEqual( ropeBuf->lineFromOffset(offset), charBuf->lineFromOffset(offset) );
+    }
+}
+
+
+} // edbee
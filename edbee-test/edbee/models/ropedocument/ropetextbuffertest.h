@@ -0,0 +1,30 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/models/textbuffertest.h"
+
+namespace edbee {
+
+
+/// The class for testing the rope textbuffer
+/// It runs all TextBufferTest tests against the buffer of a RopeTextDocument, with the rope specific tests
+class RopeTextBufferTest : public TextBufferTest
+{
+    Q_OBJECT
+
+protected:
+    virtual TextDocument* createDocument();
+
+private slots:
+
+    void testRawAppend();
+    void testBigTextAndChunking();
+    void testChunkAt();
+    void testCompareWithCharTextBuffer();
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::RopeTextBufferTest);
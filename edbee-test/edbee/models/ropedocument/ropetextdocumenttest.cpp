@@ -0,0 +1,20 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "ropetextdocumenttest.h"
+
+#include "edbee/models/ropedocument/ropetextdocument.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Returns a new rope document, so the TextDocumentTest tests are performed on the rope document
+TextDocument* RopeTextDocumentTest::createDocument()
+{
+    return new RopeTextDocument();
+}
+
+
+} // edbee
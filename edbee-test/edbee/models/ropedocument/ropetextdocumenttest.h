@@ -0,0 +1,23 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/models/textdocumenttest.h"
+
+namespace edbee {
+
+
+/// The class for testing the rope textdocument
+/// It runs all TextDocumentTest tests against a RopeTextDocument
+class RopeTextDocumentTest : public TextDocumentTest
+{
+    Q_OBJECT
+
+protected:
+    virtual TextDocument* createDocument();
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::RopeTextDocumentTest);
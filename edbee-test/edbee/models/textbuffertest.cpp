@@ -3,9 +3,11 @@
 
 #include "textbuffertest.h"
 
+#include <QScopedPointer>
+
 #include "edbee/models/textbuffer.h"
-#include "edbee/models/chardocument/chartextbuffer.h"
 #include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/util/lineoffsetvector.h"
 
 #include "edbee/debug.h"
 
@@ -22,10 +24,19 @@ do { \
 } while(false)
 
 
+/// Returns a new document with the buffer that's tested
+/// Subclasses override this method to run the same tests against another buffer implementation
+TextDocument* TextBufferTest::createDocument()
+{
+    return new CharTextDocument();
+}
+
+
 /// This method tests the line from offset method
 void TextBufferTest::testlineFromOffset()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     TextBuffer* buf = doc.buffer();
 
     // build an initial doc
@@ -43,7 +54,8 @@ void TextBufferTest::testlineFromOffset()
 /// Tests if the column from offset and line works correctly
 void TextBufferTest::testColumnFromOffsetAndLine()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     TextBuffer* buf = doc.buffer();
     buf->appendText("a1\nbb2\nccc3\n\nd5");
 
@@ -80,7 +92,8 @@ void TextBufferTest::testColumnFromOffsetAndLine()
 void TextBufferTest::testReplaceText()
 {
     // first test. An empty document should be empty!
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     TextBuffer* buf = doc.buffer();
     testBuffer( buf, "", "0" );
 
@@ -163,7 +176,8 @@ void TextBufferTest::testReplaceText()
 /// This method tests the finchar pos within range function
 void TextBufferTest::testFindCharPosWithinRange()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     TextBuffer* buf = doc.buffer();
     buf->appendText("aaa\naa bb cc\n a \n ");
     QString strA = "a";
@@ -204,7 +218,8 @@ void TextBufferTest::testFindCharPosWithinRange()
 /// This method is for testing the line function
 void TextBufferTest::testLine()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     TextBuffer* buf = doc.buffer();
     buf->appendText("aaa\nbbb\nccc\nddd");
 
@@ -220,7 +235,8 @@ void TextBufferTest::testLine()
 /// test method test the working of the lineoffsetvector. (Which fgot corrupted with certain replaces)
 void TextBufferTest::testReplaceIssue141()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     TextBuffer* buf = doc.buffer();
 //    CharTextBuffer* charBuf = dynamic_cast<CharTextBuffer*>(buf);
     buf->appendText("11\n22\n33");
@@ -249,4 +265,56 @@ void TextBufferTest::testReplaceIssue141()
 }
 
 
+/// Tests the line lookups at the end of the document (after an empty line and in the last line)
+void TextBufferTest::testLineLookupsAtEnd()
+{
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
+    TextBuffer* buf = doc.buffer();
+    buf->appendText("a1\nb2\nc3\n\nd5");
+
+    testEqual( buf->lineFromOffset(9), 3 );
+    testEqual( buf->lineFromOffset(10), 4 );
+    testEqual( buf->lineFromOffset(12), 4 );
+    testEqual( buf->lineLength(1), 3 );
+    testEqual( buf->lineLength(3), 1 );
+    testEqual( buf->lineLengthWithoutNewline(4), 2 );
+}
+
+
+/// Tests the newline offsets of a change, with inline offsets and with more newlines
+void TextBufferTest::testTextBufferChange()
+{
+    LineOffsetVector lineOffsets;
+
+    QString text("a\nb\n");
+    TextBufferChange change( &lineOffsets, 10, 2, text.constData(), text.length() );
+    testEqual( change.offset(), 10 );
+    testEqual( change.length(), 2 );
+    testEqual( change.newLineCount(), 2 );
+    testEqual( change.newLineOffset(0), 12 );
+    testEqual( change.newLineOffset(1), 14 );
+
+    // a copy contains the same offsets
+    TextBufferChange copy( change );
+    testEqual( copy.newLineCount(), 2 );
+    testEqual( copy.newLineOffset(1), 14 );
+
+    // more newlines than fit inline
+    QString lines( TextBufferChange::InlineLineOffsetCount * 3, QChar('\n') );
+    TextBufferChange bigChange( &lineOffsets, 0, 0, lines.constData(), lines.length() );
+    testEqual( bigChange.newLineCount(), lines.length() );
+    QVector<TextOffset> offsets = bigChange.newLineOffsets();
+    testEqual( offsets.size(), lines.length() );
+    for( int i=0; i < offsets.size(); ++i ) {
+        testEqual( offsets.at(i), i + 1 );
+        testEqual( bigChange.newLineOffset(i), i + 1 );
+    }
+
+    TextBufferChange emptyChange;
+    testEqual( emptyChange.newLineCount(), 0 );
+    testEqual( emptyChange.newTextLength(), 0 );
+}
+
+
 } // edbee
@@ -7,12 +7,19 @@
 
 namespace edbee {
 
+class TextDocument;
+
 
 /// The clas for testing the textbuffer
+/// The tests are performed on the buffer of the document returned by createDocument,
+/// subclasses (like RopeTextBufferTest) run the same tests against other buffer implementations
 class TextBufferTest : public edbee::test::TestCase
 {
     Q_OBJECT
 
+protected:
+    virtual TextDocument* createDocument();
+
 private slots:
 
     void testlineFromOffset();
@@ -21,6 +28,8 @@ private slots:
     void testFindCharPosWithinRange();
     void testLine();
     void testReplaceIssue141();
+    void testLineLookupsAtEnd();
+    void testTextBufferChange();
 };
 
 } // edbee
@@ -3,6 +3,7 @@
 
 #include "textdocumenttest.h"
 
+#include <QScopedPointer>
 #include <QStringList>
 #include <QDebug>
 
@@ -10,6 +11,7 @@
 #include "edbee/models/textbuffer.h"
 #include "edbee/models/textlinedata.h"
 #include "edbee/models/textrange.h"
+#include "edbee/models/textundostack.h"
 
 #include "edbee/debug.h"
 
@@ -25,10 +27,19 @@ do { \
 } while(false)
 
 
+/// Returns a new document that's tested
+/// Subclasses override this method to run the same tests against another document implementation
+TextDocument* TextDocumentTest::createDocument()
+{
+    return new CharTextDocument();
+}
+
+
 /// Test the line data handling of line data
 void TextDocumentTest::testLineData()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     TextBuffer* buf = doc.buffer();
     buf->appendText("aaa\nbbb\nccc");
     testTrue( doc.getLineData( 0, 0 ) == 0 );
@@ -84,7 +95,8 @@ void TextDocumentTest::testLineData()
 /// b) "a[X]c[d] => "aR[]cS[]"
 void TextDocumentTest::testReplaceRangeSet_simple()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     doc.append("abcd");
 
     // create the ranges
@@ -110,7 +122,8 @@ void TextDocumentTest::testReplaceRangeSet_simple()
 /// test =>  "a[bc]de[fg]h" => "aX|deY|h
 void TextDocumentTest::testReplaceRangeSet_sizeDiff()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     doc.append("abcdefgh");
 
     // create the ranges
@@ -128,7 +141,8 @@ void TextDocumentTest::testReplaceRangeSet_sizeDiff()
 /// a|b|cd => aX|bY|cd
 void TextDocumentTest::testReplaceRangeSet_simpleInsert()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     doc.append("abcd");
 
     // create the ranges
@@ -147,7 +161,8 @@ void TextDocumentTest::testReplaceRangeSet_simpleInsert()
 /// a[1]b2c[3]d4 =>  a|b2c|d4
 void TextDocumentTest::testReplaceRangeSet_delete()
 {
-    CharTextDocument doc;
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
     doc.append("a1b2c3d4");
 
     // create the ranges
@@ -161,5 +176,56 @@ void TextDocumentTest::testReplaceRangeSet_delete()
 }
 
 
+/// Replacing multiple ranges with newlines should update the line offsets
+/// a[1]b[2]c[3] => a\n|b\n|c\n|
+void TextDocumentTest::testReplaceRangeSet_newlines()
+{
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
+    doc.setText("a1b2c3");
+
+    TextRangeSet ranges(&doc);
+    ranges.addRange(1,2);
+    ranges.addRange(3,4);
+    ranges.addRange(5,6);
+
+    doc.replaceRangeSet( ranges, "\n" );
+    testEqual( doc.text(), "a\nb\nc\n" );
+    testEqual( doc.lineCount(), 4 );
+    testEqual( ranges.rangesAsString(), "2>2,4>4,6>6" );
+}
+
+
+/// Multiple ranges are replaced one by one (with the room reserved in advance), every range can be undone separately
+/// a[1]b[2]c[3] => aX|bYY|cZ| => a1b2c3
+void TextDocumentTest::testReplaceRangeSet_undo()
+{
+    QScopedPointer<TextDocument> docPtr( createDocument() );
+    TextDocument& doc = *docPtr;
+    doc.append("a1b2c3");
+    doc.textUndoStack()->clear();
+
+    TextRangeSet ranges(&doc);
+    ranges.addRange(1,2);
+    ranges.addRange(3,4);
+    ranges.addRange(5,6);
+
+    doc.replaceRangeSet( ranges, QStringLiteral("X,YY,Z").split(",") );
+    testEqual( doc.text(), "aXbYYcZ" );
+    testEqual( ranges.rangesAsString(), "2>2,5>5,7>7" );
+
+    doc.textUndoStack()->undo();
+    testEqual( doc.text(), "aXbYYc3" );
+    doc.textUndoStack()->undo();
+    doc.textUndoStack()->undo();
+    testEqual( doc.text(), "a1b2c3" );
+
+    doc.textUndoStack()->redo();
+    doc.textUndoStack()->redo();
+    doc.textUndoStack()->redo();
+    testEqual( doc.text(), "aXbYYcZ" );
+}
+
+
 
 } // edbee
@@ -7,10 +7,19 @@
 
 namespace edbee {
 
+class TextDocument;
+
+
+/// The class for testing the textdocument
+/// The tests are performed on the document returned by createDocument,
+/// subclasses (like RopeTextDocumentTest) run the same tests against other document implementations
 class TextDocumentTest : public edbee::test::TestCase
 {
     Q_OBJECT
 
+protected:
+    virtual TextDocument* createDocument();
+
 private slots:
 
     void testLineData();
@@ -18,6 +27,8 @@ private slots:
     void testReplaceRangeSet_sizeDiff();
     void testReplaceRangeSet_simpleInsert();
     void testReplaceRangeSet_delete();
+    void testReplaceRangeSet_newlines();
+    void testReplaceRangeSet_undo();
 };
 
 
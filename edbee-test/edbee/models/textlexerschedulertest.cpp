@@ -0,0 +1,131 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textlexerschedulertest.h"
+
+#include <QCoreApplication>
+
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textdocumentscopes.h"
+#include "edbee/models/textgrammar.h"
+#include "edbee/models/textlexerscheduler.h"
+#include "edbee/edbee.h"
+#include "edbee/testsupport.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Fills the document with the given number of lines and sets the test grammar
+static void fillDocument( TextDocument* doc, int lineCount )
+{
+    QString text;
+    for( int i=0; i < lineCount; ++i ) {
+        text.append( QStringLiteral("if a /* comment */ b\n") );
+    }
+    doc->setText( text );
+    doc->setLanguageGrammar( TestSupport::grammar( QStringLiteral("schedulertest") ) );
+}
+
+
+/// Processes the events until the scheduler isn't pending anymore
+/// @return the number of processed time slices
+static int processPendingLexing( TextLexerScheduler* scheduler )
+{
+    int count = 0;
+    while( scheduler->isPending() && count < 100000 ) {
+        QCoreApplication::processEvents();
+        ++count;
+    }
+    return count;
+}
+
+
+/// A range that can be lexed in a single time slice is lexed directly
+void TextLexerSchedulerTest::testSmallRange()
+{
+    CharTextDocument doc;
+    fillDocument( &doc, 100 );
+
+    TextLexerScheduler scheduler;
+    scheduler.setDocument( &doc );
+    testTrue( scheduler.lexRange( 0, doc.offsetFromLine(10) ) );
+    testFalse( scheduler.isPending() );
+    testTrue( doc.scopes()->lastScopedOffset() >= doc.offsetFromLine(10) );
+}
+
+
+/// A large range is lexed in batches on the event loop
+void TextLexerSchedulerTest::testTimeSlicedLexing()
+{
+    CharTextDocument doc;
+    fillDocument( &doc, 1000 );
+
+    // a time slice of 0 lexes a single batch per time slice
+    TextLexerScheduler scheduler;
+    scheduler.setDocument( &doc );
+    scheduler.setTimeSlice( 0 );
+    scheduler.setBatchLineCount( 10 );
+    testFalse( scheduler.lexRange( doc.offsetFromLine(990), doc.length() ) );
+    testTrue( scheduler.isPending() );
+    testEqual( scheduler.requestedOffset(), doc.length() );
+
+    // only the first batch is lexed
+    TextOffset lastScopedOffset = doc.scopes()->lastScopedOffset();
+    testTrue( lastScopedOffset >= doc.offsetFromLine(10) );
+    testTrue( lastScopedOffset < doc.offsetFromLine(990) );
+
+    // the rest is lexed on the event loop
+    testTrue( processPendingLexing( &scheduler ) > 1 );
+    testFalse( scheduler.isPending() );
+    testEqual( doc.scopes()->lastScopedOffset(), doc.length() );
+    testEqual( doc.scopes()->scopedRangesAtLine(999)->size(), doc.scopes()->scopedRangesAtLine(0)->size() );
+}
+
+
+/// A new request replaces the pending request
+void TextLexerSchedulerTest::testNewRequest()
+{
+    CharTextDocument doc;
+    fillDocument( &doc, 1000 );
+
+    TextLexerScheduler scheduler;
+    scheduler.setDocument( &doc );
+    scheduler.setTimeSlice( 0 );
+    scheduler.setBatchLineCount( 10 );
+    testFalse( scheduler.lexRange( doc.offsetFromLine(990), doc.length() ) );
+
+    scheduler.requestLexing( doc.offsetFromLine(100) );
+    testEqual( scheduler.requestedOffset(), doc.offsetFromLine(100) );
+    processPendingLexing( &scheduler );
+    testTrue( doc.scopes()->lastScopedOffset() >= doc.offsetFromLine(100) );
+    testTrue( doc.scopes()->lastScopedOffset() < doc.offsetFromLine(990) );
+}
+
+
+/// Changing the document cancels the pending request
+void TextLexerSchedulerTest::testChangeDocument()
+{
+    CharTextDocument doc;
+    fillDocument( &doc, 1000 );
+    CharTextDocument otherDoc;
+    fillDocument( &otherDoc, 10 );
+
+    TextLexerScheduler scheduler;
+    scheduler.setDocument( &doc );
+    scheduler.setTimeSlice( 0 );
+    scheduler.setBatchLineCount( 10 );
+    testFalse( scheduler.lexRange( 0, doc.length() ) );
+    testTrue( scheduler.isPending() );
+
+    TextOffset lastScopedOffset = doc.scopes()->lastScopedOffset();
+    scheduler.setDocument( &otherDoc );
+    testFalse( scheduler.isPending() );
+    QCoreApplication::processEvents();
+    testEqual( doc.scopes()->lastScopedOffset(), lastScopedOffset );
+    testTrue( scheduler.document() == &otherDoc );
+}
+
+
+} // edbee
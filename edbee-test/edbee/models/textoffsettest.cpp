@@ -0,0 +1,199 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textoffsettest.h"
+
+#include <QByteArray>
+
+#include "edbee/models/changes/textchange.h"
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textbuffer.h"
+#include "edbee/models/textrange.h"
+#include "edbee/util/gapvector.h"
+#include "edbee/util/lineoffsetvector.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// An offset a bit beyond 2^31 (which doesn't fit in an int)
+static const qint64 Offset2G = Q_INT64_C(2147483648);
+
+/// The stress tests allocate several gigabytes of memory, they only run when the
+/// EDBEE_STRESS_TESTS environment variable is set
+static const char* StressTestsEnvVar = "EDBEE_STRESS_TESTS";
+
+
+/// Tests if the offset type has the configured size
+void TextOffsetTest::testOffsetSize()
+{
+#ifdef EDBEE_64BIT_OFFSETS
+    testEqual( static_cast<int>( sizeof(TextOffset) ), 8 );
+#else
+    testEqual( static_cast<int>( sizeof(TextOffset) ), 4 );
+#endif
+}
+
+
+/// Tests the textrange calculations with offsets beyond 2^31
+void TextOffsetTest::testTextRangeBeyond2G()
+{
+    if( skipWithout64BitOffsets() ) { return; }
+
+    TextRange range( Offset2G + 10, Offset2G - 10 );
+    testEqual( range.min(), Offset2G - 10 );
+    testEqual( range.max(), Offset2G + 10 );
+    testEqual( range.length(), 20 );
+    testTrue( range.contains( Offset2G ) );
+    testFalse( range.contains( 10 ) );
+
+    range.setLength( Offset2G );
+    testEqual( range.min(), Offset2G - 10 );
+    testEqual( range.max(), 2 * Offset2G - 10 );
+
+    range.maxVar() += Offset2G;
+    testEqual( range.max(), 3 * Offset2G - 10 );
+}
+
+
+/// Tests the line-offset vector with offsets beyond 2^31
+void TextOffsetTest::testLineOffsetVectorBeyond2G()
+{
+    if( skipWithout64BitOffsets() ) { return; }
+
+    LineOffsetVector v;
+    v.appendOffset( Offset2G - 1 );
+    v.appendOffset( Offset2G + 100 );
+    v.appendOffset( 3 * Offset2G );
+
+    testEqual( v.length(), 4 );
+    testEqual( v.at(2), Offset2G + 100 );
+    testEqual( v.at(3), 3 * Offset2G );
+
+    testEqual( v.findLineFromOffset( 100 ), 0 );
+    testEqual( v.findLineFromOffset( Offset2G ), 1 );
+    testEqual( v.findLineFromOffset( Offset2G + 100 ), 2 );
+    testEqual( v.findLineFromOffset( 2 * Offset2G ), 2 );
+    testEqual( v.findLineFromOffset( 4 * Offset2G ), 3 );
+}
+
+
+/// Tests the ranged change calculations with offsets beyond 2^31
+void TextOffsetTest::testTextChangeBeyond2G()
+{
+    if( skipWithout64BitOffsets() ) { return; }
+
+    TextChange change1( Offset2G, 4, QStringLiteral("ab") );
+    TextChange change2( Offset2G + 4, 2, QString() );
+    TextChange change3( Offset2G + 10, 2, QString() );
+
+    testEqual( change1.offset(), Offset2G );
+    testTrue( change1.isTouchedBy( &change2 ) );
+    testFalse( change1.isOverlappedBy( &change2 ) );
+    testFalse( change1.isTouchedBy( &change3 ) );
+
+    change3.addOffset( -6 );
+    testEqual( change3.offset(), Offset2G + 4 );
+    testTrue( change1.isTouchedBy( &change3 ) );
+}
+
+
+/// Tests a gap-vector with more than 2^31 items (stress test)
+void TextOffsetTest::testGapVectorBeyond2G()
+{
+    if( skipWithout64BitOffsets() || skipWithoutStressTests() ) { return; }
+
+    const TextOffset blockSize = 1024 * 1024;
+    QByteArray block( static_cast<int>( blockSize ), 'a' );
+
+    GapVector<char> v(16);
+    v.resize( Offset2G + 2 * blockSize );
+    while( v.length() <= Offset2G ) {
+        v.append( block.constData(), blockSize );
+    }
+    TextOffset length = v.length();
+    testTrue( length > Offset2G );
+
+    // replace in the middle of the vector, beyond 2^31
+    v.replace( Offset2G, 1, "xyz", 3 );
+    testEqual( v.length(), length + 2 );
+    testEqual( v.gapBegin(), Offset2G + 3 );
+    testEqual( v.at( Offset2G - 1 ), 'a' );
+    testEqual( v.at( Offset2G ), 'x' );
+    testEqual( v.at( Offset2G + 2 ), 'z' );
+    testEqual( v.at( Offset2G + 3 ), 'a' );
+
+    // move the gap to the front
+    v.replace( 0, 0, "b", 1 );
+    testEqual( v.at( Offset2G + 1 ), 'x' );
+    testEqual( v.at( v.length() - 1 ), 'a' );
+}
+
+
+/// Tests a char textbuffer with more than 2^31 characters (stress test)
+void TextOffsetTest::testCharTextBufferBeyond2G()
+{
+    if( skipWithout64BitOffsets() || skipWithoutStressTests() ) { return; }
+
+    // every block is a single line of text
+    const TextOffset blockSize = 1024 * 1024;
+    QString block( static_cast<int>( blockSize - 1 ), QChar('a') );
+    block.append( QChar('\n') );
+
+    CharTextDocument doc;
+    TextBuffer* buf = doc.buffer();
+    int blockCount = 0;
+    buf->rawAppendBegin();
+    while( blockCount * blockSize <= Offset2G ) {
+        buf->rawAppend( block.constData(), blockSize );
+        ++blockCount;
+    }
+    buf->rawAppendEnd();
+
+    TextOffset length = buf->length();
+    testEqual( length, blockCount * blockSize );
+    testEqual( buf->lineCount(), blockCount + 1 );
+    testEqual( buf->offsetFromLine( blockCount ), length );
+    testEqual( buf->lineFromOffset( length - 1 ), blockCount - 1 );
+    testEqual( buf->lineFromOffset( Offset2G ), static_cast<int>( Offset2G / blockSize ) );
+
+    // replace the last newline (beyond 2^31)
+    buf->replaceText( length - 1, 1, QStringLiteral("XYZ\n") );
+    testEqual( buf->length(), length + 3 );
+    testEqual( buf->charAt( length - 1 ), QChar('X') );
+    testEqual( buf->textPart( length - 2, 4 ), QStringLiteral("aXYZ") );
+    testEqual( buf->offsetFromLine( blockCount ), length + 3 );
+    testEqual( buf->columnFromOffsetAndLine( length + 2 ), blockSize + 2 );
+
+    // inserting at the start of the document should shift all offsets beyond 2^31
+    buf->replaceText( 0, 0, QStringLiteral("b") );
+    testEqual( buf->offsetFromLine( blockCount ), length + 4 );
+    testEqual( buf->lineFromOffset( length + 3 ), blockCount - 1 );
+    testEqual( buf->charAt( length ), QChar('X') );
+}
+
+
+/// Skips the current test when the offsets are 32 bit
+/// @return true if the test is skipped
+bool TextOffsetTest::skipWithout64BitOffsets()
+{
+#ifdef EDBEE_64BIT_OFFSETS
+    return false;
+#else
+    testSkip( "Requires EDBEE_64BIT_OFFSETS" );
+    return true;
+#endif
+}
+
+
+/// Skips the current test when the stress tests aren't enabled
+/// @return true if the test is skipped
+bool TextOffsetTest::skipWithoutStressTests()
+{
+    if( qEnvironmentVariableIsSet( StressTestsEnvVar ) ) { return false; }
+    testSkip( QStringLiteral("Set %1 to run this stress test").arg( StressTestsEnvVar ) );
+    return true;
+}
+
+
+} // edbee
@@ -0,0 +1,32 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+/// Tests the document model with offsets beyond 2^31 (only when built with EDBEE_64BIT_OFFSETS)
+class TextOffsetTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testOffsetSize();
+    void testTextRangeBeyond2G();
+    void testLineOffsetVectorBeyond2G();
+    void testTextChangeBeyond2G();
+    void testGapVectorBeyond2G();
+    void testCharTextBufferBeyond2G();
+
+private:
+    bool skipWithout64BitOffsets();
+    bool skipWithoutStressTests();
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::TextOffsetTest);
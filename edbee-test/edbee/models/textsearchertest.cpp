@@ -164,6 +164,69 @@ void TextSearcherTest::testSelectAll()
 }
 
 
+/// Tests searching a large document in blocks. A match that crosses the gap of the buffer is found
+void TextSearcherTest::testSearchAcrossChunks()
+{
+    CharTextDocument doc;
+    QString filler( 100000, QChar('x') );
+    doc.setText( filler + "needle" + filler + "needle" );
+
+    // place the gap in the middle of the first needle
+    doc.replace( 100003, 0, "-" );
+    doc.replace( 100003, 1, "" );
+    testEqual( doc.length(), 200012 );
+
+    TextSearcher searcher;
+    searcher.setSearchTerm("needle");
+    TextRangeSet ranges( &doc );
+    ranges.addRange( 0, 0 );
+    testEqual( searcher.findNextRange( &ranges ).toString(), "100000>100006" );
+
+    ranges.setRange( 100001, 100001 );
+    testEqual( searcher.findNextRange( &ranges ).toString(), "200006>200012" );
+
+    searcher.setReverse( true );
+    ranges.setRange( 150000, 150000 );
+    testEqual( searcher.findNextRange( &ranges ).toString(), "100000>100006" );
+
+    ranges.setRange( doc.length(), doc.length() );
+    testEqual( searcher.findNextRange( &ranges ).toString(), "200006>200012" );
+}
+
+
+/// Tests regular expression matches that are much longer than the context of a searched block
+void TextSearcherTest::testSearchLongMatches()
+{
+    CharTextDocument doc;
+    QString filler( 100000, QChar('x') );
+    doc.setText( filler + "BEGIN" + QString( 10000, QChar('\n') ) + "END" + filler );
+
+    // place the gap in the middle of the match
+    doc.replace( 105000, 0, "-" );
+    doc.replace( 105000, 1, "" );
+
+    TextSearcher searcher;
+    searcher.setSyntax( TextSearcher::SyntaxRegExp );
+    searcher.setSearchTerm("BEGIN[\\s\\S]*?END");
+    TextRangeSet ranges( &doc );
+    ranges.addRange( 0, 0 );
+    testEqual( searcher.findNextRange( &ranges ).toString(), "100000>110008" );
+
+    searcher.setReverse( true );
+    ranges.setRange( doc.length(), doc.length() );
+    testEqual( searcher.findNextRange( &ranges ).toString(), "100000>110008" );
+
+    // a match that's longer than the visible data is searched again with a larger context
+    doc.setText( QString( 2500000, QChar('y') ) + "x" );
+    doc.replace( 1000000, 0, "-" );
+    doc.replace( 1000000, 1, "" );
+    searcher.setReverse( false );
+    searcher.setSearchTerm("y+");
+    ranges.setRange( 0, 0 );
+    testEqual( searcher.findNextRange( &ranges ).toString(), "0>2500000" );
+}
+
+
 /// Creates the basic fixture
 TextDocument* TextSearcherTest::createFixtureDocument()
 {
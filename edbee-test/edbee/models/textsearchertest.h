@@ -31,6 +31,8 @@ private slots:
     void testSelectNext();
     void testSelectPrev();
     void testSelectAll();
+    void testSearchAcrossChunks();
+    void testSearchLongMatches();
 
 
 private:
@@ -0,0 +1,208 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textsnapshottest.h"
+
+#include <QThread>
+
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textbuffer.h"
+#include "edbee/models/textsnapshot.h"
+#include "edbee/util/xorshiftrandom.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// A thread that reads the text of a snapshot
+class SnapshotReaderThread : public QThread
+{
+public:
+    SnapshotReaderThread( const TextSnapshot& snapshot ) : snapshot_(snapshot), lineCount_(0) {}
+
+    QString text() const { return text_; }
+    int lineCount() const { return lineCount_; }
+
+protected:
+    virtual void run()
+    {
+        for( int i=0; i < 20; ++i ) {
+            text_ = snapshot_.text();
+            lineCount_ = snapshot_.lineCount();
+        }
+    }
+
+private:
+    TextSnapshot snapshot_;
+    QString text_;
+    int lineCount_;
+};
+
+
+/// Returns the line starts of the snapshot as a string (like TextBuffer::lineOffsetsAsString)
+static QString lineOffsetsAsString( const TextSnapshot& snapshot )
+{
+    QStringList offsets;
+    for( int i=0; i < snapshot.lineCount(); ++i ) {
+        offsets.append( QString::number( snapshot.offsetFromLine(i) ) );
+    }
+    return offsets.join(",");
+}
+
+
+/// Tests the snapshot of an empty document
+void TextSnapshotTest::testEmptySnapshot()
+{
+    TextSnapshot nullSnapshot;
+    testTrue( nullSnapshot.isNull() );
+    testEqual( nullSnapshot.length(), 0 );
+    testEqual( nullSnapshot.lineCount(), 1 );
+    testEqual( nullSnapshot.text(), "" );
+
+    CharTextDocument doc;
+    TextSnapshot snapshot = doc.snapshot();
+    testFalse( snapshot.isNull() );
+    testEqual( snapshot.length(), 0 );
+    testEqual( snapshot.lineCount(), 1 );
+    testEqual( snapshot.lineFromOffset(0), 0 );
+    testEqual( snapshot.chunkCount(), 0 );
+
+    TextOffset chunkStart = -1, chunkLength = -1;
+    testTrue( snapshot.chunkAt( 0, chunkStart, chunkLength ) == 0 );
+    testEqual( chunkStart, 0 );
+    testEqual( chunkLength, 0 );
+}
+
+
+/// A snapshot should never change, even when the document is changed
+void TextSnapshotTest::testSnapshotIsImmutable()
+{
+    CharTextDocument doc;
+    doc.setText("abc\ndef");
+    TextSnapshot snapshot1 = doc.snapshot();
+    testEqual( snapshot1.revision(), doc.revision() );
+
+    doc.replace( 1, 1, "BB\n" );
+    testEqual( doc.text(), "aBB\nc\ndef" );
+    testTrue( snapshot1.revision() != doc.revision() );
+    testEqual( snapshot1.text(), "abc\ndef" );
+    testEqual( snapshot1.lineCount(), 2 );
+
+    TextSnapshot snapshot2 = doc.snapshot();
+    testEqual( snapshot2.revision(), doc.revision() );
+    testEqual( snapshot2.text(), "aBB\nc\ndef" );
+    testEqual( snapshot2.lineCount(), 3 );
+
+    // without changes the same snapshot is returned
+    TextSnapshot snapshot3 = doc.snapshot();
+    testEqual( snapshot3.revision(), snapshot2.revision() );
+    testEqual( snapshot3.text(), snapshot2.text() );
+}
+
+
+/// Tests the line methods of the snapshot
+void TextSnapshotTest::testLines()
+{
+    CharTextDocument doc;
+    doc.setText("a1\nb2\nc3\n\nd5");
+    TextSnapshot snapshot = doc.snapshot();
+    testEqual( lineOffsetsAsString( snapshot ), "0,3,6,9,10" );
+    testEqual( snapshot.lineFromOffset(0), 0 );
+    testEqual( snapshot.lineFromOffset(2), 0 );
+    testEqual( snapshot.lineFromOffset(3), 1 );
+    testEqual( snapshot.lineFromOffset(9), 3 );
+    testEqual( snapshot.lineFromOffset(12), 4 );
+    testEqual( snapshot.line(1), "b2\n" );
+    testEqual( snapshot.lineWithoutNewline(1), "b2" );
+    testEqual( snapshot.lineWithoutNewline(4), "d5" );
+    testEqual( snapshot.lineLength(3), 1 );
+    testEqual( snapshot.charAt(4), QChar('2') );
+    testEqual( snapshot.textPart(4,4), "2\nc3" );
+}
+
+
+/// Tests if only the changed chunks are rebuilt and the others are shared
+void TextSnapshotTest::testChunkSharing()
+{
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("12345678\n").repeated( TextSnapshotBuilder::ChunkSize * 2 ) );
+    TextSnapshotBuilder builder( doc.buffer() );
+
+    TextSnapshot snapshot1 = builder.snapshot();
+    int chunkCount = snapshot1.chunkCount();
+    testTrue( chunkCount >= 18 );
+    testEqual( builder.rebuiltChunkCount(), chunkCount );
+
+    // type some characters in the middle of the document
+    TextOffset offset = doc.length() / 2;
+    doc.replace( offset, 0, "a" );
+    doc.replace( offset + 1, 0, "b" );
+    TextSnapshot snapshot2 = builder.snapshot();
+    testEqual( builder.rebuiltChunkCount(), 1 );
+    testEqual( snapshot2.chunkCount(), chunkCount );
+    testEqual( snapshot2.textPart( offset - 1, 4 ), "\nab1" );
+    testEqual( snapshot2.lineCount(), doc.lineCount() );
+
+    // the unchanged chunks are shared
+    TextOffset chunkStart1 = 0, chunkLength1 = 0, chunkStart2 = 0, chunkLength2 = 0;
+    testTrue( snapshot1.chunkAt( 0, chunkStart1, chunkLength1 ) == snapshot2.chunkAt( 0, chunkStart2, chunkLength2 ) );
+    testTrue( snapshot1.chunkAt( snapshot1.length(), chunkStart1, chunkLength1 ) == snapshot2.chunkAt( snapshot2.length(), chunkStart2, chunkLength2 ) );
+    testEqual( chunkStart2, chunkStart1 + 2 );
+
+    // nothing is rebuilt without changes
+    builder.snapshot();
+    testEqual( builder.rebuiltChunkCount(), 0 );
+}
+
+
+/// Compares the snapshots with the document after random changes
+void TextSnapshotTest::testRandomChanges()
+{
+    XorShiftRandom random(1234);
+    CharTextDocument doc;
+    TextSnapshotBuilder builder( doc.buffer() );
+    for( int step=0; step < 200; ++step ) {
+        for( int i = random.next() % 4; i >= 0; --i ) {
+            TextOffset offset = random.next() % ( doc.length() + 1 );
+            TextOffset length = random.next() % ( qMin( doc.length() - offset, TextOffset(5000) ) + 1 );
+            QString text;
+            for( int j = random.next() % ( random.next() % 4 == 0 ? 9000 : 6 ); j > 0; --j ) {
+                text.append( random.next() % 10 == 0 ? QChar('\n') : QChar( 'a' + random.next() % 3 ) );
+            }
+            doc.replace( offset, length, text );
+        }
+
+        TextSnapshot snapshot = builder.snapshot();
+        testEqual( snapshot.revision(), doc.revision() );
+        testEqual( snapshot.text(), doc.text() );
+        testEqual( lineOffsetsAsString( snapshot ), doc.buffer()->lineOffsetsAsString() );
+        for( TextOffset offset = 0; offset <= doc.length(); offset += 97 ) {
+            testEqual( snapshot.lineFromOffset( offset ), doc.lineFromOffset( offset ) );
+        }
+    }
+}
+
+
+/// Reads a snapshot from another thread, while the document is changed
+void TextSnapshotTest::testReadFromOtherThread()
+{
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("line\n").repeated(50000) );
+    TextSnapshot snapshot = doc.snapshot();
+    QString expected = doc.text();
+
+    SnapshotReaderThread thread( snapshot );
+    thread.start();
+    for( int i=0; i < 1000; ++i ) {
+        doc.replace( i * 7, 1, "X" );
+        doc.snapshot();
+    }
+    thread.wait();
+
+    testEqual( thread.text(), expected );
+    testEqual( thread.lineCount(), 50001 );
+}
+
+
+} // edbee
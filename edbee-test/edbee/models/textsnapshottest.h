@@ -0,0 +1,28 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class TextSnapshotTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testEmptySnapshot();
+    void testSnapshotIsImmutable();
+    void testLines();
+    void testChunkSharing();
+    void testRandomChanges();
+    void testReadFromOtherThread();
+
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::TextSnapshotTest);
@@ -0,0 +1,205 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "typingbenchmark.h"
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include "edbee/allocationcounter.h"
+#include "edbee/models/chardocument/chartextbuffer.h"
+#include "edbee/models/textrange.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// The number of lines of the benchmark document
+static const int LineCount = 20000;
+
+/// The number of typed characters of a single benchmark run
+static const int TypeCount = 200000;
+
+/// Every TypedLineLength characters a newline is typed
+static const int TypedLineLength = 40;
+
+/// The number of carets of the multi-caret benchmark (a caret on every other line)
+static const int CaretCount = LineCount / 2;
+
+/// The number of characters typed with every caret
+static const int MultiCaretTypeCount = 20;
+
+
+/// Types characters in a buffer with enough room (in the gap of the text and of the line offsets).
+/// In that situation a single character edit may not allocate any memory in the buffer layer
+/// (the buffer has no textChanged receivers, so the removed text isn't copied)
+void TypingBenchmark::testTypingWithoutAllocations()
+{
+    CharTextBuffer buffer;
+    fillBuffer( &buffer );
+
+    // make room in the gaps at the caret, by inserting and removing text
+    TextOffset caret = buffer.offsetFromLine( LineCount / 2 );
+    typeText( &buffer, caret, 2000 );
+    removeText( &buffer, caret, 2000 );
+    TextOffset length = buffer.length();
+
+    AllocationCounter counter;
+    typeText( &buffer, caret, 1000 );
+    removeText( &buffer, caret, 1000 );
+    qint64 allocations = counter.count();
+
+    testEqual( buffer.length(), length );
+    if( AllocationCounter::isAvailable() ) {
+        testEqual( allocations, 0 );
+    }
+}
+
+
+/// Types characters (and newlines) in the middle of a document
+void TypingBenchmark::benchmarkTyping()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    CharTextBuffer buffer;
+    fillBuffer( &buffer );
+    TextOffset caret = buffer.offsetFromLine( LineCount / 2 );
+    int lineCount = buffer.lineCount();
+
+    QElapsedTimer timer;
+    timer.start();
+    AllocationCounter counter;
+    typeText( &buffer, caret, TypeCount );
+    qint64 allocations = counter.count();
+    qint64 time = timer.nsecsElapsed();
+
+    reportBenchmark( QStringLiteral("typing"), time, TypeCount );
+    if( AllocationCounter::isAvailable() ) {
+        reportBenchmark( QStringLiteral("typing (%1 allocations)").arg( allocations ), time );
+        // only the growing of the gaps allocates memory
+        testTrue( allocations * 100 <= TypeCount );
+    }
+    testEqual( buffer.lineCount(), lineCount + TypeCount / TypedLineLength );
+}
+
+
+/// Removes characters with backspace, with and without the old text for the textChanged signal
+/// (the buffer has a textChanged receiver, like the buffer of a document)
+void TypingBenchmark::benchmarkBackspace()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    for( int i=0; i < 2; ++i ) {
+        bool oldTextRequired = i == 0;
+
+        CharTextBuffer buffer;
+        connect( &buffer, &TextBuffer::textChanged, this, &TypingBenchmark::receiveTextChange );
+        buffer.setOldTextRequired( oldTextRequired );
+        fillBuffer( &buffer );
+        TextOffset caret = buffer.offsetFromLine( LineCount / 2 );
+        typeText( &buffer, caret, TypeCount );
+
+        QElapsedTimer timer;
+        timer.start();
+        AllocationCounter counter;
+        removeText( &buffer, caret, TypeCount );
+        qint64 allocations = counter.count();
+        qint64 time = timer.nsecsElapsed();
+
+        QString name = oldTextRequired ? QStringLiteral("backspace with old text") : QStringLiteral("backspace");
+        reportBenchmark( name, time, TypeCount );
+        if( AllocationCounter::isAvailable() ) {
+            reportBenchmark( QStringLiteral("%1 (%2 allocations)").arg( name ).arg( allocations ), time );
+            if( !oldTextRequired ) { testEqual( allocations, 0 ); }
+        }
+        testEqual( buffer.lineCount(), LineCount + 1 );
+    }
+}
+
+
+/// Types characters with a caret on every other line. Every character is inserted range by range
+/// (a replaceText call per caret) and with a single replaceRanges call
+void TypingBenchmark::benchmarkMultiCaretTyping()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    CharTextBuffer rangeBuffer;
+    CharTextBuffer batchBuffer;
+    fillBuffer( &rangeBuffer );
+    fillBuffer( &batchBuffer );
+
+    QVector<TextRange> ranges;
+    for( int i=0; i < CaretCount; ++i ) {
+        TextOffset offset = rangeBuffer.offsetFromLine( i * 2 );
+        ranges.append( TextRange( offset, offset ) );
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for( int i=0; i < MultiCaretTypeCount; ++i ) {
+        QChar c( 'a' + i );
+        for( int j=0; j < CaretCount; ++j ) {
+            rangeBuffer.replaceText( ranges.at(j).min() + j * (i + 1) + i, 0, &c, 1 );
+        }
+    }
+    qint64 rangeTime = timer.nsecsElapsed();
+
+    timer.restart();
+    for( int i=0; i < MultiCaretTypeCount; ++i ) {
+        QVector<TextRange> carets;
+        for( int j=0; j < CaretCount; ++j ) {
+            TextOffset offset = ranges.at(j).min() + j * i + i;
+            carets.append( TextRange( offset, offset ) );
+        }
+        batchBuffer.replaceRanges( carets, QStringList( QString( QChar( 'a' + i ) ) ) );
+    }
+    qint64 batchTime = timer.nsecsElapsed();
+
+    reportBenchmark( QStringLiteral("replaceText per caret"), rangeTime, MultiCaretTypeCount );
+    reportBenchmark( QStringLiteral("replaceRanges"), batchTime, MultiCaretTypeCount );
+    testEqual( batchBuffer.length(), rangeBuffer.length() );
+    testTrue( batchBuffer.text() == rangeBuffer.text() );
+}
+
+
+/// Fills the given buffer with LineCount lines
+void TypingBenchmark::fillBuffer(CharTextBuffer* buffer)
+{
+    QString lineText = QStringLiteral("The quick brown fox jumps over the lazy dog\n");
+    buffer->rawAppendBegin();
+    for( int i=0; i < LineCount; ++i ) {
+        buffer->rawAppend( lineText.constData(), lineText.length() );
+    }
+    buffer->rawAppendEnd();
+}
+
+
+/// Types the given number of characters one by one, starting at the given offset
+/// Every TypedLineLength characters a newline is typed
+void TypingBenchmark::typeText(CharTextBuffer* buffer, TextOffset offset, int count)
+{
+    for( int i=0; i < count; ++i ) {
+        QChar c = ( i + 1 ) % TypedLineLength == 0 ? QChar('\n') : QChar( 'a' + i % 26 );
+        buffer->replaceText( offset + i, 0, &c, 1 );
+    }
+}
+
+
+/// Removes the given number of characters before offset + count one by one (like pressing backspace)
+void TypingBenchmark::removeText(CharTextBuffer* buffer, TextOffset offset, int count)
+{
+    for( int i=count; i > 0; --i ) {
+        buffer->replaceText( offset + i - 1, 1, nullptr, 0 );
+    }
+}
+
+
+/// The textChanged receiver of the backspace benchmark, it ignores the change
+void TypingBenchmark::receiveTextChange(TextBufferChange change, QString oldText)
+{
+    Q_UNUSED(change);
+    Q_UNUSED(oldText);
+}
+
+
+} // edbee
@@ -0,0 +1,36 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/benchmarkcase.h"
+
+namespace edbee {
+
+class CharTextBuffer;
+class TextBufferChange;
+
+/// Measures the time and the heap allocations of typing (and removing) single characters in a text buffer
+/// and the time of typing with many carets
+class TypingBenchmark : public BenchmarkCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testTypingWithoutAllocations();
+    void benchmarkTyping();
+    void benchmarkBackspace();
+    void benchmarkMultiCaretTyping();
+
+private:
+    void fillBuffer( CharTextBuffer* buffer );
+    void typeText( CharTextBuffer* buffer, TextOffset offset, int count );
+    void removeText( CharTextBuffer* buffer, TextOffset offset, int count );
+    void receiveTextChange( edbee::TextBufferChange change, QString oldText );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::TypingBenchmark);
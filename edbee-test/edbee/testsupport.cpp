@@ -0,0 +1,66 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "testsupport.h"
+
+#include <QFile>
+
+#include "edbee/models/textgrammar.h"
+#include "edbee/edbee.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Writes (or appends) the given data to a file
+/// @param fileName the name of the file
+/// @param data the data to write
+/// @param append should the data be appended to the existing file?
+/// @return true if the file is opened and all data is written (use it with testTrue)
+bool TestSupport::writeFile(const QString& fileName, const QByteArray& data, bool append)
+{
+    QFile file( fileName );
+    if( !file.open( append ? QIODevice::Append : QIODevice::WriteOnly ) ) { return false; }
+    return file.write( data ) == data.size();
+}
+
+
+/// Reads the data of the given file
+/// @return the data of the file, an empty array if the file can't be opened
+QByteArray TestSupport::readFile(const QString& fileName)
+{
+    QFile file( fileName );
+    if( !file.open( QIODevice::ReadOnly ) ) { return QByteArray(); }
+    return file.readAll();
+}
+
+
+/// Returns the grammar for the lexer tests: the given keywords, numbers, block comments and quoted strings
+/// (with a back reference, included from the repository). The grammar is registered with the grammar manager,
+/// the next call with the same name returns the same grammar
+/// @param name the name of the grammar, the scope name is "source.<name>"
+/// @param keywords the keywords of the grammar, every keyword has its own rule with the scope "keyword.<keyword>"
+TextGrammar* TestSupport::grammar(const QString& name, const QStringList& keywords)
+{
+    QString scopeName = QStringLiteral("source.%1").arg( name );
+    TextGrammarManager* manager = Edbee::instance()->grammarManager();
+    TextGrammar* grammar = manager->get( scopeName );
+    if( grammar ) { return grammar; }
+
+    grammar = new TextGrammar( scopeName, name );
+    TextGrammarRule* mainRule = TextGrammarRule::createMainRule( grammar, scopeName );
+    foreach( const QString& keyword, keywords ) {
+        mainRule->giveRule( TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("keyword.%1").arg( keyword ), QStringLiteral("\\b%1\\b").arg( keyword ) ) );
+    }
+    mainRule->giveRule( TextGrammarRule::createSingleLineRegExp( grammar, QStringLiteral("constant.numeric"), QStringLiteral("\\b\\d+\\b") ) );
+    mainRule->giveRule( TextGrammarRule::createMultiLineRegExp( grammar, QStringLiteral("comment.block"), QString(), QStringLiteral("/\\*"), QStringLiteral("\\*/") ) );
+    mainRule->giveRule( TextGrammarRule::createIncludeRule( grammar, QStringLiteral("#strings") ) );
+    grammar->giveMainRule( mainRule );
+    grammar->giveToRepos( QStringLiteral("strings"), TextGrammarRule::createMultiLineRegExp( grammar, QStringLiteral("string.quoted"), QString(), QStringLiteral("(['\"])"), QStringLiteral("\\1") ) );
+    manager->giveGrammar( grammar );
+    return grammar;
+}
+
+
+} // edbee
@@ -0,0 +1,23 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace edbee {
+
+class TextGrammar;
+
+/// The helper functions that are shared by the tests (files and grammars)
+class TestSupport {
+public:
+    static bool writeFile( const QString& fileName, const QByteArray& data, bool append=false );
+    static QByteArray readFile( const QString& fileName );
+
+    static TextGrammar* grammar( const QString& name, const QStringList& keywords=QStringList( QStringLiteral("if") ) );
+};
+
+} // edbee
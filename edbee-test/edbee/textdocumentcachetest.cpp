@@ -0,0 +1,178 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textdocumentcachetest.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "edbee/io/textdocumentcache.h"
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textdocumentscopes.h"
+#include "edbee/models/textgrammar.h"
+#include "edbee/models/textlexer.h"
+#include "edbee/util/lineending.h"
+#include "edbee/util/textcodec.h"
+#include "edbee/edbee.h"
+#include "edbee/testsupport.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// A stored document is restored with the same text, encoding and line ending
+void TextDocumentCacheTest::testLoadAndStore()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("text.txt");
+    testTrue( TestSupport::writeFile( fileName, "first\r\ncaf\xc3\xa9\r\n\r\nlast" ) );
+
+    TextDocumentCache cache( dir.filePath("cache") );
+    CharTextDocument doc;
+    testTrue( cache.load( &doc, fileName ) );
+    testFalse( cache.isRestored() );
+    testTrue( cache.store( &doc, fileName ) );
+    testTrue( QFile::exists( cache.entryFileName( fileName ) ) );
+
+    CharTextDocument restored;
+    testTrue( cache.load( &restored, fileName ) );
+    testTrue( cache.isRestored() );
+    testEqual( restored.text(), doc.text() );
+    testEqual( restored.lineCount(), 4 );
+    for( int line=0; line < restored.lineCount(); ++line ) {
+        testEqual( restored.offsetFromLine( line ), doc.offsetFromLine( line ) );
+    }
+    testEqual( restored.encoding()->name(), QStringLiteral("UTF-8") );
+    testEqual( static_cast<int>( restored.lineEnding()->type() ), static_cast<int>( LineEnding::WindowsType ) );
+
+    // a document with text isn't restored
+    testTrue( cache.load( &restored, fileName ) );
+    testFalse( cache.isRestored() );
+
+    testTrue( cache.remove( fileName ) );
+    testFalse( QFile::exists( cache.entryFileName( fileName ) ) );
+}
+
+
+/// The entry of a changed file isn't used
+void TextDocumentCacheTest::testChangedFile()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("changed.txt");
+    testTrue( TestSupport::writeFile( fileName, "abc\ndef" ) );
+
+    TextDocumentCache cache( dir.filePath("cache") );
+    CharTextDocument doc;
+    testTrue( cache.load( &doc, fileName ) );
+    testTrue( cache.store( &doc, fileName ) );
+
+    // the same size, another content
+    testTrue( TestSupport::writeFile( fileName, "abcd\nef" ) );
+    CharTextDocument changed;
+    testTrue( cache.load( &changed, fileName ) );
+    testFalse( cache.isRestored() );
+    testEqual( changed.text(), QStringLiteral("abcd\nef") );
+    testEqual( changed.offsetFromLine( 1 ), 5 );
+
+    // another file with the same content
+    QString otherFileName = dir.filePath("other.txt");
+    testTrue( TestSupport::writeFile( otherFileName, "abcd\nef" ) );
+    CharTextDocument other;
+    testTrue( cache.load( &other, otherFileName ) );
+    testFalse( cache.isRestored() );
+}
+
+
+/// A changed file with the same size, modification time and sampled content hash has other newlines.
+/// The cached line offsets don't match these newlines and aren't used
+void TextDocumentCacheTest::testChangedUnsampledContent()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("sampled.txt");
+    QByteArray data = QByteArray( 99, 'x' ).append('\n').repeated( 2500 );     // larger than the hashed samples, smaller than the parallel load threshold
+    testTrue( TestSupport::writeFile( fileName, data ) );
+
+    TextDocumentCache cache( dir.filePath("cache") );
+    CharTextDocument doc;
+    testTrue( cache.load( &doc, fileName ) );
+    testTrue( cache.store( &doc, fileName ) );
+
+    // move the newline of line 800, which isn't in the hashed samples
+    QDateTime lastModified = QFileInfo( fileName ).lastModified();
+    data[80099] = 'x';
+    data[80050] = '\n';
+    testTrue( TestSupport::writeFile( fileName, data ) );
+    QFile file( fileName );
+    file.open( QIODevice::ReadWrite );
+    file.setFileTime( lastModified, QFileDevice::FileModificationTime );
+    file.close();
+
+    CharTextDocument changed;
+    testTrue( cache.load( &changed, fileName ) );
+    testFalse( cache.isRestored() );
+    testEqual( changed.lineCount(), 2501 );
+    testEqual( changed.offsetFromLine( 801 ), 80051 );
+    testEqual( changed.offsetFromLine( 802 ), 80200 );
+}
+
+
+/// An invalid entry is ignored
+void TextDocumentCacheTest::testInvalidEntry()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("invalid.txt");
+    testTrue( TestSupport::writeFile( fileName, "line\nline\n" ) );
+
+    TextDocumentCache cache( dir.filePath("cache") );
+    CharTextDocument doc;
+    testTrue( cache.load( &doc, fileName ) );
+    testTrue( cache.store( &doc, fileName ) );
+
+    testTrue( TestSupport::writeFile( cache.entryFileName( fileName ), "EDBC this isn't a cache entry" ) );
+    CharTextDocument invalid;
+    testTrue( cache.load( &invalid, fileName ) );
+    testFalse( cache.isRestored() );
+    testEqual( invalid.text(), QStringLiteral("line\nline\n") );
+
+    // a missing file can't be loaded or stored
+    CharTextDocument missing;
+    testFalse( cache.load( &missing, dir.filePath("missing.txt") ) );
+    testFalse( cache.store( &missing, dir.filePath("missing.txt") ) );
+}
+
+
+/// The scopes are restored without lexing, the lexer continues with the restored multi-line ranges
+void TextDocumentCacheTest::testScopes()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("scopes.txt");
+    testTrue( TestSupport::writeFile( fileName, "if a\n/* comment\nstill */ if \"str\nstr\" b\n'open\n" ) );
+
+    TextGrammar* grammar = TestSupport::grammar( QStringLiteral("cachetest") );
+    TextDocumentCache cache( dir.filePath("cache") );
+    CharTextDocument doc;
+    testTrue( cache.load( &doc, fileName ) );
+    doc.setLanguageGrammar( grammar );
+    doc.textLexer()->lexRange( 0, doc.length() );
+    testTrue( cache.store( &doc, fileName ) );
+
+    CharTextDocument restored;
+    testTrue( cache.load( &restored, fileName ) );
+    testTrue( cache.isRestored() );
+    testTrue( restored.languageGrammar() == grammar );
+    testEqual( restored.scopes()->lastScopedOffset(), doc.scopes()->lastScopedOffset() );
+    testEqual( restored.scopes()->scopesAsStringList().join("|"), doc.scopes()->scopesAsStringList().join("|") );
+
+    // the open string continues on the appended line
+    doc.append( QStringLiteral("still' if\n") );
+    restored.append( QStringLiteral("still' if\n") );
+    doc.textLexer()->lexRange( 0, doc.length() );
+    restored.textLexer()->lexRange( 0, restored.length() );
+    testEqual( restored.scopes()->scopesAsStringList().join("|"), doc.scopes()->scopesAsStringList().join("|") );
+}
+
+
+} // edbee
@@ -0,0 +1,26 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class TextDocumentCacheTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testLoadAndStore();
+    void testChangedFile();
+    void testChangedUnsampledContent();
+    void testInvalidEntry();
+    void testScopes();
+
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::TextDocumentCacheTest);
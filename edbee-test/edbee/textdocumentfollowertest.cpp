@@ -0,0 +1,195 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textdocumentfollowertest.h"
+
+#include <QTemporaryDir>
+
+#include "edbee/io/textdocumentfollower.h"
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textundostack.h"
+#include "edbee/testsupport.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Only the appended bytes are appended to the document, without undo data
+void TextDocumentFollowerTest::testFollow()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("follow.log");
+    testTrue( TestSupport::writeFile( fileName, "existing\n" ) );
+
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("loaded\n") );
+    int undoSize = doc.textUndoStack()->size();
+
+    TextDocumentFollower follower( &doc );
+    testTrue( follower.follow( fileName ) );
+    testTrue( follower.isFollowing() );
+    testEqual( follower.position(), 9 );
+    testEqual( doc.text(), QStringLiteral("loaded\n") );
+
+    testTrue( TestSupport::writeFile( fileName, "a\r\nb\n", true ) );
+    follower.readAppendedData();
+    testEqual( doc.text(), QStringLiteral("loaded\na\nb\n") );
+    testEqual( doc.lineCount(), 4 );
+    testEqual( follower.position(), 14 );
+    testEqual( doc.textUndoStack()->size(), undoSize );
+
+    // nothing happens without new data, or after stopping
+    follower.readAppendedData();
+    testEqual( doc.text(), QStringLiteral("loaded\na\nb\n") );
+    follower.stop();
+    testFalse( follower.isFollowing() );
+    testTrue( TestSupport::writeFile( fileName, "c\n", true ) );
+    follower.readAppendedData();
+    testEqual( doc.text(), QStringLiteral("loaded\na\nb\n") );
+}
+
+
+/// A multi-byte sequence or a \r\n line ending can be split over two writes
+void TextDocumentFollowerTest::testSplitSequences()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("split.log");
+    testTrue( TestSupport::writeFile( fileName, "" ) );
+
+    CharTextDocument doc;
+    TextDocumentFollower follower( &doc );
+    testTrue( follower.follow( fileName, 0 ) );
+
+    testTrue( TestSupport::writeFile( fileName, "caf\xc3", true ) );
+    follower.readAppendedData();
+    testEqual( doc.text(), QStringLiteral("caf") );
+
+    testTrue( TestSupport::writeFile( fileName, "\xa9\r", true ) );
+    follower.readAppendedData();
+    testEqual( doc.text(), QString::fromUtf8("caf\xc3\xa9") );
+
+    testTrue( TestSupport::writeFile( fileName, "\nnext\r", true ) );
+    follower.readAppendedData();
+    testEqual( doc.text(), QString::fromUtf8("caf\xc3\xa9\nnext") );
+
+    testTrue( TestSupport::writeFile( fileName, "line", true ) );
+    follower.readAppendedData();
+    testEqual( doc.text(), QString::fromUtf8("caf\xc3\xa9\nnext\rline") );
+}
+
+
+/// A \r at the end of the file is appended when the follower stops or the file is reset
+void TextDocumentFollowerTest::testPendingCarriageReturn()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("pending.log");
+    testTrue( TestSupport::writeFile( fileName, "a\r" ) );
+
+    CharTextDocument doc;
+    {
+        TextDocumentFollower follower( &doc );
+        testTrue( follower.follow( fileName, 0 ) );
+        testEqual( doc.text(), QStringLiteral("a") );
+        follower.stop();
+        testEqual( doc.text(), QStringLiteral("a\r") );
+
+        // the truncated file doesn't continue the \r\n of the old file
+        testTrue( follower.follow( fileName, 1 ) );
+        testEqual( doc.text(), QStringLiteral("a\r") );
+        testTrue( TestSupport::writeFile( fileName, "\n" ) );
+        follower.readAppendedData();
+        testEqual( doc.text(), QStringLiteral("a\r\r\n") );
+
+        testTrue( TestSupport::writeFile( fileName, "b\r", true ) );
+        follower.readAppendedData();
+        testEqual( doc.text(), QStringLiteral("a\r\r\nb") );
+    }
+    // the destructor stops the follower
+    testEqual( doc.text(), QStringLiteral("a\r\r\nb\r") );
+    testEqual( doc.textUndoStack()->size(), 0 );
+}
+
+
+/// The follower doesn't use a deleted document
+void TextDocumentFollowerTest::testDeletedDocument()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("deleted.log");
+    testTrue( TestSupport::writeFile( fileName, "a\r" ) );
+
+    CharTextDocument* doc = new CharTextDocument();
+    TextDocumentFollower follower( doc );
+    testTrue( follower.follow( fileName, 0 ) );
+    delete doc;
+    testTrue( follower.document() == nullptr );
+
+    testTrue( TestSupport::writeFile( fileName, "\nb\n", true ) );
+    follower.readAppendedData();
+    follower.stop();
+    testFalse( follower.isFollowing() );
+}
+
+
+/// With a maximum line count the first lines are removed
+void TextDocumentFollowerTest::testMaxLineCount()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("max.log");
+    QByteArray data;
+    for( int i=0; i < 100; ++i ) { data.append( QByteArray::number(i) ).append('\n'); }
+    testTrue( TestSupport::writeFile( fileName, data ) );
+
+    CharTextDocument doc;
+    TextDocumentFollower follower( &doc );
+    follower.setMaxLineCount( 32 );
+    testTrue( follower.follow( fileName, 0 ) );
+    testEqual( doc.lineCount(), 30 );   // 2 extra lines are removed (1/16 of the maximum)
+    testEqual( doc.lineWithoutNewline(0), QStringLiteral("71") );
+    testEqual( doc.lineWithoutNewline(28), QStringLiteral("99") );
+
+    testTrue( TestSupport::writeFile( fileName, "100\n101\n", true ) );
+    follower.readAppendedData();
+    testEqual( doc.lineCount(), 32 );
+    testEqual( doc.lineWithoutNewline(0), QStringLiteral("71") );
+
+    testTrue( TestSupport::writeFile( fileName, "102\n", true ) );
+    follower.readAppendedData();
+    testEqual( doc.lineCount(), 30 );
+    testEqual( doc.lineWithoutNewline(0), QStringLiteral("74") );
+    testEqual( doc.textUndoStack()->size(), 0 );
+}
+
+
+/// A truncated file is followed from the start
+void TextDocumentFollowerTest::testTruncatedFile()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("truncated.log");
+    testTrue( TestSupport::writeFile( fileName, "first file\n" ) );
+
+    CharTextDocument doc;
+    TextDocumentFollower follower( &doc );
+    testTrue( follower.follow( fileName, 0 ) );
+    testEqual( doc.text(), QStringLiteral("first file\n") );
+
+    testTrue( TestSupport::writeFile( fileName, "new\n" ) );
+    follower.readAppendedData();
+    testEqual( doc.text(), QStringLiteral("first file\nnew\n") );
+    testEqual( follower.position(), 4 );
+}
+
+
+/// Following a file that doesn't exist fails
+void TextDocumentFollowerTest::testMissingFile()
+{
+    QTemporaryDir dir;
+    CharTextDocument doc;
+    TextDocumentFollower follower( &doc );
+    testFalse( follower.follow( dir.filePath("missing.log") ) );
+    testFalse( follower.isFollowing() );
+    testFalse( follower.errorString().isEmpty() );
+}
+
+
+} // edbee
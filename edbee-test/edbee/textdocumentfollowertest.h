@@ -0,0 +1,28 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class TextDocumentFollowerTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testFollow();
+    void testSplitSequences();
+    void testPendingCarriageReturn();
+    void testDeletedDocument();
+    void testMaxLineCount();
+    void testTruncatedFile();
+    void testMissingFile();
+
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::TextDocumentFollowerTest);
@@ -0,0 +1,191 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textdocumentserializerbenchmark.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QIODevice>
+
+#include <limits>
+
+#include "edbee/edbee.h"
+#include "edbee/io/textdocumentserializer.h"
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/util/lineending.h"
+#include "edbee/util/textcodec.h"
+#include "allocationcounter.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// Loading an UTF-8 file with some multi-byte characters and windows line endings
+void TextDocumentSerializerBenchmark::benchmarkLoadUtf8()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runLoad( "load UTF-8", benchmarkData( "The quick brown fox jumps over the lazy dog, caf\xc3\xa9 \xe2\x82\xac 12.50\r\n" ) );
+}
+
+
+/// Loading a Latin-1 file (the invalid UTF-8 byte makes the detector choose Latin-1)
+void TextDocumentSerializerBenchmark::benchmarkLoadLatin1()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runLoad( "load Latin-1", benchmarkData( "The quick brown fox jumps over the lazy dog, caf\xe9 12.50\n" ) );
+}
+
+
+/// Measures loading the given data with the serial and the parallel decoder and checks that both results are the same
+void TextDocumentSerializerBenchmark::runLoad(const QString& name, const QByteArray& data)
+{
+    int expected = -1;
+    for( int parallel = 0; parallel <= 1; ++parallel ) {
+        QElapsedTimer timer;
+        timer.start();
+        int result = measureLoad( data, parallel != 0 );
+        qint64 nsecs = timer.nsecsElapsed();
+
+        reportThroughput( QStringLiteral("%1 %2").arg( name ).arg( parallel ? "parallel" : "serial" ), nsecs, data.size() );
+        if( expected < 0 ) { expected = result; }
+        testEqual( result, expected );
+    }
+}
+
+
+/// Loads the given data in a new document
+/// @return the number of lines of the document (to compare the results)
+int TextDocumentSerializerBenchmark::measureLoad(const QByteArray& data, bool parallel)
+{
+    QBuffer buffer;
+    buffer.setData( data );     // shared, the data isn't copied
+    CharTextDocument doc;
+    TextDocumentSerializer serializer( &doc );
+    serializer.setParallelLoadThreshold( parallel ? 0 : std::numeric_limits<qint64>::max() );
+    testTrue( serializer.load( &buffer ) );
+    return doc.lineCount();
+}
+
+
+/// The number of bytes (UTF-16) of the document that's saved by the benchmark
+static const qint64 SaveDocumentSize = Q_INT64_C(500) * 1024 * 1024;
+
+
+/// A device that only counts the written bytes, so saving isn't limited by the disk (or memory)
+class DiscardingDevice : public QIODevice
+{
+public:
+    DiscardingDevice() : writtenBytes_(0) {}
+
+    qint64 writtenBytes() const { return writtenBytes_; }
+
+protected:
+    virtual qint64 readData( char* data, qint64 maxSize )
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(maxSize);
+        return -1;
+    }
+
+    virtual qint64 writeData( const char* data, qint64 size )
+    {
+        Q_UNUSED(data);
+        writtenBytes_ += size;
+        return size;
+    }
+
+private:
+    qint64 writtenBytes_;        ///< The number of written bytes
+};
+
+
+/// A filter that selects all lines (this forces the line by line save path)
+class SelectAllLinesBenchmarkFilter : public TextDocumentSerializerFilter
+{
+public:
+    virtual bool saveLineSelector( TextDocumentSerializer* serializer, int lineIdx, QString& line )
+    {
+        Q_UNUSED(serializer);
+        Q_UNUSED(lineIdx);
+        Q_UNUSED(line);
+        return true;
+    }
+};
+
+
+/// Fills the document by repeating the given line until the document has the given size (in bytes)
+static void fillDocument( TextDocument* doc, const QString& line, qint64 size )
+{
+    doc->rawAppendBegin();
+    for( qint64 bytes = 0; bytes < size; bytes += line.length() * sizeof(QChar) ) {
+        doc->rawAppend( line.constData(), line.length() );
+    }
+    doc->rawAppendEnd();
+}
+
+
+/// Saving doesn't copy the document, the extra memory is about the size of the save buffer
+void TextDocumentSerializerBenchmark::testSaveMemory()
+{
+    if( !AllocationCounter::isAvailable() ) { return; }
+
+    CharTextDocument doc;
+    fillDocument( &doc, QString::fromUtf8( "The quick brown fox jumps over the lazy dog, caf\xc3\xa9 \xe2\x82\xac 12.50\n" ), 16 * 1024 * 1024 );
+    for( int useFilter=0; useFilter <= 1; ++useFilter ) {
+        AllocationCounter counter;
+        qint64 written = measureSave( QString(), &doc, "UTF-8", LineEnding::WindowsType, useFilter != 0 );
+        testTrue( written > doc.length() );
+        testTrue( counter.peakBytes() < 4 * 1024 * 1024 );
+    }
+}
+
+
+/// Saves a document of 500 MB with the different save paths
+void TextDocumentSerializerBenchmark::benchmarkSave()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    CharTextDocument doc;
+    fillDocument( &doc, QString::fromUtf8( "The quick brown fox jumps over the lazy dog, caf\xc3\xa9 \xe2\x82\xac 12.50\n" ), SaveDocumentSize );
+    measureSave( "save UTF-8", &doc, "UTF-8", LineEnding::UnixType, false );
+    measureSave( "save UTF-8 CRLF", &doc, "UTF-8", LineEnding::WindowsType, false );
+    measureSave( "save UTF-8 CRLF with filter", &doc, "UTF-8", LineEnding::WindowsType, true );
+    measureSave( "save Latin-1 CRLF", &doc, "ISO-8859-1", LineEnding::WindowsType, false );
+    measureSave( "save UTF-16LE CRLF (QTextCodec)", &doc, "UTF-16LE", LineEnding::WindowsType, false );
+}
+
+
+/// Saves the document to a discarding device and reports the throughput and the peak extra memory
+/// @param name the name of the benchmark (empty to skip reporting)
+/// @param doc the document to save
+/// @param codecName the encoding to save with
+/// @param lineEndingType the line ending to save with
+/// @param useFilter save with a filter (line by line)
+/// @return the number of written bytes
+qint64 TextDocumentSerializerBenchmark::measureSave(const QString& name, TextDocument* doc, const QString& codecName, int lineEndingType, bool useFilter)
+{
+    DiscardingDevice device;
+    device.open( QIODevice::WriteOnly | QIODevice::Unbuffered );
+    TextDocumentSerializer serializer( doc );
+    SelectAllLinesBenchmarkFilter filter;
+    if( useFilter ) { serializer.setFilter( &filter ); }
+    doc->setEncoding( Edbee::instance()->codecManager()->codecForName( codecName ) );
+    doc->setLineEnding( LineEnding::get( lineEndingType ) );
+
+    QElapsedTimer timer;
+    timer.start();
+    testTrue( serializer.saveWithoutOpening( &device ) );
+    qint64 nsecs = timer.nsecsElapsed();
+    if( name.isEmpty() ) { return device.writtenBytes(); }
+
+    reportThroughput( name, nsecs, doc->length() * sizeof(QChar) );
+    if( AllocationCounter::isAvailable() ) {
+        AllocationCounter counter;
+        testTrue( serializer.saveWithoutOpening( &device ) );
+        reportBenchmark( QStringLiteral("%1 peak extra memory %2 KB").arg( name ).arg( counter.peakBytes() / 1024 ), nsecs );
+    }
+    return device.writtenBytes();
+}
+
+
+} // edbee
@@ -0,0 +1,35 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/benchmarkcase.h"
+
+namespace edbee {
+
+class TextDocument;
+
+/// Measures the load throughput of the TextDocumentSerializer with the serial and the parallel decoder
+/// and the save throughput (and extra memory) of the different save paths
+class TextDocumentSerializerBenchmark : public BenchmarkCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void benchmarkLoadUtf8();
+    void benchmarkLoadLatin1();
+
+    void testSaveMemory();
+    void benchmarkSave();
+
+private:
+    void runLoad( const QString& name, const QByteArray& data );
+    int measureLoad( const QByteArray& data, bool parallel );
+    qint64 measureSave( const QString& name, TextDocument* doc, const QString& codecName, int lineEndingType, bool useFilter );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::TextDocumentSerializerBenchmark);
@@ -0,0 +1,97 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textdocumentserializerjobtest.h"
+
+#include <QTemporaryDir>
+
+#include "edbee/io/textdocumentserializerjob.h"
+#include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/textundostack.h"
+#include "edbee/util/lineending.h"
+#include "edbee/testsupport.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// The loaded text replaces the text of the document at once
+void TextDocumentSerializerJobTest::testLoad()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("load.txt");
+    testTrue( TestSupport::writeFile( fileName, "a\r\nb\r\nc" ) );
+
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("old text") );
+    TextDocumentSerializerJob* job = TextDocumentSerializerJob::load( &doc, fileName );
+    testTrue( job->waitForFinished() );
+    testTrue( job->isFinished() );
+    testFalse( job->isRunning() );
+    testEqual( doc.text(), QStringLiteral("a\nb\nc") );
+    testEqual( doc.lineCount(), 3 );
+    testEqual( static_cast<int>( doc.lineEnding()->type() ), static_cast<int>( LineEnding::WindowsType ) );
+    testTrue( doc.textUndoStack()->isPersisted() );
+    delete job;
+}
+
+
+/// Saving writes the snapshot of the moment the job is started
+void TextDocumentSerializerJobTest::testSave()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("save.txt");
+    testTrue( TestSupport::writeFile( fileName, "existing" ) );
+
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("a\nb") );
+    TextDocumentSerializerJob* job = TextDocumentSerializerJob::save( &doc, fileName );
+    doc.setText( QStringLiteral("changed while saving") );
+    testTrue( job->waitForFinished() );
+    testEqual( QString::fromLatin1( TestSupport::readFile( fileName ) ), QStringLiteral("a\nb") );
+    testFalse( doc.textUndoStack()->isPersisted() );    // the document is changed after the snapshot
+    delete job;
+}
+
+
+/// A cancelled job doesn't change the document or the file
+void TextDocumentSerializerJobTest::testCancel()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("cancel.txt");
+    testTrue( TestSupport::writeFile( fileName, "file text" ) );
+
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("document text") );
+    TextDocumentSerializerJob loadJob( TextDocumentSerializerJob::LoadOperation, &doc, fileName );
+    loadJob.cancel();
+    loadJob.start();
+    testFalse( loadJob.waitForFinished() );
+    testTrue( loadJob.isCancelled() );
+    testEqual( loadJob.errorString(), QStringLiteral("Cancelled") );
+    testEqual( doc.text(), QStringLiteral("document text") );
+
+    TextDocumentSerializerJob saveJob( TextDocumentSerializerJob::SaveOperation, &doc, fileName );
+    saveJob.cancel();
+    saveJob.start();
+    testFalse( saveJob.waitForFinished() );
+    testEqual( TestSupport::readFile( fileName ), QByteArray("file text") );
+}
+
+
+/// A file that can't be opened results in an error
+void TextDocumentSerializerJobTest::testMissingFile()
+{
+    QTemporaryDir dir;
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("document text") );
+    TextDocumentSerializerJob job( TextDocumentSerializerJob::LoadOperation, &doc, dir.filePath("missing.txt") );
+    job.start();
+    testFalse( job.waitForFinished() );
+    testFalse( job.errorString().isEmpty() );
+    testEqual( doc.text(), QStringLiteral("document text") );
+}
+
+
+} // edbee
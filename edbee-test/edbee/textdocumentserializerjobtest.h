@@ -0,0 +1,25 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class TextDocumentSerializerJobTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testLoad();
+    void testSave();
+    void testCancel();
+    void testMissingFile();
+
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::TextDocumentSerializerJobTest);
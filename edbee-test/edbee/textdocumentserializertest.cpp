@@ -4,10 +4,21 @@
 #include "textdocumentserializertest.h"
 
 #include <QBuffer>
+#include <QStringList>
+#include <QTextCodec>
 
+#include <limits>
+
+#include "edbee/edbee.h"
+#include "edbee/models/chardocument/chartextbuffer.h"
 #include "edbee/models/chardocument/chartextdocument.h"
+#include "edbee/models/ropedocument/ropetextdocument.h"
 #include "edbee/models/textdocument.h"
+#include "edbee/models/textlinedata.h"
+#include "edbee/models/textsnapshot.h"
 #include "edbee/io/textdocumentserializer.h"
+#include "edbee/util/lineending.h"
+#include "edbee/util/textcodec.h"
 
 #include "edbee/debug.h"
 
@@ -40,4 +51,327 @@ void TextDocumentSerializerTest::testLoad()
 }
 
 
+/// Loads the given data with the parallel decoder and the serial decoder and compares the result
+/// @param doc the document to load the data in
+/// @param data the data to load
+/// @return the text of the document loaded with the parallel decoder
+QString TextDocumentSerializerTest::loadBothWays(TextDocument* doc, const QByteArray& data)
+{
+    QByteArray bytes( data );
+    QBuffer buffer( &bytes );
+
+    TextDocumentSerializer serial( doc );
+    serial.setParallelLoadThreshold( std::numeric_limits<qint64>::max() );
+    doc->setText( QString() );
+    testTrue( serial.load( &buffer ) );
+    QString expected = doc->text();
+    int expectedLineCount = doc->lineCount();
+    QString expectedEncoding = doc->encoding()->name();
+    LineEnding::Type expectedLineEnding = doc->lineEnding()->type();
+    LineEndingStatistics expectedStatistics = doc->lineEndingStatistics();
+
+    TextDocumentSerializer parallel( doc );
+    parallel.setParallelLoadThreshold( 0 );
+    doc->setText( QString() );
+    testTrue( parallel.load( &buffer ) );
+    testEqual( doc->text(), expected );
+    testEqual( doc->lineCount(), expectedLineCount );
+    testEqual( doc->encoding()->name(), expectedEncoding );
+    testEqual( static_cast<int>( doc->lineEnding()->type() ), static_cast<int>( expectedLineEnding ) );
+    for( int type=0; type < LineEnding::typeCount(); ++type ) {
+        testEqual( doc->lineEndingStatistics().count( static_cast<LineEnding::Type>( type ) ), expectedStatistics.count( static_cast<LineEnding::Type>( type ) ) );
+    }
+    return doc->text();
+}
+
+
+/// Large files are loaded with the parallel decoder, the result should be exactly the same as the serial loader
+void TextDocumentSerializerTest::testLoadParallel()
+{
+    CharTextDocument doc;
+    testEqual( loadBothWays( &doc, "Test,\r\nWerkt het?\r\nRick!!" ), QStringLiteral("Test,\nWerkt het?\nRick!!") );
+    testEqual( loadBothWays( &doc, "caf\xc3\xa9\nline 2\n" ), QString::fromUtf8("caf\xc3\xa9\nline 2\n") );
+    testEqual( loadBothWays( &doc, "\xef\xbb\xbf" "bom\n" ), QStringLiteral("bom\n") );
+    testEqual( loadBothWays( &doc, "mac\rline\rend" ), QStringLiteral("mac\rline\rend") );
+    testEqual( loadBothWays( &doc, "mac\rline\rend\r" ), QStringLiteral("mac\rline\rend\r") );
+
+    // a large file with multiple blocks
+    QByteArray data;
+    for( int i=0; i < 20000; ++i ) { data.append( "Line with an \xe2\x82\xac sign\r\n" ); }
+    QString text = loadBothWays( &doc, data );
+    testEqual( doc.lineCount(), 20001 );
+    testEqual( doc.lineWithoutNewline(19999), QString::fromUtf8("Line with an \xe2\x82\xac sign") );
+    testEqual( text.length(), 20000 * 20 );
+}
+
+
+/// Line endings and UTF-8 sequences can be split over the blocks of the serial loader
+void TextDocumentSerializerTest::testLoadBlockBoundaries()
+{
+    CharTextDocument doc;
+    CharTextDocument compactDoc;
+    static_cast<CharTextBuffer*>( compactDoc.buffer() )->setCompactStorageEnabled( true );
+
+    // the serial loader reads blocks of 8191 bytes
+    for( int offset = 8188; offset <= 8191; ++offset ) {
+        QByteArray data( offset, 'a' );
+        data.append( "\r\n\xe2\x82\xac\r\n" );
+        data.append( QByteArray( 8191 - 3, 'b' ) );
+        data.append( "\xe2\x82\xac\r" );
+        QString expected = QString::fromUtf8( data ).replace( QStringLiteral("\r\n"), QStringLiteral("\n") );
+        testEqual( loadBothWays( &doc, data ), expected );
+        testEqual( loadBothWays( &compactDoc, data ), expected );
+        testEqual( doc.lineCount(), 3 );
+    }
+}
+
+
+/// Documents that can't be written directly fall back to a normal append
+void TextDocumentSerializerTest::testLoadParallelFallbacks()
+{
+    QByteArray data;
+    for( int i=0; i < 1000; ++i ) { data.append( "line \xc3\xa9\n" ); }
+
+    CharTextDocument compactDoc;
+    static_cast<CharTextBuffer*>( compactDoc.buffer() )->setCompactStorageEnabled( true );
+    loadBothWays( &compactDoc, data );
+    testEqual( compactDoc.lineCount(), 1001 );
+
+    RopeTextDocument ropeDoc;
+    loadBothWays( &ropeDoc, data );
+    testEqual( ropeDoc.lineCount(), 1001 );
+}
+
+
+/// A non-ASCII character after the first block is used to detect the encoding
+void TextDocumentSerializerTest::testDetectWholeFile()
+{
+    QByteArray data( "ascii line\n" );
+    data = data.repeated( 5000 );
+    data.append( "caf\xe9\n" );
+
+    CharTextDocument doc;
+    testEqual( loadBothWays( &doc, data ).right(5), QString::fromLatin1("caf\xe9\n") );
+    testEqual( doc.encoding()->name(), QStringLiteral("ISO-8859-1") );
+
+    // only detect with the first block
+    QBuffer buffer( &data );
+    TextDocumentSerializer serializer( &doc );
+    serializer.setValidateWholeFile( false );
+    testTrue( serializer.load( &buffer ) );
+    testEqual( doc.encoding()->name(), QStringLiteral("UTF-8") );
+}
+
+
+/// Loading in a detached buffer doesn't change the document
+void TextDocumentSerializerTest::testLoadBuffer()
+{
+    CharTextDocument doc;
+    TextDocumentSerializer serializer( &doc );
+    QByteArray data("a\r\nb\r\nc");
+    QBuffer buffer(&data);
+    buffer.open( QIODevice::ReadOnly );
+
+    CharTextBuffer textBuffer;
+    testTrue( serializer.loadBufferWithoutOpening( &buffer, &textBuffer ) );
+    testEqual( textBuffer.text(), QStringLiteral("a\nb\nc") );
+    testEqual( static_cast<int>( serializer.detectedLineEnding()->type() ), static_cast<int>( LineEnding::WindowsType ) );
+    testTrue( serializer.detectedEncoding() != 0 );
+    testEqual( doc.text(), QStringLiteral("") );
+}
+
+
+/// The line endings of the complete file are counted, the most common line ending is detected
+void TextDocumentSerializerTest::testLineEndingStatistics()
+{
+    // the first block (8191 bytes) only contains unix line endings
+    QByteArray data = QByteArray( "unix line\n" ).repeated( 1000 );
+    data.append( QByteArray( "windows line\r\n" ).repeated( 2000 ) );
+
+    CharTextDocument doc;
+    loadBothWays( &doc, data );
+    testEqual( static_cast<int>( doc.lineEnding()->type() ), static_cast<int>( LineEnding::WindowsType ) );
+    testEqual( doc.lineEndingStatistics().count( LineEnding::UnixType ), 1000 );
+    testEqual( doc.lineEndingStatistics().count( LineEnding::WindowsType ), 2000 );
+    testEqual( doc.lineEndingStatistics().count( LineEnding::MacClassicType ), 0 );
+    testTrue( doc.lineEndingStatistics().isMixed() );
+    testEqual( doc.lineCount(), 3001 );
+
+    // UTF-16 is decoded with the QTextCodec, the line endings are counted and normalized the same way
+    QString text = QStringLiteral("line\r\nnext\nmac\r").repeated( 1000 );
+    QString expected = QString( text ).replace( QStringLiteral("\r\n"), QStringLiteral("\n") );
+    testEqual( loadBothWays( &doc, QTextCodec::codecForName("UTF-16")->fromUnicode( text ) ), expected );
+    testEqual( doc.lineEndingStatistics().count( LineEnding::UnixType ), 1000 );
+    testEqual( doc.lineEndingStatistics().count( LineEnding::WindowsType ), 1000 );
+    testEqual( doc.lineEndingStatistics().count( LineEnding::MacClassicType ), 1000 );
+}
+
+
+/// Mixed line endings are restored when saving with preserved line endings
+void TextDocumentSerializerTest::testPreserveLineEndings()
+{
+    QByteArray data( "a\r\nb\nc\r\nd\r\ne" );
+    QBuffer buffer( &data );
+    CharTextDocument doc;
+    TextDocumentSerializer serializer( &doc );
+    serializer.setPreserveLineEndings( true );
+    testTrue( serializer.load( &buffer ) );
+    testEqual( doc.text(), QStringLiteral("a\nb\nc\nd\ne") );
+    testEqual( static_cast<int>( doc.lineEnding()->type() ), static_cast<int>( LineEnding::WindowsType ) );
+    testTrue( doc.getLineData( 0, LineEndingField ) == 0 );
+    testTrue( doc.getLineData( 1, LineEndingField ) != 0 );
+
+    // new lines get the line ending of the document
+    doc.append( QStringLiteral("\nf") );
+    QByteArray saved;
+    QBuffer savedBuffer( &saved );
+    savedBuffer.open( QIODevice::WriteOnly );
+    testTrue( serializer.saveWithoutOpening( &savedBuffer ) );
+    testEqual( QString::fromLatin1( saved ), QStringLiteral("a\r\nb\nc\r\nd\r\ne\r\nf") );
+
+    // without preserving the line endings, every line gets the line ending of the document
+    QByteArray converted;
+    QBuffer convertedBuffer( &converted );
+    convertedBuffer.open( QIODevice::WriteOnly );
+    TextDocumentSerializer converter( &doc );
+    testTrue( converter.saveWithoutOpening( &convertedBuffer ) );
+    testEqual( QString::fromLatin1( converted ), QStringLiteral("a\r\nb\r\nc\r\nd\r\ne\r\nf") );
+}
+
+
+/// A snapshot is saved with the given encoding and line ending, changes after taking the snapshot aren't saved
+void TextDocumentSerializerTest::testSaveSnapshot()
+{
+    CharTextDocument doc;
+    doc.setText( QStringLiteral("a\nb\nc") );
+    TextSnapshot snapshot = doc.snapshot();
+    doc.setText( QStringLiteral("changed") );
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open( QIODevice::WriteOnly );
+    TextDocumentSerializer serializer( &doc );
+    testTrue( serializer.saveSnapshotWithoutOpening( &buffer, snapshot, doc.encoding(), LineEnding::windowsType() ) );
+    testEqual( QString::fromLatin1( data ), QStringLiteral("a\r\nb\r\nc") );
+}
+
+
+/// A filter that selects all lines
+class SelectAllLinesFilter : public TextDocumentSerializerFilter
+{
+public:
+    virtual bool saveLineSelector( TextDocumentSerializer* serializer, int lineIdx, QString& line )
+    {
+        Q_UNUSED(serializer);
+        Q_UNUSED(lineIdx);
+        Q_UNUSED(line);
+        return true;
+    }
+};
+
+
+/// Saving encodes the text and replaces the newlines with the line ending, with and without a filter.
+/// The result is the same as encoding the complete text with the QTextEncoder.
+/// The small save buffer makes sure the text is written in multiple parts
+void TextDocumentSerializerTest::testSaveEncodings()
+{
+    QString text = QString::fromUtf8( "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\nsecond line\n\nlast line" ).repeated( 50 );
+    CharTextDocument doc;
+    doc.setText( text );
+    SelectAllLinesFilter filter;
+
+    QStringList codecNames;
+    codecNames << "UTF-8" << "UTF-8 with BOM" << "ISO-8859-1" << "UTF-16LE";
+    foreach( QString codecName, codecNames ) {
+        TextCodec* codec = Edbee::instance()->codecManager()->codecForName( codecName );
+        for( int type=0; type < LineEnding::typeCount(); ++type ) {
+            const LineEnding* lineEnding = LineEnding::get( type );
+            QTextEncoder* encoder = codec->makeEncoder();
+            QByteArray expected = encoder->fromUnicode( QString( text ).replace( QLatin1Char('\n'), QString::fromLatin1( lineEnding->chars() ) ) );
+            delete encoder;
+
+            for( int useFilter=0; useFilter <= 1; ++useFilter ) {
+                QByteArray data;
+                QBuffer buffer(&data);
+                buffer.open( QIODevice::WriteOnly );
+                TextDocumentSerializer serializer( &doc );
+                serializer.setSaveBufferSize( 64 );
+                if( useFilter ) { serializer.setFilter( &filter ); }
+                testTrue( serializer.saveSnapshotWithoutOpening( &buffer, doc.snapshot(), codec, lineEnding ) );
+                testEqual( QString::fromLatin1( data.toHex() ), QString::fromLatin1( expected.toHex() ) );
+            }
+        }
+    }
+}
+
+
+/// A stopped serializer doesn't load or save anything
+void TextDocumentSerializerTest::testStop()
+{
+    CharTextDocument doc;
+    TextDocumentSerializer serializer( &doc );
+    serializer.requestStop();
+    testTrue( serializer.isStopRequested() );
+
+    QByteArray data("Test,\r\nWerkt het?\r\nRick!!");
+    QBuffer buffer(&data);
+    testFalse( serializer.load( &buffer ) );
+    testEqual( serializer.errorString(), QStringLiteral("Cancelled") );
+    testEqual( doc.text(), QStringLiteral("") );
+
+    doc.setText( QStringLiteral("text") );
+    QByteArray savedData;
+    QBuffer saveBuffer(&savedData);
+    testFalse( serializer.save( &saveBuffer ) );
+    testEqual( savedData.size(), 0 );
+}
+
+
+/// A listener that stores the progress
+class SerializerProgressListener : public TextDocumentSerializerListener
+{
+public:
+    SerializerProgressListener() : count_(0), processed_(0), total_(0) {}
+
+    virtual void serializerProgress( TextDocumentSerializer* serializer, qint64 processed, qint64 total )
+    {
+        Q_UNUSED(serializer);
+        ++count_;
+        processed_ = processed;
+        total_ = total;
+    }
+
+    int count_;                  ///< The number of progress calls
+    qint64 processed_;           ///< The last processed value
+    qint64 total_;               ///< The last total value
+};
+
+
+/// The listener receives the progress of loading
+void TextDocumentSerializerTest::testProgress()
+{
+    QByteArray data( "line\n" );
+    data = data.repeated( 10000 );
+
+    CharTextDocument doc;
+    SerializerProgressListener listener;
+    TextDocumentSerializer serializer( &doc );
+    serializer.setListener( &listener );
+    serializer.setParallelLoadThreshold( std::numeric_limits<qint64>::max() );
+    QBuffer buffer(&data);
+    testTrue( serializer.load( &buffer ) );
+    testTrue( listener.count_ > 1 );
+    testEqual( listener.processed_, data.size() );
+    testEqual( listener.total_, data.size() );
+
+    // the parallel loader reports the progress too
+    SerializerProgressListener parallelListener;
+    serializer.setListener( &parallelListener );
+    serializer.setParallelLoadThreshold( 0 );
+    testTrue( serializer.load( &buffer ) );
+    testTrue( parallelListener.count_ > 0 );
+    testEqual( parallelListener.processed_, data.size() );
+}
+
+
 } // edbee
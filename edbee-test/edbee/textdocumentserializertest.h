@@ -7,6 +7,8 @@
 
 namespace edbee {
 
+class TextDocument;
+
 class TextDocumentSerializerTest : public edbee::test::TestCase
 {
     Q_OBJECT
@@ -14,6 +16,20 @@ class TextDocumentSerializerTest : public edbee::test::TestCase
 private slots:
 
     void testLoad();
+    void testLoadParallel();
+    void testLoadBlockBoundaries();
+    void testLoadParallelFallbacks();
+    void testDetectWholeFile();
+    void testLoadBuffer();
+    void testLineEndingStatistics();
+    void testPreserveLineEndings();
+    void testSaveSnapshot();
+    void testSaveEncodings();
+    void testStop();
+    void testProgress();
+
+private:
+    QString loadBothWays( TextDocument* doc, const QByteArray& data );
 
 };
 
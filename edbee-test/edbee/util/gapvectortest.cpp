@@ -3,6 +3,8 @@
 
 #include "gapvectortest.h"
 
+#include <QByteArray>
+
 #include "edbee/util/gapvector.h"
 
 #include "edbee/debug.h"
@@ -158,6 +160,142 @@ void GapVectorTest::testCopyRange()
 
 }
 
+
+void GapVectorTest::testSpanAt()
+{
+    QCharGapVector v("ABCD",2);
+    v.moveGapTo(2);
+    testContent( v, "AB[__>CD" );
+
+    TextOffset start = -1, length = -1;
+    const QChar* span = v.spanAt( 1, start, length );
+    testEqual( start, 0 );
+    testEqual( length, 2 );
+    testEqual( QString( span, length ), "AB" );
+
+    span = v.spanAt( 2, start, length );
+    testEqual( start, 2 );
+    testEqual( length, 2 );
+    testEqual( QString( span, length ), "CD" );
+
+    span = v.spanAt( 4, start, length );
+    testEqual( start, 2 );
+    testEqual( QString( span, length ), "CD" );
+
+    // the gap may never be moved
+    testContent( v, "AB[__>CD" );
+
+    // the gap at the end results in a single span
+    v.moveGapTo(4);
+    span = v.spanAt( 4, start, length );
+    testEqual( start, 0 );
+    testEqual( QString( span, length ), "ABCD" );
+}
+
+
+/// Tests the growing of the vector. The gap is placed at the insert position while the vector grows
+void GapVectorTest::testGrowthPolicy()
+{
+    QCharGapVector v("ABCD", 0 );
+    v.setGrowSize(2);
+    v.replaceString(1,0,"X");
+    testContent( v, "AX[__>BCD" );
+    testEqual( v.reallocationCount(), 1 );
+    testEqual( v.highWaterMark(), 7 );
+
+    // the maximum growsize limits the extra room
+    v.setGrowDivisor(1);
+    v.setMaxGrowSize(1);
+    v.replaceString(5,0,"YZW");
+    testContent( v, "AXBCDYZW[_>" );
+    testEqual( v.reallocationCount(), 2 );
+    testEqual( v.capacity(), 9 );
+}
+
+
+/// Tests releasing unused memory with squeeze and after large deletions
+void GapVectorTest::testReleaseMemory()
+{
+    QCharGapVector v("ABCD", 4 );
+    v.moveGapTo(2);
+    v.squeeze();
+    testContent( v, "AB[>CD" );
+    testEqual( v.capacity(), 4 );
+    testEqual( v.highWaterMark(), 8 );
+
+    // memory is released after deleting most of the items (when the capacity reaches the threshold)
+    GapVector<char> c(16);
+    c.setReleaseThreshold(64);
+    QByteArray data(100, 'a');
+    c.append( data.constData(), 100 );
+    TextOffset capacity = c.capacity();
+    c.replace( 10, 20, "", 0 );
+    testEqual( c.capacity(), capacity );
+    c.replace( 10, 60, "", 0 );
+    testEqual( c.length(), 20 );
+    testEqual( c.capacity(), 40 );
+    testEqual( c.gapBegin(), 10 );
+
+    // without a release threshold the memory is kept
+    c.setReleaseThreshold(0);
+    c.append( data.constData(), 100 );
+    capacity = c.capacity();
+    c.replace( 0, 110, "", 0 );
+    testEqual( c.capacity(), capacity );
+
+    // without auto release the memory is kept until releaseUnusedMemory is called
+    c.setReleaseThreshold(64);
+    c.setAutoReleaseEnabled( false );
+    c.append( data.constData(), 100 );
+    capacity = c.capacity();
+    c.replace( 0, 90, "", 0 );
+    testEqual( c.capacity(), capacity );
+    c.releaseUnusedMemory();
+    testEqual( c.capacity(), 20 );
+}
+
+
+/// Truncate gives back the unused part of appendUninitialized
+void GapVectorTest::testTruncate()
+{
+    QCharGapVector v("ABCD", 4 );
+    v.moveGapTo(1);
+    QChar* data = v.appendUninitialized( 4 );
+    data[0] = QChar('E');
+    v.truncate( 5 );
+    testEqual( v.length(), 5 );
+    testEqual( v.getUnitTestString().left(6), QStringLiteral("ABCDE[") );
+    v.truncate( 0 );
+    testEqual( v.length(), 0 );
+}
+
+
+/// Tests the Latin-1 (single byte) character vector
+void GapVectorTest::testLatin1GapVector()
+{
+    QString text = QString::fromLatin1("AB\xe9" "D");
+    Latin1GapVector v(4);
+    v.append( text.constData(), text.length() );
+    testEqual( v.length(), 4 );
+    testEqual( v.charAt(2), QChar(0xE9) );
+
+    // replacing should work over the gap
+    v.replace( 1, 1, QStringLiteral("xyz").constData(), 3 );
+    testEqual( v.mid( 0, v.length() ), QString::fromLatin1("Axyz\xe9" "D") );
+    v.moveGapTo( 2 );
+    testEqual( v.mid( 1, 4 ), QString::fromLatin1("xyz\xe9") );
+
+    // deleting
+    v.replace( 0, 4, nullptr, 0 );
+    testEqual( v.mid( 0, v.length() ), QString::fromLatin1("\xe9" "D") );
+
+    // only characters below U+0100 fit
+    testTrue( Latin1GapVector::fits( text.constData(), text.length() ) );
+    QString wide = QStringLiteral("a") + QChar(0x20AC);
+    testFalse( Latin1GapVector::fits( wide.constData(), wide.length() ) );
+}
+
+
 void GapVectorTest::testIssue141()
 {
     QCharGapVector v("036",1);
@@ -19,6 +19,11 @@ private slots:
     void testReplace();
 
     void testCopyRange();
+    void testSpanAt();
+    void testLatin1GapVector();
+    void testGrowthPolicy();
+    void testReleaseMemory();
+    void testTruncate();
 
     void testIssue141();
 
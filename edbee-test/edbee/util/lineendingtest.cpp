@@ -3,6 +3,8 @@
 
 #include "lineendingtest.h"
 
+#include <QString>
+
 #include "edbee/util/lineending.h"
 
 #include "edbee/debug.h"
@@ -28,5 +30,40 @@ void LineEndingTest::testDetect()
 }
 
 
+/// Normalizing removes the \r of \r\n and counts the line endings
+void LineEndingTest::testStatistics()
+{
+    LineEndingStatistics statistics;
+    statistics.setWindowsLinesRecorded( true );
+    QString text = QStringLiteral("aaa\r\nbb\nccc\rddd\r\ne\r");
+    QChar* end = statistics.normalize( text.data(), text.data() + text.length() );
+    text.truncate( static_cast<int>( end - text.constData() ) );
+    testEqual( text, QStringLiteral("aaa\nbb\nccc\rddd\ne\r") );
+    testEqual( statistics.count( LineEnding::UnixType ), 1 );
+    testEqual( statistics.count( LineEnding::WindowsType ), 2 );
+    testEqual( statistics.count( LineEnding::MacClassicType ), 2 );
+    testEqual( statistics.totalCount(), 5 );
+    testEqual( statistics.newlineCount(), 3 );
+    testTrue( statistics.isMixed() );
+    testEqual( statistics.mostCommon()->type(), LineEnding::WindowsType );
+    testEqual( statistics.windowsLines().size(), 2 );
+    testEqual( statistics.windowsLines().at(1), 2 );
+
+    // the lines of appended statistics continue after the counted lines
+    LineEndingStatistics next;
+    QString nextText = QStringLiteral("x\r\n");
+    next.setWindowsLinesRecorded( true );
+    next.normalize( nextText.data(), nextText.data() + nextText.length() );
+    statistics.append( next );
+    testEqual( statistics.count( LineEnding::WindowsType ), 3 );
+    testEqual( statistics.windowsLines().at(2), 3 );
+
+    LineEndingStatistics empty;
+    testFalse( empty.isMixed() );
+    testTrue( empty.mostCommon() == 0 );
+    testEqual( empty.mostCommon( LineEnding::unixType() )->type(), LineEnding::UnixType );
+}
+
+
 
 } // edbee
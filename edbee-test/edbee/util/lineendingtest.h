@@ -14,6 +14,7 @@ class LineEndingTest : public edbee::test::TestCase
 
 private slots:
     void testDetect();
+    void testStatistics();
 
 
 };
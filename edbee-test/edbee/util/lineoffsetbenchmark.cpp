@@ -0,0 +1,95 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "lineoffsetbenchmark.h"
+
+#include <QElapsedTimer>
+
+#include "edbee/models/chardocument/chartextbuffer.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// The number of lines of the benchmark document
+static const int LineCount = 200000;
+
+/// The number of edits of a single benchmark run
+static const int EditCount = 20000;
+
+
+/// Inserts and removes lines close to each other (like typing)
+void LineOffsetBenchmark::benchmarkClusteredEdits()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runEdits( "clustered", false );
+}
+
+
+/// Inserts and removes lines spread over the complete document (like multi-caret edits)
+void LineOffsetBenchmark::benchmarkScatteredEdits()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runEdits( "scattered", true );
+}
+
+
+/// Runs the edits with the line offset vector and with the line offset tree, and compares the results
+/// @param name the name of the benchmark
+/// @param scattered should the edits be spread over the document?
+void LineOffsetBenchmark::runEdits(const QString& name, bool scattered)
+{
+    CharTextBuffer vectorBuffer;
+    CharTextBuffer treeBuffer;
+    treeBuffer.setLineOffsetTreeEnabled(true);
+
+    qint64 vectorTime = applyEdits( &vectorBuffer, scattered );
+    qint64 treeTime = applyEdits( &treeBuffer, scattered );
+    reportBenchmark( QStringLiteral("%1 LineOffsetVector").arg(name), vectorTime, EditCount );
+    reportBenchmark( QStringLiteral("%1 LineOffsetTree").arg(name), treeTime, EditCount );
+
+    testEqual( treeBuffer.length(), vectorBuffer.length() );
+    testEqual( treeBuffer.lineCount(), vectorBuffer.lineCount() );
+    bool equal = true;
+    for( int line=0, cnt=vectorBuffer.lineCount(); line < cnt && equal; ++line ) {
+        equal = treeBuffer.offsetFromLine(line) == vectorBuffer.offsetFromLine(line);
+    }
+    testTrue( equal );
+}
+
+
+/// Fills the buffer with LineCount lines and measures the time of EditCount edits.
+/// Every edit inserts or removes a line and looks up the line of the changed offset
+/// @param buffer the buffer to edit
+/// @param scattered should the edits be spread over the document?
+/// @return the time in nanoseconds
+qint64 LineOffsetBenchmark::applyEdits(CharTextBuffer* buffer, bool scattered)
+{
+    QString lineText = QStringLiteral("line\n");
+    buffer->rawAppendBegin();
+    for( int i=0; i < LineCount; ++i ) {
+        buffer->rawAppend( lineText.constData(), lineText.length() );
+    }
+    buffer->rawAppendEnd();
+
+    QElapsedTimer timer;
+    timer.start();
+    int errorCount = 0;
+    for( int i=0; i < EditCount; ++i ) {
+        // the scattered edits jump between the start and the end of the document
+        int line = scattered ? ( i * 7919 ) % LineCount : LineCount / 2 + i % 64;
+        TextOffset offset = buffer->offsetFromLine( line );
+        if( i % 2 == 0 ) {
+            buffer->replaceText( offset, 0, lineText.constData(), lineText.length() );
+        } else {
+            buffer->replaceText( offset, lineText.length(), nullptr, 0 );
+        }
+        if( buffer->lineFromOffset( offset + 1 ) != line ) { ++errorCount; }
+    }
+    qint64 result = timer.nsecsElapsed();
+    testEqual( errorCount, 0 );
+    return result;
+}
+
+
+} // edbee
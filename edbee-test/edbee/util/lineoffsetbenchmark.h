@@ -0,0 +1,30 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/benchmarkcase.h"
+
+namespace edbee {
+
+class CharTextBuffer;
+
+/// Compares the LineOffsetVector with the LineOffsetTree for clustered and scattered edits
+class LineOffsetBenchmark : public BenchmarkCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void benchmarkClusteredEdits();
+    void benchmarkScatteredEdits();
+
+private:
+    void runEdits( const QString& name, bool scattered );
+    qint64 applyEdits( CharTextBuffer* buffer, bool scattered );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::LineOffsetBenchmark);
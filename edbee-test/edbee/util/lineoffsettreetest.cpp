@@ -0,0 +1,190 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "lineoffsettreetest.h"
+
+#include "edbee/models/chardocument/chartextbuffer.h"
+#include "edbee/models/textbuffer.h"
+#include "edbee/util/lineoffsettree.h"
+#include "edbee/util/lineoffsetvector.h"
+#include "edbee/util/xorshiftrandom.h"
+
+#include "edbee/debug.h"
+
+
+namespace edbee {
+
+#define testLot(t,expected) testEqual(t.toUnitTestString(),expected)
+
+/// The line information of the change is calculated with the reference vector
+#define T_TEXT_REPLACED(offset,lengthIn,str) do {\
+    QString qstr(str); \
+    TextBufferChange change(&v, offset, lengthIn, qstr.data(), qstr.length() ); \
+    t.applyChange(change); \
+    v.applyChange(change); \
+} while(false)
+
+
+void LineOffsetTreeTest::testAppendOffset()
+{
+    LineOffsetTree t;
+    testLot(t,"0");
+    testEqual( t.length(), 1 );
+    testEqual( t.chunkCount(), 0 );
+
+    t.appendOffset(2);
+    t.appendOffset(4);
+    t.appendOffset(9);
+    testLot(t,"0,2,4,9");
+    testEqual( t.length(), 4 );
+    testEqual( t.at(3), 9 );
+    testEqual( t.chunkCount(), 1 );
+
+    t.clear();
+    testLot(t,"0");
+}
+
+
+void LineOffsetTreeTest::testTextReplaced()
+{
+    LineOffsetVector v;
+    LineOffsetTree t;
+    T_TEXT_REPLACED(0,0,"a\nb\nc\nd\ne");
+    testLot(t,"0,2,4,6,8");
+
+    // next insert a newline
+    T_TEXT_REPLACED(3,0,"\n");
+    testLot(t,"0,2,4,5,7,9");
+
+    T_TEXT_REPLACED(0,0,"\n");
+    testLot(t,"0,1,3,5,6,8,10");
+
+    // replace a newline in the middle
+    T_TEXT_REPLACED(4,3,"xy");
+    testLot(t,"0,1,3,7,9");
+
+    // remove the last newline
+    T_TEXT_REPLACED(8,1,"");
+    testLot(t,"0,1,3,7");
+
+    T_TEXT_REPLACED(0,9,"");
+    testLot(t,"0");
+}
+
+
+void LineOffsetTreeTest::testFindLineFromOffset()
+{
+    LineOffsetTree t;
+    t.appendOffset(4);
+    t.appendOffset(5);
+    testEqual( t.findLineFromOffset(0), 0 );
+    testEqual( t.findLineFromOffset(3), 0 );
+    testEqual( t.findLineFromOffset(4), 1 );
+    testEqual( t.findLineFromOffset(5), 2 );
+    testEqual( t.findLineFromOffset(100), 2 );
+
+    // lines spread over multiple chunks
+    t.clear();
+    for( int i=1; i <= 1000; ++i ) { t.appendOffset( i*10 ); }
+    testEqual( t.length(), 1001 );
+    testEqual( t.at(1000), 10000 );
+    testEqual( t.findLineFromOffset(9), 0 );
+    testEqual( t.findLineFromOffset(10), 1 );
+    testEqual( t.findLineFromOffset(5555), 555 );
+    testEqual( t.findLineFromOffset(9999), 999 );
+    testEqual( t.findLineFromOffset(10000), 1000 );
+}
+
+
+/// Tests if the tree keeps the chunks of a reasonable size
+void LineOffsetTreeTest::testChunkSizes()
+{
+    LineOffsetVector v;
+    LineOffsetTree t;
+    T_TEXT_REPLACED(0,0,QString( 10 * LineOffsetTree::ChunkSize, QChar('\n') ));
+    testEqual( t.length(), 10 * LineOffsetTree::ChunkSize + 1 );
+    testEqual( t.chunkCount(), 10 );
+
+    // many single line inserts at the same location, shouldn't result in many tiny chunks
+    for( int i=0; i < 5 * LineOffsetTree::ChunkSize; ++i ) {
+        T_TEXT_REPLACED(100,0,"\n");
+    }
+    testTrue( t.chunkCount() <= 2 * 15 );
+
+    // removing almost everything should result in a single chunk
+    T_TEXT_REPLACED(0, 15 * LineOffsetTree::ChunkSize - 2,"");
+    testLot(t,"0,1,2");
+    testEqual( t.chunkCount(), 1 );
+}
+
+
+/// Applies random changes to the tree and the vector and compares the results
+void LineOffsetTreeTest::testCompareWithLineOffsetVector()
+{
+    LineOffsetVector v;
+    LineOffsetTree t;
+    XorShiftRandom random(12345);
+    TextOffset length = 0;
+    for( int i=0; i < 2000; ++i ) {
+        TextOffset offset = length > 0 ? random.next() % ( length + 1 ) : 0;
+        TextOffset removed = qMin<TextOffset>( random.next() % 8, length - offset );
+        if( random.next() % 50 == 0 ) { removed = length - offset; }
+
+        QString text;
+        int textLength = random.next() % 20 == 0 ? random.next() % 500 : random.next() % 6;
+        for( int j=0; j < textLength; ++j ) {
+            text.append( random.next() % 3 == 0 ? QChar('\n') : QChar('a') );
+        }
+        T_TEXT_REPLACED(offset,removed,text);
+        length += text.length() - removed;
+
+        testEqual( t.length(), v.length() );
+        if( i % 100 == 0 ) {
+            for( int line=0; line < v.length(); ++line ) {
+                testEqual( t.at(line), v.at(line) );
+            }
+            for( TextOffset off=0; off <= length; ++off ) {
+                testEqual( t.findLineFromOffset(off), v.findLineFromOffset(off) );
+            }
+        }
+    }
+}
+
+
+/// Tests the CharTextBuffer with the line offset tree enabled
+void LineOffsetTreeTest::testCharTextBuffer()
+{
+    CharTextBuffer charBuf;
+    TextBuffer& buf = charBuf;
+    buf.setText("a\nbb\nccc");
+    charBuf.setLineOffsetTreeEnabled(true);
+    testTrue( charBuf.isLineOffsetTreeEnabled() );
+    testEqual( buf.lineCount(), 3 );
+    testEqual( buf.offsetFromLine(1), 2 );
+    testEqual( buf.offsetFromLine(2), 5 );
+    testEqual( buf.offsetFromLine(3), 8 );
+    testEqual( buf.lineFromOffset(4), 1 );
+
+    buf.replaceText( 1, 0, "\nxx" );
+    testEqual( buf.lineCount(), 4 );
+    testEqual( buf.offsetFromLine(2), 5 );
+    testEqual( buf.line(1), QStringLiteral("xx\n") );
+
+    // raw appending
+    buf.rawAppendBegin();
+    buf.rawAppend( QChar('\n') );
+    buf.rawAppend( QChar('d') );
+    buf.rawAppendEnd();
+    testEqual( buf.lineCount(), 5 );
+    testEqual( buf.line(4), QStringLiteral("d") );
+
+    // switching back should keep the lines
+    charBuf.setLineOffsetTreeEnabled(false);
+    testFalse( charBuf.isLineOffsetTreeEnabled() );
+    testEqual( buf.lineCount(), 5 );
+    testEqual( buf.offsetFromLine(4), 12 );
+    testEqual( buf.lineFromOffset(9), 3 );
+}
+
+
+} // edbee
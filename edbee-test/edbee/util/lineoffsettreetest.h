@@ -0,0 +1,28 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class LineOffsetTreeTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testAppendOffset();
+    void testTextReplaced();
+    void testFindLineFromOffset();
+    void testChunkSizes();
+    void testCompareWithLineOffsetVector();
+    void testCharTextBuffer();
+
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::LineOffsetTreeTest);
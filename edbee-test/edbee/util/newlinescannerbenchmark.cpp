@@ -0,0 +1,133 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "newlinescannerbenchmark.h"
+
+#include <QElapsedTimer>
+
+#include "edbee/models/chardocument/chartextbuffer.h"
+#include "edbee/models/textbuffer.h"
+#include "edbee/util/lineending.h"
+#include "edbee/util/lineoffsetvector.h"
+#include "edbee/util/newlinescanner.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// The number of characters of the benchmark text
+static const int TextLength = 16 * 1024 * 1024;
+
+/// The length of a line of the benchmark text
+static const int LineLength = 60;
+
+
+/// Returns the benchmark text
+/// @param withNewlines when false the text doesn't contain any newlines
+static QString benchmarkText( bool withNewlines )
+{
+    QString result( TextLength, QChar('a') );
+    if( withNewlines ) {
+        for( int i = LineLength - 1; i < TextLength; i += LineLength ) { result[i] = QChar('\n'); }
+    }
+    return result;
+}
+
+
+void NewlineScannerBenchmark::benchmarkCount()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runPath( CountPath, "NewlineScanner::count", benchmarkText(true) );
+}
+
+
+void NewlineScannerBenchmark::benchmarkAppendOffsets()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runPath( AppendOffsetsPath, "NewlineScanner::appendOffsets", benchmarkText(true) );
+}
+
+
+/// Creating a textbuffer change, this happens for every paste and load
+void NewlineScannerBenchmark::benchmarkTextBufferChange()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runPath( TextBufferChangePath, "TextBufferChange", benchmarkText(true) );
+}
+
+
+/// Detecting the line ending of a text without line endings (worst case)
+void NewlineScannerBenchmark::benchmarkLineEndingDetect()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runPath( LineEndingDetectPath, "LineEnding::detect", benchmarkText(false) );
+}
+
+
+/// Appending a text to a CharTextBuffer, like the TextDocumentSerializer does when loading a file
+void NewlineScannerBenchmark::benchmarkRawAppend()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runPath( RawAppendPath, "CharTextBuffer::rawAppend", benchmarkText(true) );
+}
+
+
+/// Measures the given path for all supported implementations, and checks that all implementations return the same result
+void NewlineScannerBenchmark::runPath(Path path, const QString& name, const QString& text)
+{
+    NewlineScanner::Implementation original = NewlineScanner::implementation();
+    int expected = -1;
+    for( int impl = NewlineScanner::ScalarImplementation; impl <= NewlineScanner::Avx2Implementation; ++impl ) {
+        NewlineScanner::Implementation implementation = static_cast<NewlineScanner::Implementation>(impl);
+        if( !NewlineScanner::setImplementation( implementation ) ) { continue; }
+
+        measure( path, text );     // warm up
+        QElapsedTimer timer;
+        timer.start();
+        int result = measure( path, text );
+        qint64 nsecs = timer.nsecsElapsed();
+
+        reportThroughput( QStringLiteral("%1 %2").arg( name ).arg( NewlineScanner::implementationName( implementation ) ), nsecs, text.length() * static_cast<qint64>( sizeof(QChar) ) );
+        if( expected < 0 ) { expected = result; }
+        testEqual( result, expected );
+    }
+    NewlineScanner::setImplementation( original );
+}
+
+
+/// Runs the given path once
+/// @return the number of found lines (to compare the implementations)
+int NewlineScannerBenchmark::measure(Path path, const QString& text)
+{
+    switch( path ) {
+        case CountPath:
+            return NewlineScanner::count( text.constData(), text.length() );
+
+        case AppendOffsetsPath: {
+            QVector<TextOffset> offsets;
+            NewlineScanner::appendOffsets( text.constData(), text.length(), 1, offsets );
+            return offsets.size();
+        }
+
+        case TextBufferChangePath: {
+            LineOffsetVector lineOffsets;
+            TextBufferChange change( &lineOffsets, 0, 0, text.constData(), text.length() );
+            return change.newLineCount();
+        }
+
+        case LineEndingDetectPath:
+            return LineEnding::detect( text ) ? 1 : 0;
+
+        case RawAppendPath: {
+            CharTextBuffer buffer;
+            buffer.rawAppendBegin();
+            buffer.rawAppend( text.constData(), text.length() );
+            buffer.rawAppendEnd();
+            return buffer.lineCount();
+        }
+    }
+    return 0;
+}
+
+
+} // edbee
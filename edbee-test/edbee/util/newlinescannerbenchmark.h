@@ -0,0 +1,39 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/benchmarkcase.h"
+
+namespace edbee {
+
+/// Measures the throughput of the newline scanning paths for every supported NewlineScanner implementation
+class NewlineScannerBenchmark : public BenchmarkCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void benchmarkCount();
+    void benchmarkAppendOffsets();
+    void benchmarkTextBufferChange();
+    void benchmarkLineEndingDetect();
+    void benchmarkRawAppend();
+
+private:
+    enum Path {
+        CountPath,
+        AppendOffsetsPath,
+        TextBufferChangePath,
+        LineEndingDetectPath,
+        RawAppendPath
+    };
+
+    void runPath( Path path, const QString& name, const QString& text );
+    int measure( Path path, const QString& text );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::NewlineScannerBenchmark);
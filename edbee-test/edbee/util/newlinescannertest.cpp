@@ -0,0 +1,119 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "newlinescannertest.h"
+
+#include "edbee/util/newlinescanner.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+void NewlineScannerTest::testFind()
+{
+    QString text("abc\ndef\n");
+    const QChar* begin = text.constData();
+    const QChar* end = begin + text.length();
+    testEqual( NewlineScanner::find( begin, end, '\n' ) - begin, 3 );
+    testEqual( NewlineScanner::find( begin + 4, end, '\n' ) - begin, 7 );
+    testEqual( NewlineScanner::find( begin, end, 'e' ) - begin, 5 );
+    testTrue( NewlineScanner::find( begin, end, 'x' ) == end );
+    testTrue( NewlineScanner::find( begin, begin, '\n' ) == begin );
+}
+
+
+void NewlineScannerTest::testFindLineBreak()
+{
+    QString text("0123456789abcdefghij\r\n");
+    const QChar* begin = text.constData();
+    const QChar* end = begin + text.length();
+    testEqual( NewlineScanner::findLineBreak( begin, end ) - begin, 20 );
+    testEqual( NewlineScanner::findLineBreak( begin + 21, end ) - begin, 21 );
+    testTrue( NewlineScanner::findLineBreak( begin, begin + 20 ) == begin + 20 );
+}
+
+
+void NewlineScannerTest::testCount()
+{
+    QString text("a\nb\n\n0123456789abcdefghijklmnopqrstuvwxyz\n");
+    testEqual( NewlineScanner::count( text.constData(), text.length() ), 4 );
+    testEqual( NewlineScanner::count( text.constData(), 4 ), 2 );
+    testEqual( NewlineScanner::count( text.constData(), 0 ), 0 );
+
+    // the characters 0x0A0A and 0x0D0A contain a newline byte, but they aren't newlines
+    QString wide( 40, QChar(0x0A0A) );
+    wide[33] = QChar(0x0D0A);
+    testEqual( NewlineScanner::count( wide.constData(), wide.length() ), 0 );
+}
+
+
+void NewlineScannerTest::testAppendOffsets()
+{
+    QString text("a\nb\n\n0123456789abcdefghijklmnopqrstuvwxyz\n");
+    QVector<TextOffset> offsets;
+    NewlineScanner::appendOffsets( text.constData(), text.length(), 10, offsets );
+    testEqual( offsets.size(), 4 );
+    testEqual( offsets.at(0), 11 );
+    testEqual( offsets.at(1), 13 );
+    testEqual( offsets.at(2), 14 );
+    testEqual( offsets.at(3), 51 );
+
+    // existing offsets are kept
+    NewlineScanner::appendOffsets( text.constData(), 2, 100, offsets );
+    testEqual( offsets.size(), 5 );
+    testEqual( offsets.at(4), 101 );
+}
+
+
+/// Compares all supported implementations with a simple loop, for all lengths and alignments
+void NewlineScannerTest::testImplementations()
+{
+    NewlineScanner::Implementation original = NewlineScanner::implementation();
+    testTrue( NewlineScanner::isSupported( NewlineScanner::ScalarImplementation ) );
+
+    QString text;
+    for( int i=0; i < 100; ++i ) {
+        const char* chars = "a\nb\r\n";
+        text.append( QChar( chars[ ( i * 7 ) % 5 ] ) );
+        if( i % 9 == 0 ) { text.append( QChar(0x0A0A) ); }
+    }
+
+    for( int impl = NewlineScanner::ScalarImplementation; impl <= NewlineScanner::Avx2Implementation; ++impl ) {
+        NewlineScanner::Implementation implementation = static_cast<NewlineScanner::Implementation>(impl);
+        if( !NewlineScanner::setImplementation( implementation ) ) { continue; }
+        testTrue( NewlineScanner::implementation() == implementation );
+
+        int errorCount = 0;
+        for( int start=0; start < 20; ++start ) {
+            for( int length=0; start + length <= text.length(); ++length ) {
+                const QChar* begin = text.constData() + start;
+                const QChar* end = begin + length;
+
+                const QChar* newline = end;
+                const QChar* lineBreak = end;
+                QVector<TextOffset> offsets;
+                for( const QChar* c = end - 1; c >= begin; --c ) {
+                    if( *c == '\n' ) { newline = c; }
+                    if( *c == '\n' || *c == '\r' ) { lineBreak = c; }
+                }
+                for( const QChar* c = begin; c < end; ++c ) {
+                    if( *c == '\n' ) { offsets.append( c - begin ); }
+                }
+
+                QVector<TextOffset> result;
+                NewlineScanner::appendOffsets( begin, length, 0, result );
+                if( NewlineScanner::find( begin, end, '\n' ) != newline ) { ++errorCount; }
+                if( NewlineScanner::findLineBreak( begin, end ) != lineBreak ) { ++errorCount; }
+                if( NewlineScanner::count( begin, length ) != offsets.size() ) { ++errorCount; }
+                if( result != offsets ) { ++errorCount; }
+            }
+        }
+        testEqual( errorCount, 0 );
+    }
+
+    NewlineScanner::setImplementation( original );
+}
+
+
+} // edbee
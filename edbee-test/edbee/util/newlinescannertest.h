@@ -0,0 +1,27 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class NewlineScannerTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testFind();
+    void testFindLineBreak();
+    void testCount();
+    void testAppendOffsets();
+    void testImplementations();
+
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::NewlineScannerTest);
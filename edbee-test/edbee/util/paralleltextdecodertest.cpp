@@ -0,0 +1,135 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "paralleltextdecodertest.h"
+
+#include "edbee/util/newlinescanner.h"
+#include "edbee/util/paralleltextdecoder.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Decodes the given data and returns the result as a string
+/// @param lineOffsets (out) the found line offsets
+static QString decode( ParallelTextDecoder& decoder, QVector<TextOffset>* lineOffsets=0 )
+{
+    QVector<TextOffset> offsets;
+    QString result( static_cast<int>( decoder.decodedLength() ), Qt::Uninitialized );
+    decoder.decode( result.data(), 0, offsets );
+    if( lineOffsets ) { *lineOffsets = offsets; }
+    return result;
+}
+
+
+/// Decodes the given utf8 data with the given block size
+static QString decodeUtf8( const QByteArray& data, int blockSize=ParallelTextDecoder::DefaultBlockSize, QVector<TextOffset>* lineOffsets=0 )
+{
+    ParallelTextDecoder decoder( ParallelTextDecoder::Utf8Encoding, data.constData(), data.size() );
+    decoder.setBlockSize( blockSize );
+    return decode( decoder, lineOffsets );
+}
+
+
+void ParallelTextDecoderTest::testUtf8()
+{
+    QByteArray data("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 end");     // a 2, 3 and 4 byte sequence (the last one is a surrogate pair)
+    QString text = QString::fromUtf8( data );
+    testEqual( decodeUtf8( data ), text );
+    testEqual( decodeUtf8( data, 4 ), text );
+    testEqual( decodeUtf8( QByteArray() ), QStringLiteral("") );
+}
+
+
+void ParallelTextDecoderTest::testLatin1()
+{
+    QByteArray data("caf\xe9\r\nna\xefve");
+    ParallelTextDecoder decoder( ParallelTextDecoder::Latin1Encoding, data.constData(), data.size() );
+    decoder.setBlockSize( 4 );
+    testEqual( decode( decoder ), QString::fromUtf8("caf\xc3\xa9\nna\xc3\xafve") );
+}
+
+
+/// \r\n is translated to \n, a single \r is kept
+void ParallelTextDecoderTest::testNewlines()
+{
+    QVector<TextOffset> lineOffsets;
+    testEqual( decodeUtf8( "a\r\nb\rc\n", 4, &lineOffsets ), QStringLiteral("a\nb\rc\n") );
+    testEqual( lineOffsets.size(), 2 );
+    testEqual( lineOffsets.at(0), 2 );
+    testEqual( lineOffsets.at(1), 6 );
+
+    // a \r\n pair at a block boundary
+    testEqual( decodeUtf8( "abc\r\ndef\r\n", 4 ), QStringLiteral("abc\ndef\n") );
+}
+
+
+/// The line endings are counted per block and merged, a \r\n can be split over two blocks
+void ParallelTextDecoderTest::testLineEndingStatistics()
+{
+    QByteArray data("abc\r\ndef\nghi\rjkl\r\nmno\r\n");
+    ParallelTextDecoder decoder( ParallelTextDecoder::Utf8Encoding, data.constData(), data.size() );
+    decoder.setBlockSize( 4 );
+    QVector<TextOffset> lineOffsets;
+    LineEndingStatistics lineEndings;
+    lineEndings.setWindowsLinesRecorded( true );
+    QString result( static_cast<int>( decoder.decodedLength() ), Qt::Uninitialized );
+    decoder.decode( result.data(), 0, lineOffsets, &lineEndings );
+
+    testEqual( result, QStringLiteral("abc\ndef\nghi\rjkl\nmno\n") );
+    testEqual( lineEndings.count( LineEnding::UnixType ), 1 );
+    testEqual( lineEndings.count( LineEnding::WindowsType ), 3 );
+    testEqual( lineEndings.count( LineEnding::MacClassicType ), 1 );
+    testEqual( lineEndings.newlineCount(), lineOffsets.size() );
+    testEqual( lineEndings.windowsLines().size(), 3 );
+    testEqual( lineEndings.windowsLines().at(0), 0 );
+    testEqual( lineEndings.windowsLines().at(1), 2 );
+    testEqual( lineEndings.windowsLines().at(2), 3 );
+}
+
+
+void ParallelTextDecoderTest::testByteOrderMark()
+{
+    QByteArray data("\xef\xbb\xbfHello");
+    ParallelTextDecoder decoder( ParallelTextDecoder::Utf8Encoding, data.constData(), data.size() );
+    testEqual( decode( decoder ), QString( QChar(0xfeff) ) + QStringLiteral("Hello") );
+
+    ParallelTextDecoder skipDecoder( ParallelTextDecoder::Utf8Encoding, data.constData(), data.size() );
+    skipDecoder.setSkipByteOrderMark( true );
+    testEqual( decode( skipDecoder ), QStringLiteral("Hello") );
+}
+
+
+/// Invalid bytes are replaced by the replacement character
+void ParallelTextDecoderTest::testInvalidUtf8()
+{
+    QChar replacement( QChar::ReplacementCharacter );
+    testEqual( decodeUtf8( "a\xff" "b" ), QStringLiteral("a%1b").arg(replacement) );
+    testEqual( decodeUtf8( "a\xe2\x82" ), QStringLiteral("a%1%1").arg(replacement) );
+    testEqual( decodeUtf8( "\x80\x80\x80\x80\x80x", 4 ), decodeUtf8( "\x80\x80\x80\x80\x80x" ) );
+}
+
+
+/// The result should never depend on the block size
+void ParallelTextDecoderTest::testBlockBoundaries()
+{
+    QString line = QString::fromUtf8("ab\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\r\n");
+    QString text;
+    for( int i=0; i < 500; ++i ) { text.append( line ); }
+    QByteArray data = text.toUtf8();
+
+    QVector<TextOffset> expectedOffsets;
+    QString expected = decodeUtf8( data, ParallelTextDecoder::DefaultBlockSize, &expectedOffsets );
+    testEqual( expected, QString(text).replace( QStringLiteral("\r\n"), QStringLiteral("\n") ) );
+    testEqual( expectedOffsets.size(), 500 );
+
+    for( int blockSize = 4; blockSize < 40; ++blockSize ) {
+        QVector<TextOffset> lineOffsets;
+        testEqual( decodeUtf8( data, blockSize, &lineOffsets ), expected );
+        testTrue( lineOffsets == expectedOffsets );
+    }
+}
+
+
+} // edbee
@@ -0,0 +1,28 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class ParallelTextDecoderTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testUtf8();
+    void testLatin1();
+    void testNewlines();
+    void testLineEndingStatistics();
+    void testByteOrderMark();
+    void testInvalidUtf8();
+    void testBlockBoundaries();
+
+};
+
+} // edbee
+
+DECLARE_TEST(edbee::ParallelTextDecoderTest);
@@ -0,0 +1,182 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "regexpbenchmark.h"
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include "edbee/util/regexp.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// The number of times every line is scanned
+static const int ScanCount = 20000;
+
+/// The lines that are scanned
+static const char* SampleLines[] = {
+    "    for( int i=0; i < count; ++i ) { if( values[i] > 0x7f ) { total += values[i] * 1.5e3; } }  // sum",
+    "    static const char* name = \"buffer \\\"quoted\\\" text\"; return name;",
+    "<div class=\"content\" id='main'><a href=\"#top\">a link</a> &amp; <img src=\"a.png\"/></div>",
+    "function add( a, b ) { var c = a + b; /* block comment */ return c * 2; }"
+};
+
+/// Patterns that are typical for grammars, with a name for the report
+static const char* SamplePatterns[][2] = {
+    { "keywords",      "\\b(if|else|for|while|do|switch|case|return|break|continue|static|const|var|function)\\b" },
+    { "identifier",    "\\b[A-Za-z_][A-Za-z0-9_]*\\b" },
+    { "number",        "\\b(0x[0-9a-fA-F]+|[0-9]+(\\.[0-9]+)?([eE][+-]?[0-9]+)?)\\b" },
+    { "string begin",  "(['\"])" },
+    { "string escape", "\\\\." },
+    { "line comment",  "(//).*$\\n?" },
+    { "block comment", "/\\*" },
+    { "operator",      "(\\+\\+|--|\\+=|-=|==|!=|<=|>=|&&|\\|\\||[-+*/%<>=!&|^~?:])" },
+    { "html tag",      "(</?)([a-zA-Z0-9:-]+)(?=[^>]*>)" },
+    { "html entity",   "(&)([a-zA-Z0-9]+|#[0-9]+|#x[0-9a-fA-F]+)(;)" },
+    { "lookbehind",    "(?<=\\.)[a-z_]+" },
+    { "anchored",      "\\G\\s*([a-z]+)" }
+};
+
+
+/// Returns the number of sample patterns
+static int samplePatternCount()
+{
+    return int( sizeof(SamplePatterns) / sizeof(SamplePatterns[0]) );
+}
+
+
+/// Returns the sample lines
+static QStringList sampleLines()
+{
+    QStringList result;
+    for( unsigned int i=0; i < sizeof(SampleLines) / sizeof(SampleLines[0]); ++i ) {
+        result.append( QString::fromLatin1( SampleLines[i] ) );
+    }
+    return result;
+}
+
+
+/// Searches every pattern through the lines, from match to match like the lexer, with the QString and the
+/// zero-copy (QStringView) indexIn
+void RegExpBenchmark::benchmarkPatterns()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    QStringList lines = sampleLines();
+    for( int patternIdx=0; patternIdx < samplePatternCount(); ++patternIdx ) {
+        RegExp regExp( QString::fromLatin1( SamplePatterns[patternIdx][1] ) );
+        testTrue( regExp.isValid() );
+
+        for( int view=0; view < 2; ++view ) {
+            qint64 searchCount = 0;
+            qint64 matchCount = 0;
+            QElapsedTimer timer;
+            timer.start();
+            for( int scan=0; scan < ScanCount; ++scan ) {
+                foreach( const QString& line, lines ) {
+                    int offset = 0;
+                    while( offset <= line.length() ) {
+                        int pos = view ? regExp.indexIn( QStringView( line ), offset ) : regExp.indexIn( line, offset );
+                        ++searchCount;
+                        if( pos < 0 ) { break; }
+                        ++matchCount;
+                        offset = pos + qMax( regExp.len(), 1 );
+                    }
+                }
+            }
+            qint64 nsecs = timer.nsecsElapsed();
+            reportBenchmark( QStringLiteral("RegExp %1 indexIn(%2) (%3 matches)").arg( SamplePatterns[patternIdx][0] )
+                .arg( view ? "QStringView" : "QString" ).arg( matchCount ), nsecs, searchCount );
+        }
+    }
+}
+
+
+/// Searches all patterns at once with a regexp set, compared with searching all patterns on their own
+/// (the way the grammar lexer searches the candidate rules of a context)
+void RegExpBenchmark::benchmarkRegExpSet()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    QStringList patterns;
+    QList<RegExp*> regExps;
+    for( int patternIdx=0; patternIdx < samplePatternCount(); ++patternIdx ) {
+        patterns.append( QString::fromLatin1( SamplePatterns[patternIdx][1] ) );
+        regExps.append( new RegExp( patterns.last() ) );
+    }
+    RegExpSet regExpSet( patterns );
+    testTrue( regExpSet.isValid() );
+
+    QStringList lines = sampleLines();
+    qint64 tokenCount[2] = { 0, 0 };
+    for( int useSet=0; useSet < 2; ++useSet ) {
+        QElapsedTimer timer;
+        timer.start();
+        for( int scan=0; scan < ScanCount; ++scan ) {
+            foreach( const QString& line, lines ) {
+                int offset = 0;
+                while( offset <= line.length() ) {
+                    int foundPos = -1;
+                    int foundLength = 0;
+                    if( useSet ) {
+                        foundPos = regExpSet.indexIn( line, offset );
+                        foundLength = regExpSet.len();
+                    } else {
+                        foreach( RegExp* regExp, regExps ) {
+                            int pos = regExp->indexIn( QStringView( line ), offset );
+                            if( pos >= 0 && ( foundPos < 0 || pos < foundPos ) ) {
+                                foundPos = pos;
+                                foundLength = regExp->len();
+                            }
+                        }
+                    }
+                    if( foundPos < 0 ) { break; }
+                    ++tokenCount[useSet];
+                    offset = foundPos + qMax( foundLength, 1 );
+                }
+            }
+        }
+        qint64 nsecs = timer.nsecsElapsed();
+        reportBenchmark( QStringLiteral("RegExp %1 patterns %2").arg( patterns.size() ).arg( useSet ? "with RegExpSet" : "searched one by one" ),
+            nsecs, tokenCount[useSet] );
+    }
+    testEqual( tokenCount[1], tokenCount[0] );
+    qDeleteAll( regExps );
+}
+
+
+/// Reads the captures of the matches as new strings and as views
+void RegExpBenchmark::benchmarkCaptures()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+
+    RegExp regExp( QStringLiteral("(</?)([a-zA-Z0-9:-]+)|([A-Za-z_]+)(\\()") );
+    QStringList lines = sampleLines();
+    for( int view=0; view < 2; ++view ) {
+        qint64 captureCount = 0;
+        qint64 captureLength = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for( int scan=0; scan < ScanCount; ++scan ) {
+            foreach( const QString& line, lines ) {
+                int offset = 0;
+                while( offset <= line.length() ) {
+                    int pos = regExp.indexIn( QStringView( line ), offset );
+                    if( pos < 0 ) { break; }
+                    for( int nth=0; nth < 5; ++nth ) {
+                        captureLength += view ? regExp.capView( nth ).size() : regExp.cap( nth ).length();
+                        ++captureCount;
+                    }
+                    offset = pos + qMax( regExp.len(), 1 );
+                }
+            }
+        }
+        qint64 nsecs = timer.nsecsElapsed();
+        reportBenchmark( QStringLiteral("RegExp %1 (%2 characters)").arg( view ? "capView" : "cap" ).arg( captureLength ), nsecs, captureCount );
+    }
+}
+
+
+} // edbee
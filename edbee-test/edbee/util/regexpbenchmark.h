@@ -0,0 +1,26 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/benchmarkcase.h"
+
+namespace edbee {
+
+/// Measures the speed of searching patterns that are typical for tmLanguage grammars, the way the grammar lexer
+/// searches them: from token to token through a line
+class RegExpBenchmark : public BenchmarkCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void benchmarkPatterns();
+    void benchmarkRegExpSet();
+    void benchmarkCaptures();
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::RegExpBenchmark);
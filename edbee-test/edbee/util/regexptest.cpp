@@ -33,4 +33,105 @@ void RegExpTest::testRegExp()
 }
 
 
+/// Searching the same regexp again (the region is reused) and the views on the searched string
+void RegExpTest::testRegExpReuse()
+{
+    RegExp regExp( "(a+)|(b+)" );
+    QString text( "xaab bbb" );
+    testEqual( regExp.indexIn( QStringView( text ), 0 ), 1 );
+    testEqual( regExp.pos(1), 1 );
+    testEqual( regExp.len(1), 2 );
+    testEqual( regExp.pos(2), -1 );
+    testEqual( regExp.capView(1).toString(), QStringLiteral("aa") );
+    testTrue( regExp.capView(1).data() == text.constData() + 1 );   // a view, not a copy
+
+    // the groups of the previous match are cleared
+    testEqual( regExp.indexIn( QStringView( text ), 3 ), 3 );
+    testEqual( regExp.pos(1), -1 );
+    testEqual( regExp.len(1), 0 );  // an unmatched group has no length
+    testEqual( regExp.len(2), 1 );
+    testTrue( regExp.capView(1).isNull() );
+    testEqual( regExp.cap(2), QStringLiteral("b") );
+
+    testEqual( regExp.indexIn( QStringView( text ).mid( 4 ), 0 ), 1 );
+    testEqual( regExp.capView(2).toString(), QStringLiteral("bbb") );
+
+    testEqual( regExp.indexIn( QStringLiteral("xyz") ), -1 );
+    testEqual( regExp.pos(0), -1 );
+    testEqual( regExp.len(0), 0 );
+    testEqual( regExp.len(3), -1 );  // an unknown group
+}
+
+
+/// The QRegExp engine returns the same lengths and views as the Oniguruma engine
+/// (0 for an unmatched group or after a failed match, -1 for an unknown group)
+void RegExpTest::testQRegExpEngine()
+{
+    RegExp regExp( "a+(b*)(x)?c*", true, RegExp::SyntaxDefault, RegExp::EngineQRegExp );
+    QString text( "xxxaaabccccddddd" );
+    testEqual( regExp.indexIn( text ), 3 );
+    testEqual( regExp.len(0), 8 );
+    testEqual( regExp.pos(1), 6 );
+    testEqual( regExp.len(1), 1 );
+    testEqual( regExp.pos(2), -1 );
+    testEqual( regExp.len(2), 0 );
+    testEqual( regExp.len(3), -1 );
+    testTrue( regExp.capView(2).isNull() );
+    testEqual( regExp.capView(1).toString(), QStringLiteral("b") );
+    testTrue( regExp.capView(0).data() == text.constData() + 3 );   // a view, not a copy
+
+    // the view of a backward search is on the searched string
+    testEqual( regExp.lastIndexIn( text ), 5 );
+    testEqual( regExp.len(0), 6 );
+    testTrue( regExp.capView(0).data() == text.constData() + 5 );
+
+    testEqual( regExp.indexIn( QStringLiteral("xyz") ), -1 );
+    testEqual( regExp.len(0), 0 );
+    testEqual( regExp.len(1), 0 );
+}
+
+
+/// The set should return the leftmost match, on the same position the pattern with the lowest index
+void RegExpTest::testRegExpSet()
+{
+    QStringList patterns;
+    patterns << "\\bif\\b" << "b(c+)" << "a+(b*)c*" << "\\d+";
+    RegExpSet regExpSet( patterns );
+    testTrue( regExpSet.isValid() );
+    testEqual( regExpSet.size(), 4 );
+
+    testEqual( regExpSet.indexIn("xxxaaabccccddddd"), 3 );
+    testEqual( regExpSet.matchedIndex(), 2 );
+    testEqual( regExpSet.pos(0), 3 );
+    testEqual( regExpSet.len(0), 8 );
+    testEqual( regExpSet.pos(1), 6 );
+    testEqual( regExpSet.len(1), 1 );
+    testEqual( regExpSet.pos(2), -1 );
+
+    // the offset is respected
+    testEqual( regExpSet.indexIn("if 12 bcc abc", 1), 3 );
+    testEqual( regExpSet.matchedIndex(), 3 );
+    testEqual( regExpSet.indexIn("if 12 bcc abc", 5), 6 );
+    testEqual( regExpSet.matchedIndex(), 1 );
+    testEqual( regExpSet.pos(1), 7 );
+    testEqual( regExpSet.len(1), 2 );
+
+    testEqual( regExpSet.indexIn("xyz"), -1 );
+    testEqual( regExpSet.matchedIndex(), -1 );
+    testEqual( regExpSet.pos(0), -1 );
+
+    // on the same position the pattern with the lowest index wins
+    RegExpSet digitSet( QStringList() << "\\d" << "\\d+" );
+    testEqual( digitSet.indexIn("x42"), 1 );
+    testEqual( digitSet.matchedIndex(), 0 );
+    testEqual( digitSet.len(0), 1 );
+
+    // an invalid pattern makes the set invalid
+    RegExpSet invalidSet( QStringList() << "a+" << "(b" );
+    testFalse( invalidSet.isValid() );
+    testFalse( invalidSet.errorString().isEmpty() );
+    testEqual( invalidSet.indexIn("aaa"), -2 );
+}
+
+
 } // edbee
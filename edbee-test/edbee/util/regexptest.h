@@ -13,6 +13,9 @@ class RegExpTest  : public edbee::test::TestCase
 private slots:
 
     void testRegExp();
+    void testRegExpReuse();
+    void testQRegExpEngine();
+    void testRegExpSet();
 
 };
 
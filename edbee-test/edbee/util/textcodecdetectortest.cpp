@@ -0,0 +1,64 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textcodecdetectortest.h"
+
+#include <QByteArray>
+
+#include "edbee/util/textcodec.h"
+#include "edbee/util/textcodecdetector.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+void TextCodecDetectorTest::testByteOrderMarks()
+{
+    testEqual( detect( "\xef\xbb\xbf" "abc" ), QStringLiteral("UTF-8 with BOM") );
+    testEqual( detect( QByteArray( "\xff\xfe" "a\0", 4 ) ), QStringLiteral("UTF-16LE with BOM") );
+    testEqual( detect( QByteArray( "\xfe\xff\0a", 4 ) ), QStringLiteral("UTF-16BE with BOM") );
+    testTrue( TextCodecDetector::hasByteOrderMark( "\xef\xbb\xbf", 3 ) );
+    testFalse( TextCodecDetector::hasByteOrderMark( "\xef\xbb", 2 ) );
+    testFalse( TextCodecDetector::hasByteOrderMark( "abc", 3 ) );
+}
+
+
+void TextCodecDetectorTest::testDetectCodec()
+{
+    testEqual( detect( "plain ascii" ), QStringLiteral("UTF-8") );
+    testEqual( detect( "caf\xc3\xa9" ), QStringLiteral("UTF-8") );
+    testEqual( detect( "caf\xe9 au lait" ), QStringLiteral("ISO-8859-1") );
+
+    // the last bytes are validated too
+    testEqual( detect( "abcdefgh\xe9" ), QStringLiteral("ISO-8859-1") );
+
+    // overlong sequences aren't valid UTF-8
+    testEqual( detect( "abc\xc0\xaf" "def" ), QStringLiteral("ISO-8859-1") );
+}
+
+
+/// By default the buffer is the first block of a file and may end with an incomplete sequence
+void TextCodecDetectorTest::testWholeFile()
+{
+    testEqual( detect( "caf\xc3" ), QStringLiteral("UTF-8") );
+    testEqual( detect( "caf\xc3", true ), QStringLiteral("ISO-8859-1") );
+
+    // a non-ASCII character after the first block
+    QByteArray data( 64 * 1024, 'a' );
+    data.append( "caf\xe9\n" );
+    testEqual( detect( data.left( 8192 ) ), QStringLiteral("UTF-8") );
+    testEqual( detect( data, true ), QStringLiteral("ISO-8859-1") );
+}
+
+
+/// Returns the name of the codec that's detected for the given data
+QString TextCodecDetectorTest::detect(const QByteArray& data, bool wholeFile)
+{
+    TextCodecDetector detector( data.constData(), data.size() );
+    detector.setWholeFile( wholeFile );
+    return detector.detectCodec()->name();
+}
+
+
+} // edbee
@@ -0,0 +1,27 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class TextCodecDetectorTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testByteOrderMarks();
+    void testDetectCodec();
+    void testWholeFile();
+
+private:
+    QString detect( const QByteArray& data, bool wholeFile=false );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::TextCodecDetectorTest);
@@ -0,0 +1,196 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "textcodectest.h"
+
+#include <QByteArray>
+#include <QStringList>
+#include <QTextCodec>
+
+#include "edbee/edbee.h"
+#include "edbee/util/textcodec.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Returns the codec with the given name
+static TextCodec* codecForName( const QString& name )
+{
+    return Edbee::instance()->codecManager()->codecForName( name );
+}
+
+
+/// Returns the bytes as hexadecimal string (so the test output shows the exact bytes)
+static QString toHex( const QByteArray& bytes )
+{
+    return QString::fromLatin1( bytes.toHex() );
+}
+
+
+void TextCodecTest::testDecodeUtf8()
+{
+    testEqual( decode( "UTF-8", "" ), QStringLiteral("") );
+    testEqual( decode( "UTF-8", "caf\xc3\xa9" ), QString::fromUtf8("caf\xc3\xa9") );
+    testEqual( decode( "UTF-8", "\xe2\x82\xac 12.50" ), QString::fromUtf8("\xe2\x82\xac 12.50") );
+    testEqual( decode( "UTF-8", "smile \xf0\x9f\x98\x80!" ), QString::fromUtf8("smile \xf0\x9f\x98\x80!") );
+
+    // long ASCII runs are converted 16 characters at a time
+    QByteArray data( "A line with only ASCII characters, followed by caf\xc3\xa9\r\n" );
+    data = data.repeated( 100 );
+    testEqual( decode( "UTF-8", data ), QString::fromUtf8( data ) );
+}
+
+
+/// Every byte that doesn't start a valid sequence is replaced by a replacement character (like the ParallelTextDecoder)
+void TextCodecTest::testDecodeInvalidUtf8()
+{
+    QString r( QChar::ReplacementCharacter );
+    testEqual( decode( "UTF-8", "a\x80" "b" ), "a" + r + "b" );                       // a continuation byte without lead byte
+    testEqual( decode( "UTF-8", "a\xc3" "b" ), "a" + r + "b" );                       // too few continuation bytes
+    testEqual( decode( "UTF-8", "\xc0\xaf" ), r + r );                                // overlong 2 byte sequence
+    testEqual( decode( "UTF-8", "\xe0\x80\x80" ), r + r + r );                        // overlong 3 byte sequence
+    testEqual( decode( "UTF-8", "\xed\xa0\x80" ), r + r + r );                        // surrogate
+    testEqual( decode( "UTF-8", "\xf4\x90\x80\x80" ), r + r + r + r );                // above U+10FFFF
+    testEqual( decode( "UTF-8", "caf\xe9 au lait" ), "caf" + r + " au lait" );
+
+    // an incomplete sequence at the end of the data
+    testEqual( decode( "UTF-8", "caf\xe2\x82" ), "caf" + r + r );
+}
+
+
+/// The result doesn't depend on the boundaries of the blocks
+void TextCodecTest::testDecodeSplitBlocks()
+{
+    QByteArray data( "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xe0\x80 \xf0\x9f\x98 end" );
+    QString expected = decode( "UTF-8", data );
+    for( int i=0; i <= data.size(); ++i ) {
+        testEqual( decode( "UTF-8", data, i ), expected );
+    }
+
+    // the decoder writes at most maxDecodedLength characters
+    TextDecoder decoder( codecForName("UTF-8") );
+    QString text( 16, QChar('x') );
+    testEqual( decoder.decode( "\xf0\x9f", 2, text.data() ), 0 );
+    testEqual( decoder.maxDecodedLength( 2 ), 4 );
+    testEqual( decoder.decode( "\x98\x80", 2, text.data() ), 2 );
+    testEqual( text.left(2), QString::fromUtf8("\xf0\x9f\x98\x80") );
+}
+
+
+/// Only the codec with BOM skips the byte order mark, like the QTextDecoder
+void TextCodecTest::testDecodeByteOrderMark()
+{
+    testEqual( decode( "UTF-8 with BOM", "\xef\xbb\xbf" "bom" ), QStringLiteral("bom") );
+    testEqual( decode( "UTF-8 with BOM", "\xef\xbb\xbf" "bom", 1 ), QStringLiteral("bom") );
+    testEqual( decode( "UTF-8 with BOM", "\xef\xbb\xbf" "bom", 3 ), QStringLiteral("bom") );
+    testEqual( decode( "UTF-8 with BOM", "no bom" ), QStringLiteral("no bom") );
+    testEqual( decode( "UTF-8", "\xef\xbb\xbf" "bom" ), QString::fromUtf8("\xef\xbb\xbf" "bom") );
+
+    // only the first character is skipped
+    testEqual( decode( "UTF-8 with BOM", "a\xef\xbb\xbf" ), QString::fromUtf8("a\xef\xbb\xbf") );
+}
+
+
+void TextCodecTest::testDecodeLatin1()
+{
+    QByteArray data;
+    for( int i=0; i < 256; ++i ) { data.append( static_cast<char>(i) ); }
+    testEqual( decode( "ISO-8859-1", data ), QString::fromLatin1( data ) );
+    testEqual( decode( "ISO-8859-1", data, 17 ), QString::fromLatin1( data ) );
+    testTrue( TextDecoder( codecForName("ISO-8859-1") ).isBuiltin() );
+}
+
+
+/// The built-in encoders produce the same output as the QTextEncoder
+void TextCodecTest::testEncode()
+{
+    QStringList texts;
+    texts << QStringLiteral("plain ascii")
+          << QString::fromUtf8("caf\xc3\xa9 \xe2\x82\xac 12.50 \xf0\x9f\x98\x80")
+          << QString::fromUtf8( QByteArray( "A line with only ASCII characters, followed by caf\xc3\xa9\r\n" ).repeated( 100 ) )
+          << QStringLiteral("lone ") + QChar(0xDC00) + QStringLiteral(" low surrogate")
+          << QStringLiteral("lone ") + QChar(0xD800) + QStringLiteral(" high surrogate");
+
+    QStringList codecNames;
+    codecNames << "UTF-8" << "UTF-8 with BOM" << "ISO-8859-1";
+    foreach( QString codecName, codecNames ) {
+        testTrue( TextEncoder( codecForName( codecName ) ).isBuiltin() );
+        foreach( QString text, texts ) {
+            testEqual( toHex( encode( codecName, QStringList( text ) ) ), toHex( encodeWithQt( codecName, QStringList( text ) ) ) );
+        }
+    }
+}
+
+
+/// A surrogate pair can be split over two calls
+void TextCodecTest::testEncodeSplitSurrogates()
+{
+    QString smile = QString::fromUtf8("\xf0\x9f\x98\x80");
+    QStringList parts;
+    parts << QStringLiteral("a") + smile.at(0) << smile.at(1) + QStringLiteral("b");
+    testEqual( toHex( encode( "UTF-8", parts ) ), toHex( "a\xf0\x9f\x98\x80" "b" ) );
+    testEqual( toHex( encode( "UTF-8", parts ) ), toHex( encodeWithQt( "UTF-8", parts ) ) );
+}
+
+
+/// Codecs without a built-in converter use the Qt codec
+void TextCodecTest::testQtFallback()
+{
+    TextDecoder decoder( codecForName("UTF-16LE") );
+    testFalse( decoder.isBuiltin() );
+    testEqual( decoder.toUnicode( "a\0b\0", 4 ), QStringLiteral("ab") );
+
+    TextEncoder encoder( codecForName("UTF-16LE") );
+    testFalse( encoder.isBuiltin() );
+    QByteArray output;
+    encoder.encode( QStringLiteral("ab"), output );
+    testEqual( toHex( output ), toHex( QByteArray( "a\0b\0", 4 ) ) );
+}
+
+
+/// Decodes the data with the given codec
+/// @param codecName the name of the codec
+/// @param data the data to decode
+/// @param splitOffset decode the data in two blocks, split at this offset (-1 for a single block)
+QString TextCodecTest::decode(const QString& codecName, const QByteArray& data, int splitOffset)
+{
+    TextDecoder decoder( codecForName( codecName ) );
+    testTrue( decoder.isBuiltin() );
+    QString text( static_cast<int>( decoder.maxDecodedLength( data.size() ) ) + TextDecoder::MaxFinishLength, Qt::Uninitialized );
+    QChar* out = text.data();
+    if( splitOffset >= 0 ) {
+        out += decoder.decode( data.constData(), splitOffset, out );
+        out += decoder.decode( data.constData() + splitOffset, data.size() - splitOffset, out );
+    } else {
+        out += decoder.decode( data.constData(), data.size(), out );
+    }
+    out += decoder.finish( out );
+    text.truncate( static_cast<int>( out - text.constData() ) );
+    return text;
+}
+
+
+/// Encodes the given parts (one call per part) with the QTextEncoder of the codec
+QByteArray TextCodecTest::encodeWithQt(const QString& codecName, const QStringList& parts)
+{
+    QTextEncoder* encoder = codecForName( codecName )->makeEncoder();
+    QByteArray result;
+    foreach( QString part, parts ) { result.append( encoder->fromUnicode( part ) ); }
+    delete encoder;
+    return result;
+}
+
+
+/// Encodes the given parts (one call per part) with the TextEncoder
+QByteArray TextCodecTest::encode(const QString& codecName, const QStringList& parts)
+{
+    TextEncoder encoder( codecForName( codecName ) );
+    QByteArray result;
+    foreach( QString part, parts ) { encoder.encode( part, result ); }
+    return result;
+}
+
+
+} // edbee
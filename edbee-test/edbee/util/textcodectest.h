@@ -0,0 +1,36 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class TextCodec;
+
+class TextCodecTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testDecodeUtf8();
+    void testDecodeInvalidUtf8();
+    void testDecodeSplitBlocks();
+    void testDecodeByteOrderMark();
+    void testDecodeLatin1();
+    void testEncode();
+    void testEncodeSplitSurrogates();
+    void testQtFallback();
+
+private:
+    QString decode( const QString& codecName, const QByteArray& data, int splitOffset=-1 );
+    QByteArray encodeWithQt( const QString& codecName, const QStringList& parts );
+    QByteArray encode( const QString& codecName, const QStringList& parts );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::TextCodecTest);
@@ -0,0 +1,52 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "utf8validatorbenchmark.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include "edbee/util/utf8validator.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+/// Validating a source file (ASCII), this is the common case
+void Utf8ValidatorBenchmark::benchmarkAscii()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runValidate( "Utf8Validator ASCII", benchmarkData( "    for( int i=0; i < count; ++i ) { total += values[i]; }  // sum\n" ) );
+}
+
+
+/// Validating a text with a non-ASCII character on every line
+void Utf8ValidatorBenchmark::benchmarkUtf8()
+{
+    if( skipWithoutBenchmarks() ) { return; }
+    runValidate( "Utf8Validator UTF-8", benchmarkData( "The quick brown fox jumps over the lazy dog, caf\xc3\xa9 \xe2\x82\xac 12.50\n" ) );
+}
+
+
+/// Measures the validation for all supported implementations, and checks that all implementations return the same result
+void Utf8ValidatorBenchmark::runValidate(const QString& name, const QByteArray& data)
+{
+    Utf8Validator::Implementation original = Utf8Validator::implementation();
+    for( int impl = Utf8Validator::ScalarImplementation; impl <= Utf8Validator::Avx2Implementation; ++impl ) {
+        Utf8Validator::Implementation implementation = static_cast<Utf8Validator::Implementation>(impl);
+        if( !Utf8Validator::setImplementation( implementation ) ) { continue; }
+
+        Utf8Validator::validate( data.constData(), data.size() );     // warm up
+        QElapsedTimer timer;
+        timer.start();
+        Utf8Validator::Result result = Utf8Validator::validate( data.constData(), data.size() );
+        qint64 nsecs = timer.nsecsElapsed();
+
+        reportThroughput( QStringLiteral("%1 %2").arg( name ).arg( Utf8Validator::implementationName( implementation ) ), nsecs, data.size() );
+        testTrue( result != Utf8Validator::InvalidResult );
+    }
+    Utf8Validator::setImplementation( original );
+}
+
+
+} // edbee
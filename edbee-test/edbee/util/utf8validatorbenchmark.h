@@ -0,0 +1,27 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/benchmarkcase.h"
+
+namespace edbee {
+
+/// Measures the throughput of the UTF-8 validation for every supported Utf8Validator implementation
+class Utf8ValidatorBenchmark : public BenchmarkCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void benchmarkAscii();
+    void benchmarkUtf8();
+
+private:
+    void runValidate( const QString& name, const QByteArray& data );
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::Utf8ValidatorBenchmark);
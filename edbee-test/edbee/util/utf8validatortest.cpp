@@ -0,0 +1,140 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#include "utf8validatortest.h"
+
+#include <QByteArray>
+
+#include "edbee/util/utf8validator.h"
+
+#include "edbee/debug.h"
+
+namespace edbee {
+
+
+/// Validates the given (complete) data
+static Utf8Validator::Result validate( const QByteArray& data )
+{
+    return Utf8Validator::validate( data.constData(), data.size() );
+}
+
+
+void Utf8ValidatorTest::testValidate()
+{
+    testTrue( validate( "" ) == Utf8Validator::AsciiResult );
+    testTrue( validate( "Hello world\r\n" ) == Utf8Validator::AsciiResult );
+    testTrue( validate( "caf\xc3\xa9" ) == Utf8Validator::Utf8Result );
+    testTrue( validate( "\xe2\x82\xac 12.50" ) == Utf8Validator::Utf8Result );
+    testTrue( validate( "\xf0\x9f\x98\x80" ) == Utf8Validator::Utf8Result );
+    testTrue( validate( "\xf4\x8f\xbf\xbf" ) == Utf8Validator::Utf8Result );       // U+10FFFF
+    testTrue( validate( "\xee\x80\x80" ) == Utf8Validator::Utf8Result );           // U+E000, after the surrogates
+    testTrue( validate( "caf\xe9" ) == Utf8Validator::InvalidResult );
+
+    // a non-ASCII character after a long ASCII text
+    QByteArray data( 100000, 'a' );
+    testTrue( validate( data ) == Utf8Validator::AsciiResult );
+    data.append( "\xc3\xa9" );
+    testTrue( validate( data ) == Utf8Validator::Utf8Result );
+    data.append( "\xe9" );
+    testTrue( validate( data ) == Utf8Validator::InvalidResult );
+}
+
+
+/// Only well-formed UTF-8 is valid
+void Utf8ValidatorTest::testInvalidSequences()
+{
+    testTrue( validate( "\x80" ) == Utf8Validator::InvalidResult );                // a continuation byte without lead byte
+    testTrue( validate( "\xc3\xa9\xa9" ) == Utf8Validator::InvalidResult );        // too many continuation bytes
+    testTrue( validate( "\xc3" "a" ) == Utf8Validator::InvalidResult );            // too few continuation bytes
+    testTrue( validate( "\xc0\x80" ) == Utf8Validator::InvalidResult );            // overlong 2 byte sequence
+    testTrue( validate( "\xe0\x80\x80" ) == Utf8Validator::InvalidResult );        // overlong 3 byte sequence
+    testTrue( validate( "\xf0\x80\x80\x80" ) == Utf8Validator::InvalidResult );    // overlong 4 byte sequence
+    testTrue( validate( "\xed\xa0\x80" ) == Utf8Validator::InvalidResult );        // surrogate U+D800
+    testTrue( validate( "\xf4\x90\x80\x80" ) == Utf8Validator::InvalidResult );    // U+110000
+    testTrue( validate( "\xf8\x88\x80\x80\x80" ) == Utf8Validator::InvalidResult );   // obsolete 5 byte sequence
+    testTrue( validate( "\xfe\xff" ) == Utf8Validator::InvalidResult );
+}
+
+
+/// An incomplete sequence at the end is only valid when the data isn't complete
+void Utf8ValidatorTest::testIncompleteSequence()
+{
+    testTrue( Utf8Validator::validate( "abc\xe2\x82", 5, true ) == Utf8Validator::InvalidResult );
+    testTrue( Utf8Validator::validate( "abc\xe2\x82", 5, false ) == Utf8Validator::Utf8Result );
+    testTrue( Utf8Validator::validate( "abc\xf0", 4, false ) == Utf8Validator::Utf8Result );
+
+    // the start of an invalid sequence is invalid
+    testTrue( Utf8Validator::validate( "abc\xe0\x80", 5, false ) == Utf8Validator::InvalidResult );
+    testTrue( Utf8Validator::validate( "abc\xf5", 4, false ) == Utf8Validator::InvalidResult );
+}
+
+
+/// Appending the data in blocks gives the same result as validating it at once
+void Utf8ValidatorTest::testAppend()
+{
+    QByteArray data( "ab\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 end" );
+    for( int split1=0; split1 <= data.size(); ++split1 ) {
+        for( int split2=split1; split2 <= data.size(); ++split2 ) {
+            Utf8Validator validator;
+            validator.append( data.constData(), split1 );
+            validator.append( data.constData() + split1, split2 - split1 );
+            testTrue( validator.result(false) == Utf8Validator::validate( data.constData(), split2, false ) );
+            validator.append( data.constData() + split2, data.size() - split2 );
+            testTrue( validator.result() == Utf8Validator::Utf8Result );
+        }
+    }
+
+    Utf8Validator validator;
+    validator.append( "a\xe2", 2 );
+    testTrue( validator.result() == Utf8Validator::InvalidResult );
+    testTrue( validator.result(false) == Utf8Validator::Utf8Result );
+    validator.append( "\x28", 1 );
+    testTrue( validator.isInvalid() );
+    validator.append( "\x82\xac", 2 );
+    testTrue( validator.result() == Utf8Validator::InvalidResult );
+
+    validator.reset();
+    testTrue( validator.result() == Utf8Validator::AsciiResult );
+}
+
+
+/// Compares all supported implementations with the scalar implementation, for all lengths and alignments
+void Utf8ValidatorTest::testImplementations()
+{
+    Utf8Validator::Implementation original = Utf8Validator::implementation();
+    testTrue( Utf8Validator::isSupported( Utf8Validator::ScalarImplementation ) );
+
+    // a mix of ASCII, valid sequences and invalid bytes
+    const char* parts[] = { "abcdefgh", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "0123456789abcdefghijklmnopqrstuvwxyz", "\xed\x9f\xbf", "\xf4\x8f\xbf\xbf" };
+    const char* invalid[] = { "\xe9", "\xed\xa0\x80", "\xc0\xaf", "\x80" };
+    QByteArray data;
+    for( int i=0; i < 60; ++i ) {
+        data.append( parts[ ( i * 5 ) % 7 ] );
+        if( i % 23 == 22 ) { data.append( invalid[ ( i / 23 ) % 4 ] ); }
+    }
+
+    for( int impl = Utf8Validator::ScalarImplementation; impl <= Utf8Validator::Avx2Implementation; ++impl ) {
+        Utf8Validator::Implementation implementation = static_cast<Utf8Validator::Implementation>(impl);
+        if( !Utf8Validator::setImplementation( implementation ) ) { continue; }
+        testTrue( Utf8Validator::implementation() == implementation );
+
+        int errorCount = 0;
+        for( int start=0; start < 20; ++start ) {
+            for( int length=0; start + length <= data.size(); ++length ) {
+                const char* begin = data.constData() + start;
+                Utf8Validator::setImplementation( Utf8Validator::ScalarImplementation );
+                Utf8Validator::Result expected = Utf8Validator::validate( begin, length, false );
+                Utf8Validator::Result expectedComplete = Utf8Validator::validate( begin, length, true );
+                Utf8Validator::setImplementation( implementation );
+                if( Utf8Validator::validate( begin, length, false ) != expected ) { ++errorCount; }
+                if( Utf8Validator::validate( begin, length, true ) != expectedComplete ) { ++errorCount; }
+            }
+        }
+        testEqual( errorCount, 0 );
+    }
+
+    Utf8Validator::setImplementation( original );
+}
+
+
+} // edbee
@@ -0,0 +1,27 @@
+// edbee - Copyright (c) 2012-2025 by Rick Blommers and contributors
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "edbee/util/test.h"
+
+namespace edbee {
+
+class Utf8ValidatorTest : public edbee::test::TestCase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testValidate();
+    void testInvalidSequences();
+    void testIncompleteSequence();
+    void testAppend();
+    void testImplementations();
+
+};
+
+
+} // edbee
+
+DECLARE_TEST(edbee::Utf8ValidatorTest);